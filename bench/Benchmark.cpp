@@ -0,0 +1,371 @@
+/*
+* Times each stage of a run separately over a grid of synthetic curves (months x tenors x results requested), writing
+* the timings as JSON to track across releases. The JSON follows Google Benchmark's layout (a "context" object and a
+* "benchmarks" array of runs, times in ns), so that its tools, such as compare.py, can diff two files.
+*
+* Usage: bso_bench [--json <file>] [--min-time <seconds>] [--filter <substring>] [--threads <n>] [--quick]
+*/
+
+#include "SyntheticCurves.hpp"
+
+#include "app/counter/PathCounter.hpp"
+#include "app/domain/BondReturnData.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/io/BinaryResults.hpp"
+#include "app/io/CSVLoader.hpp"
+#include "app/io/ResultsOutput.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/OptimiserState.hpp"
+#include "helpers/Parallel.hpp"
+#include "helpers/Strings.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace Bench::Detail
+{
+	struct Options
+	{
+		std::optional<std::filesystem::path> JSONPath{};
+		// Each benchmark repeats until it has run for at least this long (and at least minIterations times).
+		double minTimeSeconds = 0.5;
+		std::string filter{};
+		unsigned int numThreads = 0;
+		bool quick = false;
+	};
+
+	struct Grid
+	{
+		std::vector<int> months{};
+		std::vector<int> numTenors{};
+		std::vector<int> numResults{};
+	};
+
+	/// The timings of one benchmark, with the parameters it ran with as counters.
+	struct Run
+	{
+		std::string name{};
+		std::size_t iterations = 0;
+		// Wall time per iteration, the median being reported as the benchmark's time.
+		double medianNs = 0.0;
+		double minNs = 0.0;
+		double meanNs = 0.0;
+		// Process CPU time per iteration, across every thread.
+		double CPUNs = 0.0;
+		std::vector<std::pair<std::string, double>> counters{};
+	};
+
+	constexpr std::size_t minIterations = 3;
+	constexpr std::size_t maxIterations = 100'000;
+
+	class ArgumentError final : public std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	[[nodiscard]] static Options parseArguments(const std::vector<std::string_view>& args) {
+		Options options{};
+		for (std::size_t i = 0; i < args.size(); ++i) {
+			const std::string_view arg = args[i];
+			auto value = [&] {
+				if (i + 1 >= args.size()) {
+					throw ArgumentError(std::format("{} requires a value", arg));
+				}
+				return args[++i];
+			};
+
+			if (arg == "--json") {
+				options.JSONPath = std::filesystem::path(value());
+			}
+			else if (arg == "--min-time") {
+				const std::string_view sv = value();
+				const auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), options.minTimeSeconds);
+				if (ec != std::errc{} || ptr != sv.data() + sv.size() || !(options.minTimeSeconds >= 0.0)) {
+					throw ArgumentError(std::format("--min-time must be a non-negative number, received {}", sv));
+				}
+			}
+			else if (arg == "--filter") {
+				options.filter = value();
+			}
+			else if (arg == "--threads") {
+				const std::string_view sv = value();
+				const auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), options.numThreads);
+				if (ec != std::errc{} || ptr != sv.data() + sv.size() || options.numThreads == 0) {
+					throw ArgumentError(std::format("--threads must be a positive integer, received {}", sv));
+				}
+			}
+			else if (arg == "--quick") {
+				options.quick = true;
+			}
+			else {
+				throw ArgumentError(std::format("Unknown argument {}", arg));
+			}
+		}
+		return options;
+	}
+
+	/// Returns the grid of runs, the quick grid being small enough to check the benchmarks still work.
+	[[nodiscard]] static Grid gridFor(const Options& options) {
+		if (options.quick) {
+			return {.months = {60, 240}, .numTenors = {3, 8}, .numResults = {1, 100}};
+		}
+		return {.months = {120, 600, 1200}, .numTenors = {3, 8, 16}, .numResults = {1, 100, 10'000}};
+	}
+
+	/**
+	* Calls fn once untimed to warm up, then times it repeatedly until it has run for at least options.minTimeSeconds
+	* and minIterations times.
+	*/
+	[[nodiscard]] static Run measure(
+		std::string name,
+		const Options& options,
+		const std::function<void()>& fn
+	) {
+		using Clock = std::chrono::steady_clock;
+
+		fn();
+		std::vector<double> times{};
+		const std::clock_t CPUStart = std::clock();
+		const auto start = Clock::now();
+		do {
+			const auto iterationStart = Clock::now();
+			fn();
+			times.push_back(std::chrono::duration<double, std::nano>(Clock::now() - iterationStart).count());
+		} while (
+			times.size() < maxIterations && (
+				times.size() < minIterations
+				|| std::chrono::duration<double>(Clock::now() - start).count() < options.minTimeSeconds
+			)
+		);
+		const double CPUNs = static_cast<double>(std::clock() - CPUStart) * 1e9 / CLOCKS_PER_SEC;
+
+		Run run{.name = std::move(name), .iterations = times.size()};
+		run.meanNs = std::accumulate(times.begin(), times.end(), 0.0) / static_cast<double>(times.size());
+		run.CPUNs = CPUNs / static_cast<double>(times.size());
+		std::ranges::nth_element(times, times.begin() + static_cast<std::ptrdiff_t>(times.size() / 2));
+		run.medianNs = times[times.size() / 2];
+		run.minNs = std::ranges::min(times);
+		return run;
+	}
+
+	/// Formats a time in ns with units suited to its size, such as "12.3 ms".
+	[[nodiscard]] static std::string formatTime(const double ns) {
+		if (ns >= 1e9) {
+			return std::format("{:.3f} s", ns / 1e9);
+		}
+		if (ns >= 1e6) {
+			return std::format("{:.3f} ms", ns / 1e6);
+		}
+		if (ns >= 1e3) {
+			return std::format("{:.3f} us", ns / 1e3);
+		}
+		return std::format("{:.0f} ns", ns);
+	}
+
+	/// Runs every benchmark over the grid (or those whose names contain options.filter), printing each as it finishes.
+	[[nodiscard]] static std::vector<Run> runBenchmarks(const Options& options, const std::filesystem::path& workDir) {
+		std::vector<Run> runs{};
+		const Grid grid = gridFor(options);
+
+		auto wanted = [&](const std::string& name) {
+			return options.filter.empty() || name.contains(options.filter);
+		};
+		auto record = [&](Run run, std::vector<std::pair<std::string, double>> counters) {
+			run.counters = std::move(counters);
+			std::println(
+				"{:<60} {:>12} {:>12} {:>10}",
+				run.name, formatTime(run.medianNs), formatTime(run.CPUNs), run.iterations
+			);
+			runs.push_back(std::move(run));
+		};
+
+		std::println("{:<60} {:>12} {:>12} {:>10}", "Benchmark", "Time", "CPU", "Iterations");
+		std::println("{}", std::string(97, '-'));
+
+		for (const int numMonths : grid.months) {
+			for (const int numTenors : grid.numTenors) {
+				const Domain::BondReturnData tenorData = syntheticCurve(syntheticTenors(numTenors), numMonths);
+				const std::string curveName = std::format("months:{}/tenors:{}", numMonths, numTenors);
+				auto curveCounters = [&] {
+					return std::vector<std::pair<std::string, double>>{
+						{"months", numMonths}, {"tenors", numTenors}
+					};
+				};
+
+				// Stages depending only on the curve:
+				if (const std::string name = "loadBondReturnCSV/" + curveName; wanted(name)) {
+					const std::filesystem::path CSVPath = workDir / std::format("{}_{}.csv", numMonths, numTenors);
+					writeCurveCSV(tenorData, CSVPath);
+					const std::string CSVPathString = CSVPath.string();
+					record(measure(name, options, [&] {
+						const auto loaded = IO::Input::loadBondReturnCSV(CSVPathString);
+					}), curveCounters());
+				}
+				if (const std::string name = "countPaths/" + curveName; wanted(name)) {
+					record(measure(name, options, [&] {
+						const auto count = PathCounter::countPaths(tenorData.tenors(), tenorData.numMonths());
+					}), curveCounters());
+				}
+
+				for (const int numResults : grid.numResults) {
+					const std::string runName = std::format("{}/k:{}", curveName, numResults);
+					DynamicOptimiser::OptimalResults results{};
+					auto runCounters = [&] {
+						auto counters = curveCounters();
+						counters.emplace_back("k", numResults);
+						counters.emplace_back("results", static_cast<double>(results.size()));
+						return counters;
+					};
+
+					if (const std::string name = "getOptimalSequences/" + runName; wanted(name)) {
+						record(measure(name, options, [&] {
+							DynamicOptimiser::getOptimalSequences(tenorData, numResults, results);
+						}), runCounters());
+					}
+					if (const std::string name = "reconstructPaths/" + runName; wanted(name)) {
+						// The state holds every month's decisions from its forward pass, so results() times just
+						// walking the paths back from them:
+						const DynamicOptimiser::OptimiserState state(tenorData, numResults);
+						record(measure(name, options, [&] {
+							state.results(results);
+						}), runCounters());
+					}
+
+					const bool wantCSV = wanted("writeCSV/" + runName);
+					const bool wantBinary = wanted("writeBinaryResults/" + runName);
+					if (!wantCSV && !wantBinary) {
+						continue;
+					}
+					if (results.size() == 0) {
+						DynamicOptimiser::getOptimalSequences(tenorData, numResults, results);
+					}
+					const std::filesystem::path resultsPath = workDir / "results";
+					if (wantCSV) {
+						record(measure("writeCSV/" + runName, options, [&] {
+							IO::Output::writeCSV(results, results.size(), resultsPath);
+						}), runCounters());
+					}
+					if (wantBinary) {
+						record(measure("writeBinaryResults/" + runName, options, [&] {
+							IO::Output::writeBinaryResults(results, results.size(), tenorData.tenors(), resultsPath);
+						}), runCounters());
+					}
+				}
+			}
+		}
+		return runs;
+	}
+
+	/// Writes the runs as JSON in Google Benchmark's layout, throwing std::ios_base::failure if writing fails.
+	static void writeJSON(
+		const std::vector<Run>& runs,
+		const std::string_view executable,
+		const std::filesystem::path& filePath
+	) {
+		std::ofstream out(filePath, std::ios::trunc);
+		// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+		out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+
+		#ifdef NDEBUG
+		constexpr std::string_view buildType = "release";
+		#else
+		constexpr std::string_view buildType = "debug";
+		#endif
+
+		std::string JSON = "{\n  \"context\": {\n";
+		std::format_to(
+			std::back_inserter(JSON),
+			"    \"date\": \"{:%FT%TZ}\",\n"
+			"    \"executable\": {},\n"
+			"    \"num_cpus\": {},\n"
+			"    \"library_build_type\": \"{}\"\n",
+			std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()),
+			Helpers::Strings::quoteJSON(executable),
+			Helpers::Parallel::maxThreads(),
+			buildType
+		);
+		JSON += "  },\n  \"benchmarks\": [";
+		for (std::size_t i = 0; i < runs.size(); ++i) {
+			const Run& run = runs[i];
+			std::format_to(
+				std::back_inserter(JSON),
+				"{}\n    {{\n"
+				"      \"name\": \"{}\",\n"
+				"      \"run_name\": \"{}\",\n"
+				"      \"run_type\": \"iteration\",\n"
+				"      \"iterations\": {},\n"
+				"      \"real_time\": {},\n"
+				"      \"cpu_time\": {},\n"
+				"      \"time_unit\": \"ns\",\n"
+				"      \"min_time\": {},\n"
+				"      \"mean_time\": {}",
+				i == 0 ? "" : ",", run.name, run.name, run.iterations, run.medianNs, run.CPUNs, run.minNs, run.meanNs
+			);
+			for (const auto& [counter, value] : run.counters) {
+				std::format_to(std::back_inserter(JSON), ",\n      \"{}\": {}", counter, value);
+			}
+			JSON += "\n    }";
+		}
+		JSON += "\n  ]\n}\n";
+		out << JSON;
+		out.flush();
+	}
+}
+
+int main(const int argc, char* argv[])
+{
+	namespace Detail = Bench::Detail;
+
+	Detail::Options options{};
+	try {
+		options = Detail::parseArguments(std::vector<std::string_view>(argv + 1, argv + argc));
+	}
+	catch (const Detail::ArgumentError& e) {
+		std::println(stderr, "{}", e.what());
+		std::println(
+			stderr,
+			"Usage: {} [--json <file>] [--min-time <seconds>] [--filter <substring>] [--threads <n>] [--quick]",
+			argv[0]
+		);
+		return 2;
+	}
+	if (options.numThreads != 0) {
+		Helpers::Parallel::setMaxThreads(options.numThreads);
+	}
+
+	const std::filesystem::path workDir = std::filesystem::temp_directory_path() / "bso_bench";
+	try {
+		std::filesystem::create_directories(workDir);
+		const auto runs = Detail::runBenchmarks(options, workDir);
+		if (options.JSONPath) {
+			Detail::writeJSON(runs, argv[0], *options.JSONPath);
+		}
+	}
+	catch (const std::exception& e) {
+		std::println(stderr, "Benchmark failed: {}", e.what());
+		std::error_code ec{};
+		std::filesystem::remove_all(workDir, ec);
+		return 1;
+	}
+	std::error_code ec{};
+	std::filesystem::remove_all(workDir, ec);
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "SyntheticCurves.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <numbers>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Bench
+{
+	namespace Detail
+	{
+		constexpr std::array tenorLadder = {1, 2, 3, 4, 6, 9, 12, 18, 24, 36, 48, 60, 84, 120, 180, 240, 360};
+
+		/// Draws standard normal values from a std::mt19937_64, whose output is fixed by the standard.
+		class NormalSource
+		{
+			public:
+				explicit NormalSource(const std::uint64_t seed) : engine_(seed) {}
+
+				[[nodiscard]] double operator()() {
+					if (hasSpare_) {
+						hasSpare_ = false;
+						return spare_;
+					}
+					// Box-Muller, with u1 in (0, 1] so that its log is finite:
+					const double u1 = 1.0 - uniform();
+					const double u2 = uniform();
+					const double radius = std::sqrt(-2.0 * std::log(u1));
+					spare_ = radius * std::sin(2.0 * std::numbers::pi * u2);
+					hasSpare_ = true;
+					return radius * std::cos(2.0 * std::numbers::pi * u2);
+				}
+
+			private:
+				/// Returns a double in [0, 1) from the top 53 bits of the engine's output.
+				[[nodiscard]] double uniform() {
+					return static_cast<double>(engine_() >> 11) * 0x1.0p-53;
+				}
+
+				std::mt19937_64 engine_;
+				double spare_ = 0.0;
+				bool hasSpare_ = false;
+		};
+	}
+
+	std::vector<int> syntheticTenors(const int numTenors) {
+		std::vector<int> tenors{};
+		tenors.reserve(static_cast<std::size_t>(numTenors));
+		for (int i = 0; i < numTenors; ++i) {
+			const auto ladderSize = static_cast<int>(Detail::tenorLadder.size());
+			tenors.push_back(
+				i < ladderSize
+					? Detail::tenorLadder[static_cast<std::size_t>(i)]
+					: Detail::tenorLadder.back() + 60 * (i - ladderSize + 1)
+			);
+		}
+		return tenors;
+	}
+
+	Domain::BondReturnData syntheticCurve(std::vector<int> tenors, const int numMonths, const std::uint64_t seed) {
+		// Annual rates, with the short rate mean-reverting towards its long-run level:
+		constexpr double longRunRate = 0.04;
+		constexpr double reversion = 0.02;
+		constexpr double rateVolatility = 0.002;
+		constexpr double termPremium = 0.005;
+		constexpr double tenorNoise = 0.0005;
+
+		Detail::NormalSource normal(seed);
+		const std::size_t numTenors = tenors.size();
+		std::vector<double> grid(numTenors * static_cast<std::size_t>(std::max(numMonths, 0)));
+
+		double shortRate = longRunRate;
+		for (int month = 0; month < numMonths; ++month) {
+			shortRate += reversion * (longRunRate - shortRate) + rateVolatility * normal();
+			for (std::size_t row = 0; row < numTenors; ++row) {
+				const double years = tenors[row] / 12.0;
+				const double yield = shortRate + termPremium * std::log1p(years) + tenorNoise * normal();
+				// Floored well above -100% a year, so that every curve also suits log space:
+				grid[row * static_cast<std::size_t>(numMonths) + static_cast<std::size_t>(month)] =
+					std::pow(1.0 + std::max(yield, -0.5), years) - 1.0;
+			}
+		}
+		return {std::move(tenors), numMonths, std::move(grid), "synthetic"};
+	}
+
+	void writeCurveCSV(const Domain::BondReturnData& tenorData, const std::filesystem::path& filePath) {
+		std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+		// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+		out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+
+		std::string line = "Tenor";
+		for (int month = 0; month < tenorData.numMonths(); ++month) {
+			std::format_to(std::back_inserter(line), ",{}", month);
+		}
+		line += '\n';
+		out << line;
+
+		for (int row = 0; row < tenorData.numTenors(); ++row) {
+			line = std::format("{}", tenorData.tenors()[static_cast<std::size_t>(row)]);
+			for (int month = 0; month < tenorData.numMonths(); ++month) {
+				std::format_to(std::back_inserter(line), ",{}", tenorData(row, month));
+			}
+			line += '\n';
+			out << line;
+		}
+		out.flush();
+	}
+}
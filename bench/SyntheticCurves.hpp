@@ -0,0 +1,33 @@
+#ifndef BSO_BENCH_SYNTHETIC_CURVES_HPP
+#define BSO_BENCH_SYNTHETIC_CURVES_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+namespace Bench
+{
+	/// Returns the first numTenors of a ladder of common tenors (1, 2, 3, 4, 6, 9, 12, 18, 24 months and so on),
+	/// continuing in steps of 60 months beyond the ladder's end.
+	[[nodiscard]] std::vector<int> syntheticTenors(int numTenors);
+
+	/**
+	* Generates holding period returns for the given tenors (in increasing order) over numMonths months, as a yield
+	* curve whose short rate wanders around 4% a year, with a term premium growing with tenor and a little noise per
+	* tenor. The same seed always gives the same curve on every platform, since only the engine's raw output is used
+	* (rather than std::normal_distribution, whose algorithm is left to the implementation).
+	*/
+	[[nodiscard]] Domain::BondReturnData syntheticCurve(std::vector<int> tenors, int numMonths, std::uint64_t seed = 1);
+
+	/// Writes bond return data as a CSV in the form loadBondReturnCSV reads, throwing std::ios_base::failure if
+	/// writing fails.
+	void writeCurveCSV(const Domain::BondReturnData& tenorData, const std::filesystem::path& filePath);
+}
+
+#endif // BSO_BENCH_SYNTHETIC_CURVES_HPP
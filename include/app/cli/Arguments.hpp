@@ -0,0 +1,27 @@
+#ifndef BSO_APP_CLI_ARGUMENTS_HPP
+#define BSO_APP_CLI_ARGUMENTS_HPP
+
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace Arguments
+{
+	/// Thrown if the command-line arguments provided for a non-interactive mode are invalid.
+	struct ArgumentError final : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	/// Splits "--option=value" into its name and value, returning std::nullopt for the value if there is none.
+	[[nodiscard]] std::pair<std::string_view, std::optional<std::string_view>> splitInlineValue(std::string_view arg);
+
+	/// Parses a positive integer argument, naming what it is (e.g. "number of results") in any error.
+	[[nodiscard]] int parsePositiveInt(std::string_view sv, std::string_view description);
+
+	/// Parses a non-negative, finite number argument, naming what it is in any error.
+	[[nodiscard]] double parseNonNegativeNumber(std::string_view sv, std::string_view description);
+}
+
+#endif // BSO_APP_CLI_ARGUMENTS_HPP
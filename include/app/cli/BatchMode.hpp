@@ -0,0 +1,89 @@
+#ifndef BSO_APP_CLI_BATCH_MODE_HPP
+#define BSO_APP_CLI_BATCH_MODE_HPP
+
+#include "app/cli/Arguments.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace BatchMode
+{
+	/// Thrown if the command-line arguments provided for batch mode are invalid.
+	using ArgumentError = Arguments::ArgumentError;
+
+	/// Stores the options for a non-interactive batch run, as parsed from the command line.
+	struct BatchOptions
+	{
+		// Paths to bond return data, the final component of each may contain the wildcards '*' and '?'.
+		std::vector<std::string> inputPatterns{};
+		// If set, a file listing further inputs (or patterns) one per line, relative to the file's own directory.
+		std::optional<std::filesystem::path> manifestPath{};
+		// Runs only the inputs of one shard of the batch: those whose position among every input, once expanded,
+		// leaves shardIndex when divided by numShards (see IO::SweepSummary for combining the shards afterwards).
+		std::size_t shardIndex = 0;
+		std::size_t numShards = 1;
+		int numResultsRequested{};
+		// If set, every result within this many basis points of the best HPR is found instead of a number of results.
+		std::optional<double> withinBasisPoints{};
+		// If no output directory is provided, results are printed to the terminal instead.
+		std::optional<std::filesystem::path> outputDirectory{};
+		// Saves results as binary results files rather than CSV (see "include/app/io/BinaryResults.hpp").
+		bool binaryResults = false;
+		// The maximum number of threads to use for parallel work, 0 uses every hardware thread.
+		unsigned int maxThreads = 0;
+		// The number of inputs run at once, each on a single thread, with loading and saving overlapping the runs.
+		unsigned int numJobs = 1;
+		// Converts CSV inputs to binary curve sidecars on first load, and reuses them while the CSV is unchanged.
+		bool useBinaryCache = false;
+		// Recomputes decisions from checkpoints while reconstructing paths, roughly halving speed to save memory.
+		bool lowMemory = false;
+		// Ranks by sums of log returns, so that long horizons of large returns cannot overflow.
+		bool logSpace = false;
+		// Counts strategies differing only in when they wait as one result (see OptimiserOptions::distinctPurchases).
+		bool distinctPurchases = false;
+		// Finds the results for every horizon from 1 month to the input's last, in a single run, saved together as one
+		// CSV with a column for the horizon (see DynamicOptimiser::getOptimalSequencesForAllHorizons).
+		bool allHorizons = false;
+		// If set, each run's final optimiser state is saved in this directory keyed by a hash of the input's data, and
+		// an input whose data was already run (for as many results or more) is answered from it without running.
+		std::optional<std::filesystem::path> resultDirectory{};
+		// Keeps each input's optimiser state in a sidecar file, so that once the input gains months,
+		// only the new months are run.
+		bool keepState = false;
+		// Estimates each run's memory before it starts, and if it would not fit in the memory available, packs its
+		// decisions, checkpoints it, or finds fewer results (see DynamicOptimiser::admitRun).
+		bool checkMemory = true;
+		// If set, a JSON summary of each input's phase timings, buffer sizes and merge counts is written here
+		// (needs a build with instrumentation, see "include/app/instrumentation/Instrumentation.hpp").
+		std::optional<std::filesystem::path> profilePath{};
+		// If set, a summary of the batch (each input's best HPR, how often each tenor is bought first, and the top
+		// results across every input) is saved here (see "include/app/io/SweepSummary.hpp"), and results are not
+		// printed unless saved with an output directory.
+		std::optional<std::filesystem::path> summaryPath{};
+		// Suppresses everything except errors and printed results.
+		bool quiet = false;
+		bool showHelp = false;
+	};
+
+	/// Parses the command-line arguments (excluding the program name) into BatchOptions,
+	/// throwing an ArgumentError if they are invalid.
+	[[nodiscard]] BatchOptions parseArguments(std::span<const std::string_view> args);
+
+	/// Prints instructions on how to run the program in batch mode.
+	void printUsage(std::string_view programName);
+
+	/// Loads each input in turn and runs it through the optimiser, saving or printing the results,
+	/// and returns the exit code for the program (non-zero if any input failed).
+	[[nodiscard]] int runBatch(const BatchOptions& options);
+
+	/// Parses the command-line arguments and runs the batch, handling requests for help and invalid arguments,
+	/// returning the exit code for the program.
+	[[nodiscard]] int run(std::string_view programName, std::span<const std::string_view> args);
+}
+
+#endif // BSO_APP_CLI_BATCH_MODE_HPP
\ No newline at end of file
@@ -1,10 +1,22 @@
 #ifndef BSO_APP_CLI_OUTPUT_MESSAGES_HPP
 #define BSO_APP_CLI_OUTPUT_MESSAGES_HPP
 
+#include <string>
+
+namespace DynamicOptimiser
+{
+	// Forward declaration, implemented in "include/app/optimiser/MemoryEstimate.hpp".
+	struct Admission;
+}
+
 namespace OutputMessages
 {
 	/// Prints instructions on how to format the bond return data file.
 	void printFileHelp();
+
+	/// Describes why and how a run was adjusted to fit its memory budget (or that it could not be),
+	/// as a sentence for a note or warning.
+	[[nodiscard]] std::string admissionNote(const DynamicOptimiser::Admission& admission, int numResultsRequested);
 }
 
 #endif // BSO_APP_CLI_OUTPUT_MESSAGES_HPP
\ No newline at end of file
@@ -11,7 +11,8 @@ namespace Domain
 
 namespace Prompts
 {
-	/// Will warn the user if they request more than the specified number of results.
+	/// Will warn the user if they request more than the specified number of results, when the memory available cannot
+	/// be determined (otherwise they are warned if the results would not fit in it).
 	constexpr int REQUEST_WARNING_NUM = 1'000'000;
 
 	using DataPromptResult = Transformers::PromptResult<Domain::BondReturnData>;
@@ -19,8 +20,9 @@ namespace Prompts
 	[[nodiscard]] DataPromptResult getDataPrompt();
 
 	using NumResultsPromptResult = Transformers::PromptResult<int>;
-	/// Prompts the user for the number of results they'd like to calculate.
-	[[nodiscard]] NumResultsPromptResult getNumResultsPrompt();
+	/// Prompts the user for the number of results they'd like to calculate from tenorData,
+	/// warning them if that many would need more memory than is available.
+	[[nodiscard]] NumResultsPromptResult getNumResultsPrompt(const Domain::BondReturnData& tenorData);
 }
 
 #endif //BSO_APP_CLI_PROMPTS_HPP
\ No newline at end of file
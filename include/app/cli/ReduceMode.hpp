@@ -0,0 +1,40 @@
+#ifndef BSO_APP_CLI_REDUCE_MODE_HPP
+#define BSO_APP_CLI_REDUCE_MODE_HPP
+
+#include "app/cli/Arguments.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ReduceMode
+{
+	/// Stores the options for combining sweep summaries, as parsed from the command line.
+	struct ReduceOptions
+	{
+		// Paths to sweep summaries, the final component of each may contain the wildcards '*' and '?'.
+		std::vector<std::string> summaryPatterns{};
+		// The number of top results across every input to keep, by default (and at most) the fewest any summary keeps.
+		std::optional<std::size_t> numTopResults{};
+		// If set, the combined summary is saved here, so that it can itself be combined with others.
+		std::optional<std::filesystem::path> outputPath{};
+		bool showHelp = false;
+	};
+
+	/// Parses the command-line arguments (excluding the program name and "reduce") into ReduceOptions,
+	/// throwing an Arguments::ArgumentError if they are invalid.
+	[[nodiscard]] ReduceOptions parseArguments(std::span<const std::string_view> args);
+
+	/// Prints instructions on how to combine sweep summaries.
+	void printUsage(std::string_view programName);
+
+	/// Parses the command-line arguments, then combines the summaries (written by batch mode's --summary) and reports
+	/// their statistics, handling requests for help and invalid arguments, returning the exit code for the program.
+	[[nodiscard]] int run(std::string_view programName, std::span<const std::string_view> args);
+}
+
+#endif // BSO_APP_CLI_REDUCE_MODE_HPP
\ No newline at end of file
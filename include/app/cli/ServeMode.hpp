@@ -0,0 +1,31 @@
+#ifndef BSO_APP_CLI_SERVE_MODE_HPP
+#define BSO_APP_CLI_SERVE_MODE_HPP
+
+#include "app/cli/Arguments.hpp"
+#include "app/service/Server.hpp"
+
+#include <span>
+#include <string_view>
+
+namespace ServeMode
+{
+	/// Stores the options for serving, as parsed from the command line.
+	struct ServeOptions
+	{
+		Service::ServerOptions server{};
+		bool showHelp = false;
+	};
+
+	/// Parses the command-line arguments (excluding the program name and "serve") into ServeOptions,
+	/// throwing an Arguments::ArgumentError if they are invalid.
+	[[nodiscard]] ServeOptions parseArguments(std::span<const std::string_view> args);
+
+	/// Prints instructions on how to run the program as a service.
+	void printUsage(std::string_view programName);
+
+	/// Parses the command-line arguments and serves queries until interrupted, handling requests for help and invalid
+	/// arguments, returning the exit code for the program.
+	[[nodiscard]] int run(std::string_view programName, std::span<const std::string_view> args);
+}
+
+#endif // BSO_APP_CLI_SERVE_MODE_HPP
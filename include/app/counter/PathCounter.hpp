@@ -1,13 +1,24 @@
 #ifndef BSO_APP_COUNTER_PATH_COUNTER_HPP
 #define BSO_APP_COUNTER_PATH_COUNTER_HPP
 
+#include <future>
+#include <string>
 #include <vector>
 
 namespace PathCounter
 {
-	/// Prints the total number of possible buying strategies from the provided bond return data,
-	/// printing an approximation if the number of strategies exceeds exact representation as a long long.
-	void printPathCount(const std::vector<int>& tenorList, int numMonths);
+	/**
+	* Starts counting the exact total number of possible buying strategies for the tenors and horizon on another
+	* thread, returning a future for the count in decimal, so that it can run alongside the optimiser.
+	*/
+	[[nodiscard]] std::shared_future<std::string> countPathsAsync(const std::vector<int>& tenorList, int numMonths);
+
+	/// As countPathsAsync, but counts on the calling thread.
+	[[nodiscard]] std::string countPaths(const std::vector<int>& tenorList, int numMonths);
+
+	/// Prints a count of strategies from countPaths with separators, however large, along with its magnitude in
+	/// scientific notation if it exceeds a long long.
+	void printPathCount(const std::string& digits);
 }
 
 #endif // BSO_APP_COUNTER_PATH_COUNTER_HPP
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <cstddef>
 #include <filesystem>
 #include <mdspan>
+#include <memory>
+#include <span>
 #include <vector>
 
 namespace Domain
@@ -16,6 +18,16 @@ namespace Domain
 			// Constructor:
 			BondReturnData(std::vector<int> t, int m, std::vector<double> g, std::filesystem::path s);
 
+			/// Constructs over a row-major grid owned elsewhere (such as a memory-mapped file) rather than copying it,
+			/// where the storage handle keeps the grid alive for as long as this object, or any copy of it, exists.
+			BondReturnData(
+				std::vector<int> t,
+				int m,
+				std::shared_ptr<const void> storage,
+				const double* gridData,
+				std::filesystem::path s
+			);
+
 			// Defined explicit move/copy semantics to avoid dangling mdspans.
 			BondReturnData(const BondReturnData& other);
 			BondReturnData& operator=(const BondReturnData& other);
@@ -42,17 +54,44 @@ namespace Domain
 			[[nodiscard]] int numMonths() const noexcept { return numMonths_; }
 			[[nodiscard]] const std::filesystem::path& dataPath() const noexcept { return dataPath_; }
 
+			/// The row-major grid of bond return data, with rows sorted by increasing tenor.
+			[[nodiscard]] std::span<const double> grid() const noexcept {
+				return {gridView_.data_handle(), gridView_.size()};
+			}
+
 			[[nodiscard]] int numTenors() const noexcept {
 				return static_cast<int>(tenors_.size());
 			}
 
+			/// Returns a copy holding months [firstMonth, firstMonth + count) alone, as if loaded from a file of just
+			/// those months, such as to optimise over a shorter horizon or a later start, throwing std::out_of_range if
+			/// they are not all held.
+			[[nodiscard]] BondReturnData monthRange(int firstMonth, int count) const;
+
+			/// Returns a copy mirrored in time, so that a bond of tenor t bought at month s is bought at month
+			/// numMonths - s - t of the mirror, such as to run the optimiser from the last month back. Months from
+			/// which a bond would mature beyond the mirror's last month are never bought, so hold 0.
+			[[nodiscard]] BondReturnData mirrored() const;
+
 		private:
+			/// Returns the start of the grid, whether owned by grid_ or external storage.
+			[[nodiscard]] const double* gridData() const noexcept {
+				return externalStorage_ ? externalGrid_ : grid_.data();
+			}
+
+			/// Checks the class invariants, throwing std::invalid_argument if any are violated.
+			void validate(std::size_t gridSize) const;
+
 			std::vector<int> tenors_;
 			int numMonths_;
-			// A row-major vectorisation of the grid of bond return data, with rows sorted by increasing tenor.
+			// A row-major vectorisation of the grid of bond return data, with rows sorted by increasing tenor,
+			// which is empty if the grid is held in external storage instead.
 			std::vector<double> grid_;
-			// An mdspan view over "grid_" for convenient access.
-			std::mdspan<double, std::dextents<std::size_t, 2>> gridView_;
+			// Keeps an externally owned grid alive, shared between copies since the grid is never modified.
+			std::shared_ptr<const void> externalStorage_;
+			const double* externalGrid_ = nullptr;
+			// An mdspan view over the grid for convenient access.
+			std::mdspan<const double, std::dextents<std::size_t, 2>> gridView_;
 			std::filesystem::path dataPath_;
 	};
 }
@@ -1,6 +1,7 @@
 #ifndef BSO_APP_DOMAIN_INVESTMENT_ACTION_HPP
 #define BSO_APP_DOMAIN_INVESTMENT_ACTION_HPP
 
+#include <cstdint>
 #include <format>
 #include <iterator>
 #include <ostream>
@@ -8,40 +9,53 @@
 
 namespace Domain
 {
-	/// Stores an investment action: the starting month, whether to buy our wait, and the tenor of bond to buy
-	/// or the length of time to wait.
+	/// Stores an investment action: whether to buy or wait, and the tenor of bond to buy or the length of time to wait.
+	///
+	/// Paths of actions are reconstructed by the million, so each is packed into 32 bits: the action in the lowest bit
+	/// and the length in the other 31, which hold any positive int. An action does not store the month it starts in,
+	/// since each action of a path starts in the month the one before it ends: a path's start months are the running
+	/// sum of its lengths.
 	class InvestmentAction
 	{
 		public:
 			enum class Action { Buy, Wait };
 
-			// Constructor:
-			explicit InvestmentAction(const Action actionInvestOrWait, const int choiceMonth, const int periodLength) :
-				action_(actionInvestOrWait),
-				startMonth_(choiceMonth),
-				length_(periodLength)
+			/// Selects the constructor which skips validation, for values already known to be valid.
+			struct Trusted
 			{
-				if (choiceMonth < 0) {
-					throw std::invalid_argument("InvestmentAction: Month cannot be negative");
-				}
+				explicit Trusted() = default;
+			};
+			static constexpr Trusted trusted{};
+
+			// Constructor:
+			explicit InvestmentAction(const Action actionInvestOrWait, const int periodLength) {
 				if (periodLength <= 0) {
 					throw std::invalid_argument("InvestmentAction: Tenor / wait length must be positive");
 				}
+				bits_ = pack(actionInvestOrWait, periodLength);
 			}
 
+			/// As above, without validation, for the optimiser's own reconstruction: the length must be positive.
+			InvestmentAction(Trusted, const Action actionInvestOrWait, const int periodLength) noexcept :
+				bits_(pack(actionInvestOrWait, periodLength))
+			{}
+
 			// Getters:
-			[[nodiscard]] Action action() const noexcept { return action_; }
-			[[nodiscard]] int startMonth() const noexcept { return startMonth_; }
-			[[nodiscard]] int length() const noexcept { return length_; }
+			[[nodiscard]] Action action() const noexcept { return (bits_ & 1U) != 0 ? Action::Wait : Action::Buy; }
+			[[nodiscard]] int length() const noexcept { return static_cast<int>(bits_ >> 1); }
 
 			// Stream output according to the formatter defined later.
 			friend std::ostream& operator<<(std::ostream&, const InvestmentAction&);
 
 		private:
-			Action action_;
-			int startMonth_;
-			int length_;
+			[[nodiscard]] static constexpr std::uint32_t pack(const Action action, const int length) noexcept {
+				return (action == Action::Wait ? 1U : 0U) | (static_cast<std::uint32_t>(length) << 1);
+			}
+
+			std::uint32_t bits_;
 	};
+
+	static_assert(sizeof(InvestmentAction) == sizeof(std::uint32_t));
 }
 
 /**
@@ -50,7 +64,10 @@ namespace Domain
 *
 * Also provides a verbose "v" option to output as in the following example:
 *
-* "Month x: buy y-month bond", or,  "Month x: wait for y months"
+* "buy y-month bond", or, "wait for y months"
+*
+* An action does not know the month it starts in, so neither form includes it: callers wanting "Month x: " before it
+* print the running sum of the path's lengths themselves.
 */
 template <>
 struct std::formatter<Domain::InvestmentAction, char>
@@ -70,12 +87,12 @@ struct std::formatter<Domain::InvestmentAction, char>
 	auto format(const Domain::InvestmentAction& choice, FormatContext& ctx) const {
 		if (verbose) {
 			if (choice.action() == Domain::InvestmentAction::Action::Buy) {
-				return std::format_to(ctx.out(), "Month {}: buy {}-month bond", choice.startMonth(), choice.length());
+				return std::format_to(ctx.out(), "buy {}-month bond", choice.length());
 			}
 			if (choice.length() == 1) {
-				return std::format_to(ctx.out(), "Month {}: wait for 1 month", choice.startMonth());
+				return std::format_to(ctx.out(), "wait for 1 month");
 			}
-			return std::format_to(ctx.out(), "Month {}: wait for {} months", choice.startMonth(), choice.length());
+			return std::format_to(ctx.out(), "wait for {} months", choice.length());
 		}
 		if (choice.action() == Domain::InvestmentAction::Action::Buy) {
 			return std::format_to(ctx.out(), "b{}", choice.length());
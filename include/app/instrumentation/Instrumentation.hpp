@@ -0,0 +1,176 @@
+#ifndef BSO_APP_INSTRUMENTATION_INSTRUMENTATION_HPP
+#define BSO_APP_INSTRUMENTATION_INSTRUMENTATION_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Set to 1 by configuring with -DBSO_INSTRUMENTATION=ON, otherwise every recording call below compiles to nothing.
+#ifndef BSO_INSTRUMENTATION
+	#define BSO_INSTRUMENTATION 0
+#endif
+
+/*
+* Records where a run spends its time and memory: the time in each phase, the peak sizes of the optimiser's largest
+* buffers, how many candidates its merges take and put back, and how many results each month finds. This tells
+* whether a slow run is bound by I/O or by merging, but costs a little on every month, so is only compiled in when
+* BSO_INSTRUMENTATION is set. Otherwise a Recording leaves its Report empty.
+*
+* Recording is process-wide, so that work on other threads (such as ParallelEngine's tasks) is counted, and so only
+* one Recording may be active at a time.
+*/
+
+namespace Instrumentation
+{
+	inline constexpr bool enabled = BSO_INSTRUMENTATION != 0;
+
+	enum class Phase
+	{
+		// Reading and parsing (or mapping) the bond return data.
+		Load,
+		// Ordering the loaded rows by tenor.
+		Sort,
+		// The optimiser's month by month merges.
+		ForwardPass,
+		// Walking the paths back from the decisions.
+		Reconstruction,
+		// Writing results to files.
+		Export
+	};
+
+	inline constexpr std::size_t numPhases = 5;
+
+	/// Returns the phase's name in snake case, such as "forward_pass".
+	[[nodiscard]] std::string_view phaseName(Phase phase) noexcept;
+
+	/// What was recorded while a Recording was active.
+	struct Report
+	{
+		// Time spent in each phase, indexed by Phase. A phase entered within another is only counted as the inner.
+		std::array<std::chrono::nanoseconds, numPhases> phaseTimes{};
+		// The largest allocations of the CRFs window and of the decision store seen, in bytes.
+		std::size_t peakCRFsBytes = 0;
+		std::size_t peakDecisionsBytes = 0;
+		// Candidates put into and taken from each month's k-way merge, summed over every month.
+		std::uint64_t mergePushes = 0;
+		std::uint64_t mergePops = 0;
+		// Indexed by month, the number of results the month's merge found (the last run's, if months are re-run),
+		// with month 0, which only seeds the run, left at 0.
+		std::vector<int> resultsPerMonth{};
+
+		[[nodiscard]] std::chrono::nanoseconds time(const Phase phase) const noexcept {
+			return phaseTimes[static_cast<std::size_t>(phase)];
+		}
+
+		void clear() noexcept;
+	};
+
+	/// Writes the report as a JSON object, with times in seconds.
+	[[nodiscard]] std::string toJSON(const Report& report);
+
+	/// Records into report for as long as it exists, std::logic_error being thrown if another Recording is active.
+	class Recording
+	{
+		public:
+			explicit Recording(Report& report);
+			~Recording();
+
+			Recording(const Recording&) = delete;
+			Recording& operator=(const Recording&) = delete;
+	};
+
+	namespace Detail
+	{
+		// Implemented in "src/app/instrumentation/Instrumentation.cpp", and only called when enabled.
+		void addPhaseTime(Phase phase, std::chrono::nanoseconds time) noexcept;
+		void recordCRFsBytes(std::size_t bytes) noexcept;
+		void recordDecisionsBytes(std::size_t bytes) noexcept;
+		void countMerge(std::uint64_t pushes, std::uint64_t pops) noexcept;
+		void recordMonthResults(int month, int numResults);
+
+		/// The innermost phase being timed on this thread, which is paused while an inner phase runs.
+		class PhaseTimerBase;
+		inline thread_local PhaseTimerBase* currentPhase = nullptr;
+
+		class PhaseTimerBase
+		{
+			public:
+				explicit PhaseTimerBase(const Phase phase) noexcept :
+					phase_(phase),
+					outer_(currentPhase)
+				{
+					const auto now = std::chrono::steady_clock::now();
+					if (outer_) {
+						outer_->pause(now);
+					}
+					start_ = now;
+					currentPhase = this;
+				}
+
+				~PhaseTimerBase() {
+					const auto now = std::chrono::steady_clock::now();
+					pause(now);
+					currentPhase = outer_;
+					if (outer_) {
+						outer_->start_ = now;
+					}
+				}
+
+				PhaseTimerBase(const PhaseTimerBase&) = delete;
+				PhaseTimerBase& operator=(const PhaseTimerBase&) = delete;
+
+			private:
+				void pause(const std::chrono::steady_clock::time_point now) noexcept {
+					addPhaseTime(phase_, std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_));
+				}
+
+				Phase phase_;
+				PhaseTimerBase* outer_;
+				std::chrono::steady_clock::time_point start_{};
+		};
+
+		/// An empty stand-in for PhaseTimerBase when not enabled.
+		struct NoPhaseTimer
+		{
+			explicit constexpr NoPhaseTimer(Phase) noexcept {}
+		};
+	}
+
+	/// Times the enclosing scope as the given phase, pausing any phase it is nested in.
+	using PhaseTimer = std::conditional_t<enabled, Detail::PhaseTimerBase, Detail::NoPhaseTimer>;
+
+	/// Records a CRFs window allocation of the given size.
+	inline void recordCRFsBytes(const std::size_t bytes) noexcept {
+		if constexpr (enabled) {
+			Detail::recordCRFsBytes(bytes);
+		}
+	}
+
+	/// Records a decision store's allocations of the given size.
+	inline void recordDecisionsBytes(const std::size_t bytes) noexcept {
+		if constexpr (enabled) {
+			Detail::recordDecisionsBytes(bytes);
+		}
+	}
+
+	/// Records one month's merge, which put pushes candidates into it and took pops out.
+	inline void countMerge(const std::uint64_t pushes, const std::uint64_t pops) noexcept {
+		if constexpr (enabled) {
+			Detail::countMerge(pushes, pops);
+		}
+	}
+
+	/// Records the number of results the month's merge found.
+	inline void recordMonthResults(const int month, const int numResults) {
+		if constexpr (enabled) {
+			Detail::recordMonthResults(month, numResults);
+		}
+	}
+}
+
+#endif // BSO_APP_INSTRUMENTATION_INSTRUMENTATION_HPP
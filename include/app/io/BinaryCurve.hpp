@@ -0,0 +1,75 @@
+#ifndef BSO_APP_IO_BINARY_CURVE_HPP
+#define BSO_APP_IO_BINARY_CURVE_HPP
+
+#include "app/io/LoadError.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+/*
+* A binary curve file holds bond return data exactly as BondReturnData stores it, so that it can be memory-mapped and
+* used in place without parsing. All values are stored in the byte order of the machine that wrote the file, which is
+* recorded so files from machines with a different byte order are rejected rather than misread. The layout is:
+*  - a 64-byte header (see "src/app/io/BinaryCurve.cpp"), including the "stamp" of the CSV it was converted from;
+*  - the tenors in increasing order as 32-bit integers, padded with zeros to a multiple of 8 bytes;
+*  - the row-major grid of bond returns as doubles, one row of numMonths values per tenor.
+*/
+
+namespace IO
+{
+	/// The extension for binary curve files, the sidecar for a CSV adds this to the CSV's full filename.
+	inline constexpr std::string_view binaryCurveExtension = "bsoc";
+
+	/// Identifies the contents of the CSV file a binary curve was converted from, so stale conversions are detected.
+	struct SourceStamp
+	{
+		std::uint64_t size{};
+		// The last write time, in ticks of std::filesystem::file_time_type since its epoch.
+		std::int64_t modified{};
+		std::uint64_t hash{};
+
+		friend bool operator==(const SourceStamp&, const SourceStamp&) = default;
+	};
+}
+
+namespace IO::Input
+{
+	/// Thrown if a binary curve file cannot be read, is malformed, or contains invalid data.
+	struct BinaryCurveError final : LoadError
+	{
+		using LoadError::LoadError;
+	};
+
+	/// Maps the binary curve file at the given path and returns its data as BondReturnData, which keeps the mapping
+	/// alive and reads the grid directly from it, throwing a BinaryCurveError if the file is invalid.
+	/// The data's path is reported as dataPath, or the binary file's own path if none is given.
+	[[nodiscard]] Domain::BondReturnData loadBinaryCurve(
+		const std::filesystem::path& binaryPath,
+		std::optional<std::filesystem::path> dataPath = std::nullopt
+	);
+
+	/// Reads just the source stamp from a binary curve file's header,
+	/// returning nullopt if the file does not exist or is not a binary curve this version can read.
+	[[nodiscard]] std::optional<SourceStamp> readSourceStamp(const std::filesystem::path& binaryPath);
+}
+
+namespace IO::Output
+{
+	/// Writes the bond return data as a binary curve file recording the stamp of its source,
+	/// throwing std::ios_base::failure if writing fails.
+	void writeBinaryCurve(
+		const Domain::BondReturnData& tenorData,
+		const SourceStamp& sourceStamp,
+		const std::filesystem::path& binaryPath
+	);
+}
+
+#endif // BSO_APP_IO_BINARY_CURVE_HPP
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef BSO_APP_IO_BINARY_RESULTS_HPP
+#define BSO_APP_IO_BINARY_RESULTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	// Forward declaration, implemented in "include/app/optimiser/DynamicOptimiser.hpp".
+	struct OptimalResults;
+}
+
+/*
+* A binary results file holds the optimiser's results as columns, so that analysis tools can load them with a few reads
+* (as numpy arrays, or as the buffers of an Arrow large_list<uint8> column of paths) rather than parsing CSV. As with
+* binary curves, values are stored in the byte order of the machine that wrote the file, as recorded in the header.
+* The layout is:
+*  - a 64-byte header (see "src/app/io/BinaryResults.cpp");
+*  - the tenors in increasing order as 32-bit integers, padded with zeros to a multiple of 8 bytes;
+*  - every result's path end to end as one byte per step, 0 for waiting a month, or i for buying the ith tenor
+*    (counting from 1) which then covers that tenor's months, padded with zeros to a multiple of 8 bytes;
+*  - the CRFs as doubles, best first (or their natural logs if the header's logSpace flag is set);
+*  - numResults + 1 offsets into the path bytes as 64-bit integers, with result i's path spanning
+*    [offsets[i], offsets[i + 1]).
+* The paths come before the fixed-width columns so that they can be written as they are found, a block at a time.
+*/
+
+namespace IO::Output
+{
+	/// The extension for binary results files.
+	inline constexpr std::string_view binaryResultsExtension = "bsor";
+
+	/**
+	* As CSVWriter, but writes a binary results file. Paths are written as each block arrives, while the CRFs and
+	* offsets (16 bytes per result) are held until finish, which writes them and then the header. Paths can only
+	* use up to 255 tenors, std::invalid_argument being thrown on construction if there are more.
+	*/
+	class BinaryResultsWriter
+	{
+		public:
+			/// Creates (or truncates) the file, for the results of a run over the given tenors.
+			BinaryResultsWriter(const std::filesystem::path& filePath, const std::vector<int>& tenors);
+
+			BinaryResultsWriter(const BinaryResultsWriter&) = delete;
+			BinaryResultsWriter& operator=(const BinaryResultsWriter&) = delete;
+
+			/// Writes the first numRows of results, which are the results of ranks [firstRank, firstRank + numRows),
+			/// with ranks written in order, std::invalid_argument being thrown if not.
+			void write(const DynamicOptimiser::OptimalResults& results, std::size_t firstRank, std::size_t numRows);
+
+			/// Writes the CRFs, offsets and header, and flushes everything, so that any failure to write is thrown.
+			void finish();
+
+		private:
+			std::ofstream out_;
+			std::uint32_t numTenors_;
+			// Indexed by tenor length, the step code for buying that tenor.
+			std::vector<std::uint8_t> tenorCodes_{};
+			bool logSpace_ = false;
+			// The current block's steps, reused for every block.
+			std::vector<std::uint8_t> steps_{};
+			std::vector<double> CRFs_{};
+			std::vector<std::uint64_t> offsets_{0};
+	};
+
+	/// Writes the optimiser's results (for the given tenors) as a binary results file without any interaction,
+	/// throwing std::ios_base::failure if writing fails.
+	void writeBinaryResults(
+		const DynamicOptimiser::OptimalResults& results,
+		std::size_t numResultsToExport,
+		const std::vector<int>& tenors,
+		const std::filesystem::path& filePath
+	);
+}
+
+#endif // BSO_APP_IO_BINARY_RESULTS_HPP
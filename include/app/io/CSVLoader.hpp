@@ -1,7 +1,9 @@
 #ifndef BSO_APP_IO_CSV_LOADER_HPP
 #define BSO_APP_IO_CSV_LOADER_HPP
 
-#include <stdexcept>
+#include "app/io/LoadError.hpp"
+
+#include <filesystem>
 #include <string_view>
 
 namespace Domain
@@ -13,14 +15,21 @@ namespace Domain
 namespace IO::Input
 {
 	/// Thrown if an error occurs loading the provided file or parsing its data.
-	struct CSVError final : std::runtime_error
+	struct CSVError final : LoadError
 	{
-		using std::runtime_error::runtime_error;
+		using LoadError::LoadError;
 	};
 
+	/// Expands a provided file path string, checking that it names an accessible file with a CSV extension,
+	/// throwing a CSVError if not.
+	[[nodiscard]] std::filesystem::path validatedCSVPath(std::string_view CSVPathSv);
+
 	/// Takes a provided file path string, checks the file contains bond return data in the required format,
 	/// and returns the data as BondReturnData.
 	[[nodiscard]] Domain::BondReturnData loadBondReturnCSV(std::string_view CSVPathSv);
+
+	/// As loadBondReturnCSV, but parses contents which have already been read from the (validated) CSVPath.
+	[[nodiscard]] Domain::BondReturnData parseBondReturnCSV(std::string_view contents, std::filesystem::path CSVPath);
 }
 
 #endif // BSO_APP_IO_CSV_LOADER_HPP
\ No newline at end of file
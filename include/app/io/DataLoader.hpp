@@ -0,0 +1,33 @@
+#ifndef BSO_APP_IO_DATA_LOADER_HPP
+#define BSO_APP_IO_DATA_LOADER_HPP
+
+#include "app/io/LoadError.hpp"
+
+#include <filesystem>
+#include <string_view>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+namespace IO::Input
+{
+	/// Options controlling how bond return data is loaded.
+	struct LoadOptions
+	{
+		// If set, a CSV is converted to a binary curve sidecar on first load, which is then used in place of the
+		// CSV for as long as the CSV's size, modification time and contents are unchanged.
+		bool useBinaryCache = false;
+	};
+
+	/// Returns the path of the binary curve sidecar for the CSV at the given path, such as "data.csv.bsoc".
+	[[nodiscard]] std::filesystem::path binarySidecarPath(const std::filesystem::path& CSVPath);
+
+	/// Takes a provided file path string to bond return data stored either as CSV or as a binary curve (chosen by
+	/// extension), and returns the data as BondReturnData, throwing a LoadError if it cannot be loaded.
+	[[nodiscard]] Domain::BondReturnData loadBondReturnData(std::string_view pathSv, const LoadOptions& options = {});
+}
+
+#endif // BSO_APP_IO_DATA_LOADER_HPP
\ No newline at end of file
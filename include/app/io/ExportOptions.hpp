@@ -13,17 +13,27 @@ namespace Domain
 namespace IO::Output
 {
 	// If the user decides to save the results, the file will be "RESULTS_FILENAME.csv"
-	// or some "RESULTS_FILENAME_<num>.csv".
+	// or some "RESULTS_FILENAME_<num>.csv" (or .bsor rather than .csv for binary results).
 	constexpr std::string_view RESULTS_FILENAME = "bond_results";
 	// We set a limit to avoid, for example, the existence of "RESULTS_FILENAME_{1 to (MAX_INT)}.csv" causing problems,
 	// despite this situation being unlikely it does defend against overflows.
 	constexpr int RESULT_FILES_LIMIT = 10'000;
 
+	/// The formats results can be saved in.
+	enum class ResultsFormat
+	{
+		// One row of rank, HPR and path per result.
+		CSV,
+		// Columns of CRFs and encoded paths, for loading into analysis tools (see "include/app/io/BinaryResults.hpp").
+		Binary
+	};
+
 	namespace Decision
 	{
 		struct Save
 		{
 			std::filesystem::path filePath{};
+			ResultsFormat format = ResultsFormat::CSV;
 		};
 		struct Print {};
 		struct Quit {};
@@ -0,0 +1,15 @@
+#ifndef BSO_APP_IO_LOAD_ERROR_HPP
+#define BSO_APP_IO_LOAD_ERROR_HPP
+
+#include <stdexcept>
+
+namespace IO::Input
+{
+	/// Base for the errors thrown if bond return data cannot be loaded, whatever format it is stored in.
+	struct LoadError : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+}
+
+#endif // BSO_APP_IO_LOAD_ERROR_HPP
\ No newline at end of file
@@ -1,27 +1,101 @@
 #ifndef BSO_APP_IO_RESULTS_OUTPUT_HPP
 #define BSO_APP_IO_RESULTS_OUTPUT_HPP
 
+#include "app/io/ExportOptions.hpp"
 #include "app/optimiser/DynamicOptimiser.hpp"
 
 #include <cstddef>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
 #include <vector>
 
+namespace Helpers::Parallel
+{
+	// Forward declaration, implemented in "include/helpers/Parallel.hpp".
+	class WorkerPool;
+}
+
+namespace DynamicOptimiser
+{
+	// Forward declaration, implemented in "include/app/optimiser/ResultDAG.hpp".
+	class ResultDAG;
+}
+
 namespace IO::Output
 {
 	/// Stores what actually happened after the user made their export decision, since writes can fail.
 	enum class ExportOutcome { Saved, Print, Quit };
 
+	/// Formats the holding period return of the ith result as a percentage to 2 decimal places, such as "4.10%",
+	/// or in scientific notation if the return is beyond the range of a double (only possible in log space).
+	[[nodiscard]] std::string formatHoldingPeriodReturn(const DynamicOptimiser::OptimalResults& results, std::size_t i);
+
 	/// Prints the optimiser results to the terminal.
 	void printResults(const DynamicOptimiser::OptimalResults& results, std::size_t numResultsToPrint);
 
-	/// Tries to save the optimiser's results to the path specified, offering to print to the terminal if writing fails.
-	[[nodiscard]] ExportOutcome exportCSV(
+	/**
+	* Writes results to a CSV file as they arrive, a block of ranks at a time, such as from
+	* DynamicOptimiser::streamOptimalSequences, throwing std::ios_base::failure if writing fails. Rows are formatted
+	* straight into reusable buffers, a block of rows per thread for large blocks, then written in order, so that the
+	* file is written in large pieces.
+	*/
+	class CSVWriter
+	{
+		public:
+			/// Creates (or truncates) the file.
+			explicit CSVWriter(const std::filesystem::path& filePath);
+			~CSVWriter();
+
+			CSVWriter(const CSVWriter&) = delete;
+			CSVWriter& operator=(const CSVWriter&) = delete;
+
+			/// Writes the first numRows of results, which are the results of ranks [firstRank, firstRank + numRows).
+			void write(const DynamicOptimiser::OptimalResults& results, std::size_t firstRank, std::size_t numRows);
+
+			/// Flushes everything written, so that any failure to write is thrown.
+			void finish();
+
+		private:
+			// Rows are formatted in blocks of this many, each thread formatting one block at a time into its own buffer.
+			static constexpr std::size_t rowsPerBlock = 4096;
+			static constexpr std::size_t minBlocksForThreads = 8;
+
+			std::ofstream out_;
+			std::vector<std::string> buffers_{};
+			// Only started once a write is large enough to share between threads.
+			std::unique_ptr<Helpers::Parallel::WorkerPool> pool_{};
+	};
+
+	/// Writes the optimiser's results to the path specified as CSV without any interaction,
+	/// throwing std::ios_base::failure if writing fails.
+	void writeCSV(
+		const DynamicOptimiser::OptimalResults& results,
+		std::size_t numResultsToExport,
+		const std::filesystem::path& filePath
+	);
+
+	/// As above, for every result held in a DynamicOptimiser::ResultDAG, unfolding their paths a block at a time.
+	void writeCSV(const DynamicOptimiser::ResultDAG& results, const std::filesystem::path& filePath);
+
+	/// Writes the results for every horizon, as from DynamicOptimiser::getOptimalSequencesForAllHorizons, to the path
+	/// specified as one CSV, each row starting with its horizon in months before the rank, HPR and path written by
+	/// writeCSV, throwing std::ios_base::failure if writing fails.
+	void writeHorizonsCSV(
+		const std::vector<DynamicOptimiser::OptimalResults>& resultsByHorizon,
+		const std::filesystem::path& filePath
+	);
+
+	/// Tries to save the optimiser's results (for the given tenors) to the path and in the format the user decided on,
+	/// offering to print to the terminal if writing fails.
+	[[nodiscard]] ExportOutcome exportResults(
 		const DynamicOptimiser::OptimalResults& results,
 		// We ask for the number of results to export rather than relying on the size of the OptimalResults object
 		// since this is constructed based on how many results the user requests, it may be that fewer results exist.
 		std::size_t numResultsToExport,
-		const std::filesystem::path& filePath
+		const std::vector<int>& tenors,
+		const Decision::Save& decision
 	);
 }
 
@@ -0,0 +1,124 @@
+#ifndef BSO_APP_IO_SWEEP_SUMMARY_HPP
+#define BSO_APP_IO_SWEEP_SUMMARY_HPP
+
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+* A sweep summary file holds what is kept of a batch of inputs once their full results are dropped, so that shards of
+* a sweep run on separate machines need only send back a few kilobytes each to be combined. As with binary results,
+* values are stored in the byte order of the machine that wrote the file, as recorded in the header. The layout is,
+* after a 64-byte header (see "src/app/io/SweepSummary.cpp"), each part padded with zeros to a multiple of 8 bytes:
+*  - each input's position in the sweep's list of inputs as 64-bit integers;
+*  - each input's best CRF as doubles (NaN if it had no results);
+*  - the length of each input's name as 32-bit integers, then the names end to end;
+*  - the tenors first bought by the inputs' best results as 32-bit integers, in increasing order (0 for a result
+*    which only waits), then how many best results bought each as 64-bit integers;
+*  - the top results across every input: their CRFs as doubles, best first, the input each is from (indexing the
+*    inputs above) and its rank there as 32-bit integers, then numTopResults + 1 offsets into the steps as 64-bit
+*    integers, with result i's path spanning [offsets[i], offsets[i + 1]);
+*  - the steps of those paths end to end as 32-bit integers, n > 0 buying an n-month bond, and -n waiting n months.
+* CRFs are natural logs of CRFs if the header's logSpace flag is set.
+*/
+
+namespace IO
+{
+	/// The extension for sweep summary files.
+	inline constexpr std::string_view sweepSummaryExtension = "bsom";
+
+	/// Thrown if a sweep summary file cannot be read or is malformed, or if summaries cannot be combined.
+	struct SweepSummaryError final : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	/**
+	* The summary statistics of a sweep over many inputs: each input's best CRF, how often each tenor is the first
+	* bought by an input's best result, and the top results across every input, up to maxTopResults of them.
+	*
+	* Top results are ordered by CRF, with ties going to the input earlier in the sweep, then to the better rank
+	* within it, so the top results of a sweep split into shards and merged are exactly those of the whole sweep
+	* summarised at once, however it was split.
+	*/
+	class SweepSummary
+	{
+		public:
+			/// An empty summary keeping up to maxTopResults top results, of CRFs in log space if logSpace is set.
+			SweepSummary(std::size_t maxTopResults, bool logSpace) noexcept;
+
+			/// Adds an input's results, found by the optimiser and so sorted best first, where position is its place
+			/// in the sweep's list of inputs. Throws std::invalid_argument if the results' logSpace differs from the
+			/// summary's.
+			void add(std::string_view inputName, std::size_t position, const DynamicOptimiser::OptimalResults& results);
+
+			/// Counts inputs which failed, and so have no results to add.
+			void addFailures(std::size_t numFailed) noexcept { numFailures_ += numFailed; }
+
+			/**
+			* Combines summaries of parts of a sweep into one of the whole, keeping up to maxTopResults top results,
+			* found by a k-way merge of each summary's own. Throws a SweepSummaryError if some summaries are in log
+			* space and others are not, if maxTopResults is more than some summary keeps (since results it dropped
+			* could belong among them), or if an input is in more than one summary.
+			*/
+			[[nodiscard]] static SweepSummary merge(std::span<const SweepSummary> summaries, std::size_t maxTopResults);
+
+			/// Writes the summary to the given path, throwing std::ios_base::failure if writing fails.
+			void save(const std::filesystem::path& summaryPath) const;
+
+			/// Reads a summary written by save(), throwing a SweepSummaryError if the file is invalid.
+			[[nodiscard]] static SweepSummary load(const std::filesystem::path& summaryPath);
+
+			[[nodiscard]] std::size_t maxTopResults() const noexcept { return maxTopResults_; }
+			[[nodiscard]] bool logSpace() const noexcept { return logSpace_; }
+			[[nodiscard]] std::size_t numFailures() const noexcept { return numFailures_; }
+
+			/// The number of inputs added.
+			[[nodiscard]] std::size_t numInputs() const noexcept { return inputNames_.size(); }
+			[[nodiscard]] const std::string& inputName(const std::size_t i) const noexcept { return inputNames_[i]; }
+
+			/// Each input's best CRF (or log CRF if logSpace()), NaN for an input with no results.
+			[[nodiscard]] std::span<const double> bestCRFs() const noexcept { return bestCRFs_; }
+
+			/// How many inputs' best results first bought each tenor, 0 for results which never buy.
+			[[nodiscard]] const std::map<int, std::uint64_t>& firstPurchaseCounts() const noexcept {
+				return firstPurchaseCounts_;
+			}
+
+			/// The top results across every input, best first.
+			[[nodiscard]] const DynamicOptimiser::OptimalResults& topResults() const noexcept { return top_; }
+
+			/// The input (indexing the inputs added) that the ith top result is from.
+			[[nodiscard]] std::size_t topInput(const std::size_t i) const noexcept { return topInputs_[i]; }
+
+		private:
+			/// Appends the ith of results to the top results, as from the given input and of the given rank there.
+			void appendTop(
+				const DynamicOptimiser::OptimalResults& results,
+				std::size_t i,
+				std::uint32_t input,
+				std::uint32_t rank
+			);
+
+			std::size_t maxTopResults_;
+			bool logSpace_;
+			std::size_t numFailures_ = 0;
+			std::vector<std::string> inputNames_{};
+			std::vector<std::uint64_t> positions_{};
+			std::vector<double> bestCRFs_{};
+			std::map<int, std::uint64_t> firstPurchaseCounts_{};
+			DynamicOptimiser::OptimalResults top_{};
+			std::vector<std::uint32_t> topInputs_{};
+			std::vector<std::uint32_t> topRanks_{};
+	};
+}
+
+#endif // BSO_APP_IO_SWEEP_SUMMARY_HPP
\ No newline at end of file
@@ -0,0 +1,188 @@
+#ifndef BSO_APP_OPTIMISER_DECISION_STORE_HPP
+#define BSO_APP_OPTIMISER_DECISION_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	/// How the optimiser stores the decision made for every (month, rank) pair, which dominates its memory use.
+	enum class DecisionLayout
+	{
+		// Chooses Packed when the Wide layout would be large, and Wide otherwise.
+		Auto,
+		// A pair of 32-bit integers per decision, fastest to read and write.
+		Wide,
+		// Bit-packed rows sized to the tenors and ranks each month actually uses, several times smaller for large
+		// numbers of results, at the cost of some extra work packing and unpacking.
+		Packed
+	};
+
+	/// Returns the layout to use for the given problem size, resolving DecisionLayout::Auto.
+	[[nodiscard]] DecisionLayout resolveDecisionLayout(
+		DecisionLayout requested,
+		int numTenors,
+		int numMonths,
+		int numResultsRequested
+	) noexcept;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	/// The decision reaching a given (month, rank): the tenor bought to reach it, and the rank in the month it came
+	/// from. To keep tenors small for packing, they are stored as codes: 0 is a 1-month wait, and i + 1 is the tenor
+	/// at (sorted) index i.
+	struct Decision
+	{
+		std::int32_t tenorCode{};
+		std::int32_t prevRank{};
+	};
+
+	/*
+	* Both stores are written a whole month (row) at a time, in order: beginRow(), then push() for each rank in turn,
+	* then commitRow(), after which the row may be read with count() and get(). Both can also be grown with
+	* extendRows(), for months appended to the problem after earlier months' rows were written, or reset() for another
+	* run, keeping their allocations for reuse. Both allocate their decisions from the memory resource given.
+	*/
+
+	/// Stores decisions as a flat (numMonths + 1) x numResultsRequested grid of Decisions.
+	class WideDecisionStore
+	{
+		public:
+			WideDecisionStore(
+				int numTenors,
+				int numMonths,
+				int numResultsRequested,
+				std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+			);
+
+			void beginRow(const int month) noexcept {
+				currentRow_ = decisions_.data() + static_cast<std::size_t>(month) * rowCapacity_;
+				currentMonth_ = month;
+				currentCount_ = 0;
+			}
+
+			void push(const int tenorCode, const int prevRank) noexcept {
+				currentRow_[currentCount_++] = {tenorCode, prevRank};
+			}
+
+			void commitRow() noexcept {
+				counts_[currentMonth_] = currentCount_;
+			}
+
+			[[nodiscard]] int count(const int month) const noexcept { return counts_[month]; }
+
+			[[nodiscard]] Decision get(const int month, const int rank) const noexcept {
+				return decisions_[static_cast<std::size_t>(month) * rowCapacity_ + rank];
+			}
+
+			/// Grows the store to hold rows for months up to numMonths, keeping every row already written.
+			void extendRows(int numMonths);
+
+			/// Empties the store and sizes it as if newly constructed, only allocating if it has never been this large.
+			void reset(int numTenors, int numMonths, int numResultsRequested);
+
+			/// The bytes the store has allocated.
+			[[nodiscard]] std::size_t bytes() const noexcept;
+
+			/// The bytes a store of the given size allocates, known before constructing it.
+			[[nodiscard]] static std::size_t maxBytes(int numTenors, int numMonths, int numResultsRequested) noexcept;
+
+		private:
+			std::size_t rowCapacity_;
+			std::pmr::vector<Decision> decisions_;
+			std::pmr::vector<int> counts_;
+			Decision* currentRow_ = nullptr;
+			int currentMonth_ = 0;
+			int currentCount_ = 0;
+	};
+
+	/**
+	* Stores each row of decisions as its own bit-packed array, each decision taking just enough bits for the tenor
+	* codes, plus enough for the largest previous rank in that row. Since a row only holds as many decisions as were
+	* found for that month, and early months reach only a few ranks, most rows are far smaller than with the Wide
+	* layout, and the largest shrink from 64 bits per decision to roughly numTenors' and numResultsRequested's widths.
+	*
+	* A row is first written to a scratch row of full-width Decisions, since the rank width is only known once the
+	* row is complete, and is then packed into an allocation of the size needed (or a larger one the row already held,
+	* if the store is reused).
+	*/
+	class PackedDecisionStore
+	{
+		public:
+			PackedDecisionStore(
+				int numTenors,
+				int numMonths,
+				int numResultsRequested,
+				std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+			);
+
+			void beginRow(const int month) noexcept {
+				currentMonth_ = month;
+				scratchCount_ = 0;
+			}
+
+			void push(const int tenorCode, const int prevRank) noexcept {
+				scratch_[scratchCount_++] = {tenorCode, prevRank};
+			}
+
+			/// Packs the scratch row into the current month's row.
+			void commitRow();
+
+			[[nodiscard]] int count(const int month) const noexcept { return rows_[month].count; }
+
+			/// Grows the store to hold rows for months up to numMonths, keeping every row already written.
+			void extendRows(int numMonths);
+
+			/// Empties the store and sizes it as if newly constructed, keeping every row's allocation (including rows
+			/// beyond numMonths, for a later, longer run) so that rows are only reallocated when they outgrow them.
+			void reset(int numTenors, int numMonths, int numResultsRequested);
+
+			/// The bytes the store has allocated, summing every row's, so is only for occasional use.
+			[[nodiscard]] std::size_t bytes() const noexcept;
+
+			/// An upper bound on the bytes a store of the given size allocates, as if every month found every result
+			/// with the widest ranks, so usually well above what a run uses.
+			[[nodiscard]] static std::size_t maxBytes(int numTenors, int numMonths, int numResultsRequested) noexcept;
+
+			[[nodiscard]] Decision get(const int month, const int rank) const noexcept {
+				const PackedRow& row = rows_[month];
+				const unsigned int entryBits = tenorBits_ + row.rankBits;
+				const std::size_t bitPos = static_cast<std::size_t>(rank) * entryBits;
+				const std::size_t wordPos = bitPos / 64;
+				const unsigned int shift = bitPos % 64;
+				// Rows carry an extra word of padding so the following word can always be read, and the double shift
+				// avoids shifting by 64 (undefined behaviour) when the entry lies wholly within the first word.
+				const std::uint64_t bits =
+					((row.words[wordPos] >> shift) | ((row.words[wordPos + 1] << 1) << (63 - shift)))
+					& lowBitsMask(entryBits);
+				return {
+					static_cast<std::int32_t>(bits & lowBitsMask(tenorBits_)),
+					static_cast<std::int32_t>(bits >> tenorBits_)
+				};
+			}
+
+		private:
+			struct PackedRow
+			{
+				std::pmr::vector<std::uint64_t> words{};
+				int count = 0;
+				unsigned int rankBits = 0;
+			};
+
+			[[nodiscard]] static constexpr std::uint64_t lowBitsMask(const unsigned int numBits) noexcept {
+				return numBits >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << numBits) - 1;
+			}
+
+			std::pmr::memory_resource* resource_;
+			unsigned int tenorBits_;
+			// May hold rows beyond the current run's months, emptied, kept from a longer run for their allocations.
+			std::vector<PackedRow> rows_;
+			std::pmr::vector<Decision> scratch_;
+			int currentMonth_ = 0;
+			int scratchCount_ = 0;
+	};
+}
+
+#endif // BSO_APP_OPTIMISER_DECISION_STORE_HPP
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef BSO_APP_OPTIMISER_DEVICE_KERNEL_HPP
+#define BSO_APP_OPTIMISER_DEVICE_KERNEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Set to 1 by configuring with -DBSO_CUDA=ON, which compiles "src/app/optimiser/DeviceKernel.cu" to define the
+// functions below. Otherwise they are not defined, and streamed scenarios always run on the CPU.
+#ifndef BSO_CUDA
+	#define BSO_CUDA 0
+#endif
+
+/*
+* Runs a chunk of streamed scenarios on a CUDA device, one thread per scenario, for sweeps of many scenarios each
+* wanting only a few results (see streamScenarios in "src/app/optimiser/DynamicOptimiser.cpp", which prepares each
+* chunk and falls back to the CPU for any it cannot run here). Each thread runs its scenario's months in turn, and
+* each month's merge is the FixedEngine's: every source's head held in registers, the first greatest taken for each
+* result, so the results are exactly those of the CPU. Every array is interleaved across the chunk's scenarios, as
+* [index * numScenarios + scenario], so that neighbouring threads read and write neighbouring values.
+*
+* Compiled by nvcc, so this header sticks to C++20 and includes none of the optimiser's others. These are internal
+* to the optimiser, and not for use elsewhere.
+*/
+
+namespace DynamicOptimiser::Detail::Device
+{
+	// The most results per scenario, and sources per month (waiting plus each tenor), the kernel runs: each thread
+	// holds a month's heads in registers, so both are fixed.
+	inline constexpr int maxResults = 16;
+	inline constexpr int maxSources = 16;
+
+	/// A month's decision for a rank, laid out as DynamicOptimiser::Decision (whose header nvcc cannot compile).
+	struct Decision
+	{
+		std::int32_t tenorCode{};
+		std::int32_t prevRank{};
+	};
+
+	/// A chunk of scenarios sharing their tenors and horizon, and where to write their results.
+	struct Chunk
+	{
+		std::size_t numScenarios{};
+		int numMonths{};
+		// Sorted in increasing order, at most maxSources - 1 of them.
+		const int* tenors{};
+		int numTenors{};
+		// At most maxResults.
+		int numResults{};
+		bool logSpace{};
+		// The factor of the bond of tenor i maturing at month m, as [(m * numTenors + i) * numScenarios + scenario],
+		// (so for every month from 0 to numMonths, those before the tenor being unused), in log space if set.
+		const double* factors{};
+
+		// The top CRFs of the final month, as [rank * numScenarios + scenario], -inf past the last result found.
+		double* finalCRFs{};
+		// The decisions of months 1 to numMonths, as [(month * numResults + rank) * numScenarios + scenario] (so
+		// month 0's row is unused), those past the last result found in a month being unset.
+		Decision* decisions{};
+		// Set to 1 for each scenario whose CRFs overflowed, whose results are then incomplete, otherwise 0.
+		std::uint8_t* overflowed{};
+	};
+
+	/// Whether there is a CUDA device to run on, looked for on the first call.
+	[[nodiscard]] bool available() noexcept;
+
+	/// Runs the chunk on the device, its arrays being in host memory, and throwing std::runtime_error if CUDA fails.
+	void run(const Chunk& chunk);
+}
+
+#endif // BSO_APP_OPTIMISER_DEVICE_KERNEL_HPP
\ No newline at end of file
@@ -1,6 +1,15 @@
 #ifndef BSO_APP_OPTIMISER_DYNAMIC_OPTIMISER_HPP
 #define BSO_APP_OPTIMISER_DYNAMIC_OPTIMISER_HPP
 
+#include "app/optimiser/DecisionStore.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <mdspan>
+#include <memory>
+#include <memory_resource>
+#include <span>
 #include <vector>
 
 namespace Domain
@@ -13,15 +22,300 @@ namespace Domain
 
 namespace DynamicOptimiser
 {
+	/// Stores the results in a compressed sparse row layout: every result's path of InvestmentActions is held end
+	/// to end in one array, with result i's path spanning [pathOffsets[i], pathOffsets[i + 1]), avoiding an
+	/// allocation per result.
 	struct OptimalResults
 	{
 		std::vector<double> CRFs{}; // sorted CRFs
-		std::vector<std::vector<Domain::InvestmentAction>> decisions{}; // reconstructed decision paths
+		std::vector<Domain::InvestmentAction> actions{}; // reconstructed decision paths, end to end
+		std::vector<std::size_t> pathOffsets{}; // size CRFs.size() + 1 (or empty if there are no results)
+		// If set, CRFs holds the natural log of each CRF rather than the CRF itself (see OptimiserOptions::logSpace).
+		bool logSpace = false;
+
+		/// The number of results held.
+		[[nodiscard]] std::size_t size() const noexcept { return CRFs.size(); }
+
+		/// The ith CRF, converted back from log space if need be (so may be +inf if beyond the range of a double).
+		[[nodiscard]] double CRF(const std::size_t i) const noexcept {
+			return logSpace ? std::exp(CRFs[i]) : CRFs[i];
+		}
+
+		/// The path of InvestmentActions achieving the ith result.
+		[[nodiscard]] std::span<const Domain::InvestmentAction> path(std::size_t i) const noexcept;
+
+		void clear() noexcept;
+	};
+
+	/// How each month's k-way merge finds the best candidate among its lists.
+	enum class MergeEngine
+	{
+		// A binary heap of candidates, as std::priority_queue.
+		Heap,
+		// A loser tree, replaying one comparison per level per result, generally the faster. For large numbers of
+		// results, each month's merge is split by rank across threads, each range merged by a loser tree of its own
+		// (see Merge::ParallelEngine), with the same results.
+		LoserTree,
+		// As LoserTree, unless there are few enough tenors for a fixed-size merge replaying every comparison
+		// branchlessly per result. The results are the same, but it measured no faster overall (slower for hundreds
+		// of results or more), so is not the default.
+		Auto
+	};
+
+	/// Options for tuning how the optimiser runs, which never change the results found
+	/// (except for the order of results with exactly equal CRFs, and apart from distinctPurchases).
+	struct OptimiserOptions
+	{
+		// How decisions are stored during the run, the packed layout allows several times more results in the same
+		// memory, and is chosen automatically for large runs.
+		DecisionLayout decisionLayout = DecisionLayout::Auto;
+		MergeEngine mergeEngine = MergeEngine::LoserTree;
+		// Keeps only a segment of months' decisions at a time, recomputing each segment from periodic checkpoints
+		// of the CRFs while reconstructing the paths. Memory for decisions falls from O(numMonths * k)
+		// to O(sqrt(numMonths * maxTenor) * k), at the cost of roughly doubling the runtime.
+		bool lowMemory = false;
+		// Ranks by sums of log(1 + return) rather than products of (1 + return), so that CRFs beyond the range of a
+		// double cannot overflow. The ranking is the same (up to rounding of near-equal CRFs), but every bond return
+		// must be above -100%, std::domain_error being thrown if not.
+		bool logSpace = false;
+		// Counts strategies which buy the same tenors in the same order and reach the same CRF as one, differing only in
+		// when they wait, so that each such group takes one of the results requested rather than one per strategy
+		// (the first found being kept). Only used by getOptimalSequences, which then runs in double, and cannot be
+		// combined with lowMemory, std::invalid_argument being thrown if so.
+		bool distinctPurchases = false;
+	};
+
+	class Workspace;
+
+	namespace Detail
+	{
+		// Forward declaration, implemented in "src/app/optimiser/DynamicOptimiser.cpp".
+		struct WorkspaceBuffers;
+		[[nodiscard]] WorkspaceBuffers& buffersOf(Workspace& workspace) noexcept;
+	}
+
+	/**
+	* Holds the optimiser's buffers between runs: the window of CRFs, the decision stores and the buffers paths are
+	* walked into. Each run resizes them for its own size, only allocating where they are too small, so repeated runs
+	* of similar size (as in batch mode, or a service) allocate nothing per month or per result. Small buffers sized
+	* by the number of tenors are still allocated per run, as are the results themselves unless reused.
+	*
+	* The window of CRFs and the decisions, by far the largest buffers, are allocated from the memory resource given,
+	* such as an arena. A workspace is only for one run at a time, so concurrent runs each need their own.
+	*/
+	class Workspace
+	{
+		public:
+			explicit Workspace(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+			~Workspace();
+
+			Workspace(Workspace&&) noexcept;
+			Workspace& operator=(Workspace&&) noexcept;
+
+			/// The bytes the workspace has allocated.
+			[[nodiscard]] std::size_t bytes() const noexcept;
+
+			/// Frees every buffer, keeping the memory resource.
+			void release();
+
+		private:
+			friend Detail::WorkspaceBuffers& Detail::buffersOf(Workspace& workspace) noexcept;
+
+			std::unique_ptr<Detail::WorkspaceBuffers> buffers_;
 	};
 
 	/// Given BondReturnData, returns the requested number of optimal results (or as many as found if fewer),
 	/// comprising the CRFs themselves and the path of InvestmentActions to achieve these.
-	[[nodiscard]] OptimalResults getOptimalSequences(const Domain::BondReturnData& tenorData, int numResultsRequested);
+	[[nodiscard]] OptimalResults getOptimalSequences(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const OptimiserOptions& options = {}
+	);
+
+	/// As above, but writes into an existing OptimalResults, reusing the storage it already holds,
+	/// so that repeated runs, such as in batch mode, avoid reallocating their results.
+	void getOptimalSequences(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		OptimalResults& results,
+		const OptimiserOptions& options = {}
+	);
+
+	/// As above, but runs in workspace, reusing the buffers it holds from earlier runs.
+	void getOptimalSequences(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		OptimalResults& results,
+		Workspace& workspace,
+		const OptimiserOptions& options = {}
+	);
+
+	/// Receives a block of results, holding ranks [firstRank, firstRank + block.size()), whose storage is only valid
+	/// for the call.
+	using ResultBlockSink = std::function<void(std::size_t firstRank, const OptimalResults& block)>;
+
+	/**
+	* As getOptimalSequences, but rather than reconstructing every path at once, walks them back from the decisions a
+	* block of ranks at a time, passing each block to sink in rank order before walking the next. Large exports then
+	* only hold the decisions and one block of paths, rather than every path as well. Returns the number of results
+	* found. With options.lowMemory, reconstructs every path together as usual, then passes them as one block.
+	*/
+	std::size_t streamOptimalSequences(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const ResultBlockSink& sink,
+		const OptimiserOptions& options = {}
+	);
+
+	/// As above, but runs in workspace, reusing the buffers it holds from earlier runs.
+	std::size_t streamOptimalSequences(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const ResultBlockSink& sink,
+		Workspace& workspace,
+		const OptimiserOptions& options = {}
+	);
+
+	/**
+	* Given BondReturnData, returns the requested number of optimal results for every horizon at the cost of a single
+	* run: element h - 1 holds the results over the first h months, exactly as getOptimalSequences would find them for
+	* the data cut to those months. Every month's row of CRFs is the top of its own horizon (waiting being one of the
+	* ways to reach it), so each row is kept as it is written, and the paths ending at each month are walked back from
+	* the decisions kept for the whole run. Paths then take O(k * numMonths^2) actions in total, against the decisions'
+	* O(k * numMonths). Cannot be combined with options.lowMemory, which discards the decisions needed,
+	* std::invalid_argument being thrown if so.
+	*/
+	[[nodiscard]] std::vector<OptimalResults> getOptimalSequencesForAllHorizons(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const OptimiserOptions& options = {}
+	);
+
+	/// As above, but writes into existing results, reusing the storage they already hold, and runs in workspace.
+	void getOptimalSequencesForAllHorizons(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		std::vector<OptimalResults>& results,
+		Workspace& workspace,
+		const OptimiserOptions& options = {}
+	);
+
+	/**
+	* Given BondReturnData, returns the requested number of optimal results for every start month at the cost of a
+	* single run: element s holds the results of investing from month s to the last month, with their paths in the
+	* months of tenorData (so starting at month s). Rather than seeding month 0 and running forward once per start, the
+	* top CRFs of each month's suffix are merged backwards from the last month, the sources being the suffixes after
+	* waiting a month or buying each tenor. That is the forward pass over the grid mirrored in time (see
+	* Domain::BondReturnData::mirrored), so it runs as getOptimalSequencesForAllHorizons over the mirror, with the same
+	* merge engines and decision stores, and the paths are then mirrored back. The CRFs multiply the same factors in
+	* the opposite order, so may differ from running the data cut to each start in their last bits, and results with
+	* equal CRFs may be ordered differently. Options are as for getOptimalSequencesForAllHorizons.
+	*/
+	[[nodiscard]] std::vector<OptimalResults> getOptimalSequencesForAllStarts(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const OptimiserOptions& options = {}
+	);
+
+	/// As above, but writes into existing results, reusing the storage they already hold, and runs in workspace.
+	void getOptimalSequencesForAllStarts(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		std::vector<OptimalResults>& results,
+		Workspace& workspace,
+		const OptimiserOptions& options = {}
+	);
+
+	/**
+	* A lower bound on the CRFs of the results wanted, rather than a number of them. Either an absolute CRF, or a margin
+	* below the best result's CRF, so that a margin of 0.0005 asks for every result within 5 bp of the best HPR.
+	* Both are given as CRFs (not logs of them), even with OptimiserOptions::logSpace.
+	*/
+	struct CRFThreshold
+	{
+		enum class Kind
+		{
+			AtLeast,
+			BelowBest
+		};
+
+		Kind kind = Kind::BelowBest;
+		double value = 0.0;
+	};
+
+	/**
+	* Given BondReturnData, returns every result meeting the threshold, however many that is. A backward pass first
+	* finds the best CRF achievable over the months after each month, so that any partial path which could not meet the
+	* threshold even when completed in the best way is pruned as soon as it is found, keeping only the candidates that
+	* may be needed. Pruning relies on later months never reversing the ranking, so every bond return must be at least
+	* -100% (above it with OptimiserOptions::logSpace), std::domain_error being thrown if not.
+	*/
+	[[nodiscard]] OptimalResults getOptimalSequencesWithin(
+		const Domain::BondReturnData& tenorData,
+		const CRFThreshold& threshold,
+		const OptimiserOptions& options = {}
+	);
+
+	/// As above, but writes into an existing OptimalResults, reusing the storage it already holds.
+	void getOptimalSequencesWithin(
+		const Domain::BondReturnData& tenorData,
+		const CRFThreshold& threshold,
+		OptimalResults& results,
+		const OptimiserOptions& options = {}
+	);
+
+	/// Bond returns for a batch of scenarios sharing one tenor list and horizon,
+	/// accessed as [scenario, tenor row, month], with rows sorted by increasing tenor.
+	using ScenarioReturns = std::mdspan<const double, std::dextents<std::size_t, 3>>;
+
+	/**
+	* Runs the optimiser over every scenario in the batch, such as simulated grids for stress testing, returning the
+	* results for each scenario in turn. Scenarios are spread across threads, and when only the best result is
+	* requested, blocks of scenarios are run month by month together, with each block's CRFs stored scenario-minor
+	* so that the inner loops vectorise across scenarios.
+	*/
+	[[nodiscard]] std::vector<OptimalResults> getOptimalSequences(
+		const std::vector<int>& tenors,
+		ScenarioReturns scenarioReturns,
+		int numResultsRequested,
+		const OptimiserOptions& options = {}
+	);
+
+	/// A chunk of scenarios to fill with bond returns, accessed as ScenarioReturns is.
+	using ScenarioChunk = std::mdspan<double, std::dextents<std::size_t, 3>>;
+
+	/// Fills chunk with the returns of the scenarios from firstScenario on, returning how many it filled, which is
+	/// fewer than the chunk holds only once the scenarios have run out.
+	using ScenarioSource = std::function<std::size_t(std::size_t firstScenario, ScenarioChunk chunk)>;
+
+	/// Receives the results of scenarios [firstScenario, firstScenario + results.size()), whose storage is only valid
+	/// for the call.
+	using ScenarioResultsSink = std::function<void(std::size_t firstScenario, std::span<const OptimalResults> results)>;
+
+	/**
+	* As the batch getOptimalSequences above, for more scenarios than can be held at once, such as simulated grids
+	* generated as they are run. Scenarios are read from source a chunk of scenariosPerChunk at a time, and each
+	* chunk's results are passed to sink in scenario order before the chunk after next is read. While a chunk runs,
+	* the next is filled on another thread, so producing the scenarios overlaps running them, and memory is bounded
+	* by two chunks of returns and one of results however many scenarios there are. Source is called one chunk at a
+	* time, but not on the calling thread. Returns the number of scenarios run. Throws std::invalid_argument if
+	* scenariosPerChunk is 0 or source fills more scenarios than the chunk holds, and as the batch getOptimalSequences
+	* does, in which case the chunks before have already been passed to sink.
+	*
+	* In a build configured with -DBSO_CUDA=ON, chunks of up to 16 results and 15 tenors per scenario (and without
+	* distinctPurchases) run on a CUDA device if there is one, a thread per scenario, with the same results. A chunk
+	* run there also holds every month's decisions, (numMonths + 1) * numResultsRequested * 8 bytes per scenario, on
+	* the device and here, which scenariosPerChunk bounds too. Throws std::runtime_error if CUDA fails.
+	*/
+	std::size_t streamScenarios(
+		const std::vector<int>& tenors,
+		int numMonths,
+		int numResultsRequested,
+		std::size_t scenariosPerChunk,
+		const ScenarioSource& source,
+		const ScenarioResultsSink& sink,
+		const OptimiserOptions& options = {}
+	);
 }
 
 #endif // BSO_APP_OPTIMISER_DYNAMIC_OPTIMISER_HPP
\ No newline at end of file
@@ -0,0 +1,337 @@
+#ifndef BSO_APP_OPTIMISER_FORWARD_PASS_HPP
+#define BSO_APP_OPTIMISER_FORWARD_PASS_HPP
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/Kernels.hpp"
+#include "app/optimiser/KWayMerge.hpp"
+#include "app/optimiser/MaturityFactors.hpp"
+#include "helpers/Parallel.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mdspan>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/*
+* The optimiser's forward pass, shared between the ways of running it (see "src/app/optimiser/DynamicOptimiser.cpp"
+* and "src/app/optimiser/OptimiserState.cpp"). These are internal to the optimiser, and not for use elsewhere.
+*/
+
+namespace DynamicOptimiser::Detail
+{
+	// Type for the windowed CRFs mdspan:
+	using CRFsSpan = std::mdspan<double, std::dextents<std::size_t, 2>>;
+}
+
+namespace DynamicOptimiser::Detail::ForwardPass
+{
+	/// A decision store for months whose decisions are not needed, in the checkpointed first pass.
+	struct DiscardedDecisions
+	{
+		void beginRow(int) const noexcept {}
+		void push(int, int) const noexcept {}
+		void commitRow() const noexcept {}
+	};
+
+	/// A handler of each month's row of CRFs which ignores every row, for runs which need none (see runMonths).
+	struct IgnoreRows
+	{
+		void operator()(int, std::span<const double>) const noexcept {}
+	};
+
+	/// A filter of each month's results which keeps every one, for runs which need none (see runMonths).
+	struct AllResults
+	{
+		static constexpr bool canSkip = false;
+
+		void beginRow(int) const noexcept {}
+		std::true_type keep(int, int, double, int, int) const noexcept { return {}; }
+	};
+
+	/**
+	* A filter of each month's results counting strategies which buy the same tenors in the same order as one if they
+	* reach the same CRF, so that strategies differing only in when they wait (whose CRFs tie on a flat curve, say)
+	* take one of the results requested rather than one each. Of equivalent results, the first found is kept.
+	*
+	* Each result held is given a 64-bit signature of the tenors its path buys, and within each run of equal CRFs in a
+	* month, a result whose signature has already been seen is skipped. Equivalent partial paths stay equivalent
+	* whatever follows them, so skipping them in every month skips no distinct strategy: the results are the best
+	* distinct strategies, up to rounding of near-equal CRFs (and the vanishing chance of two signatures colliding).
+	*/
+	class DistinctPurchases
+	{
+		public:
+			static constexpr bool canSkip = true;
+
+			/// Sized for the optimiser's window of months, and seeded for month 0.
+			DistinctPurchases(const std::vector<int>& tenorList, std::size_t window, int numResultsRequested);
+
+			// The signatures are viewed in place, so the filter is not copied.
+			DistinctPurchases(const DistinctPurchases&) = delete;
+			DistinctPurchases& operator=(const DistinctPurchases&) = delete;
+
+			void beginRow(const int) noexcept {
+				runCRF_ = std::numeric_limits<double>::quiet_NaN();
+				runSignatures_.clear();
+			}
+
+			/// Returns whether to keep the result at the month's next rank, recording its signature if kept.
+			bool keep(const int month, const int rank, const double CRF, const int tenorCode, const int prevRank) {
+				// 0 is wait sentinel, which buys nothing so leaves the signature unchanged.
+				const int prevMonth = tenorCode == 0 ? month - 1 : month - tenorList_[tenorCode - 1];
+				const std::uint64_t prevSignature = signatures_[prevMonth % window_, prevRank];
+				const std::uint64_t signature = tenorCode == 0
+					? prevSignature
+					: (std::rotl(prevSignature, 17) ^ static_cast<std::uint64_t>(tenorCode)) * signatureMultiplier;
+
+				// NaN never equals a CRF, so every row starts a new run:
+				if (CRF != runCRF_) {
+					runCRF_ = CRF;
+					runSignatures_.clear();
+				}
+				if (!runSignatures_.insert(signature)) {
+					return false;
+				}
+				signatures_[month % window_, rank] = signature;
+				return true;
+			}
+
+		private:
+			// Odd, so that multiplying by it mixes the tenors bought into every bit of the signature reversibly.
+			static constexpr std::uint64_t signatureMultiplier = 0x9E3779B97F4A7C15ULL;
+
+			/**
+			* The signatures seen in the current run of equal CRFs, held in an open-addressed table. Clearing only moves
+			* to a new generation rather than touching the table, since runs are usually short but the table may have
+			* grown large for a long one.
+			*/
+			class SignatureSet
+			{
+				public:
+					void clear() noexcept;
+					/// Adds signature, returning false if it was already present.
+					bool insert(std::uint64_t signature);
+
+				private:
+					struct Slot
+					{
+						std::uint64_t signature{};
+						std::uint32_t generation{}; // the slot is empty unless this is the current generation
+					};
+
+					std::vector<Slot> slots_{};
+					std::size_t size_ = 0;
+					std::uint32_t generation_ = 1;
+			};
+
+			const std::vector<int>& tenorList_;
+			int window_;
+			std::vector<std::uint64_t> signaturesBuffer_;
+			// Accessed as [month % window, rank], like the window of CRFs.
+			std::mdspan<std::uint64_t, std::dextents<std::size_t, 2>> signatures_;
+			double runCRF_ = std::numeric_limits<double>::quiet_NaN();
+			SignatureSet runSignatures_{};
+	};
+
+	/// Seeds month 0, which is reached with a CRF of 1 by having "waited", in the windowed CRFs.
+	template <typename CRFPolicy>
+	void seedBaseCase(const CRFsSpan& CRFs) {
+		for (std::size_t i = 0; i < CRFs.extent(1); ++i) {
+			CRFs[0, i] = -std::numeric_limits<double>::infinity();
+		}
+		CRFs[0, 0] = CRFPolicy::initialCRF;
+	}
+
+	/// Calls run(mergeEngine) with the merge engine selected, using the CRF policy selected by logSpace,
+	/// sized for the given number of tenors and results.
+	template <typename F>
+	void withMergeEngine(
+		const MergeEngine engine,
+		const bool logSpace,
+		const int numTenors,
+		const int numResultsRequested,
+		F&& run
+	) {
+		const auto withPolicy = [&]<typename CRFPolicy>() {
+			// There is a source for waiting, plus one per tenor.
+			const std::size_t maxSources = static_cast<std::size_t>(numTenors) + 1;
+			const unsigned int numThreads = Helpers::Parallel::availableThreads();
+			if (engine == MergeEngine::Heap) {
+				Merge::HeapEngine<CRFPolicy> mergeEngine(maxSources);
+				run(mergeEngine);
+			}
+			else if (
+				numThreads > 1
+				&& numResultsRequested >= 2 * Merge::ParallelEngine<CRFPolicy>::minResultsPerTask
+			) {
+				Merge::ParallelEngine<CRFPolicy> mergeEngine(maxSources, numThreads);
+				run(mergeEngine);
+			}
+			else if (engine == MergeEngine::Auto && maxSources <= 4) {
+				Merge::FixedEngine<CRFPolicy, 4> mergeEngine{};
+				run(mergeEngine);
+			}
+			else if (engine == MergeEngine::Auto && maxSources <= 8) {
+				Merge::FixedEngine<CRFPolicy, 8> mergeEngine{};
+				run(mergeEngine);
+			}
+			else if (engine == MergeEngine::Auto && maxSources <= 12) {
+				Merge::FixedEngine<CRFPolicy, 12> mergeEngine{};
+				run(mergeEngine);
+			}
+			else if (engine == MergeEngine::Auto && maxSources <= 16) {
+				Merge::FixedEngine<CRFPolicy, 16> mergeEngine{};
+				run(mergeEngine);
+			}
+			else {
+				Merge::LoserTreeEngine<CRFPolicy> mergeEngine(maxSources);
+				run(mergeEngine);
+			}
+		};
+		if (logSpace) {
+			withPolicy.template operator()<Merge::LogCRFs>();
+		}
+		else {
+			withPolicy.template operator()<Merge::ProductCRFs>();
+		}
+	}
+
+	/// Checks that every bond return bought by months firstMonth to lastMonth gives a positive factor, so has a
+	/// logarithm, throwing std::domain_error if not.
+	void assertLogSpaceValid(const Domain::BondReturnData& tenorData, int firstMonth, int lastMonth);
+
+	/**
+	* Runs the k-way merge for each month in [firstMonth, lastMonth], given that the windowed CRFs hold every
+	* month in the window before firstMonth, writing each month's top CRFs into the window and its decisions
+	* into row (month - decisionRowOffset) of the store. The window row of a month is month % window.
+	* Templated on the merge engine and store so that their inner loops inline into the merge.
+	*
+	* Each month's row of results found is passed to onRow(month, row) once written, before later months can
+	* overwrite it.
+	*
+	* Each result is only held if filter.keep(month, rank, CRF, tenorCode, prevRank) returns true, after
+	* filter.beginRow(month) for its month, the rank being the next of the month's row.
+	*/
+	template <
+		typename MergeEngine,
+		typename DecisionStore,
+		typename OnRow = IgnoreRows,
+		typename ResultFilter = AllResults
+	>
+	void runMonths(
+		const Domain::BondReturnData& tenorData,
+		const int numResultsRequested,
+		const CRFsSpan& CRFs,
+		const int firstMonth,
+		const int lastMonth,
+		MergeEngine& mergeEngine,
+		DecisionStore& decisions,
+		const int decisionRowOffset,
+		OnRow&& onRow = OnRow{},
+		ResultFilter&& filter = ResultFilter{}
+	) {
+		using Filter = std::remove_cvref_t<ResultFilter>;
+		using CRFPolicy = typename MergeEngine::Policy;
+		const int numTenors = tenorData.numTenors();
+		const auto& tenorList = tenorData.tenors();
+		const std::size_t window = CRFs.extent(0);
+		const auto rowCRFs = [&](const int month) {
+			return &CRFs[static_cast<std::size_t>(month) % window, 0];
+		};
+
+		// The lists to merge: waiting + each tenor that can end at the current month
+		const std::size_t maxSources = static_cast<std::size_t>(numTenors) + 1;
+		std::vector<Merge::Source> sources{};
+		sources.reserve(maxSources);
+		// Each source's predecessor's best CRF, gathered side by side with the month's row of factors, so that the
+		// first candidates (the heads) are formed and checked in one vectorised pass.
+		MaturityFactors<CRFPolicy> maturityFactors(tenorData, firstMonth, lastMonth);
+		std::vector<double> prevBestCRFs(maxSources);
+		std::vector<double> heads(maxSources);
+
+		for (int currentMonth = firstMonth; currentMonth <= lastMonth; ++currentMonth) {
+			double* const currentCRFs = rowCRFs(currentMonth);
+
+			// Reset the current months values, since they will be stale after the window first wraps:
+			Kernels::fillUnreached(currentCRFs, static_cast<std::size_t>(numResultsRequested));
+
+			// The sources are waiting then each tenor in turn, matching the order of the month's factors, so a source's
+			// tenor code is also its index:
+			const double* const factors = maturityFactors.row(currentMonth);
+			sources.clear();
+			const auto addSource = [&](const int prevMonth) {
+				const double* const prevCRFs = rowCRFs(prevMonth);
+				const int tenorCode = static_cast<int>(sources.size());
+				prevBestCRFs[sources.size()] = prevCRFs[0];
+				sources.push_back({prevCRFs, factors[tenorCode], tenorCode});
+			};
+			// Add the waiting list:
+			addSource(currentMonth - 1);
+			// Add the tenors lists, tenors being sorted, so stopping at the first too long to end here:
+			for (int i = 0; i < numTenors && tenorList[i] <= currentMonth; ++i) {
+				addSource(currentMonth - tenorList[i]);
+			}
+
+			// Note: the predecessors' best CRFs are never -inf, since we allow waiting there will always be
+			// at least one way to reach each month.
+			constexpr bool logSpace = std::is_same_v<CRFPolicy, Merge::LogCRFs>;
+			if (
+				const std::size_t overflowed = Kernels::combineHeads(
+					prevBestCRFs.data(), factors, heads.data(), sources.size(), logSpace
+				);
+				overflowed != sources.size()
+			) {
+				Merge::throwCRFOverflow(heads[overflowed], currentMonth);
+			}
+
+			// Extract the number of maximal results requested for this month:
+			int numResults = 0;
+			// Returns whether the result was kept, as std::true_type if every result is:
+			const auto emit = [&](const double CRF, const int tenorCode, const int prevRank) {
+				if constexpr (Filter::canSkip) {
+					if (!filter.keep(currentMonth, numResults, CRF, tenorCode, prevRank)) {
+						return false;
+					}
+					currentCRFs[numResults++] = CRF;
+					decisions.push(tenorCode, prevRank);
+					return true;
+				}
+				else {
+					currentCRFs[numResults++] = CRF;
+					decisions.push(tenorCode, prevRank);
+					return std::true_type{};
+				}
+			};
+			decisions.beginRow(currentMonth - decisionRowOffset);
+			filter.beginRow(currentMonth);
+			if (numResultsRequested == 1) {
+				// The only result is the greatest head (the first of equal heads, as the loser tree picks),
+				// so there is no need to build the tree (and a filter keeps the first result of a row):
+				const std::size_t best = Kernels::firstMaxIndex(heads.data(), sources.size());
+				emit(heads[best], sources[best].tenorCode, 0);
+				Instrumentation::countMerge(sources.size(), 1);
+			}
+			else {
+				mergeEngine.merge(
+					std::span<const Merge::Source>(sources),
+					std::span<const double>(heads).first(sources.size()),
+					numResultsRequested,
+					currentMonth,
+					emit
+				);
+			}
+			// Any unfilled tail remains at -inf CRF, and beyond the row's count in the decision store.
+			decisions.commitRow();
+			Instrumentation::recordMonthResults(currentMonth, numResults);
+			onRow(currentMonth, std::span<const double>(currentCRFs, static_cast<std::size_t>(numResults)));
+		}
+	}
+}
+
+#endif // BSO_APP_OPTIMISER_FORWARD_PASS_HPP
\ No newline at end of file
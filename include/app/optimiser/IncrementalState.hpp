@@ -0,0 +1,95 @@
+#ifndef BSO_APP_OPTIMISER_INCREMENTAL_STATE_HPP
+#define BSO_APP_OPTIMISER_INCREMENTAL_STATE_HPP
+
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <filesystem>
+#include <span>
+#include <variant>
+#include <vector>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+namespace DynamicOptimiser
+{
+	/// A new bond return for the bond of the given tenor (in months) bought at the given month.
+	struct ReturnEdit
+	{
+		int tenor{};
+		int month{};
+		double bondReturn{};
+	};
+
+	/**
+	* The optimiser's full state after running over every month, which can be re-run after editing a few bond returns,
+	* such as to bump each in turn for sensitivity analysis, recomputing only the months an edit can reach.
+	*
+	* A bond bought at month s with tenor t only enters the merge of month s + t, so no month before the earliest such
+	* maturity can change. Unlike OptimiserState, every month's row of CRFs is kept rather than a window, so that each
+	* month from there can be re-run on its own from the rows it reads. A month is only re-run if it is an edited
+	* bond's maturity, or one of the months it reads from changed, and it changed only if its CRFs or decisions differ
+	* from before. Once a whole window of months (the longest tenor's) has passed unchanged, with no edited maturities
+	* to come, no later month can change, and the rest are skipped. The results are exactly those of running
+	* getOptimalSequences over the edited returns from the start.
+	*
+	* Memory is (numMonths + 1) rows of CRFs on top of the decisions, so roughly twice a single run's with the Wide
+	* layout. OptimiserOptions::lowMemory and distinctPurchases cannot be used, and it always runs in double.
+	*/
+	class IncrementalState
+	{
+		public:
+			/// Runs the optimiser over every month of tenorData, throwing as getOptimalSequences does, or
+			/// std::invalid_argument if no results are requested or options.lowMemory or distinctPurchases is set.
+			IncrementalState(
+				const Domain::BondReturnData& tenorData,
+				int numResultsRequested,
+				const OptimiserOptions& options = {}
+			);
+
+			/**
+			* Applies the edits in order, then re-runs the months they can reach, returning the number of months re-run.
+			* Throws std::invalid_argument if any edit is for a tenor not held, a month beyond the data or a non-finite
+			* return, or std::domain_error if in log space and any return is -100% or below, in which case no edit is
+			* applied. If re-running throws (such as on overflow), the edits are undone and the months re-run before the
+			* failure are restored.
+			*/
+			int applyEdits(std::span<const ReturnEdit> edits);
+
+			/// Reconstructs the results into results, reusing the storage it already holds.
+			void results(OptimalResults& results) const;
+
+			/// As above, returning a new OptimalResults.
+			[[nodiscard]] OptimalResults results() const;
+
+			/// The bond return data with every edit so far applied.
+			[[nodiscard]] Domain::BondReturnData tenorData() const;
+
+			[[nodiscard]] const std::vector<int>& tenors() const noexcept { return tenors_; }
+			[[nodiscard]] int numMonths() const noexcept { return numMonths_; }
+			[[nodiscard]] int numResultsRequested() const noexcept { return numResultsRequested_; }
+			[[nodiscard]] bool logSpace() const noexcept { return logSpace_; }
+
+		private:
+			/// Re-runs the months from firstMonth that the edited maturities reach, returning the number re-run.
+			int rerunFrom(int firstMonth, const std::vector<char>& editedMaturities);
+
+			std::vector<int> tenors_{};
+			int numMonths_ = 0;
+			int numResultsRequested_ = 0;
+			bool logSpace_ = false;
+			MergeEngine mergeEngine_ = MergeEngine::LoserTree;
+			// The bond returns with every edit applied, row-major by tenor as in BondReturnData.
+			std::vector<double> grid_{};
+			std::filesystem::path dataPath_{};
+			// Every month's row of CRFs, accessed as [month, rank].
+			std::vector<double> CRFs_{};
+			std::variant<WideDecisionStore, PackedDecisionStore> decisions_{WideDecisionStore(0, 0, 0)};
+	};
+}
+
+#endif // BSO_APP_OPTIMISER_INCREMENTAL_STATE_HPP
\ No newline at end of file
@@ -0,0 +1,645 @@
+#ifndef BSO_APP_OPTIMISER_K_WAY_MERGE_HPP
+#define BSO_APP_OPTIMISER_K_WAY_MERGE_HPP
+
+#include "app/instrumentation/Instrumentation.hpp"
+#include "helpers/Parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+* Each month's results are found by a k-way merge over its "sources": waiting from the previous month, and buying each
+* tenor which ends at the month from the month it was bought. A source's list of candidates is its predecessor month's
+* CRFs in rank order, each multiplied by the source's factor, so the lists are already sorted and the merge just has
+* to repeatedly take the best head. The merge engines here differ only in how they find that head.
+*
+* Engines are templated on a CRF policy, which sets how a candidate's CRF is built from its predecessor's:
+* ProductCRFs multiply by the factor (1 + return), and LogCRFs add log(1 + return) to the log of the CRF instead.
+*
+* Each result is passed to emit(CRF, tenorCode, prevRank), which returns whether it is kept, and only kept results
+* count towards the number requested, so that the caller may skip some (see ForwardPass::DistinctPurchases). An emit
+* returning std::true_type keeps every result, which engines needing to know the results' ranks up front rely on.
+*/
+
+namespace DynamicOptimiser::Merge
+{
+	/// Throws std::overflow_error, reporting that a CRF of value was reached by the given month.
+	[[noreturn]] void throwCRFOverflow(double value, int month);
+
+	/// CRFs as products of return factors, which can overflow on long horizons so are checked.
+	struct ProductCRFs
+	{
+		static constexpr double initialCRF = 1.0;
+		static constexpr bool canOverflow = true;
+
+		[[nodiscard]] static double factor(const double bondReturn) noexcept { return 1.0 + bondReturn; }
+
+		/// Combines without checking, for callers which check for overflow themselves.
+		[[nodiscard]] static double combine(const double prevCRF, const double factor) noexcept {
+			return prevCRF * factor;
+		}
+
+		/// Whether combining with factor keeps CRFs in order, so a source's list stays sorted.
+		[[nodiscard]] static bool preservesOrder(const double factor) noexcept { return factor > 0.0; }
+
+		[[nodiscard]] static double apply(const double prevCRF, const double factor, const int month) {
+			const double nextCRF = combine(prevCRF, factor);
+			if (std::isinf(nextCRF)) {
+				throwCRFOverflow(nextCRF, month);
+			}
+			return nextCRF;
+		}
+	};
+
+	/**
+	* CRFs as sums of log(1 + return), which rank identically to products (log being increasing) but cannot
+	* realistically overflow: each month adds at most log(DBL_MAX) ~ 709, so no check is needed. This requires every
+	* factor used to be positive, which the optimiser checks before running.
+	*/
+	struct LogCRFs
+	{
+		static constexpr double initialCRF = 0.0;
+		static constexpr bool canOverflow = false;
+
+		[[nodiscard]] static double factor(const double bondReturn) noexcept { return std::log1p(bondReturn); }
+
+		[[nodiscard]] static double combine(const double prevCRF, const double factor) noexcept {
+			return prevCRF + factor;
+		}
+
+		[[nodiscard]] static bool preservesOrder(double) noexcept { return true; }
+
+		[[nodiscard]] static double apply(const double prevCRF, const double factor, int) noexcept {
+			return combine(prevCRF, factor);
+		}
+	};
+
+	/// One of the lists being merged for a month.
+	struct Source
+	{
+		const double* prevCRFs{}; // row of the predecessor month's CRFs, -inf past the last result there
+		double factor{}; // factor applied to every CRF in the list by the CRF policy (that for a 0% return if waiting)
+		int tenorCode{}; // 0 = wait, i + 1 = buy tenor at index i (see Decision)
+	};
+
+	/// Returns the candidate CRF at rank in the source's list, or -inf if the list has run out (rank is always valid).
+	template <typename CRFPolicy>
+	[[nodiscard]] double candidateCRF(const Source& source, const int rank, const int month) {
+		const double prevCRF = source.prevCRFs[rank];
+		// Stop advancing if we reach the sentinel, no more results are available from that month.
+		if (prevCRF == -std::numeric_limits<double>::infinity()) {
+			return prevCRF;
+		}
+		return CRFPolicy::apply(prevCRF, source.factor, month);
+	}
+
+	/// As candidateCRF, but without checking for overflow, for candidates which are only compared.
+	template <typename CRFPolicy>
+	[[nodiscard]] double uncheckedCandidateCRF(const Source& source, const int rank) noexcept {
+		const double prevCRF = source.prevCRFs[rank];
+		if (prevCRF == -std::numeric_limits<double>::infinity()) {
+			return prevCRF;
+		}
+		return CRFPolicy::combine(prevCRF, source.factor);
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	/// Merges with a binary heap of candidates, doing a pop and a push per result.
+	/// The heap's storage is kept between months, so it is only allocated once per run.
+	template <typename CRFPolicy>
+	class HeapEngine
+	{
+		public:
+			using Policy = CRFPolicy;
+
+			explicit HeapEngine(const std::size_t maxSources) {
+				heap_.reserve(maxSources);
+			}
+
+			/// Emits up to numResultsRequested results in decreasing order of CRF via emit(CRF, tenorCode, prevRank),
+			/// returning how many were emitted. heads holds each source's first candidate, already checked.
+			template <typename Emit>
+			int merge(
+				const std::span<const Source> sources,
+				const std::span<const double> heads,
+				const int numResultsRequested,
+				const int month,
+				Emit&& emit
+			) {
+				// Counted for instrumentation only, so optimised away otherwise:
+				std::uint64_t numPushes = sources.size();
+				std::uint64_t numPops = 0;
+				heap_.clear();
+				for (std::size_t s = 0; s < sources.size(); ++s) {
+					// Note: the first CRF will never be -inf here, since we allow waiting there will always be
+					// at least one way to reach each month.
+					heap_.push_back({heads[s], static_cast<int>(s), 0});
+					std::ranges::push_heap(heap_, {}, &Candidate::CRF);
+				}
+
+				int numResults = 0;
+				while (numResults < numResultsRequested && !heap_.empty()) {
+					std::ranges::pop_heap(heap_, {}, &Candidate::CRF);
+					const Candidate top = heap_.back();
+					heap_.pop_back();
+					++numPops;
+
+					const Source& source = sources[top.source];
+					if (emit(top.CRF, source.tenorCode, top.rank)) {
+						++numResults;
+					}
+
+					// Advance the list the current maximal head came from:
+					if (const int nextRank = top.rank + 1; nextRank < numResultsRequested) {
+						if (const double nextCRF = candidateCRF<CRFPolicy>(source, nextRank, month);
+							nextCRF != -std::numeric_limits<double>::infinity()
+						) {
+							heap_.push_back({nextCRF, top.source, nextRank});
+							std::ranges::push_heap(heap_, {}, &Candidate::CRF);
+							++numPushes;
+						}
+					}
+				}
+				Instrumentation::countMerge(numPushes, numPops);
+				return numResults;
+			}
+
+		private:
+			struct Candidate
+			{
+				double CRF{}; // candidate cumulative return factor at current month
+				int source{}; // index of the source the candidate came from
+				int rank{}; // rank in the source's predecessor row
+			};
+
+			std::vector<Candidate> heap_{};
+	};
+
+	/**
+	* Merges with a loser tree: a complete binary tree over one leaf per source, where each internal node holds the
+	* leaf which lost the match played there, and the overall winner is kept above the root. Replacing the winner
+	* with the next candidate from its source only replays the matches on its path to the root, one comparison per
+	* level, rather than the two per level of sifting a heap down after a pop and then up after a push.
+	*
+	* Equal CRFs are won by the source with the lower index (waiting, then shorter tenors), so ties are deterministic.
+	* The tree is sized once for the run and rebuilt in place each month.
+	*/
+	template <typename CRFPolicy>
+	class LoserTreeEngine
+	{
+		public:
+			using Policy = CRFPolicy;
+
+			explicit LoserTreeEngine(const std::size_t maxSources) :
+				numLeaves_(std::bit_ceil(std::max<std::size_t>(maxSources, 2))),
+				leaves_(numLeaves_),
+				tree_(numLeaves_),
+				winners_(2 * numLeaves_)
+			{}
+
+			/// Emits up to numResultsRequested results in decreasing order of CRF via emit(CRF, tenorCode, prevRank),
+			/// returning how many were emitted. heads holds each source's first candidate, already checked.
+			template <typename Emit>
+			int merge(
+				const std::span<const Source> sources,
+				const std::span<const double> heads,
+				const int numResultsRequested,
+				const int month,
+				Emit&& emit
+			) {
+				build(sources.size(), [&](const std::size_t s) { return Leaf{heads[s], 0}; });
+				return run(sources, [&](std::size_t) { return numResultsRequested; }, numResultsRequested, month, emit);
+			}
+
+			/// As merge, but emits exactly ranks [begins[s], ends[s]) of each source's list, in the order merge would.
+			template <typename Emit>
+			int mergeRanks(
+				const std::span<const Source> sources,
+				const std::span<const int> begins,
+				const std::span<const int> ends,
+				const int month,
+				Emit&& emit
+			) {
+				int numResults = 0;
+				build(sources.size(), [&](const std::size_t s) {
+					numResults += ends[s] - begins[s];
+					return Leaf{
+						begins[s] < ends[s]
+							? candidateCRF<CRFPolicy>(sources[s], begins[s], month)
+							: -std::numeric_limits<double>::infinity(),
+						begins[s]
+					};
+				});
+				return run(sources, [&](const std::size_t s) { return ends[s]; }, numResults, month, emit);
+			}
+
+		private:
+			struct Leaf
+			{
+				double CRF{}; // head of the source's list, -inf once it has run out (or for padding leaves)
+				int rank{}; // rank of the head in the source's predecessor row
+			};
+
+			[[nodiscard]] bool beats(const int a, const int b) const noexcept {
+				return leaves_[a].CRF > leaves_[b].CRF || (leaves_[a].CRF == leaves_[b].CRF && a < b);
+			}
+
+			/// Sets each leaf to the head of its source given by leafOf(s), and plays every match bottom-up to fill in
+			/// the losers.
+			template <typename LeafOf>
+			void build(const std::size_t numSources, LeafOf&& leafOf) {
+				for (std::size_t s = 0; s < numLeaves_; ++s) {
+					leaves_[s] = s < numSources
+						? leafOf(s)
+						: Leaf{-std::numeric_limits<double>::infinity(), 0};
+					winners_[numLeaves_ + s] = static_cast<int>(s);
+				}
+				for (std::size_t node = numLeaves_ - 1; node > 0; --node) {
+					const int left = winners_[2 * node];
+					const int right = winners_[2 * node + 1];
+					const bool leftWins = beats(left, right);
+					winners_[node] = leftWins ? left : right;
+					tree_[node] = leftWins ? right : left;
+				}
+				tree_[0] = winners_[1];
+			}
+
+			/// Emits up to numResultsRequested results from the tree as built, each source's list ending before rank
+			/// endOf(s).
+			template <typename EndOf, typename Emit>
+			int run(
+				const std::span<const Source> sources,
+				EndOf&& endOf,
+				const int numResultsRequested,
+				const int month,
+				Emit&& emit
+			) {
+				// A candidate is pushed when it enters a leaf, and popped when it wins, as for a heap:
+				std::uint64_t numPushes = 0;
+				std::uint64_t numPops = 0;
+				if constexpr (Instrumentation::enabled) {
+					numPushes = static_cast<std::uint64_t>(std::ranges::count_if(
+						std::span(leaves_).first(sources.size()),
+						[](const Leaf& leaf) { return leaf.CRF != -std::numeric_limits<double>::infinity(); }
+					));
+				}
+
+				int numResults = 0;
+				while (numResults < numResultsRequested) {
+					int winner = tree_[0];
+					Leaf& leaf = leaves_[winner];
+					if (leaf.CRF == -std::numeric_limits<double>::infinity()) {
+						break;
+					}
+					++numPops;
+
+					const Source& source = sources[winner];
+					if (emit(leaf.CRF, source.tenorCode, leaf.rank)) {
+						++numResults;
+					}
+
+					// Replace the winner with the next candidate from its list, and replay its path to the root:
+					++leaf.rank;
+					leaf.CRF = leaf.rank < endOf(static_cast<std::size_t>(winner))
+						? candidateCRF<CRFPolicy>(source, leaf.rank, month)
+						: -std::numeric_limits<double>::infinity();
+					if (leaf.CRF != -std::numeric_limits<double>::infinity()) {
+						++numPushes;
+					}
+					for (std::size_t node = (static_cast<std::size_t>(winner) + numLeaves_) / 2; node > 0; node /= 2) {
+						if (beats(tree_[node], winner)) {
+							std::swap(tree_[node], winner);
+						}
+					}
+					tree_[0] = winner;
+				}
+				Instrumentation::countMerge(numPushes, numPops);
+				return numResults;
+			}
+
+			std::size_t numLeaves_;
+			std::vector<Leaf> leaves_;
+			// tree_[0] holds the overall winner, and tree_[node] the loser at each internal node (1 is the root).
+			std::vector<int> tree_;
+			// Scratch for the winner of each subtree while building.
+			std::vector<int> winners_;
+	};
+
+	/**
+	* Merges at most MaxSources sources by replaying the whole tournament over a fixed-size array of heads for each
+	* result, padded with -inf. With few sources, the MaxSources - 1 matches, unrolled and branchless in registers,
+	* are faster than replaying the loser tree's path, whose matches are each a branch on the previous one's loser.
+	* Equal CRFs are won by the source with the lower index, as in the loser tree, so the results are the same.
+	*/
+	template <typename CRFPolicy, std::size_t MaxSources>
+	class FixedEngine
+	{
+		public:
+			using Policy = CRFPolicy;
+			static constexpr std::size_t maxSources = MaxSources;
+
+			/// Emits up to numResultsRequested results in decreasing order of CRF via emit(CRF, tenorCode, prevRank),
+			/// returning how many were emitted. heads holds each source's first candidate, already checked, and there
+			/// are at most MaxSources sources.
+			template <typename Emit>
+			int merge(
+				const std::span<const Source> sources,
+				const std::span<const double> heads,
+				const int numResultsRequested,
+				const int month,
+				Emit&& emit
+			) {
+				std::array<double, MaxSources> CRFs{};
+				std::array<int, MaxSources> ranks{};
+				CRFs.fill(-std::numeric_limits<double>::infinity());
+				std::ranges::copy(heads, CRFs.begin());
+				// Counted as for a heap, for instrumentation only:
+				std::uint64_t numPushes = heads.size();
+				std::uint64_t numPops = 0;
+
+				int numResults = 0;
+				while (numResults < numResultsRequested) {
+					const auto [winnerCRF, winner] = winnerOf<0, MaxSources>(CRFs);
+					if (winnerCRF == -std::numeric_limits<double>::infinity()) {
+						break;
+					}
+					++numPops;
+
+					const Source& source = sources[winner];
+					if (emit(winnerCRF, source.tenorCode, ranks[winner])) {
+						++numResults;
+					}
+
+					// Replace the winner with the next candidate from its list:
+					const int nextRank = ++ranks[winner];
+					CRFs[winner] = nextRank < numResultsRequested
+						? candidateCRF<CRFPolicy>(source, nextRank, month)
+						: -std::numeric_limits<double>::infinity();
+					if (CRFs[winner] != -std::numeric_limits<double>::infinity()) {
+						++numPushes;
+					}
+				}
+				Instrumentation::countMerge(numPushes, numPops);
+				return numResults;
+			}
+
+		private:
+			struct Entrant
+			{
+				double CRF{};
+				std::size_t source{};
+			};
+
+			/// The index of the first greatest of CRFs[First, First + Count), by a tournament of pairs of halves.
+			template <std::size_t First, std::size_t Count>
+			[[nodiscard]] static Entrant winnerOf(const std::array<double, MaxSources>& CRFs) noexcept {
+				if constexpr (Count == 1) {
+					return {CRFs[First], First};
+				}
+				else {
+					const Entrant left = winnerOf<First, Count / 2>(CRFs);
+					const Entrant right = winnerOf<First + Count / 2, Count - Count / 2>(CRFs);
+					// Selected field by field, which compiles to conditional moves rather than a branch:
+					const bool rightWins = right.CRF > left.CRF;
+					return {rightWins ? right.CRF : left.CRF, rightWins ? right.source : left.source};
+				}
+			}
+	};
+
+	/**
+	* Splits each month's merge across threads by rank: the results are divided into contiguous ranges of ranks, each
+	* merged as its own task. A range's results are exactly those ranked between the results at either end of it, so
+	* each end is found by selection before merging: bisecting over CRFs (by the ordered bit patterns of doubles) for
+	* the CRF at that rank, then counting how many candidates each source has above it, by binary search since each
+	* source's list is sorted, and giving equal candidates to sources in index order. Each task then merges only the
+	* candidates between its two ends, and the results are emitted in order once every task has finished.
+	*
+	* Results and ties are exactly as from the loser tree, each task merging its range with one of its own. Months with
+	* too few results to split, with a source whose factor would reverse its list (a return of -100% or below), or
+	* whose results may not all be kept, are merged by a loser tree on the calling thread instead.
+	* The pool's threads are kept for the whole run, rather than started each month.
+	*/
+	template <typename CRFPolicy>
+	class ParallelEngine
+	{
+		public:
+			using Policy = CRFPolicy;
+
+			// Each task merges at least this many results, enough that finding its ends costs little in comparison.
+			static constexpr int minResultsPerTask = 1 << 14;
+			// Each thread is given several tasks, so that threads finishing early can take over the remainder.
+			static constexpr unsigned int tasksPerThread = 4;
+
+			ParallelEngine(const std::size_t maxSources, const unsigned int numThreads) :
+				serialEngine_(maxSources),
+				taskEngines_(static_cast<std::size_t>(numThreads) * tasksPerThread, serialEngine_),
+				pool_(numThreads)
+			{}
+
+			/// Emits up to numResultsRequested results in decreasing order of CRF via emit(CRF, tenorCode, prevRank),
+			/// returning how many were emitted. heads holds each source's first candidate, already checked.
+			template <typename Emit>
+			int merge(
+				const std::span<const Source> sources,
+				const std::span<const double> heads,
+				const int numResultsRequested,
+				const int month,
+				Emit&& emit
+			) {
+				const std::size_t numSources = sources.size();
+				// Ranks can only be split up front if every result is kept:
+				constexpr bool keepsEvery = std::is_same_v<
+					std::invoke_result_t<Emit&, double, int, int>, std::true_type
+				>;
+				if (
+					!keepsEvery
+					|| !std::ranges::all_of(sources, [](const Source& source) {
+						return CRFPolicy::preservesOrder(source.factor);
+					})
+				) {
+					return serialEngine_.merge(sources, heads, numResultsRequested, month, emit);
+				}
+
+				// Each source's list runs out where its predecessor's row does (the rows being sorted, with -inf past
+				// the last result):
+				listLengths_.resize(numSources);
+				std::int64_t numAvailable = 0;
+				for (std::size_t s = 0; s < numSources; ++s) {
+					const double* const prevCRFs = sources[s].prevCRFs;
+					listLengths_[s] = static_cast<int>(
+						std::ranges::partition_point(
+							prevCRFs,
+							prevCRFs + numResultsRequested,
+							[](const double CRF) { return CRF != -std::numeric_limits<double>::infinity(); }
+						) - prevCRFs
+					);
+					numAvailable += listLengths_[s];
+				}
+				const int numResults = static_cast<int>(std::min<std::int64_t>(numAvailable, numResultsRequested));
+
+				const std::size_t numTasks = std::min<std::size_t>(
+					static_cast<std::size_t>(numResults / minResultsPerTask), taskEngines_.size()
+				);
+				if (numTasks < 2) {
+					return serialEngine_.merge(sources, heads, numResultsRequested, month, emit);
+				}
+
+				// Task t merges ranks [firstRank(t), firstRank(t + 1)), taking ranks [splits_[t, s], splits_[t + 1, s])
+				// of each source s's list.
+				const auto firstRank = [&](const std::size_t task) {
+					return static_cast<int>(
+						static_cast<std::int64_t>(numResults) * static_cast<std::int64_t>(task)
+						/ static_cast<std::int64_t>(numTasks)
+					);
+				};
+				splits_.resize((numTasks + 1) * numSources);
+				const auto taskSplits = [&](const std::size_t task) {
+					return std::span(splits_).subspan(task * numSources, numSources);
+				};
+				pool_.forEachTask(numTasks + 1, [&](const std::size_t task) {
+					split(sources, firstRank(task), taskSplits(task));
+				});
+
+				results_.resize(static_cast<std::size_t>(numResults));
+				pool_.forEachTask(numTasks, [&](const std::size_t task) {
+					Result* out = results_.data() + firstRank(task);
+					taskEngines_[task].mergeRanks(
+						sources,
+						std::span<const int>(taskSplits(task)),
+						std::span<const int>(taskSplits(task + 1)),
+						month,
+						[&](const double CRF, const int tenorCode, const int prevRank) {
+							*out++ = {CRF, tenorCode, prevRank};
+							return std::true_type{};
+						}
+					);
+				});
+
+				// The loser tree would also have formed the next candidate of each list, so overflows there as well:
+				if constexpr (CRFPolicy::canOverflow) {
+					const std::span<const int> ends = taskSplits(numTasks);
+					for (std::size_t s = 0; s < numSources; ++s) {
+						if (ends[s] < numResultsRequested) {
+							static_cast<void>(candidateCRF<CRFPolicy>(sources[s], ends[s], month));
+						}
+					}
+				}
+
+				for (const auto& [CRF, tenorCode, prevRank] : results_) {
+					emit(CRF, tenorCode, prevRank);
+				}
+				return numResults;
+			}
+
+		private:
+			struct Result
+			{
+				double CRF{};
+				int tenorCode{};
+				int prevRank{};
+			};
+
+			/// Maps doubles to unsigned integers in the same order (-0 just below +0), so CRFs can be bisected.
+			[[nodiscard]] static std::uint64_t orderedBits(const double value) noexcept {
+				const auto bits = std::bit_cast<std::uint64_t>(value);
+				return bits >> 63 ? ~bits : bits | (std::uint64_t{1} << 63);
+			}
+
+			[[nodiscard]] static double fromOrderedBits(const std::uint64_t key) noexcept {
+				return std::bit_cast<double>(key >> 63 ? key & ~(std::uint64_t{1} << 63) : ~key);
+			}
+
+			/// The number of candidates in a source's list with a CRF of at least (or, if strictly, above) value.
+			[[nodiscard]] int countFrom(
+				const Source& source,
+				const int listLength,
+				const double value,
+				const bool strictly
+			) const noexcept {
+				const auto ranks = std::views::iota(0, listLength);
+				return static_cast<int>(
+					std::ranges::partition_point(ranks, [&](const int rank) {
+						const double CRF = uncheckedCandidateCRF<CRFPolicy>(source, rank);
+						return strictly ? CRF > value : CRF >= value;
+					}) - ranks.begin()
+				);
+			}
+
+			/// Sets splits[s] to the number of candidates each source contributes to the first rank results.
+			void split(
+				const std::span<const Source> sources,
+				const int rank,
+				const std::span<int> splits
+			) const noexcept {
+				if (rank == 0) {
+					std::ranges::fill(splits, 0);
+					return;
+				}
+				const auto countAtLeast = [&](const double value) {
+					std::int64_t count = 0;
+					for (std::size_t s = 0; s < sources.size(); ++s) {
+						count += countFrom(sources[s], listLengths_[s], value, false);
+					}
+					return count;
+				};
+
+				// The result at rank - 1 has the greatest CRF with at least rank candidates at or above it, which lies
+				// between the lowest and highest candidates of any list:
+				std::uint64_t low = std::numeric_limits<std::uint64_t>::max();
+				std::uint64_t high = 0;
+				for (std::size_t s = 0; s < sources.size(); ++s) {
+					if (const int listLength = listLengths_[s]; listLength > 0) {
+						low = std::min(low, orderedBits(uncheckedCandidateCRF<CRFPolicy>(sources[s], listLength - 1)));
+						high = std::max(high, orderedBits(uncheckedCandidateCRF<CRFPolicy>(sources[s], 0)));
+					}
+				}
+				while (low < high) {
+					const std::uint64_t mid = low + (high - low + 1) / 2;
+					if (countAtLeast(fromOrderedBits(mid)) >= rank) {
+						low = mid;
+					}
+					else {
+						high = mid - 1;
+					}
+				}
+				const double pivot = fromOrderedBits(low);
+
+				// Every candidate above the pivot is taken, then as many equal to it as needed, lower sources first:
+				std::int64_t remaining = rank;
+				for (std::size_t s = 0; s < sources.size(); ++s) {
+					splits[s] = countFrom(sources[s], listLengths_[s], pivot, true);
+					remaining -= splits[s];
+				}
+				for (std::size_t s = 0; s < sources.size() && remaining > 0; ++s) {
+					const int numEqual = countFrom(sources[s], listLengths_[s], pivot, false) - splits[s];
+					const int taken = static_cast<int>(std::min<std::int64_t>(numEqual, remaining));
+					splits[s] += taken;
+					remaining -= taken;
+				}
+			}
+
+			LoserTreeEngine<CRFPolicy> serialEngine_;
+			// One loser tree per task, each merging its range of ranks.
+			std::vector<LoserTreeEngine<CRFPolicy>> taskEngines_{};
+			Helpers::Parallel::WorkerPool pool_;
+			// The number of candidates in each source's list this month.
+			std::vector<int> listLengths_{};
+			// The split of each source's list at the start of each task, and at the end of the last.
+			std::vector<int> splits_{};
+			// The month's results, written by rank by each task.
+			std::vector<Result> results_{};
+	};
+}
+
+#endif // BSO_APP_OPTIMISER_K_WAY_MERGE_HPP
\ No newline at end of file
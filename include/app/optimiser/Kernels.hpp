@@ -0,0 +1,35 @@
+#ifndef BSO_APP_OPTIMISER_KERNELS_HPP
+#define BSO_APP_OPTIMISER_KERNELS_HPP
+
+#include <cstddef>
+
+/*
+* The optimiser's per-month loops over whole rows, written so that the compiler vectorises them (in optimised builds,
+* such as CMake's Release), and built for each instruction set available at runtime (see BSO_TARGET_CLONES in
+* "include/helpers/Platform.hpp"). With many tenors and few results requested, these make up most of each month's
+* work. They are internal to the optimiser, and not for use elsewhere.
+*/
+
+namespace DynamicOptimiser::Kernels
+{
+	/// Sets count CRFs to -inf, the sentinel for ranks with no result (yet).
+	void fillUnreached(double* CRFs, std::size_t count) noexcept;
+
+	/**
+	* Sets each head to its predecessor's best CRF combined with its factor, as products (or sums if logSpace), for
+	* count sources. Returns the index of the first head which is infinite, so has overflowed (only possible for
+	* products), or count if none is. The check is one pass over the heads, rather than a branch per head.
+	*/
+	[[nodiscard]] std::size_t combineHeads(
+		const double* prevCRFs,
+		const double* factors,
+		double* heads,
+		std::size_t count,
+		bool logSpace
+	) noexcept;
+
+	/// Returns the index of the greatest of count (>= 1) values, the first if several are equal.
+	[[nodiscard]] std::size_t firstMaxIndex(const double* values, std::size_t count) noexcept;
+}
+
+#endif // BSO_APP_OPTIMISER_KERNELS_HPP
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef BSO_APP_OPTIMISER_MATURITY_FACTORS_HPP
+#define BSO_APP_OPTIMISER_MATURITY_FACTORS_HPP
+
+#include "app/domain/BondReturnData.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/*
+* A month-major view of the factors each month's sources apply, for the optimiser's forward pass. This is internal
+* to the optimiser, and not for use elsewhere.
+*/
+
+namespace DynamicOptimiser::Detail
+{
+	/**
+	* The factors of every source for each month, by the CRF policy: waiting's first, then each tenor's in order. Bond
+	* returns are held by the month a bond is bought (see BondReturnData), so a month's tenors would otherwise be read
+	* from a different month of each tenor's row, a cache line per tenor. Here they are held by the month the bond
+	* matures instead, so that a month's factors are one contiguous row, the same layout the heads are formed in.
+	*
+	* Rows are filled a block of months at a time, reading each tenor's returns for the block in order, so that the
+	* transpose stays within cache, and only one block is held at a time rather than a copy of the whole grid.
+	*/
+	template <typename CRFPolicy>
+	class MaturityFactors
+	{
+		public:
+			static constexpr int monthsPerBlock = 64;
+
+			/// Prepares to read the factors of months firstMonth to lastMonth, holding no more rows than those.
+			MaturityFactors(const Domain::BondReturnData& tenorData, const int firstMonth, const int lastMonth) :
+				tenorData_(tenorData),
+				lastMonth_(lastMonth),
+				blockMonths_(std::clamp(lastMonth - firstMonth + 1, 1, monthsPerBlock)),
+				rowSize_(static_cast<std::size_t>(tenorData.numTenors()) + 1),
+				factors_(static_cast<std::size_t>(blockMonths_) * rowSize_)
+			{}
+
+			/// Returns the factors for the sources of month (firstMonth to lastMonth), in the order above. Only the
+			/// factors for tenors no longer than month are set. Months are fastest read in increasing order.
+			[[nodiscard]] const double* row(const int month) {
+				if (month < blockStart_ || month >= blockStart_ + blockMonths_) {
+					fillBlock(month);
+				}
+				return &factors_[static_cast<std::size_t>(month - blockStart_) * rowSize_];
+			}
+
+		private:
+			void fillBlock(const int firstMonth) {
+				blockStart_ = firstMonth;
+				const int lastMonth = std::min(firstMonth + blockMonths_ - 1, lastMonth_);
+				const auto& tenorList = tenorData_.tenors();
+				const std::size_t numMonths = static_cast<std::size_t>(tenorData_.numMonths());
+				const double* const grid = tenorData_.grid().data();
+
+				for (int month = firstMonth; month <= lastMonth; ++month) {
+					factors_[static_cast<std::size_t>(month - firstMonth) * rowSize_] = CRFPolicy::factor(0.0);
+				}
+				for (int i = 0; i < tenorData_.numTenors(); ++i) {
+					// The returns of bonds of this tenor maturing within the block, read in order:
+					const double* const tenorReturns = grid + static_cast<std::size_t>(i) * numMonths;
+					for (int month = std::max(firstMonth, tenorList[i]); month <= lastMonth; ++month) {
+						factors_[static_cast<std::size_t>(month - firstMonth) * rowSize_ + i + 1] =
+							CRFPolicy::factor(tenorReturns[month - tenorList[i]]);
+					}
+				}
+			}
+
+			const Domain::BondReturnData& tenorData_;
+			int lastMonth_;
+			int blockMonths_;
+			std::size_t rowSize_;
+			// Rows for months [blockStart_, blockStart_ + blockMonths_), row-major.
+			std::vector<double> factors_;
+			int blockStart_ = -monthsPerBlock;
+	};
+}
+
+#endif // BSO_APP_OPTIMISER_MATURITY_FACTORS_HPP
\ No newline at end of file
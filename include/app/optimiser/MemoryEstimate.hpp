@@ -0,0 +1,84 @@
+#ifndef BSO_APP_OPTIMISER_MEMORY_ESTIMATE_HPP
+#define BSO_APP_OPTIMISER_MEMORY_ESTIMATE_HPP
+
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <cstddef>
+#include <optional>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+namespace DynamicOptimiser
+{
+	/**
+	* The memory a run of getOptimalSequences (or streamOptimalSequences) needs at its peak, in bytes, known from the
+	* problem's size before anything is allocated. Each part is an upper bound: decisions as if every month found every
+	* result, and paths as if every result bought the shortest tenor throughout.
+	*/
+	struct MemoryEstimate
+	{
+		// The decision store.
+		std::size_t decisionsBytes = 0;
+		// The window of CRFs, with lowMemory's snapshots of it, and distinctPurchases' window of signatures.
+		std::size_t CRFsBytes = 0;
+		// The paths being reconstructed (or, streamed, one block of them) together with the results they are joined
+		// into, and the results' CRFs and offsets.
+		std::size_t resultsBytes = 0;
+
+		[[nodiscard]] std::size_t total() const noexcept { return decisionsBytes + CRFsBytes + resultsBytes; }
+	};
+
+	/// Estimates the memory a run for numResultsRequested results needs with the given options, with pathsStreamed
+	/// set for streamOptimalSequences, which only holds one block of paths at a time.
+	[[nodiscard]] MemoryEstimate estimateMemory(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const OptimiserOptions& options = {},
+		bool pathsStreamed = false
+	) noexcept;
+
+	/// A run as adjusted by admitRun to fit a memory budget, and what was changed to fit.
+	struct Admission
+	{
+		OptimiserOptions options{};
+		int numResultsRequested = 0;
+		// The estimates for the run as requested and as adjusted.
+		MemoryEstimate requestedEstimate{};
+		MemoryEstimate estimate{};
+		std::size_t budgetBytes = 0;
+		// Whether the run as adjusted fits the budget, which it may not even for a single result.
+		bool fits = false;
+		// Which of the fallbacks were taken, in the order they are tried:
+		bool packedDecisions = false;
+		bool lowMemory = false;
+		bool cappedResults = false;
+
+		/// Whether the run was changed at all.
+		[[nodiscard]] bool adjusted() const noexcept { return packedDecisions || lowMemory || cappedResults; }
+	};
+
+	/**
+	* Fits a run into budgetBytes before it allocates anything, rather than leaving it to fail with std::bad_alloc
+	* partway through. If the run as requested is estimated to exceed the budget, each cheaper way of running it is tried
+	* in turn, none of which change the results: the Packed decision layout (unless Wide was asked for), then
+	* checkpointing with lowMemory (unless distinctPurchases is set). If the run still does not fit, numResultsRequested
+	* is cut to the most results that do, which returns the best of the results requested.
+	*/
+	[[nodiscard]] Admission admitRun(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const OptimiserOptions& options,
+		std::size_t budgetBytes,
+		bool pathsStreamed = false
+	) noexcept;
+
+	/// The budget to admit runs with by default: most of the memory available, leaving the rest for the rest of the
+	/// process and the system, or nothing if the memory available cannot be determined.
+	[[nodiscard]] std::optional<std::size_t> defaultMemoryBudget() noexcept;
+}
+
+#endif // BSO_APP_OPTIMISER_MEMORY_ESTIMATE_HPP
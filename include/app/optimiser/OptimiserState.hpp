@@ -0,0 +1,116 @@
+#ifndef BSO_APP_OPTIMISER_OPTIMISER_STATE_HPP
+#define BSO_APP_OPTIMISER_OPTIMISER_STATE_HPP
+
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/ResultDAG.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+namespace DynamicOptimiser
+{
+	/// The extension for saved optimiser state files, the sidecar for an input adds this to the input's full filename.
+	inline constexpr std::string_view optimiserStateExtension = "bsos";
+
+	/// Thrown if a saved optimiser state file cannot be read, is malformed, or is inconsistent.
+	struct OptimiserStateError final : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	/**
+	* The optimiser's state after running over some number of months, which can be extended as further months of data
+	* arrive without re-running the months before, and saved to disk to be extended by a later run.
+	*
+	* The forward pass reaches each month from at most the longest tenor's months before, so the state holds only that
+	* window of CRFs, along with every month's decisions (needed to reconstruct the paths), and the most recent bond
+	* returns that months still to come may buy. Extending by a month then costs the same as any month of a full run,
+	* O(n + k) merge steps rather than O(m * (n + k)) to re-run from month 0. The results are exactly those of running
+	* getOptimalSequences over all the months at once.
+	*
+	* Every month's decisions are kept, so OptimiserOptions::lowMemory cannot be used. With DecisionLayout::Auto, the
+	* layout is chosen for the months in the initial run.
+	*/
+	class OptimiserState
+	{
+		public:
+			/// Runs the optimiser over every month of tenorData, throwing as getOptimalSequences does, or
+			/// std::invalid_argument if no results are requested or options.lowMemory or distinctPurchases is set.
+			OptimiserState(
+				const Domain::BondReturnData& tenorData,
+				int numResultsRequested,
+				const OptimiserOptions& options = {}
+			);
+
+			/// Returns whether tenorData is a continuation of the months run so far: the same tenors, at least as many
+			/// months, and the same bond returns in every month that months still to run may buy.
+			[[nodiscard]] bool canExtendWith(const Domain::BondReturnData& tenorData) const;
+
+			/// Runs the months of tenorData after those already run, throwing std::invalid_argument if it is not a
+			/// continuation of them (see canExtendWith), or as getOptimalSequences does.
+			void extend(const Domain::BondReturnData& tenorData);
+
+			/// Reconstructs the results for the months run so far into results, reusing the storage it already holds.
+			void results(OptimalResults& results) const;
+
+			/// As above, but only the top maxResults, which are exactly those a run requesting that many would find.
+			void results(OptimalResults& results, int maxResults) const;
+
+			/// As above, returning a new OptimalResults.
+			[[nodiscard]] OptimalResults results() const;
+
+			/// The top maxResults results for the months run so far as a ResultDAG, rather than unfolding every path.
+			[[nodiscard]] ResultDAG resultDAG(int maxResults) const;
+
+			[[nodiscard]] const std::vector<int>& tenors() const noexcept { return tenors_; }
+			[[nodiscard]] int numMonths() const noexcept { return numMonths_; }
+			[[nodiscard]] int numResultsRequested() const noexcept { return numResultsRequested_; }
+			[[nodiscard]] bool logSpace() const noexcept { return logSpace_; }
+
+			/// Writes the state to the given path, throwing std::ios_base::failure if writing fails.
+			/// Files are specific to the byte order of the machine that wrote them.
+			void save(const std::filesystem::path& statePath) const;
+
+			/// Reads a state written by save(), throwing an OptimiserStateError if the file is invalid.
+			[[nodiscard]] static OptimiserState load(const std::filesystem::path& statePath);
+
+		private:
+			OptimiserState() = default;
+
+			/// The number of rows in the CRFs window, which unlike a single run is not limited by the horizon,
+			/// since the horizon may grow.
+			[[nodiscard]] std::size_t window() const noexcept {
+				return static_cast<std::size_t>(tenors_.back()) + 1;
+			}
+
+			/// The first month of bond returns that months still to run may buy.
+			[[nodiscard]] int firstRecentMonth() const noexcept;
+
+			/// Copies the bond returns that months still to run may buy from tenorData.
+			void keepRecentReturns(const Domain::BondReturnData& tenorData);
+
+			std::vector<int> tenors_{};
+			int numResultsRequested_ = 0;
+			int numMonths_ = 0;
+			bool logSpace_ = false;
+			MergeEngine mergeEngine_ = MergeEngine::LoserTree;
+			// The CRFs window as in a single run, accessed as [month % window(), rank].
+			std::vector<double> CRFs_{};
+			// Bond returns from firstRecentMonth() to numMonths_ - 1, row-major by tenor as in BondReturnData.
+			std::vector<double> recentReturns_{};
+			std::variant<WideDecisionStore, PackedDecisionStore> decisions_{WideDecisionStore(0, 0, 0)};
+	};
+}
+
+#endif // BSO_APP_OPTIMISER_OPTIMISER_STATE_HPP
\ No newline at end of file
@@ -0,0 +1,360 @@
+#ifndef BSO_APP_OPTIMISER_PATH_RECONSTRUCTION_HPP
+#define BSO_APP_OPTIMISER_PATH_RECONSTRUCTION_HPP
+
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/ResultDAG.hpp"
+#include "helpers/Parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*
+* Reconstructs the optimiser's results by walking each one's chain of decisions back from the final month, shared
+* between the ways of running the optimiser. These are internal to the optimiser, and not for use elsewhere.
+*/
+
+namespace DynamicOptimiser::Detail::PathReconstruction
+{
+	// Paths are only reconstructed across threads in chunks of at least this many ranks, since each walk is
+	// short, and below this the cost of starting a thread outweighs the walks it would save.
+	constexpr std::size_t minRanksPerThread = 1024;
+	// Streamed results are walked this many ranks at a time, enough to split across threads.
+	constexpr int ranksPerStreamedBlock = 1 << 16;
+
+	/**
+	* Walks one result's chain of decisions back from the final month, appending its InvestmentActions to a
+	* buffer in reverse order. The walk may be done in stages, each covering the months of whichever rows of
+	* decisions are currently available, carrying any unfinished period of waiting between them.
+	*/
+	class PathWalker
+	{
+		public:
+			PathWalker(const int finalMonth, const int finalRank) noexcept :
+				currentMonth_(finalMonth),
+				rank_(finalRank)
+			{}
+
+			/// Walks back until reaching stopMonth or earlier, reading the decisions for each month from
+			/// row (month - decisionRowOffset) of the store.
+			template <typename DecisionStore>
+			void walkBackTo(
+				const int stopMonth,
+				const DecisionStore& decisions,
+				const int decisionRowOffset,
+				const std::vector<int>& tenorList,
+				std::vector<Domain::InvestmentAction>& path
+			) {
+				while (currentMonth_ > stopMonth) {
+					const Decision decision = decisions.get(currentMonth_ - decisionRowOffset, rank_);
+					rank_ = decision.prevRank;
+					// 0 is wait sentinel.
+					if (decision.tenorCode == 0) {
+						// Wait 1 month:
+						++waitStreak_;
+						--currentMonth_;
+					}
+					else {
+						// Period of waiting has ended, so must add this to decision list:
+						if (waitStreak_ > 0) {
+							path.emplace_back(
+								Domain::InvestmentAction::trusted, Domain::InvestmentAction::Action::Wait, waitStreak_
+							);
+							waitStreak_ = 0;
+						}
+						// Buy tenor starting from current month:
+						const int tenorToReachMonth = tenorList[decision.tenorCode - 1];
+						currentMonth_ -= tenorToReachMonth;
+						path.emplace_back(
+							Domain::InvestmentAction::trusted, Domain::InvestmentAction::Action::Buy, tenorToReachMonth
+						);
+					}
+				}
+			}
+
+			/// Completes the path once the walk has reached month 0.
+			void finish(std::vector<Domain::InvestmentAction>& path) {
+				// If we the path finished with waiting, we need to add this to the decision list too:
+				if (waitStreak_ > 0) {
+					path.emplace_back(
+						Domain::InvestmentAction::trusted, Domain::InvestmentAction::Action::Wait, waitStreak_
+					);
+					waitStreak_ = 0;
+				}
+			}
+
+		private:
+			int currentMonth_;
+			int rank_;
+			// Rather than add multiple 1-month waits, we keep track of contiguous waits and add this period
+			// as a single InvestmentAction.
+			int waitStreak_ = 0;
+	};
+
+	/**
+	* Collects every result's path into the flat layout of OptimalResults, walking them in one or more stages
+	* (one per checkpointed segment, latest first). At every stage the ranks are split into the same chunks, one
+	* per thread, and each thread appends its ranks' actions for the stage to its chunk's own buffer, recording
+	* how many each added. Assembling then joins each rank's pieces from every stage in turn, and reverses them,
+	* since walks produce actions latest first (avoiding .insert() and constantly shuffling memory).
+	*
+	* The stages' buffers may be given, such as a Workspace's, to reuse their storage from earlier collections.
+	*/
+	class PathCollector
+	{
+		public:
+			/// Each stage's buffers, kept (emptied) between collections for their storage.
+			struct Stage
+			{
+				std::vector<std::vector<Domain::InvestmentAction>> chunkActions{};
+				// The number of actions each rank added in this stage.
+				std::vector<std::size_t> counts{};
+			};
+
+			explicit PathCollector(const int numResults) : PathCollector(numResults, ownStages_) {}
+
+			PathCollector(const int numResults, std::vector<Stage>& stages) :
+				numResults_(static_cast<std::size_t>(numResults)),
+				numChunks_(Helpers::Parallel::numChunks(numResults_, minRanksPerThread)),
+				stages_(stages)
+			{}
+
+			// The stages may be another's, so the collector is not copied.
+			PathCollector(const PathCollector&) = delete;
+			PathCollector& operator=(const PathCollector&) = delete;
+
+			/// Runs the next stage, calling walkRank(rank, buffer) for every rank to append its actions.
+			/// Each rank's walk only reads the decisions, so ranks are walked across threads.
+			template <typename F>
+			void walkStage(F&& walkRank) {
+				if (numStages_ == stages_.size()) {
+					stages_.emplace_back();
+				}
+				Stage& stage = stages_[numStages_++];
+				// Chunks beyond this collection's are left empty, so are skipped when assembling:
+				if (stage.chunkActions.size() < numChunks_) {
+					stage.chunkActions.resize(numChunks_);
+				}
+				for (auto& buffer : stage.chunkActions) {
+					buffer.clear();
+				}
+				stage.counts.resize(numResults_);
+				Helpers::Parallel::forEachIndexedChunk(
+					numResults_,
+					minRanksPerThread,
+					[&](const std::size_t chunk, const std::size_t beginRank, const std::size_t endRank) {
+						std::vector<Domain::InvestmentAction>& buffer = stage.chunkActions[chunk];
+						for (std::size_t rank = beginRank; rank < endRank; ++rank) {
+							const std::size_t sizeBefore = buffer.size();
+							walkRank(static_cast<int>(rank), buffer);
+							stage.counts[rank] = buffer.size() - sizeBefore;
+						}
+					}
+				);
+			}
+
+			/// Joins every stage into results' actions and pathOffsets, reusing the storage they already hold.
+			void assemble(OptimalResults& results) const {
+				const auto stages = std::span(stages_).first(numStages_);
+				std::size_t totalActions = 0;
+				for (const Stage& stage : stages) {
+					for (const auto& buffer : stage.chunkActions) {
+						totalActions += buffer.size();
+					}
+				}
+				results.actions.clear();
+				results.actions.reserve(totalActions);
+				results.pathOffsets.resize(numResults_ + 1);
+				results.pathOffsets[0] = 0;
+
+				// Where each stage has read up to, since ranks are read in order, each stage moves through
+				// its chunks in turn:
+				struct Cursor
+				{
+					std::size_t chunk = 0;
+					std::size_t pos = 0;
+				};
+				std::vector<Cursor> cursors(stages.size());
+
+				for (std::size_t rank = 0; rank < numResults_; ++rank) {
+					const auto pathStart = static_cast<std::ptrdiff_t>(results.actions.size());
+					for (std::size_t s = 0; s < stages.size(); ++s) {
+						const std::size_t count = stages[s].counts[rank];
+						if (count == 0) {
+							continue;
+						}
+						// Skip past any chunks already read (or with no actions for this stage):
+						Cursor& cursor = cursors[s];
+						while (cursor.pos == stages[s].chunkActions[cursor.chunk].size()) {
+							++cursor.chunk;
+							cursor.pos = 0;
+						}
+						const auto piece =
+							std::span(stages[s].chunkActions[cursor.chunk]).subspan(cursor.pos, count);
+						results.actions.insert(results.actions.end(), piece.begin(), piece.end());
+						cursor.pos += count;
+					}
+					std::reverse(results.actions.begin() + pathStart, results.actions.end());
+					results.pathOffsets[rank + 1] = results.actions.size();
+				}
+			}
+
+		private:
+			// Only used if no stages are given, and declared first so that it is constructed before use.
+			std::vector<Stage> ownStages_{};
+			std::size_t numResults_;
+			std::size_t numChunks_;
+			std::vector<Stage>& stages_;
+			// The stages used by this collection, the first of stages_.
+			std::size_t numStages_ = 0;
+	};
+
+	/// Reconstructs the paths of optimal investment decisions made by getOptimalSequences into results,
+	/// reusing the storage they already hold, and that of stages.
+	template <typename DecisionStore>
+	void reconstructPaths(
+		const DecisionStore& decisions,
+		const std::vector<int>& tenorList,
+		const int numMonths,
+		const int numResultsFound,
+		OptimalResults& results,
+		std::vector<PathCollector::Stage>& stages
+	) {
+		PathCollector collector(numResultsFound, stages);
+		collector.walkStage([&](const int rank, std::vector<Domain::InvestmentAction>& buffer) {
+			PathWalker walker(numMonths, rank);
+			walker.walkBackTo(0, decisions, 0, tenorList, buffer);
+			walker.finish(buffer);
+		});
+		collector.assemble(results);
+	}
+
+	/// As above, with stages of its own.
+	template <typename DecisionStore>
+	void reconstructPaths(
+		const DecisionStore& decisions,
+		const std::vector<int>& tenorList,
+		const int numMonths,
+		const int numResultsFound,
+		OptimalResults& results
+	) {
+		std::vector<PathCollector::Stage> stages{};
+		reconstructPaths(decisions, tenorList, numMonths, numResultsFound, results, stages);
+	}
+
+	/**
+	* As reconstructPaths, but a block of ranks at a time, reusing block's storage for each block's paths and CRFs
+	* (the latter read as finalCRF(rank)) and passing it to sink before walking the next, so that only one block of
+	* paths is ever held alongside the decisions. Every block is walked into stages, reusing their storage.
+	*/
+	template <typename DecisionStore, typename FinalCRF>
+	void streamPaths(
+		const DecisionStore& decisions,
+		const std::vector<int>& tenorList,
+		const int numMonths,
+		const int numResultsFound,
+		const FinalCRF& finalCRF,
+		OptimalResults& block,
+		const ResultBlockSink& sink,
+		std::vector<PathCollector::Stage>& stages
+	) {
+		for (int firstRank = 0; firstRank < numResultsFound; firstRank += ranksPerStreamedBlock) {
+			const int blockSize = std::min(ranksPerStreamedBlock, numResultsFound - firstRank);
+			PathCollector collector(blockSize, stages);
+			collector.walkStage([&](const int rank, std::vector<Domain::InvestmentAction>& buffer) {
+				PathWalker walker(numMonths, firstRank + rank);
+				walker.walkBackTo(0, decisions, 0, tenorList, buffer);
+				walker.finish(buffer);
+			});
+			collector.assemble(block);
+
+			block.CRFs.clear();
+			block.CRFs.reserve(blockSize);
+			for (int rank = firstRank; rank < firstRank + blockSize; ++rank) {
+				block.CRFs.push_back(finalCRF(rank));
+			}
+			sink(static_cast<std::size_t>(firstRank), block);
+		}
+	}
+
+	/**
+	* Builds a ResultDAG of the first numResultsFound ranks of month numMonths, with their CRFs, keeping only the
+	* (month, rank) decisions some result passes through. Every decision points back to an earlier month, so a pass
+	* from the final month back to month 0 gathers each month's ranks reached before that month is itself visited.
+	* A second pass forward then numbers the nodes month by month, so that each node's parent is already numbered,
+	* and is found among its month's ranks reached (which are sorted) by binary search.
+	*/
+	template <typename DecisionStore>
+	[[nodiscard]] ResultDAG buildResultDAG(
+		const DecisionStore& decisions,
+		const std::vector<int>& tenorList,
+		const int numMonths,
+		const int numResultsFound,
+		std::vector<double> CRFs,
+		const bool logSpace
+	) {
+		// The month a decision was made from, given the month it reaches:
+		const auto parentMonth = [&](const int month, const Decision decision) {
+			return decision.tenorCode == 0 ? month - 1 : month - tenorList[decision.tenorCode - 1];
+		};
+
+		std::vector<std::vector<std::int32_t>> reached(static_cast<std::size_t>(numMonths) + 1);
+		auto& finalRanks = reached[static_cast<std::size_t>(numMonths)];
+		finalRanks.resize(static_cast<std::size_t>(numResultsFound));
+		for (int rank = 0; rank < numResultsFound; ++rank) {
+			finalRanks[static_cast<std::size_t>(rank)] = rank;
+		}
+		std::size_t numNodes = 1;
+		for (int month = numMonths; month > 0; --month) {
+			auto& ranks = reached[static_cast<std::size_t>(month)];
+			std::ranges::sort(ranks);
+			ranks.erase(std::ranges::unique(ranks).begin(), ranks.end());
+			numNodes += ranks.size();
+			for (const std::int32_t rank : ranks) {
+				const Decision decision = decisions.get(month, rank);
+				reached[static_cast<std::size_t>(parentMonth(month, decision))].push_back(decision.prevRank);
+			}
+		}
+		if (numNodes > std::numeric_limits<std::uint32_t>::max()) {
+			throw std::length_error("ResultDAG: too many decisions reached to number");
+		}
+
+		// Month 0's only node is the first, and is its own parent:
+		std::vector<ResultDAG::Node> nodes{};
+		nodes.reserve(numNodes);
+		nodes.push_back({.parent = 0, .tenorCode = 0});
+		std::vector<std::uint32_t> firstNodes(static_cast<std::size_t>(numMonths) + 1, 0);
+		for (int month = 1; month <= numMonths; ++month) {
+			firstNodes[static_cast<std::size_t>(month)] = static_cast<std::uint32_t>(nodes.size());
+			for (const std::int32_t rank : reached[static_cast<std::size_t>(month)]) {
+				const Decision decision = decisions.get(month, rank);
+				const auto from = static_cast<std::size_t>(parentMonth(month, decision));
+				const auto& fromRanks = reached[from];
+				// Month 0's ranks are never sorted, but all are its only node:
+				const auto index = from == 0
+					? 0
+					: std::ranges::lower_bound(fromRanks, decision.prevRank) - fromRanks.begin();
+				nodes.push_back({
+					.parent = firstNodes[from] + static_cast<std::uint32_t>(index),
+					.tenorCode = decision.tenorCode
+				});
+			}
+		}
+
+		// Every final rank was reached, in order:
+		std::vector<std::uint32_t> roots(static_cast<std::size_t>(numResultsFound));
+		for (std::size_t rank = 0; rank < roots.size(); ++rank) {
+			roots[rank] = firstNodes[static_cast<std::size_t>(numMonths)] + static_cast<std::uint32_t>(rank);
+		}
+		return {tenorList, numMonths, std::move(nodes), std::move(roots), std::move(CRFs), logSpace};
+	}
+}
+
+#endif // BSO_APP_OPTIMISER_PATH_RECONSTRUCTION_HPP
\ No newline at end of file
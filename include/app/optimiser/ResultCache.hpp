@@ -0,0 +1,107 @@
+#ifndef BSO_APP_OPTIMISER_RESULT_CACHE_HPP
+#define BSO_APP_OPTIMISER_RESULT_CACHE_HPP
+
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+namespace DynamicOptimiser
+{
+	// Forward declaration, implemented in "include/app/optimiser/OptimiserState.hpp".
+	class OptimiserState;
+
+	/**
+	* Keeps the optimiser's final state for recently run bond return data, keyed by a hash of its contents (tenors,
+	* months and every bond return), so that the same data asked for again, however it was loaded, is answered without
+	* running the forward pass. The state holds every month's decisions and the final CRFs, so any k' up to the k it
+	* was run with is answered by reconstructing only the top k' paths, which are exactly those a run for k' finds.
+	* Asking for more results than are held runs again for the larger k and replaces the entry.
+	*
+	* Given a directory, each state run is also saved there as an OptimiserState file named by its key, and a miss in
+	* memory looks there before running, so that results survive between processes. A file which cannot be read, or
+	* whose tenors, months or latest returns do not match the data, counts as a miss, and failures to save are ignored.
+	*
+	* Lookups may be made from any number of threads. Runs happen outside the lock, so two threads asking for the same
+	* new data at once may both run it, the one with more results being kept. OptimiserOptions::lowMemory and
+	* distinctPurchases keep no state to reuse, so runs using them bypass the cache.
+	*
+	* The states held keep every month's decisions, and are not counted by admitRun, so callers fitting runs to the
+	* memory available must leave room for up to maxEntries of them.
+	*/
+	class ResultCache
+	{
+		public:
+			static constexpr std::size_t defaultMaxEntries = 16;
+
+			explicit ResultCache(
+				std::size_t maxEntries = defaultMaxEntries,
+				std::optional<std::filesystem::path> directory = std::nullopt
+			);
+
+			/// Writes the top numResultsRequested results for tenorData into results, reusing the storage it already
+			/// holds, and returns whether they were answered without running the forward pass. Throws as
+			/// getOptimalSequences does.
+			bool get(
+				const Domain::BondReturnData& tenorData,
+				int numResultsRequested,
+				OptimalResults& results,
+				const OptimiserOptions& options = {}
+			);
+
+			/// The hash of the bond return data identifying it in the cache.
+			[[nodiscard]] static std::uint64_t keyOf(const Domain::BondReturnData& tenorData) noexcept;
+
+			struct Stats
+			{
+				std::size_t entries = 0;
+				// Lookups answered from memory, from a saved file, and by running the optimiser.
+				std::uint64_t hits = 0;
+				std::uint64_t diskHits = 0;
+				std::uint64_t runs = 0;
+			};
+
+			[[nodiscard]] Stats stats() const;
+
+		private:
+			// The data's key, and whether it was run in log space.
+			using Key = std::pair<std::uint64_t, bool>;
+
+			struct Entry
+			{
+				std::shared_ptr<const OptimiserState> state{};
+				std::uint64_t lastUsed = 0;
+			};
+
+			[[nodiscard]] std::filesystem::path statePath(const Key& key) const;
+
+			/// Holds the state under key, unless one with more results is already held, and drops the least recently
+			/// used entry if there are too many. The lock must be held.
+			void insert(const Key& key, std::shared_ptr<const OptimiserState> state);
+
+			std::size_t maxEntries_;
+			std::optional<std::filesystem::path> directory_;
+
+			mutable std::mutex mutex_{};
+			std::map<Key, Entry> entries_{};
+			// Counts lookups, so that the entry used longest ago has the lowest lastUsed.
+			std::uint64_t clock_ = 0;
+			std::uint64_t hits_ = 0;
+			std::uint64_t diskHits_ = 0;
+			std::uint64_t runs_ = 0;
+	};
+}
+
+#endif // BSO_APP_OPTIMISER_RESULT_CACHE_HPP
\ No newline at end of file
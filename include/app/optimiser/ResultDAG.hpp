@@ -0,0 +1,172 @@
+#ifndef BSO_APP_OPTIMISER_RESULT_DAG_HPP
+#define BSO_APP_OPTIMISER_RESULT_DAG_HPP
+
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	/**
+	* A run's results held as handles into the decisions that reach them, rather than with every path copied out.
+	*
+	* The top results share most of their decisions, differing in a few months, so each (month, rank) reached by any
+	* result is kept once as a node pointing to the node it came from, and each result is just the node of its final
+	* rank. Walking a result's parent links unfolds its path, latest action first, so paths are only ever unfolded on
+	* demand, one at a time for printing or a block at a time for export. Memory is 8 bytes per node reached, at most
+	* the (numMonths + 1) * k decisions of the run, and often far fewer, rather than an action for every step of every
+	* path, which for long horizons grows as k times the path length.
+	*/
+	class ResultDAG
+	{
+		public:
+			/// A month's rank reached by some result: how it was reached (as a decision's tenorCode, 0 for waiting a
+			/// month, otherwise 1 + the index of the tenor bought), and the node of the month it was reached from.
+			/// Month 0's only node is the first, and is its own parent.
+			struct Node
+			{
+				std::uint32_t parent{};
+				std::int32_t tenorCode{};
+			};
+
+			/**
+			* Walks a result's path back from its last action to its first, merging consecutive months of waiting into
+			* a single action as OptimalResults does, so yields exactly OptimalResults::path(i) in reverse.
+			*/
+			class ReverseIterator
+			{
+				public:
+					using value_type = Domain::InvestmentAction;
+					using difference_type = std::ptrdiff_t;
+
+					ReverseIterator() = default;
+
+					/// Starts at the last action of the path ending at node, in the final month.
+					ReverseIterator(const ResultDAG& dag, std::uint32_t node) noexcept;
+
+					[[nodiscard]] Domain::InvestmentAction operator*() const {
+						return {Domain::InvestmentAction::trusted, action_, length_};
+					}
+
+					ReverseIterator& operator++() noexcept {
+						advance();
+						return *this;
+					}
+
+					ReverseIterator operator++(int) noexcept {
+						ReverseIterator previous = *this;
+						advance();
+						return previous;
+					}
+
+					[[nodiscard]] bool operator==(const ReverseIterator& other) const noexcept {
+						return node_ == other.node_ && startMonth_ == other.startMonth_ && done_ == other.done_;
+					}
+
+					[[nodiscard]] bool operator==(std::default_sentinel_t) const noexcept { return done_; }
+
+				private:
+					/// Moves to the action before the current one, or to the end once month 0 is reached.
+					void advance() noexcept;
+
+					const ResultDAG* dag_ = nullptr;
+					// The node of the month the current action starts in (or the end state's).
+					std::uint32_t node_ = 0;
+					Domain::InvestmentAction::Action action_ = Domain::InvestmentAction::Action::Wait;
+					int startMonth_ = 0;
+					int length_ = 0;
+					bool done_ = true;
+			};
+
+			/// A result's path, last action first.
+			class ReversePath
+			{
+				public:
+					ReversePath(const ResultDAG& dag, const std::uint32_t node) noexcept : dag_(&dag), node_(node) {}
+
+					[[nodiscard]] ReverseIterator begin() const noexcept { return {*dag_, node_}; }
+					[[nodiscard]] static std::default_sentinel_t end() noexcept { return std::default_sentinel; }
+
+				private:
+					const ResultDAG* dag_;
+					std::uint32_t node_;
+			};
+
+			ResultDAG() = default;
+
+			/// Holds nodes as built by the optimiser, every parent preceding its child, with each result's final node
+			/// (in the final month) in roots, and its CRF (or log CRF if logSpace is set) in CRFs.
+			ResultDAG(
+				std::vector<int> tenors,
+				int numMonths,
+				std::vector<Node> nodes,
+				std::vector<std::uint32_t> roots,
+				std::vector<double> CRFs,
+				bool logSpace
+			) noexcept;
+
+			/// The number of results held.
+			[[nodiscard]] std::size_t size() const noexcept { return roots_.size(); }
+
+			/// The ith CRF, converted back from log space if need be, as OptimalResults::CRF.
+			[[nodiscard]] double CRF(std::size_t i) const noexcept;
+
+			/// Every result's CRF, or log CRF if logSpace(), best first.
+			[[nodiscard]] std::span<const double> CRFs() const noexcept { return CRFs_; }
+
+			[[nodiscard]] bool logSpace() const noexcept { return logSpace_; }
+			[[nodiscard]] const std::vector<int>& tenors() const noexcept { return tenors_; }
+			[[nodiscard]] int numMonths() const noexcept { return numMonths_; }
+
+			/// The number of (month, rank) nodes reached by any result.
+			[[nodiscard]] std::size_t numNodes() const noexcept { return nodes_.size(); }
+
+			/// The memory held, in bytes.
+			[[nodiscard]] std::size_t bytes() const noexcept;
+
+			/// The ith result's path, unfolded as it is iterated, last action first.
+			[[nodiscard]] ReversePath reversePath(const std::size_t i) const noexcept { return {*this, roots_[i]}; }
+
+			/// Unfolds the ith result's path into path, first action first, reusing the storage it already holds.
+			void unfoldPath(std::size_t i, std::vector<Domain::InvestmentAction>& path) const;
+
+			/// Unfolds the results of ranks [firstRank, firstRank + numResults) into block, reusing the storage it
+			/// already holds, such as to pass a block at a time to IO::Output::CSVWriter.
+			void unfold(std::size_t firstRank, std::size_t numResults, OptimalResults& block) const;
+
+			/// Unfolds every result into a new OptimalResults, exactly those getOptimalSequences finds.
+			[[nodiscard]] OptimalResults unfold() const;
+
+		private:
+			std::vector<int> tenors_{};
+			int numMonths_ = 0;
+			std::vector<Node> nodes_{};
+			// Each result's node in the final month, best first.
+			std::vector<std::uint32_t> roots_{};
+			std::vector<double> CRFs_{};
+			bool logSpace_ = false;
+	};
+
+	/// As getOptimalSequences, holding the results as a ResultDAG rather than unfolding every path, throwing
+	/// std::invalid_argument if options.lowMemory is set, since every month's decisions are needed.
+	[[nodiscard]] ResultDAG getOptimalSequencesAsDAG(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		const OptimiserOptions& options = {}
+	);
+
+	/// As above, running in the workspace given.
+	[[nodiscard]] ResultDAG getOptimalSequencesAsDAG(
+		const Domain::BondReturnData& tenorData,
+		int numResultsRequested,
+		Workspace& workspace,
+		const OptimiserOptions& options = {}
+	);
+}
+
+#endif // BSO_APP_OPTIMISER_RESULT_DAG_HPP
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef BSO_APP_OPTIMISER_RESULT_ENUMERATOR_HPP
+#define BSO_APP_OPTIMISER_RESULT_ENUMERATOR_HPP
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	/**
+	* Enumerates the final month's results in rank order on demand, for when the number of results wanted is not known
+	* up front: the top few may be taken, then the next thousand, and so on, without re-running anything.
+	*
+	* Months form a DAG, with an edge for waiting from each month, and for buying each tenor from each month it can be
+	* bought, and each result is a path through it from month 0. This uses the Recursive Enumeration Algorithm of
+	* Jiménez and Marzal for k-shortest paths: each month keeps only the ranks of paths to it found so far, and a
+	* candidate for each incoming edge. Finding a month's next rank takes the best candidate, and replaces it with the
+	* next-ranked path through the same edge, which finds that predecessor's next rank in turn only if it is not already
+	* known. Memory therefore grows with the ranks actually taken, far less than the k per month of a full run.
+	*
+	* Given a CRFThreshold, only results meeting it are enumerated, and candidates which could not meet it are pruned as
+	* they are found (see getOptimalSequencesWithin).
+	*
+	* The results, and the order of results with equal CRFs, are exactly those of getOptimalSequences. Only
+	* OptimiserOptions::logSpace applies, since no decisions are stored and no merge is run.
+	*/
+	class ResultEnumerator
+	{
+		public:
+			/// Prepares to enumerate the results for tenorData (keeping a copy of it), finding the best result for
+			/// every month, and throws as getOptimalSequences does.
+			explicit ResultEnumerator(Domain::BondReturnData tenorData, const OptimiserOptions& options = {});
+
+			/// As above, but enumerating only the results meeting threshold, and throwing as getOptimalSequencesWithin.
+			ResultEnumerator(
+				Domain::BondReturnData tenorData,
+				const CRFThreshold& threshold,
+				const OptimiserOptions& options = {}
+			);
+
+			/// Finds up to the next count results, in rank order, into results (replacing its contents, but reusing its
+			/// storage), returning how many were found, fewer than count only once every result has been taken.
+			int next(int count, OptimalResults& results);
+
+			/// As above, returning a new OptimalResults.
+			[[nodiscard]] OptimalResults next(int count);
+
+			/// The number of results taken so far.
+			[[nodiscard]] int numTaken() const noexcept { return numTaken_; }
+
+			/// Whether every result has been taken.
+			[[nodiscard]] bool exhausted() const noexcept;
+
+		private:
+			/// One rank of the paths to a month: its CRF, and the decision reaching it (see Decision).
+			struct RankedPath
+			{
+				double CRF{};
+				int tenorCode{};
+				int prevRank{};
+			};
+
+			/// A candidate for a month's next rank: the path at a given rank of one predecessor, extended over the
+			/// edge from it.
+			struct Candidate
+			{
+				double CRF{};
+				int tenorCode{};
+				int prevRank{};
+			};
+
+			struct MonthPaths
+			{
+				// The ranks found so far, in order.
+				std::vector<RankedPath> paths{};
+				// A heap of at most one candidate per incoming edge, only set up once the second rank is needed.
+				std::vector<Candidate> candidates{};
+				bool candidatesInitialised = false;
+				bool exhausted = false;
+			};
+
+			/// The month from which the edge with the given tenor code reaches month.
+			[[nodiscard]] int predecessor(int month, int tenorCode) const noexcept;
+
+			/// Extends the path at prevRank of the edge's predecessor over the edge into month.
+			[[nodiscard]] Candidate candidate(int month, int tenorCode, int prevRank) const;
+
+			/// Checks the bond returns and finds the first rank for every month, throwing as getOptimalSequences does.
+			void prepare();
+
+			/// Finds the first rank for every month with a forward pass.
+			void findBestPaths();
+
+			/// Throws if the threshold is invalid, or if the bond returns could not be pruned by it.
+			void assertCanPrune(const CRFThreshold& threshold) const;
+
+			/// Finds the best CRF factor achievable from every month to the final month with a backward pass,
+			/// and sets the threshold (in the same space as the CRFs) that results must meet.
+			void setThreshold(const CRFThreshold& threshold);
+
+			/// Whether a path reaching month with the given CRF could still meet the threshold.
+			[[nodiscard]] bool canMeetThreshold(double CRF, int month) const noexcept;
+
+			/// Marks the final month as having no results to take, for runs with nothing to find, or in which even the
+			/// best result does not meet the threshold.
+			void clearResults() noexcept;
+
+			/// Finds month's next rank if there is one, marking it exhausted if not.
+			void findNextPath(int month);
+
+			Domain::BondReturnData tenorData_;
+			bool logSpace_;
+			std::vector<MonthPaths> months_{};
+			// With a threshold, the best CRF factor (or log of it) achievable from each month to the final month,
+			// and empty if there is none.
+			std::vector<double> bestSuffixFactors_{};
+			double threshold_{};
+			// Months waiting on their next rank, each needing the one below it first (an explicit stack rather than
+			// recursion, since the chain of predecessors can be as long as the horizon).
+			std::vector<int> pending_{};
+			int numTaken_ = 0;
+	};
+}
+
+#endif // BSO_APP_OPTIMISER_RESULT_ENUMERATOR_HPP
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef BSO_APP_SERVICE_CURVE_CACHE_HPP
+#define BSO_APP_SERVICE_CURVE_CACHE_HPP
+
+#include "app/io/DataLoader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Domain
+{
+	// Forward declaration, implemented in "include/app/domain/BondReturnData.hpp".
+	class BondReturnData;
+}
+
+namespace Service
+{
+	/**
+	* Keeps loaded curves in memory keyed by path, so that each is only parsed once for as long as its file is
+	* unchanged, however many queries use it. Every lookup checks the file's size and modification time, reloading it
+	* if either has changed since it was loaded. Once more than maxCurves are held, the least recently used is dropped,
+	* though queries still using it keep it alive until they finish.
+	*
+	* Lookups may be made from any number of threads. Loading happens outside the lock, so a slow load never holds up
+	* queries for other curves, but two threads asking for the same new curve at once may both load it.
+	*/
+	class CurveCache
+	{
+		public:
+			static constexpr std::size_t defaultMaxCurves = 64;
+
+			explicit CurveCache(std::size_t maxCurves = defaultMaxCurves, IO::Input::LoadOptions loadOptions = {});
+
+			/// Returns the curve at the given path, loading it if it is not held or its file has changed,
+			/// throwing an IO::Input::LoadError if it cannot be loaded.
+			[[nodiscard]] std::shared_ptr<const Domain::BondReturnData> get(const std::filesystem::path& curvePath);
+
+			/// A curve held, and how it was last found.
+			struct CurveInfo
+			{
+				std::filesystem::path path{};
+				std::vector<int> tenors{};
+				int numMonths = 0;
+			};
+
+			struct Stats
+			{
+				std::vector<CurveInfo> curves{};
+				// Lookups answered from memory, and those which loaded (or reloaded) their curve.
+				std::uint64_t hits = 0;
+				std::uint64_t loads = 0;
+			};
+
+			[[nodiscard]] Stats stats() const;
+
+		private:
+			struct Entry
+			{
+				std::shared_ptr<const Domain::BondReturnData> data{};
+				std::filesystem::file_time_type modified{};
+				std::uintmax_t size = 0;
+				std::uint64_t lastUsed = 0;
+			};
+
+			std::size_t maxCurves_;
+			IO::Input::LoadOptions loadOptions_;
+
+			mutable std::mutex mutex_{};
+			std::map<std::filesystem::path, Entry> entries_{};
+			// Counts lookups, so that the entry used longest ago has the lowest lastUsed.
+			std::uint64_t clock_ = 0;
+			std::uint64_t hits_ = 0;
+			std::uint64_t loads_ = 0;
+	};
+}
+
+#endif // BSO_APP_SERVICE_CURVE_CACHE_HPP
@@ -0,0 +1,130 @@
+#ifndef BSO_APP_SERVICE_SERVER_HPP
+#define BSO_APP_SERVICE_SERVER_HPP
+
+#include "app/service/CurveCache.hpp"
+#include "helpers/Socket.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace DynamicOptimiser
+{
+	// Forward declarations, implemented in "include/app/optimiser/DynamicOptimiser.hpp".
+	class Workspace;
+	struct OptimalResults;
+
+	// Forward declaration, implemented in "include/app/optimiser/ResultCache.hpp".
+	class ResultCache;
+}
+
+namespace Service
+{
+	/// Stores the options for serving queries, as parsed from the command line.
+	struct ServerOptions
+	{
+		// The IPv4 address to listen on, only the local machine by default.
+		std::string address = "127.0.0.1";
+		// The port to listen on, or 0 for any free port.
+		std::uint16_t port = 8080;
+		// Curves are named relative to this directory, and queries cannot reach files outside it.
+		std::filesystem::path dataRoot = ".";
+		// The number of queries answered at once, each on its own thread with its own workspace,
+		// 0 uses every hardware thread.
+		unsigned int numWorkers = 0;
+		// The number of curves kept loaded, dropping the least recently used beyond this.
+		std::size_t maxCurves = CurveCache::defaultMaxCurves;
+		// The number of runs whose results are kept to answer repeated queries (see DynamicOptimiser::ResultCache),
+		// 0 keeps none unless resultDirectory is given.
+		std::size_t maxCachedResults = 0;
+		// A directory to save each run's results in, and look for them in before running, if any.
+		std::optional<std::filesystem::path> resultDirectory{};
+		// The most results a single query may ask for.
+		int maxResults = 100'000;
+		// Converts CSV curves to binary curve sidecars on first load (see IO::Input::LoadOptions).
+		bool useBinaryCache = false;
+		// Fits each query to its worker's share of the memory available (see DynamicOptimiser::admitRun).
+		bool checkMemory = true;
+		// Suppresses the line logged for each request.
+		bool quiet = false;
+	};
+
+	/// A reply to a request, as an HTTP status code and a JSON body.
+	struct Response
+	{
+		int status = 200;
+		std::string body{};
+	};
+
+	/**
+	* Serves the optimiser over plain HTTP, answering with JSON, so that a curve is loaded once and then queried as
+	* often as needed without starting a process or parsing it again each time. Curves are kept in a CurveCache, and
+	* requests are answered by a fixed set of worker threads, each with its own DynamicOptimiser::Workspace, so that
+	* after the first few queries of a given size, runs reuse their buffers rather than allocating them. With a result
+	* cache, a query for data already run (for as many results or more) skips the forward pass altogether.
+	*
+	* Requests:
+	*   GET /health    {"status": "ok", ...}
+	*   GET /curves    the curves loaded, with the cache's hits and loads, and the result cache's if enabled
+	*   GET /optimise?curve=<path>&k=<n>[&start=<month>][&months=<n>][&log=1][&distinct=1]
+	*                  the top k results for the curve at path (relative to the data root) over months
+	*                  [start, start + months), by default every month; POST with a form-encoded body also works
+	*
+	* Each connection carries one request, and is closed once it has been answered.
+	*/
+	class Server
+	{
+		public:
+			/// Starts listening, throwing a Helpers::Socket::SocketError if it cannot (such as if the port is taken),
+			/// or std::invalid_argument if the data root is not a directory or the results directory cannot be made.
+			explicit Server(ServerOptions options);
+
+			~Server();
+
+			Server(const Server&) = delete;
+			Server& operator=(const Server&) = delete;
+
+			/// The port listened on, which is the one chosen if 0 was given.
+			[[nodiscard]] std::uint16_t port() const noexcept { return listener_.port(); }
+
+			/// Serves requests until stop is called, then finishes those already accepted before returning.
+			void run();
+
+			/// Asks run to return, and may be called from any thread, or from a signal handler.
+			void stop() noexcept { stopping_.store(true, std::memory_order_relaxed); }
+
+			/// Answers a request as run does, but without a connection, running any query in the workspace given,
+			/// and leaving its results in results.
+			[[nodiscard]] Response handle(
+				std::string_view method,
+				std::string_view target,
+				std::string_view body,
+				DynamicOptimiser::Workspace& workspace,
+				DynamicOptimiser::OptimalResults& results
+			);
+
+		private:
+			/// Reads a request from the connection, answers it and closes it.
+			void serve(
+				Helpers::Socket::Connection& connection,
+				DynamicOptimiser::Workspace& workspace,
+				DynamicOptimiser::OptimalResults& results
+			);
+
+			ServerOptions options_;
+			unsigned int numWorkers_;
+			std::filesystem::path dataRoot_;
+			CurveCache cache_;
+			// Null unless results are cached.
+			std::unique_ptr<DynamicOptimiser::ResultCache> resultCache_{};
+			Helpers::Socket::Listener listener_;
+			std::atomic<bool> stopping_{false};
+	};
+}
+
+#endif // BSO_APP_SERVICE_SERVER_HPP
@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace Helpers::Filesystem
 {
@@ -38,6 +39,10 @@ namespace Helpers::Filesystem
 	void assertFileValid(const std::filesystem::path& filePath);
 
 	[[nodiscard]] std::filesystem::path expandUserPath(std::string_view pathSv);
+
+	/// Expands a path whose final component may contain the wildcards '*' and '?' into the sorted list of
+	/// matching regular files, a path without wildcards is returned unchanged (whether or not it exists).
+	[[nodiscard]] std::vector<std::filesystem::path> expandGlob(std::string_view patternSv);
 }
 
 #endif // BSO_HELPERS_FILESYSTEM_HPP
\ No newline at end of file
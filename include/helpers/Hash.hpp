@@ -0,0 +1,15 @@
+#ifndef BSO_HELPERS_HASH_HPP
+#define BSO_HELPERS_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Helpers::Hash
+{
+	/// Returns a fast 64-bit (non-cryptographic) hash of the given bytes, processing them a word at a time,
+	/// suitable for detecting changed data but not for security purposes.
+	/// The seed allows hashes to be chained, by passing the hash of earlier data as the seed for the next.
+	[[nodiscard]] std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t seed = 0) noexcept;
+}
+
+#endif // BSO_HELPERS_HASH_HPP
\ No newline at end of file
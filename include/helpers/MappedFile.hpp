@@ -0,0 +1,39 @@
+#ifndef BSO_HELPERS_MAPPED_FILE_HPP
+#define BSO_HELPERS_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace Helpers::Filesystem
+{
+	/// A read-only memory mapping of an entire file, which is unmapped on destruction,
+	/// allowing the contents to be parsed in place without copying them into a buffer first.
+	class MappedFile
+	{
+		public:
+			/// Maps the file at the given path, throwing a FileError if it cannot be opened or mapped.
+			explicit MappedFile(const std::filesystem::path& filePath);
+			~MappedFile();
+
+			// The mapping is uniquely owned, so may be moved but not copied.
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			MappedFile(MappedFile&& other) noexcept;
+			MappedFile& operator=(MappedFile&& other) noexcept;
+
+			[[nodiscard]] std::string_view contents() const noexcept { return {data_, size_}; }
+			[[nodiscard]] const char* data() const noexcept { return data_; }
+			[[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+		private:
+			void unmap() noexcept;
+
+			const char* data_ = nullptr;
+			std::size_t size_ = 0;
+			// Only used on Windows, where the file mapping object must be kept open alongside the view.
+			void* mappingHandle_ = nullptr;
+	};
+}
+
+#endif // BSO_HELPERS_MAPPED_FILE_HPP
\ No newline at end of file
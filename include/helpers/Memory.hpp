@@ -0,0 +1,18 @@
+#ifndef BSO_HELPERS_MEMORY_HPP
+#define BSO_HELPERS_MEMORY_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace Helpers::Memory
+{
+	/// Returns the physical memory that could be allocated without swapping, in bytes, or nothing if this cannot be
+	/// determined. On Linux this is MemAvailable, which counts reclaimable caches, rather than only unused memory.
+	[[nodiscard]] std::optional<std::size_t> availableBytes() noexcept;
+
+	/// Formats a number of bytes with binary units to one decimal place, such as "1.5 GiB".
+	[[nodiscard]] std::string formatBytes(std::size_t bytes);
+}
+
+#endif // BSO_HELPERS_MEMORY_HPP
@@ -0,0 +1,286 @@
+#ifndef BSO_HELPERS_PARALLEL_HPP
+#define BSO_HELPERS_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Helpers::Parallel
+{
+	/// Returns the number of hardware threads available, or 1 if this cannot be determined.
+	[[nodiscard]] unsigned int hardwareThreads() noexcept;
+
+	/// Returns the maximum number of threads that parallel work may use,
+	/// which is the number of hardware threads unless set otherwise.
+	[[nodiscard]] unsigned int maxThreads() noexcept;
+
+	/// Sets the maximum number of threads that parallel work may use, 0 restores the default.
+	void setMaxThreads(unsigned int numThreads) noexcept;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	namespace Detail
+	{
+		// Set while the thread is running a chunk, so that parallel work nested inside it runs serially rather than
+		// starting threads of its own, since the outer work already occupies every thread it may use.
+		inline thread_local bool insideChunk = false;
+
+		/// Marks the current thread as running a chunk for its lifetime, restoring the previous state after.
+		class ChunkScope
+		{
+			public:
+				ChunkScope() noexcept : wasInside_(std::exchange(insideChunk, true)) {}
+				~ChunkScope() { insideChunk = wasInside_; }
+
+				ChunkScope(const ChunkScope&) = delete;
+				ChunkScope& operator=(const ChunkScope&) = delete;
+
+			private:
+				bool wasInside_;
+		};
+	}
+
+	/// Runs parallel work started on the current thread serially for as long as it exists, for threads which are
+	/// already one of as many as the machine can run, such as a server's workers.
+	using SerialScope = Detail::ChunkScope;
+
+	/// Returns the number of threads that parallel work started here may use: maxThreads(), or 1 inside a chunk.
+	[[nodiscard]] inline unsigned int availableThreads() noexcept {
+		return Detail::insideChunk ? 1 : maxThreads();
+	}
+
+	/// Returns the number of chunks forEachChunk splits [0, count) into for the given minChunkSize,
+	/// which is fixed for as long as the maximum number of threads is unchanged (and is 1 inside a chunk).
+	[[nodiscard]] inline std::size_t numChunks(const std::size_t count, const std::size_t minChunkSize) noexcept {
+		if (Detail::insideChunk) {
+			return std::min<std::size_t>(count, 1);
+		}
+		const std::size_t chunkSize = std::max<std::size_t>(minChunkSize, 1);
+		return std::min<std::size_t>((count + chunkSize - 1) / chunkSize, maxThreads());
+	}
+
+	/**
+	* Splits the range [0, count) into numChunks(count, minChunkSize) contiguous chunks, and calls
+	* fn(chunk, begin, end) for each chunk on its own thread, with the calling thread taking the first chunk.
+	* The chunk index allows each call to write to per-chunk storage without synchronisation.
+	*
+	* If any calls throw, the exception from the earliest chunk is rethrown once every chunk has finished,
+	* so that errors are reported deterministically regardless of how the threads were scheduled.
+	* Any parallel work started from within fn runs serially on the calling thread.
+	*/
+	template <typename F>
+	void forEachIndexedChunk(const std::size_t count, const std::size_t minChunkSize, F&& fn) {
+		const std::size_t chunks = numChunks(count, minChunkSize);
+
+		if (chunks <= 1) {
+			if (count > 0) {
+				fn(std::size_t{0}, std::size_t{0}, count);
+			}
+			return;
+		}
+
+		// Spread any remainder over the first chunks, so chunk sizes differ by at most 1:
+		const auto chunkBegin = [&](const std::size_t chunk) {
+			return chunk * (count / chunks) + std::min(chunk, count % chunks);
+		};
+
+		std::vector<std::exception_ptr> exceptions(chunks);
+		{
+			std::vector<std::jthread> workers{};
+			workers.reserve(chunks - 1);
+			for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+				workers.emplace_back([&, chunk] {
+					const Detail::ChunkScope scope{};
+					try {
+						fn(chunk, chunkBegin(chunk), chunkBegin(chunk + 1));
+					}
+					catch (...) {
+						exceptions[chunk] = std::current_exception();
+					}
+				});
+			}
+			try {
+				const Detail::ChunkScope scope{};
+				fn(std::size_t{0}, chunkBegin(0), chunkBegin(1));
+			}
+			catch (...) {
+				exceptions[0] = std::current_exception();
+			}
+			// The jthreads join on leaving scope.
+		}
+
+		for (const auto& e : exceptions) {
+			if (e) {
+				std::rethrow_exception(e);
+			}
+		}
+	}
+
+	/// As forEachIndexedChunk, but calls fn(begin, end) for each chunk,
+	/// splitting [0, count) into chunks of at least minChunkSize (one per available thread at most).
+	template <typename F>
+	void forEachChunk(const std::size_t count, const std::size_t minChunkSize, F&& fn) {
+		forEachIndexedChunk(count, minChunkSize, [&fn](std::size_t, const std::size_t begin, const std::size_t end) {
+			fn(begin, end);
+		});
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	/**
+	* A set of threads kept for repeated rounds of parallel work, such as one per month of a run, where starting
+	* threads for each round would cost more than the round itself. Each round is split into tasks, which the threads
+	* (including the calling thread) claim from a shared counter, so that a thread finishing its tasks early takes over
+	* those no other has started rather than waiting, and uneven tasks still balance.
+	*/
+	class WorkerPool
+	{
+		public:
+			/// Starts numThreads - 1 threads, the calling thread being the last.
+			explicit WorkerPool(unsigned int numThreads);
+			~WorkerPool();
+
+			WorkerPool(const WorkerPool&) = delete;
+			WorkerPool& operator=(const WorkerPool&) = delete;
+
+			[[nodiscard]] unsigned int numThreads() const noexcept {
+				return static_cast<unsigned int>(workers_.size()) + 1;
+			}
+
+			/**
+			* Calls fn(task) for each task in [0, numTasks) across the pool's threads, returning once every call has.
+			* As with forEachIndexedChunk, if any calls throw, the exception from the earliest task is rethrown once
+			* every task has finished, and any parallel work started from within fn runs serially.
+			*/
+			template <typename F>
+			void forEachTask(const std::size_t numTasks, F&& fn) {
+				if (workers_.empty() || numTasks <= 1) {
+					const Detail::ChunkScope scope{};
+					for (std::size_t task = 0; task < numTasks; ++task) {
+						fn(task);
+					}
+					return;
+				}
+
+				std::vector<std::exception_ptr> exceptions(numTasks);
+				auto runTask = [&](const std::size_t task) {
+					const Detail::ChunkScope scope{};
+					try {
+						fn(task);
+					}
+					catch (...) {
+						exceptions[task] = std::current_exception();
+					}
+				};
+				run(numTasks, [](void* const context, const std::size_t task) {
+					(*static_cast<decltype(runTask)*>(context))(task);
+				}, &runTask);
+
+				for (const auto& e : exceptions) {
+					if (e) {
+						std::rethrow_exception(e);
+					}
+				}
+			}
+
+		private:
+			using TaskFn = void (*)(void* context, std::size_t task);
+
+			/// Runs a round of numTasks calls of call(context, task), which must not throw.
+			void run(std::size_t numTasks, TaskFn call, void* context);
+			/// Claims and runs tasks of the current round until none are left.
+			void claimTasks(TaskFn call, void* context, std::size_t numTasks) noexcept;
+			void workerLoop();
+
+			std::mutex mutex_{};
+			std::condition_variable roundStarted_{};
+			std::condition_variable roundFinished_{};
+			// The current round, set under the mutex before its generation is announced:
+			TaskFn call_ = nullptr;
+			void* context_ = nullptr;
+			std::size_t numTasks_ = 0;
+			std::uint64_t generation_ = 0;
+			unsigned int busyWorkers_ = 0;
+			bool stopping_ = false;
+			std::atomic<std::size_t> nextTask_{0};
+			// Declared last, so that the threads are joined before anything they use is destroyed.
+			std::vector<std::jthread> workers_{};
+	};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	/**
+	* A queue of at most capacity items passed between threads, such as between the stages of a pipeline. Pushing
+	* blocks while the queue is full, so that a stage running ahead of the next waits for it rather than holding ever
+	* more items, and popping blocks while it is empty. Once closed, pops take the items left and then return nothing,
+	* so that consumers stop once their producers have, and pushes are refused.
+	*
+	* Items are handed over under a mutex rather than lock-free, since each is meant to carry far more work (such as
+	* a whole input) than the lock costs.
+	*/
+	template <typename T>
+	class BoundedQueue
+	{
+		public:
+			explicit BoundedQueue(const std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+			BoundedQueue(const BoundedQueue&) = delete;
+			BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+			/// Adds item once there is room, returning false (dropping it) if the queue is closed.
+			bool push(T item) {
+				std::unique_lock lock(mutex_);
+				notFull_.wait(lock, [&] { return items_.size() < capacity_ || closed_; });
+				if (closed_) {
+					return false;
+				}
+				items_.push_back(std::move(item));
+				lock.unlock();
+				notEmpty_.notify_one();
+				return true;
+			}
+
+			/// Takes the oldest item once there is one, or returns nothing once the queue is closed and empty.
+			[[nodiscard]] std::optional<T> pop() {
+				std::unique_lock lock(mutex_);
+				notEmpty_.wait(lock, [&] { return !items_.empty() || closed_; });
+				if (items_.empty()) {
+					return std::nullopt;
+				}
+				std::optional<T> item(std::move(items_.front()));
+				items_.pop_front();
+				lock.unlock();
+				notFull_.notify_one();
+				return item;
+			}
+
+			/// Refuses any further pushes, waking every waiting thread.
+			void close() {
+				{
+					const std::lock_guard lock(mutex_);
+					closed_ = true;
+				}
+				notFull_.notify_all();
+				notEmpty_.notify_all();
+			}
+
+		private:
+			std::size_t capacity_;
+			std::mutex mutex_{};
+			std::condition_variable notFull_{};
+			std::condition_variable notEmpty_{};
+			std::deque<T> items_{};
+			bool closed_ = false;
+	};
+}
+
+#endif // BSO_HELPERS_PARALLEL_HPP
\ No newline at end of file
@@ -1,10 +1,28 @@
 #ifndef BSO_HELPERS_PLATFORM_HPP
 #define BSO_HELPERS_PLATFORM_HPP
 
+// Included for the standard library's configuration macros (such as __GLIBC__), and nothing else.
+#include <version>
+
 #if defined(_WIN32) || defined(_WIN64)
 	#define BSO_IS_WINDOWS 1
 #else
 	#define BSO_IS_WINDOWS 0
 #endif
 
+/*
+* Marks a (non-template, non-inline) function to be compiled once per instruction set listed, with the version for
+* the CPU running the program chosen when it loads. This needs the loader to resolve the choice (glibc's ifunc), so
+* is only done for x86-64 Linux, where AVX2 and AVX-512 are optional. Elsewhere the baseline build is used: NEON, for
+* one, is always available on AArch64.
+*/
+#if defined(__x86_64__) && defined(__ELF__) && defined(__GLIBC__) && defined(__has_attribute)
+	#if __has_attribute(target_clones)
+		#define BSO_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+	#endif
+#endif
+#ifndef BSO_TARGET_CLONES
+	#define BSO_TARGET_CLONES
+#endif
+
 #endif // BSO_HELPERS_PLATFORM_HPP
\ No newline at end of file
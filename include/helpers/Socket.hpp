@@ -0,0 +1,77 @@
+#ifndef BSO_HELPERS_SOCKET_HPP
+#define BSO_HELPERS_SOCKET_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace Helpers::Socket
+{
+	/// Thrown if a socket cannot be opened, bound or written to.
+	struct SocketError final : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	/// An open TCP connection, which is closed on destruction.
+	class Connection
+	{
+		public:
+			/// Takes ownership of a connected socket (an int on POSIX systems, a SOCKET on Windows).
+			explicit Connection(std::intptr_t handle) noexcept : handle_(handle) {}
+			~Connection();
+
+			// The socket is uniquely owned, so may be moved but not copied.
+			Connection(const Connection&) = delete;
+			Connection& operator=(const Connection&) = delete;
+			Connection(Connection&& other) noexcept;
+			Connection& operator=(Connection&& other) noexcept;
+
+			/// Makes receive give up once nothing has arrived for the timeout, so that a stalled peer cannot hold the
+			/// connection open indefinitely.
+			void setReceiveTimeout(std::chrono::milliseconds timeout) noexcept;
+
+			/// Reads whatever has arrived, up to the size of the buffer, waiting for something if nothing has.
+			/// Returns the number of bytes read, which is 0 once the peer has closed the connection, or if it fails
+			/// or times out.
+			[[nodiscard]] std::size_t receive(std::span<char> buffer) noexcept;
+
+			/// Sends all of data, throwing a SocketError if the connection fails first.
+			void sendAll(std::string_view data);
+
+		private:
+			void close() noexcept;
+
+			std::intptr_t handle_;
+	};
+
+	/// A TCP socket listening for connections, which stops listening on destruction.
+	class Listener
+	{
+		public:
+			/// Listens on the given IPv4 address (such as "127.0.0.1", or "0.0.0.0" for every interface) and port,
+			/// or any free port if 0, throwing a SocketError if it cannot.
+			Listener(std::string_view address, std::uint16_t port);
+			~Listener();
+
+			Listener(const Listener&) = delete;
+			Listener& operator=(const Listener&) = delete;
+
+			/// The port listened on, which is the one chosen if 0 was given.
+			[[nodiscard]] std::uint16_t port() const noexcept { return port_; }
+
+			/// Waits up to the timeout for a connection, returning std::nullopt if none arrives (or accepting fails),
+			/// so that the caller can check whether to stop between waits.
+			[[nodiscard]] std::optional<Connection> accept(std::chrono::milliseconds timeout) noexcept;
+
+		private:
+			std::intptr_t handle_;
+			std::uint16_t port_ = 0;
+	};
+}
+
+#endif // BSO_HELPERS_SOCKET_HPP
@@ -28,6 +28,10 @@ namespace Helpers::Strings
 
 	[[nodiscard]] bool svIsPositiveInt(std::string_view sv) noexcept;
 
+	/// Checks whether a string_view matches a shell-style wildcard pattern, where '*' matches any (possibly empty)
+	/// sequence of characters and '?' matches any single character.
+	[[nodiscard]] bool svWildcardMatch(std::string_view pattern, std::string_view sv) noexcept;
+
 //----------------------------------------------------------------------------------------------------------------------
 
 	template<typename Int>
@@ -51,6 +55,17 @@ namespace Helpers::Strings
 		return s;
 	}
 
+	/// As formatIntWithSeparator, but for a non-negative integer already written out as digits, such as one too large
+	/// for any integer type, inserting the separators in a single pass however many digits there are.
+	[[nodiscard]] std::string formatDigitsWithSeparator(
+		std::string_view digits,
+		std::string_view separator = ",",
+		int blockSize = 3
+	);
+
+	/// Returns the string_view as a quoted JSON string, escaping quotes, backslashes and control characters.
+	[[nodiscard]] std::string quoteJSON(std::string_view sv);
+
 //----------------------------------------------------------------------------------------------------------------------
 
 	/// Returns a string of elements of a formattable range separated by the specified delimiter,
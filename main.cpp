@@ -1,10 +1,14 @@
+#include "app/cli/BatchMode.hpp"
 #include "app/cli/Prompts.hpp"
+#include "app/cli/ReduceMode.hpp"
+#include "app/cli/ServeMode.hpp"
 #include "app/counter/PathCounter.hpp"
 #include "app/domain/BondReturnData.hpp"
 #include "app/domain/InvestmentAction.hpp"
 #include "app/io/ExportOptions.hpp"
 #include "app/io/ResultsOutput.hpp"
 #include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/MemoryEstimate.hpp"
 #include "helpers/Meta.hpp"
 #include "helpers/Strings.hpp"
 #include "helpers/printing/StyledPrint.hpp"
@@ -14,22 +18,41 @@
 #include <chrono>
 #include <cstddef>
 #include <exception>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <print>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
-int main()
+int main(const int argc, char* argv[])
 {
+	// Any command-line arguments select non-interactive batch mode, or serving if the first is "serve", or combining
+	// sweep summaries if it is "reduce":
+	if (argc > 1) {
+		const std::vector<std::string_view> args(argv + 1, argv + argc);
+		if (args.front() == "serve") {
+			return ServeMode::run(argv[0], std::span(args).subspan(1));
+		}
+		if (args.front() == "reduce") {
+			return ReduceMode::run(argv[0], std::span(args).subspan(1));
+		}
+		return BatchMode::run(argv[0], args);
+	}
+
 // INPUT ---------------------------------------------------------------------------------------------------------------
 
 	int numResultsRequested{};
 	std::size_t numResultsFound{};
 
 	std::vector<int> tenorList{};
-	int numMonths{};
+	// Counted once the optimiser has finished, so as not to slow it or its timing, while the results are output and
+	// the user decides whether to ask for it, so is usually ready by then.
+	std::shared_future<std::string> pathCount{};
 
 	std::chrono::duration<double, std::milli> computationTime{};
 
@@ -42,15 +65,25 @@ int main()
 		std::println();
 
 		tenorList = tenorData.tenors();
-		numMonths = tenorData.numMonths();
 
-		const auto numResultsPromptResult = Prompts::getNumResultsPrompt();
+		const auto numResultsPromptResult = Prompts::getNumResultsPrompt(tenorData);
 		if (numResultsPromptResult.isEscape()) {
 			return 0;
 		}
 		numResultsRequested = numResultsPromptResult.getValue();
 		std::println();
 
+		// Fits the run to the memory available before anything is allocated, as the prompt will have warned:
+		DynamicOptimiser::OptimiserOptions optimiserOptions{};
+		int numResultsRun = numResultsRequested;
+		if (const auto memoryBudget = DynamicOptimiser::defaultMemoryBudget()) {
+			const auto admission = DynamicOptimiser::admitRun(
+				tenorData, numResultsRequested, optimiserOptions, *memoryBudget
+			);
+			optimiserOptions = admission.options;
+			numResultsRun = admission.numResultsRequested;
+		}
+
 		const auto exportDecision = IO::Output::getExportDecision(tenorData);
 
 // CALCULATION ---------------------------------------------------------------------------------------------------------
@@ -59,17 +92,29 @@ int main()
 
 		DynamicOptimiser::OptimalResults results{};
 		try {
-			results = DynamicOptimiser::getOptimalSequences(tenorData, numResultsRequested);
+			results = DynamicOptimiser::getOptimalSequences(tenorData, numResultsRun, optimiserOptions);
 		}
 		catch (const std::overflow_error& e) {
+			// Products of returns have overflowed, but sums of their logs cannot, so fall back to log space:
 			Helpers::Printing::styledPrintln(Helpers::Printing::Styles::error, "Overflow: {}", e.what());
-			return 1;
+			std::println("Retrying using log returns...");
+			std::println();
+			try {
+				optimiserOptions.logSpace = true;
+				results = DynamicOptimiser::getOptimalSequences(tenorData, numResultsRun, optimiserOptions);
+			}
+			catch (const std::domain_error& logError) {
+				Helpers::Printing::styledPrintln(Helpers::Printing::Styles::error, "Error: {}", logError.what());
+				return 1;
+			}
 		}
 
 		const auto endTime = std::chrono::steady_clock::now();
 
 		computationTime = endTime - startTime;
 
+		pathCount = PathCounter::countPathsAsync(tenorList, tenorData.numMonths());
+
 		numResultsFound = results.CRFs.size();
 
 // OUTPUT --------------------------------------------------------------------------------------------------------------
@@ -77,7 +122,7 @@ int main()
 		const auto outcome = std::visit(
 			Helpers::Meta::overloaded(
 				[&](const IO::Output::Decision::Save& d) {
-					return IO::Output::exportCSV(results, numResultsFound, d.filePath);
+					return IO::Output::exportResults(results, numResultsFound, tenorList, d);
 				},
 				[](const IO::Output::Decision::Print&) {
 					return IO::Output::ExportOutcome::Print;
@@ -133,7 +178,13 @@ int main()
 	std::println();
 
 	std::println("Total possible strategies:");
-	PathCounter::printPathCount(tenorList, numMonths);
+	try {
+		PathCounter::printPathCount(pathCount.get());
+	}
+	catch (const std::exception& e) {
+		Helpers::Printing::styledPrintln(Helpers::Printing::Styles::error, "Unexpected error: {}", e.what());
+		return 1;
+	}
 	std::println();
 
 	std::println("Press ENTER to quit:");
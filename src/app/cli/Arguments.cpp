@@ -0,0 +1,47 @@
+#include "app/cli/Arguments.hpp"
+
+#include "helpers/Strings.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace Arguments
+{
+	std::pair<std::string_view, std::optional<std::string_view>> splitInlineValue(const std::string_view arg) {
+		if (arg.starts_with("--")) {
+			if (const std::size_t equalsPos = arg.find('='); equalsPos != std::string_view::npos) {
+				return {arg.substr(0, equalsPos), arg.substr(equalsPos + 1)};
+			}
+		}
+		return {arg, std::nullopt};
+	}
+
+	int parsePositiveInt(const std::string_view sv, const std::string_view description) {
+		int result{};
+		if (
+			auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), result);
+			ec == std::errc::result_out_of_range && !sv.starts_with('-')
+		) {
+			throw ArgumentError(std::format("{} {} is too large", description, sv));
+		}
+		if (!Helpers::Strings::svIsPositiveInt(sv)) {
+			throw ArgumentError(std::format("{} must be a positive integer, received {}", description, sv));
+		}
+		return result;
+	}
+
+	double parseNonNegativeNumber(const std::string_view sv, const std::string_view description) {
+		double result{};
+		const auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), result);
+		if (ec != std::errc{} || ptr != sv.data() + sv.size() || !std::isfinite(result) || result < 0.0) {
+			throw ArgumentError(std::format("{} must be a non-negative number, received {}", description, sv));
+		}
+		return result;
+	}
+}
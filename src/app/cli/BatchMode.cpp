@@ -0,0 +1,1000 @@
+#include "app/cli/BatchMode.hpp"
+
+#include "app/cli/Arguments.hpp"
+#include "app/cli/OutputMessages.hpp"
+#include "app/domain/BondReturnData.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/io/BinaryCurve.hpp"
+#include "app/io/BinaryResults.hpp"
+#include "app/io/DataLoader.hpp"
+#include "app/io/ExportOptions.hpp"
+#include "app/io/ResultsOutput.hpp"
+#include "app/io/SweepSummary.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/MemoryEstimate.hpp"
+#include "app/optimiser/OptimiserState.hpp"
+#include "app/optimiser/ResultCache.hpp"
+#include "helpers/Filesystem.hpp"
+#include "helpers/Parallel.hpp"
+#include "helpers/Strings.hpp"
+#include "helpers/printing/StyledPrint.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <print>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace BatchMode
+{
+	namespace Detail
+	{
+		namespace Output
+		{
+			/// Returns "<dir>/<input name>_RESULTS_FILENAME.csv", numbering the file if an earlier input in the batch
+			/// has already claimed that name (e.g. two inputs with the same name in different directories).
+			[[nodiscard]] static std::filesystem::path outputPathFor(
+				const std::filesystem::path& inputPath,
+				const std::filesystem::path& outputDirectory,
+				const bool binaryResults,
+				std::set<std::filesystem::path>& usedOutputPaths
+			) {
+				const std::string stem = inputPath.stem().string();
+				const std::string_view extension = binaryResults ? IO::Output::binaryResultsExtension : "csv";
+				std::filesystem::path candidate =
+					outputDirectory / std::format("{}_{}.{}", stem, IO::Output::RESULTS_FILENAME, extension);
+				for (int i = 2; !usedOutputPaths.insert(candidate).second; ++i) {
+					candidate = outputDirectory
+						/ std::format("{}_{}_{}.{}", stem, IO::Output::RESULTS_FILENAME, i, extension);
+				}
+				return candidate;
+			}
+
+			/**
+			* Runs the optimiser, writing each block of results to outputPath with a Writer (constructed from the path
+			* and writerArgs) as their paths are walked, rather than holding every path at once, and returns the number
+			* of results found, setting bestHPR if there are any. The file is only created once the run has succeeded,
+			* just as when the results are written after it.
+			*/
+			template <typename Writer, typename... WriterArgs>
+			[[nodiscard]] static std::size_t streamResults(
+				const Domain::BondReturnData& tenorData,
+				const int numResultsRequested,
+				const DynamicOptimiser::OptimiserOptions& optimiserOptions,
+				DynamicOptimiser::Workspace& workspace,
+				const std::filesystem::path& outputPath,
+				std::string& bestHPR,
+				const WriterArgs&... writerArgs
+			) {
+				std::optional<Writer> writer{};
+				const std::size_t numResultsFound = DynamicOptimiser::streamOptimalSequences(
+					tenorData,
+					numResultsRequested,
+					[&](const std::size_t firstRank, const DynamicOptimiser::OptimalResults& block) {
+						if (firstRank == 0) {
+							bestHPR = IO::Output::formatHoldingPeriodReturn(block, 0);
+							writer.emplace(outputPath, writerArgs...);
+						}
+						writer->write(block, firstRank, block.size());
+					},
+					workspace,
+					optimiserOptions
+				);
+				if (!writer) {
+					writer.emplace(outputPath, writerArgs...);
+				}
+				writer->finish();
+				return numResultsFound;
+			}
+		}
+
+		namespace State
+		{
+			/// Returns "<input path>.bsos", where the optimiser state for an input is kept.
+			[[nodiscard]] static std::filesystem::path statePathFor(const std::filesystem::path& inputPath) {
+				auto statePath = inputPath;
+				statePath += '.';
+				statePath += DynamicOptimiser::optimiserStateExtension;
+				return statePath;
+			}
+
+			/// Writes the state via a temporary file renamed into place, so that a concurrent or interrupted write
+			/// never leaves a partial state behind. The state is only an optimisation, so failures are ignored.
+			static void trySaveState(
+				const DynamicOptimiser::OptimiserState& state,
+				const std::filesystem::path& statePath
+			) {
+				auto tempPath = statePath;
+				tempPath += ".tmp";
+				std::error_code ec{};
+				try {
+					state.save(tempPath);
+				}
+				catch (const std::ios_base::failure&) {
+					std::filesystem::remove(tempPath, ec);
+					return;
+				}
+				std::filesystem::rename(tempPath, statePath, ec);
+				if (ec) {
+					std::filesystem::remove(tempPath, ec);
+				}
+			}
+
+			/**
+			* Runs the optimiser over the input by extending its saved state if that was run over the earlier months of
+			* the same data with the same options, and from month 0 otherwise, saving the new state in its place.
+			* Returns the number of months the saved state had already run, 0 if it could not be used.
+			*/
+			[[nodiscard]] static int runWithState(
+				const Domain::BondReturnData& tenorData,
+				const std::filesystem::path& inputPath,
+				const BatchOptions& options,
+				DynamicOptimiser::OptimalResults& results
+			) {
+				const auto statePath = statePathFor(inputPath);
+				std::optional<DynamicOptimiser::OptimiserState> state{};
+				std::error_code ec{};
+				if (std::filesystem::is_regular_file(statePath, ec)) {
+					try {
+						state.emplace(DynamicOptimiser::OptimiserState::load(statePath));
+					}
+					catch (const DynamicOptimiser::OptimiserStateError&) {
+						// A damaged state is simply replaced below.
+					}
+				}
+
+				int resumedMonths = 0;
+				if (
+					state
+					&& state->numResultsRequested() == options.numResultsRequested
+					&& state->logSpace() == options.logSpace
+					&& state->canExtendWith(tenorData)
+				) {
+					resumedMonths = state->numMonths();
+					state->extend(tenorData);
+				}
+				else {
+					state.emplace(tenorData, options.numResultsRequested, DynamicOptimiser::OptimiserOptions{
+						.logSpace = options.logSpace
+					});
+				}
+
+				if (state->numMonths() != resumedMonths) {
+					trySaveState(*state, statePath);
+				}
+				state->results(results);
+				return resumedMonths;
+			}
+		}
+
+		static void printError(const std::string_view message) {
+			Helpers::Printing::styledPrintln(std::cerr, Helpers::Printing::Styles::error, "{}", message);
+		}
+
+		/// Parses "<i>/<n>", for the ith of n shards counting from 1, into the shard's index (from 0) and n.
+		[[nodiscard]] static std::pair<std::size_t, std::size_t> parseShard(const std::string_view sv) {
+			const std::size_t slashPos = sv.find('/');
+			if (slashPos == std::string_view::npos) {
+				throw ArgumentError(std::format("shard must be given as <i>/<n>, received {}", sv));
+			}
+			const int shard = Arguments::parsePositiveInt(sv.substr(0, slashPos), "shard");
+			const int numShards = Arguments::parsePositiveInt(sv.substr(slashPos + 1), "number of shards");
+			if (shard > numShards) {
+				throw ArgumentError(std::format("shard {} is beyond the {} shards", shard, numShards));
+			}
+			return {static_cast<std::size_t>(shard - 1), static_cast<std::size_t>(numShards)};
+		}
+
+		/// Reads the inputs listed in a manifest, one per line, skipping blank lines and those starting with '#'. Each
+		/// is taken relative to the manifest's directory, so that the manifest can be used from anywhere.
+		[[nodiscard]] static std::vector<std::string> readManifest(const std::filesystem::path& manifestPath) {
+			std::ifstream in(manifestPath);
+			if (!in) {
+				throw std::ios_base::failure("cannot open manifest");
+			}
+			std::vector<std::string> patterns{};
+			for (std::string line; std::getline(in, line);) {
+				if (line.ends_with('\r')) {
+					line.pop_back();
+				}
+				if (line.empty() || line.starts_with('#')) {
+					continue;
+				}
+				patterns.push_back((manifestPath.parent_path() / line).string());
+			}
+			if (in.bad()) {
+				throw std::ios_base::failure("cannot read manifest");
+			}
+			return patterns;
+		}
+
+		/// Writes each input's instrumentation report, as {"inputs": [{"input": <path>, "report": {...}}, ...]},
+		/// throwing std::ios_base::failure if writing fails.
+		static void writeProfile(
+			const std::vector<std::pair<std::filesystem::path, Instrumentation::Report>>& reports,
+			const std::filesystem::path& profilePath
+		) {
+			std::ofstream out(profilePath, std::ios::trunc);
+			// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+			out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+			out << "{\"inputs\": [";
+			for (std::size_t i = 0; i < reports.size(); ++i) {
+				out << std::format(
+					"{}\n  {{\"input\": {}, \"report\": {}}}",
+					i == 0 ? "" : ",",
+					Helpers::Strings::quoteJSON(reports[i].first.string()),
+					Instrumentation::toJSON(reports[i].second)
+				);
+			}
+			out << "\n]}\n";
+			out.flush();
+		}
+
+		namespace Run
+		{
+			/// Thrown if an input's run would not fit in the memory available, even once adjusted.
+			class AdmissionError : public std::runtime_error
+			{
+				public:
+					using std::runtime_error::runtime_error;
+			};
+
+			/// An input as it passes through the batch: loaded, run, then saved or printed and reported.
+			struct Job
+			{
+				std::filesystem::path inputPath{};
+				// The input's position among every input of the batch, before any sharding.
+				std::size_t position = 0;
+				// "[i/n] <input path>", prefixing every message about the input.
+				std::string progress{};
+				std::optional<Domain::BondReturnData> tenorData{};
+				// Set if the run was adjusted to fit in the memory available, reported before its results.
+				std::optional<std::string> note{};
+				DynamicOptimiser::OptimalResults results{};
+				std::vector<DynamicOptimiser::OptimalResults> resultsByHorizon{};
+				// Set if the results were streamed straight to the output file rather than held:
+				std::optional<std::size_t> numResultsStreamed{};
+				std::string bestHPR{};
+				std::filesystem::path outputPath{};
+				std::chrono::duration<double, std::milli> computationTime{};
+				int resumedMonths = 0;
+				bool fromSavedResults = false;
+				// Set once a stage fails, so that later stages pass the job on to be reported without running it.
+				std::optional<std::string> failure{};
+
+				/// Readies the job for the ith of numInputs inputs, at the given position in the whole batch, keeping
+				/// the storage its results already hold.
+				void reset(
+					std::filesystem::path path,
+					const std::size_t batchPosition,
+					const std::size_t i,
+					const std::size_t numInputs
+				) {
+					progress = std::format("[{}/{}] {}", i + 1, numInputs, path.string());
+					inputPath = std::move(path);
+					position = batchPosition;
+					tenorData.reset();
+					note.reset();
+					numResultsStreamed.reset();
+					bestHPR = "0.00%";
+					outputPath.clear();
+					computationTime = {};
+					resumedMonths = 0;
+					fromSavedResults = false;
+					failure.reset();
+				}
+			};
+
+			/// Returns the message reporting the failure of the job for the exception being handled.
+			[[nodiscard]] static std::string describeFailure(const Job& job) {
+				try {
+					throw;
+				}
+				catch (const AdmissionError& e) {
+					return std::format("{}: {}", job.progress, e.what());
+				}
+				catch (const IO::Input::LoadError& e) {
+					return std::format("{}: failed to load data: {}", job.progress, e.what());
+				}
+				catch (const std::overflow_error& e) {
+					return std::format("{}: overflow: {} (try --log-space)", job.progress, e.what());
+				}
+				catch (const std::ios_base::failure&) {
+					return std::format("{}: failed to write to {}", job.progress, job.outputPath.string());
+				}
+				catch (const std::exception& e) {
+					// Such as a domain_error for returns log space cannot hold, an invalid_argument for an input with
+					// too many tenors for binary results, or running out of memory for this input alone:
+					return std::format("{}: {}", job.progress, e.what());
+				}
+			}
+
+			static void load(Job& job, const BatchOptions& options) {
+				job.tenorData.emplace(IO::Input::loadBondReturnData(
+					job.inputPath.string(), {.useBinaryCache = options.useBinaryCache}
+				));
+			}
+
+			/**
+			* Runs the optimiser over the job's data, fitted to memoryBudget if given (throwing an AdmissionError if it
+			* cannot fit), and answered from resultCache if given. If streamedOutputPaths is given, the results are
+			* streamed straight to the output file where they can be, its name being claimed there.
+			*/
+			static void optimise(
+				Job& job,
+				const BatchOptions& options,
+				const std::optional<std::size_t> memoryBudget,
+				DynamicOptimiser::ResultCache* const resultCache,
+				DynamicOptimiser::Workspace& workspace,
+				std::set<std::filesystem::path>* const streamedOutputPaths
+			) {
+				const Domain::BondReturnData& tenorData = *job.tenorData;
+				DynamicOptimiser::OptimiserOptions optimiserOptions{
+					.lowMemory = options.lowMemory,
+					.logSpace = options.logSpace,
+					.distinctPurchases = options.distinctPurchases
+				};
+				// Runs answered from saved states need every result before writing, as do summaries of the batch.
+				const bool streamToFile = streamedOutputPaths && options.outputDirectory && !options.allHorizons
+					&& !resultCache && !options.summaryPath;
+				int numResultsRun = options.numResultsRequested;
+				if (memoryBudget) {
+					const auto admission = DynamicOptimiser::admitRun(
+						tenorData, options.numResultsRequested, optimiserOptions, *memoryBudget, streamToFile
+					);
+					if (!admission.fits) {
+						throw AdmissionError(OutputMessages::admissionNote(admission, options.numResultsRequested));
+					}
+					if (admission.adjusted()) {
+						job.note = OutputMessages::admissionNote(admission, options.numResultsRequested);
+					}
+					optimiserOptions = admission.options;
+					numResultsRun = admission.numResultsRequested;
+				}
+
+				const auto startTime = std::chrono::steady_clock::now();
+				if (options.withinBasisPoints) {
+					const DynamicOptimiser::CRFThreshold threshold{
+						.kind = DynamicOptimiser::CRFThreshold::Kind::BelowBest,
+						// A basis point is 0.01% of HPR, and so of CRF:
+						.value = *options.withinBasisPoints / 10'000.0
+					};
+					DynamicOptimiser::getOptimalSequencesWithin(
+						tenorData,
+						threshold,
+						job.results,
+						{.logSpace = options.logSpace}
+					);
+				}
+				else if (options.allHorizons) {
+					DynamicOptimiser::getOptimalSequencesForAllHorizons(
+						tenorData, numResultsRun, job.resultsByHorizon, workspace, optimiserOptions
+					);
+				}
+				else if (resultCache) {
+					job.fromSavedResults = resultCache->get(tenorData, numResultsRun, job.results, optimiserOptions);
+				}
+				else if (options.keepState) {
+					job.resumedMonths = State::runWithState(tenorData, job.inputPath, options, job.results);
+				}
+				else if (streamToFile) {
+					job.outputPath = Output::outputPathFor(
+						job.inputPath, *options.outputDirectory, options.binaryResults, *streamedOutputPaths
+					);
+					job.numResultsStreamed = options.binaryResults
+						? Output::streamResults<IO::Output::BinaryResultsWriter>(
+							tenorData,
+							numResultsRun,
+							optimiserOptions,
+							workspace,
+							job.outputPath,
+							job.bestHPR,
+							tenorData.tenors()
+						)
+						: Output::streamResults<IO::Output::CSVWriter>(
+							tenorData, numResultsRun, optimiserOptions, workspace, job.outputPath, job.bestHPR
+						);
+				}
+				else {
+					DynamicOptimiser::getOptimalSequences(
+						tenorData, numResultsRun, job.results, workspace, optimiserOptions
+					);
+				}
+				job.computationTime = std::chrono::steady_clock::now() - startTime;
+			}
+
+			/// Saves the job's results (unless they were streamed) or prints them, adds them to summary if given, and
+			/// reports the run.
+			static void finish(
+				Job& job,
+				const BatchOptions& options,
+				std::set<std::filesystem::path>& usedOutputPaths,
+				IO::SweepSummary* const summary
+			) {
+				// Runs for every horizon are reported by the longest, which is that of a single run:
+				const DynamicOptimiser::OptimalResults& reportedResults =
+					options.allHorizons && !job.resultsByHorizon.empty() ? job.resultsByHorizon.back() : job.results;
+				const std::size_t numResultsFound = job.numResultsStreamed.value_or(reportedResults.CRFs.size());
+				if (!job.numResultsStreamed && numResultsFound > 0) {
+					job.bestHPR = IO::Output::formatHoldingPeriodReturn(reportedResults, 0);
+				}
+
+				if (options.outputDirectory && !job.numResultsStreamed) {
+					job.outputPath = Output::outputPathFor(
+						job.inputPath, *options.outputDirectory, options.binaryResults, usedOutputPaths
+					);
+					if (options.allHorizons) {
+						IO::Output::writeHorizonsCSV(job.resultsByHorizon, job.outputPath);
+					}
+					else if (options.binaryResults) {
+						IO::Output::writeBinaryResults(
+							job.results, numResultsFound, job.tenorData->tenors(), job.outputPath
+						);
+					}
+					else {
+						IO::Output::writeCSV(job.results, numResultsFound, job.outputPath);
+					}
+				}
+				if (summary) {
+					summary->add(job.inputPath.string(), job.position, job.results);
+				}
+
+				if (!options.quiet) {
+					if (job.note) {
+						std::println("{}: note: {}", job.progress, *job.note);
+					}
+					std::println(
+						"{}: {} results{}, best HPR {}, computed in {:.3f} ms{}",
+						job.progress,
+						Helpers::Strings::formatIntWithSeparator(numResultsFound),
+						options.allHorizons
+							? std::format(" for each of {} horizons", job.resultsByHorizon.size())
+							: "",
+						job.bestHPR,
+						job.computationTime.count(),
+						job.resumedMonths > 0
+							? std::format(" (resumed after month {})", job.resumedMonths)
+							: job.fromSavedResults ? " (from saved results)" : ""
+					);
+					if (options.outputDirectory) {
+						std::println("Saved to {}", job.outputPath.string());
+					}
+				}
+				if (!options.outputDirectory && options.allHorizons) {
+					for (std::size_t h = 0; h < job.resultsByHorizon.size(); ++h) {
+						std::println();
+						std::println("Over {} month{}:", h + 1, h == 0 ? "" : "s");
+						IO::Output::printResults(job.resultsByHorizon[h], job.resultsByHorizon[h].size());
+					}
+					std::println();
+				}
+				else if (!options.outputDirectory && !summary) {
+					IO::Output::printResults(job.results, numResultsFound);
+					std::println();
+				}
+			}
+
+			/**
+			* Runs the inputs through a pipeline of three stages joined by bounded queues, so that loading and writing
+			* overlap the runs rather than waiting in turn: loader threads read inputs, options.numJobs workers run
+			* them (each with its own workspace, and any parallel work inside a run serial), and a single writer saves
+			* or prints each input's results (adding them to summary if given) and reports it, in the order the runs
+			* finish. A stage running ahead blocks on its full queue, so at most a few inputs per worker are held at
+			* once, and memoryBudget is split between them. Results are held until written rather than streamed, so
+			* that workers never wait on disk. Returns the number of inputs that failed.
+			*/
+			[[nodiscard]] static int runPipelined(
+				const std::vector<std::filesystem::path>& inputPaths,
+				const std::vector<std::size_t>& positions,
+				const BatchOptions& options,
+				const std::optional<std::size_t> memoryBudget,
+				DynamicOptimiser::ResultCache* const resultCache,
+				IO::SweepSummary* const summary
+			) {
+				const std::size_t numInputs = inputPaths.size();
+				const std::size_t numWorkers = std::min<std::size_t>(options.numJobs, numInputs);
+				// Loading is mostly waiting on disk, so a couple of threads keep the workers fed:
+				const std::size_t numLoaders = std::min<std::size_t>(2, numInputs);
+				// Each worker holds a run, and the writer and its queue up to numWorkers + 1 more runs' results, so the
+				// budget is split between them:
+				const std::optional<std::size_t> budgetPerJob = memoryBudget
+					? std::optional(*memoryBudget / (2 * numWorkers + 1))
+					: std::nullopt;
+
+				Helpers::Parallel::BoundedQueue<std::unique_ptr<Job>> loaded(numWorkers);
+				Helpers::Parallel::BoundedQueue<std::unique_ptr<Job>> optimised(numWorkers);
+				std::atomic<std::size_t> nextInput{0};
+				int numFailed = 0;
+				{
+					std::jthread writer([&] {
+						std::set<std::filesystem::path> usedOutputPaths{};
+						while (auto job = optimised.pop()) {
+							if (!(*job)->failure) {
+								try {
+									finish(**job, options, usedOutputPaths, summary);
+								}
+								catch (...) {
+									(*job)->failure = describeFailure(**job);
+								}
+							}
+							if ((*job)->failure) {
+								printError(*(*job)->failure);
+								++numFailed;
+							}
+						}
+					});
+					{
+						std::vector<std::jthread> workers{};
+						workers.reserve(numWorkers);
+						for (std::size_t w = 0; w < numWorkers; ++w) {
+							workers.emplace_back([&] {
+								const Helpers::Parallel::SerialScope serialScope{};
+								DynamicOptimiser::Workspace workspace{};
+								while (auto job = loaded.pop()) {
+									if (!(*job)->failure) {
+										try {
+											optimise(**job, options, budgetPerJob, resultCache, workspace, nullptr);
+										}
+										catch (...) {
+											(*job)->failure = describeFailure(**job);
+										}
+									}
+									optimised.push(std::move(*job));
+								}
+							});
+						}
+						{
+							std::vector<std::jthread> loaders{};
+							loaders.reserve(numLoaders);
+							for (std::size_t l = 0; l < numLoaders; ++l) {
+								loaders.emplace_back([&] {
+									for (std::size_t i = nextInput++; i < numInputs; i = nextInput++) {
+										auto job = std::make_unique<Job>();
+										job->reset(inputPaths[i], positions[i], i, numInputs);
+										try {
+											load(*job, options);
+										}
+										catch (...) {
+											job->failure = describeFailure(*job);
+										}
+										loaded.push(std::move(job));
+									}
+								});
+							}
+							// The jthreads join on leaving scope, each stage once the one before has finished.
+						}
+						loaded.close();
+					}
+					optimised.close();
+				}
+				return numFailed;
+			}
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	BatchOptions parseArguments(const std::span<const std::string_view> args) {
+		BatchOptions options{};
+		bool numResultsProvided = false;
+
+		for (std::size_t i = 0; i < args.size(); ++i) {
+			const auto [name, inlineValue] = Arguments::splitInlineValue(args[i]);
+
+			// Returns the value for the current option, whether given as "--option=value" or "--option value":
+			const auto getValue = [&, name = name, inlineValue = inlineValue]() -> std::string_view {
+				if (inlineValue) {
+					return *inlineValue;
+				}
+				if (i + 1 >= args.size()) {
+					throw ArgumentError(std::format("missing value for {}", name));
+				}
+				return args[++i];
+			};
+
+			if (name == "-h" || name == "--help") {
+				options.showHelp = true;
+			}
+			else if (name == "-q" || name == "--quiet") {
+				options.quiet = true;
+			}
+			else if (name == "-c" || name == "--cache") {
+				options.useBinaryCache = true;
+			}
+			else if (name == "--low-memory") {
+				options.lowMemory = true;
+			}
+			else if (name == "--no-memory-check") {
+				options.checkMemory = false;
+			}
+			else if (name == "--log-space") {
+				options.logSpace = true;
+			}
+			else if (name == "--distinct") {
+				options.distinctPurchases = true;
+			}
+			else if (name == "--all-horizons") {
+				options.allHorizons = true;
+			}
+			else if (name == "--binary") {
+				options.binaryResults = true;
+			}
+			else if (name == "-s" || name == "--state") {
+				options.keepState = true;
+			}
+			else if (name == "-i" || name == "--input") {
+				options.inputPatterns.emplace_back(getValue());
+			}
+			else if (name == "-k" || name == "--top") {
+				options.numResultsRequested = Arguments::parsePositiveInt(getValue(), "number of results");
+				numResultsProvided = true;
+			}
+			else if (name == "--within") {
+				options.withinBasisPoints =
+					Arguments::parseNonNegativeNumber(getValue(), "margin in basis points");
+			}
+			else if (name == "-j" || name == "--threads") {
+				options.maxThreads = static_cast<unsigned int>(
+					Arguments::parsePositiveInt(getValue(), "number of threads")
+				);
+			}
+			else if (name == "--shard") {
+				std::tie(options.shardIndex, options.numShards) = Detail::parseShard(getValue());
+			}
+			else if (name == "--manifest") {
+				try {
+					options.manifestPath = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw ArgumentError(std::format("invalid manifest path: {}", e.what()));
+				}
+			}
+			else if (name == "--summary") {
+				try {
+					options.summaryPath = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw ArgumentError(std::format("invalid summary path: {}", e.what()));
+				}
+			}
+			else if (name == "--jobs") {
+				options.numJobs = static_cast<unsigned int>(
+					Arguments::parsePositiveInt(getValue(), "number of jobs")
+				);
+			}
+			else if (name == "--profile") {
+				if constexpr (!Instrumentation::enabled) {
+					throw ArgumentError("--profile needs a build configured with -DBSO_INSTRUMENTATION=ON");
+				}
+				try {
+					options.profilePath = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw ArgumentError(std::format("invalid profile path: {}", e.what()));
+				}
+			}
+			else if (name == "--results-dir") {
+				try {
+					options.resultDirectory = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw ArgumentError(std::format("invalid results directory: {}", e.what()));
+				}
+			}
+			else if (name == "-o" || name == "--output") {
+				try {
+					options.outputDirectory = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw ArgumentError(std::format("invalid output directory: {}", e.what()));
+				}
+			}
+			else if (name.starts_with('-') && name.size() > 1) {
+				throw ArgumentError(std::format("unknown option {}", name));
+			}
+			else {
+				// Anything else is taken to be an input:
+				options.inputPatterns.emplace_back(args[i]);
+			}
+		}
+
+		if (options.showHelp) {
+			return options;
+		}
+		if (options.inputPatterns.empty() && !options.manifestPath) {
+			throw ArgumentError("no input files provided");
+		}
+		if (numResultsProvided && options.withinBasisPoints) {
+			throw ArgumentError("-k and --within cannot be combined");
+		}
+		if (!numResultsProvided && !options.withinBasisPoints) {
+			throw ArgumentError("the number of results must be provided with -k (or a margin with --within)");
+		}
+		if (options.withinBasisPoints && (options.keepState || options.lowMemory)) {
+			throw ArgumentError("--within cannot be combined with --state or --low-memory");
+		}
+		if (options.distinctPurchases && (options.withinBasisPoints || options.keepState || options.lowMemory)) {
+			throw ArgumentError("--distinct cannot be combined with --within, --state or --low-memory");
+		}
+		if (options.allHorizons
+			&& (options.withinBasisPoints || options.keepState || options.lowMemory || options.binaryResults)) {
+			throw ArgumentError("--all-horizons cannot be combined with --within, --state, --low-memory or --binary");
+		}
+		if (options.resultDirectory
+			&& (options.withinBasisPoints || options.keepState || options.lowMemory || options.distinctPurchases
+				|| options.allHorizons)) {
+			throw ArgumentError(
+				"--results-dir cannot be combined with --within, --state, --low-memory, --distinct or --all-horizons"
+			);
+		}
+		if (options.summaryPath && (options.withinBasisPoints || options.allHorizons)) {
+			throw ArgumentError("--summary cannot be combined with --within or --all-horizons");
+		}
+		if (options.numJobs > 1 && options.profilePath) {
+			throw ArgumentError("--profile records one run at a time, so cannot be combined with --jobs");
+		}
+		if (options.binaryResults && !options.outputDirectory) {
+			throw ArgumentError("--binary saves results to files, so needs an output directory (-o)");
+		}
+		if (options.keepState && options.lowMemory) {
+			throw ArgumentError("--state keeps every month's decisions, so cannot be combined with --low-memory");
+		}
+		return options;
+	}
+
+	void printUsage(const std::string_view programName) {
+		std::println("Usage: {} [options] <input>...", programName);
+		std::println();
+		std::println("Runs the optimiser over each input without prompting (run with no arguments for interactive mode).");
+		std::println("To serve queries over HTTP instead, run {} serve (see {} serve --help).", programName, programName);
+		std::println("To combine the summaries of a sweep's shards, run {} reduce (see {} reduce --help).",
+			programName, programName);
+		std::println();
+		std::println("Options:");
+		std::println("  -i, --input <path>   bond return data file, or a pattern with * and ? wildcards in the file name");
+		std::println("                       (may be repeated, inputs may also be given without -i)");
+		std::println("      --manifest <file>");
+		std::println("                       file listing further inputs one per line, relative to its directory");
+		std::println("  -k, --top <n>        number of top results for each input (required, unless --within)");
+		std::println("      --within <bp>    compute every result within <bp> basis points of the best HPR instead");
+		std::println("                       (every return must be at least -100%)");
+		std::println("  -o, --output <dir>   directory to save each input's results to as <input name>_{}.csv,",
+			IO::Output::RESULTS_FILENAME);
+		std::println("                       if omitted results are printed to the terminal");
+		std::println("      --binary         save results in binary as <input name>_{}.{} instead, with columns",
+			IO::Output::RESULTS_FILENAME, IO::Output::binaryResultsExtension);
+		std::println("                       of CRFs and paths for loading into analysis tools (requires -o)");
+		std::println("  -j, --threads <n>    maximum number of threads to use (defaults to every hardware thread)");
+		std::println("      --jobs <n>       run <n> inputs at once, each on a single thread, while others are loaded");
+		std::println("                       and saved, for batches of many small inputs (defaults to 1)");
+		std::println("      --shard <i>/<n>  run only the <i>th of <n> shards of the inputs (every <n>th input from the");
+		std::println("                       <i>th), such as one per machine, to be combined with {} reduce", programName);
+		std::println("      --summary <file> save a summary of the batch to <file>: each input's best HPR, how often");
+		std::println("                       each tenor is bought first, and the top <n> results across every input");
+		std::println("                       (results are then only saved with -o, not printed)");
+		std::println("  -c, --cache          convert each CSV input to a binary .{} file alongside it on first load,",
+			IO::binaryCurveExtension);
+		std::println("                       and load that instead while the CSV is unchanged");
+		std::println("      --low-memory     recompute the optimiser's decisions from checkpoints rather than keeping");
+		std::println("                       them all, using far less memory for long horizons but about twice the time");
+		std::println("      --no-memory-check");
+		std::println("                       run as requested even if estimated not to fit in the memory available,");
+		std::println("                       rather than packing decisions, checkpointing or finding fewer results");
+		std::println("      --log-space      rank by sums of log returns rather than products, so that returns too");
+		std::println("                       large for a double cannot overflow (every return must be above -100%)");
+		std::println("      --distinct       count strategies buying the same tenors in the same order for the same");
+		std::println("                       HPR as one result, however their waits are placed");
+		std::println("      --all-horizons   find the top <n> results for every horizon from 1 month to the input's last");
+		std::println("                       in a single run, saved together with a column for the horizon");
+		std::println("      --results-dir <dir>");
+		std::println("                       save each input's final optimiser state in <dir>, keyed by its data, and");
+		std::println("                       answer data already run (for as many results or more) from it");
+		std::println("  -s, --state          keep each input's optimiser state in a .{} file alongside it, so that once",
+			DynamicOptimiser::optimiserStateExtension);
+		std::println("                       the input gains months, only the new months are run");
+		std::println("      --profile <file> write each input's time per phase, buffer sizes and merge counts to <file>");
+		std::println("                       as JSON (needs a build with -DBSO_INSTRUMENTATION=ON)");
+		std::println("  -q, --quiet          only report errors (and printed results)");
+		std::println("  -h, --help           show this message");
+	}
+
+	int runBatch(const BatchOptions& options) {
+		Helpers::Parallel::setMaxThreads(options.maxThreads);
+
+		int numFailed = 0;
+
+		std::vector<std::string> inputPatterns = options.inputPatterns;
+		if (options.manifestPath) {
+			try {
+				std::ranges::move(Detail::readManifest(*options.manifestPath), std::back_inserter(inputPatterns));
+			}
+			catch (const std::ios_base::failure&) {
+				Detail::printError(std::format("Failed to read manifest {}", options.manifestPath->string()));
+				return 1;
+			}
+		}
+
+		// Expand every input up front, so that bad patterns are reported before any work is done:
+		std::vector<std::filesystem::path> inputPaths{};
+		for (const auto& pattern : inputPatterns) {
+			try {
+				const auto matches = Helpers::Filesystem::expandGlob(pattern);
+				if (matches.empty()) {
+					Detail::printError(std::format("No files match {}", pattern));
+					++numFailed;
+				}
+				inputPaths.insert(inputPaths.end(), matches.begin(), matches.end());
+			}
+			catch (const Helpers::Filesystem::FilesystemError& e) {
+				Detail::printError(std::format("Invalid input {}: {}", pattern, e.what()));
+				++numFailed;
+			}
+		}
+
+		// Every shard expands the same inputs in the same order, so each can take its own share without coordinating,
+		// remembering where each of its inputs came in the whole batch:
+		std::vector<std::size_t> positions{};
+		{
+			std::vector<std::filesystem::path> shardPaths{};
+			for (std::size_t i = options.shardIndex; i < inputPaths.size(); i += options.numShards) {
+				shardPaths.push_back(std::move(inputPaths[i]));
+				positions.push_back(i);
+			}
+			inputPaths = std::move(shardPaths);
+		}
+
+		if (options.outputDirectory) {
+			try {
+				Helpers::Filesystem::assertDirectoryValid(*options.outputDirectory);
+			}
+			catch (const Helpers::Filesystem::DirectoryError& e) {
+				Detail::printError(std::format("Invalid output directory: {}", e.what()));
+				return 1;
+			}
+		}
+		std::optional<DynamicOptimiser::ResultCache> resultCache{};
+		if (options.resultDirectory) {
+			try {
+				Helpers::Filesystem::assertDirectoryValid(*options.resultDirectory);
+			}
+			catch (const Helpers::Filesystem::DirectoryError& e) {
+				Detail::printError(std::format("Invalid results directory: {}", e.what()));
+				return 1;
+			}
+			// Each input is run once, so only the saved states are reused, and memory need hold only the latest:
+			resultCache.emplace(1, options.resultDirectory);
+		}
+
+		// Runs finding every result within a margin cannot know how many they will find, resuming state needs the
+		// number of results it was saved with, and runs for every horizon hold paths beyond a single run's, so only
+		// single runs for a number of results are fitted to the budget:
+		const auto memoryBudget =
+			options.checkMemory && !options.withinBasisPoints && !options.keepState && !options.allHorizons
+				? DynamicOptimiser::defaultMemoryBudget()
+				: std::nullopt;
+
+		const auto batchStartTime = std::chrono::steady_clock::now();
+		const std::size_t numInputs = inputPaths.size();
+		std::vector<std::pair<std::filesystem::path, Instrumentation::Report>> reports{};
+		std::optional<IO::SweepSummary> summary{};
+		if (options.summaryPath) {
+			summary.emplace(static_cast<std::size_t>(options.numResultsRequested), options.logSpace);
+		}
+
+		if (options.numJobs > 1 && numInputs > 1) {
+			numFailed += Detail::Run::runPipelined(
+				inputPaths,
+				positions,
+				options,
+				memoryBudget,
+				resultCache ? &*resultCache : nullptr,
+				summary ? &*summary : nullptr
+			);
+		}
+		else {
+			// Reused for every input so that storage for the results, and the optimiser's own buffers, are only
+			// reallocated when a run outgrows them.
+			Detail::Run::Job job{};
+			DynamicOptimiser::Workspace workspace{};
+			std::set<std::filesystem::path> usedOutputPaths{};
+
+			for (std::size_t i = 0; i < numInputs; ++i) {
+				job.reset(inputPaths[i], positions[i], i, numInputs);
+				Instrumentation::Report report{};
+				try {
+					std::optional<Instrumentation::Recording> recording{};
+					if (options.profilePath) {
+						recording.emplace(report);
+					}
+					Detail::Run::load(job, options);
+					Detail::Run::optimise(
+						job, options, memoryBudget, resultCache ? &*resultCache : nullptr, workspace, &usedOutputPaths
+					);
+					Detail::Run::finish(job, options, usedOutputPaths, summary ? &*summary : nullptr);
+					if (recording) {
+						recording.reset();
+						reports.emplace_back(job.inputPath, std::move(report));
+					}
+				}
+				catch (...) {
+					Detail::printError(Detail::Run::describeFailure(job));
+					++numFailed;
+				}
+			}
+		}
+
+		if (options.profilePath) {
+			try {
+				Detail::writeProfile(reports, *options.profilePath);
+			}
+			catch (const std::ios_base::failure&) {
+				Detail::printError(std::format("Failed to write profile to {}", options.profilePath->string()));
+				++numFailed;
+			}
+		}
+
+		if (summary) {
+			summary->addFailures(static_cast<std::size_t>(numFailed));
+			try {
+				summary->save(*options.summaryPath);
+				if (!options.quiet) {
+					std::println("Saved summary to {}", options.summaryPath->string());
+				}
+			}
+			catch (const std::ios_base::failure&) {
+				Detail::printError(std::format("Failed to write summary to {}", options.summaryPath->string()));
+				++numFailed;
+			}
+		}
+
+		if (!options.quiet) {
+			const std::chrono::duration<double, std::milli> batchTime = std::chrono::steady_clock::now() - batchStartTime;
+			std::println();
+			std::println(
+				"Processed {} inputs in {:.3f} ms ({} failures)",
+				Helpers::Strings::formatIntWithSeparator(numInputs),
+				batchTime.count(),
+				Helpers::Strings::formatIntWithSeparator(numFailed)
+			);
+		}
+
+		return numFailed == 0 ? 0 : 1;
+	}
+
+	int run(const std::string_view programName, const std::span<const std::string_view> args) {
+		BatchOptions options{};
+		try {
+			options = parseArguments(args);
+		}
+		catch (const ArgumentError& e) {
+			Detail::printError(std::format("Invalid arguments: {}", e.what()));
+			std::println();
+			printUsage(programName);
+			return 2;
+		}
+
+		if (options.showHelp) {
+			printUsage(programName);
+			return 0;
+		}
+		return runBatch(options);
+	}
+}
\ No newline at end of file
@@ -1,8 +1,16 @@
 #include "app/cli/OutputMessages.hpp"
 
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/MemoryEstimate.hpp"
+#include "helpers/Memory.hpp"
+#include "helpers/Strings.hpp"
 #include "helpers/printing/Print.hpp"
 
+#include <cstddef>
+#include <format>
 #include <print>
+#include <string>
+#include <vector>
 
 namespace OutputMessages
 {
@@ -58,6 +66,42 @@ namespace OutputMessages
 		Helpers::Printing::wrappedPrintln("but, if editing in such software, "
 			"ensure that the file remains saved as .csv or .txt.");
 		std::println();
+		Helpers::Printing::wrappedPrintln("Data may also be loaded from a binary .bsoc file, "
+			"as created alongside CSV files by batch mode's --cache option, which loads much faster for large data.");
+		std::println();
 		Helpers::Printing::printRule();
 	}
-}
\ No newline at end of file
+
+	std::string admissionNote(const DynamicOptimiser::Admission& admission, const int numResultsRequested) {
+		std::string note = std::format(
+			"{} results would need up to {} of memory, more than the {} available to use",
+			Helpers::Strings::formatIntWithSeparator(numResultsRequested),
+			Helpers::Memory::formatBytes(admission.requestedEstimate.total()),
+			Helpers::Memory::formatBytes(admission.budgetBytes)
+		);
+		if (!admission.fits) {
+			return note + ", even for a single result";
+		}
+		std::vector<std::string> changes{};
+		if (admission.packedDecisions) {
+			changes.emplace_back("decisions will be bit-packed");
+		}
+		if (admission.lowMemory) {
+			changes.emplace_back("months will be recomputed from checkpoints (taking about twice as long)");
+		}
+		if (admission.cappedResults) {
+			changes.push_back(std::format(
+				"only the top {} results will be found",
+				Helpers::Strings::formatIntWithSeparator(admission.numResultsRequested)
+			));
+		}
+		note += ", so ";
+		for (std::size_t i = 0; i < changes.size(); ++i) {
+			if (i > 0) {
+				note += i + 1 == changes.size() ? " and " : ", ";
+			}
+			note += changes[i];
+		}
+		return note;
+	}
+}
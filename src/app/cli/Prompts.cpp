@@ -2,7 +2,9 @@
 
 #include "app/cli/OutputMessages.hpp"
 #include "app/domain/BondReturnData.hpp"
-#include "app/io/CSVLoader.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/io/DataLoader.hpp"
+#include "app/optimiser/MemoryEstimate.hpp"
 #include "helpers/Quit.hpp"
 #include "helpers/Strings.hpp"
 #include "transformers/Generic.hpp"
@@ -10,13 +12,15 @@
 #include "transformers/Numeric.hpp"
 
 #include <format>
+#include <print>
+#include <string>
 #include <string_view>
 
 namespace Prompts
 {
 	DataPromptResult getDataPrompt() {
 		return Transformers::promptTransformer(
-			"Enter the path to your bond return data file (e.g. bond_data.csv or txt);\n"
+			"Enter the path to your bond return data file (e.g. bond_data.csv, txt or bsoc);\n"
 			"OR enter 'h' to show file help;\n"
 			"OR press ENTER to quit:",
 			[](const std::string_view sv) -> Transformers::TransformerResult<Domain::BondReturnData> {
@@ -31,9 +35,9 @@ namespace Prompts
 					return Transformers::Retry();
 				}
 				try {
-					return IO::Input::loadBondReturnCSV(sv);
+					return IO::Input::loadBondReturnData(sv);
 				}
-				catch (const IO::Input::CSVError& e) {
+				catch (const IO::Input::LoadError& e) {
 					return Transformers::Retry(std::format("Failed to load data: {}", e.what()));
 				}
 			}
@@ -42,7 +46,8 @@ namespace Prompts
 
 //----------------------------------------------------------------------------------------------------------------------
 
-	NumResultsPromptResult getNumResultsPrompt() {
+	NumResultsPromptResult getNumResultsPrompt(const Domain::BondReturnData& tenorData) {
+		const auto memoryBudget = DynamicOptimiser::defaultMemoryBudget();
 		while (true) {
 			const auto numResultsPromptResult = Transformers::Numeric::positiveIntTransformer(
 				"Enter how many of the top results you would like;\n"
@@ -52,18 +57,32 @@ namespace Prompts
 				return numResultsPromptResult;
 			}
 
-			if (
-				const int numResultsRequested = numResultsPromptResult.getValue();
-				// Warning number set in header.
-				numResultsRequested > REQUEST_WARNING_NUM
-			) {
+			const int numResultsRequested = numResultsPromptResult.getValue();
+			std::string warning{};
+			if (memoryBudget) {
+				const auto admission = DynamicOptimiser::admitRun(tenorData, numResultsRequested, {}, *memoryBudget);
+				if (!admission.fits || admission.adjusted()) {
+					warning = std::format(
+						"WARNING: {}.", OutputMessages::admissionNote(admission, numResultsRequested)
+					);
+				}
+			}
+			// Warning number set in header.
+			else if (numResultsRequested > REQUEST_WARNING_NUM) {
+				warning = std::format(
+					"WARNING: You have requested a large number of results ({}).",
+					Helpers::Strings::formatIntWithSeparator(numResultsRequested)
+				);
+			}
+
+			if (!warning.empty()) {
 				std::println();
 				const auto printFallbackPromptResult = Transformers::Mapping::mappingTransformer<bool>(
 					std::format(
-						"WARNING: You have requested a large number of results ({}).\n"
+						"{}\n"
 						"Enter \"y\" to proceed anyway;\n"
 						"OR press ENTER to input a new value:",
-						Helpers::Strings::formatIntWithSeparator(numResultsRequested)
+						warning
 					),
 					{{"y", true}},
 					{.caseSensitive = false, .quitWord = ""}
@@ -0,0 +1,249 @@
+#include "app/cli/ReduceMode.hpp"
+
+#include "app/cli/Arguments.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/io/ResultsOutput.hpp"
+#include "app/io/SweepSummary.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "helpers/Filesystem.hpp"
+#include "helpers/Strings.hpp"
+#include "helpers/printing/StyledPrint.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ReduceMode
+{
+	namespace Detail
+	{
+		static void printError(const std::string_view message) {
+			Helpers::Printing::styledPrintln(std::cerr, Helpers::Printing::Styles::error, "{}", message);
+		}
+
+		/// Prints the spread of the inputs' best HPRs, as the value at each of a few quantiles.
+		static void printBestDistribution(const IO::SweepSummary& summary) {
+			// Formatted as results, so that CRFs beyond a double in log space are shown as they are elsewhere:
+			DynamicOptimiser::OptimalResults best{.logSpace = summary.logSpace()};
+			std::ranges::copy_if(summary.bestCRFs(), std::back_inserter(best.CRFs), [](const double CRF) {
+				return !std::isnan(CRF);
+			});
+			std::ranges::sort(best.CRFs);
+			const std::size_t numWithoutResults = summary.numInputs() - best.size();
+
+			std::println();
+			std::println("Best HPR of each input:");
+			if (best.size() > 0) {
+				constexpr std::array<std::pair<std::string_view, double>, 7> quantiles = {{
+					{"min", 0.0}, {"10%", 0.1}, {"25%", 0.25}, {"median", 0.5}, {"75%", 0.75}, {"90%", 0.9},
+					{"max", 1.0}
+				}};
+				const auto last = static_cast<double>(best.size() - 1);
+				for (const auto& [name, quantile] : quantiles) {
+					const auto i = static_cast<std::size_t>(std::lround(quantile * last));
+					std::println("  {:<8}{}", name, IO::Output::formatHoldingPeriodReturn(best, i));
+				}
+			}
+			if (numWithoutResults > 0) {
+				std::println(
+					"  ({} input{} had no results)",
+					Helpers::Strings::formatIntWithSeparator(numWithoutResults),
+					numWithoutResults == 1 ? "" : "s"
+				);
+			}
+		}
+
+		/// Prints how often each tenor was bought first by an input's best result.
+		static void printFirstPurchases(const IO::SweepSummary& summary) {
+			std::uint64_t total = 0;
+			for (const auto& [tenor, count] : summary.firstPurchaseCounts()) {
+				total += count;
+			}
+			std::println();
+			std::println("First purchase of each input's best result:");
+			for (const auto& [tenor, count] : summary.firstPurchaseCounts()) {
+				std::println(
+					"  {:<16}{} ({:.1f}%)",
+					tenor == 0 ? std::string("none") : std::format("{}-month bond", tenor),
+					Helpers::Strings::formatIntWithSeparator(count),
+					100.0 * static_cast<double>(count) / static_cast<double>(total)
+				);
+			}
+		}
+
+		/// Prints the top results across every input, each with the input it is from.
+		static void printTopResults(const IO::SweepSummary& summary) {
+			const DynamicOptimiser::OptimalResults& top = summary.topResults();
+			std::println();
+			std::println("Top {} results across every input:", Helpers::Strings::formatIntWithSeparator(top.size()));
+			std::println();
+			for (std::size_t i = 0; i < top.size(); ++i) {
+				std::println(
+					"{}. {} ({}): {}",
+					i + 1,
+					IO::Output::formatHoldingPeriodReturn(top, i),
+					summary.inputName(summary.topInput(i)),
+					Helpers::Strings::joinFormatted(top.path(i), ",")
+				);
+			}
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	ReduceOptions parseArguments(const std::span<const std::string_view> args) {
+		ReduceOptions options{};
+
+		for (std::size_t i = 0; i < args.size(); ++i) {
+			const auto [name, inlineValue] = Arguments::splitInlineValue(args[i]);
+
+			// Returns the value for the current option, whether given as "--option=value" or "--option value":
+			const auto getValue = [&, name = name, inlineValue = inlineValue]() -> std::string_view {
+				if (inlineValue) {
+					return *inlineValue;
+				}
+				if (i + 1 >= args.size()) {
+					throw Arguments::ArgumentError(std::format("missing value for {}", name));
+				}
+				return args[++i];
+			};
+
+			if (name == "-h" || name == "--help") {
+				options.showHelp = true;
+			}
+			else if (name == "-k" || name == "--top") {
+				options.numTopResults = static_cast<std::size_t>(
+					Arguments::parsePositiveInt(getValue(), "number of results")
+				);
+			}
+			else if (name == "-o" || name == "--output") {
+				try {
+					options.outputPath = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw Arguments::ArgumentError(std::format("invalid output path: {}", e.what()));
+				}
+			}
+			else if (name.starts_with('-') && name.size() > 1) {
+				throw Arguments::ArgumentError(std::format("unknown option {}", name));
+			}
+			else {
+				options.summaryPatterns.emplace_back(args[i]);
+			}
+		}
+
+		if (!options.showHelp && options.summaryPatterns.empty()) {
+			throw Arguments::ArgumentError("no summaries provided");
+		}
+		return options;
+	}
+
+	void printUsage(const std::string_view programName) {
+		std::println("Usage: {} reduce [options] <summary>...", programName);
+		std::println();
+		std::println("Combines the summaries saved by shards of a sweep (run with --shard <i>/<n> --summary <file>),");
+		std::println("and reports the spread of the inputs' best HPRs, how often each tenor is bought first, and the");
+		std::println("top results across every input.");
+		std::println();
+		std::println("Options:");
+		std::println("  -k, --top <n>        number of top results across every input to keep, at most (and by");
+		std::println("                       default) as many as the summary keeping fewest keeps");
+		std::println("  -o, --output <file>  also save the combined summary to <file>, to be combined again later");
+		std::println("  -h, --help           show this message");
+	}
+
+	int run(const std::string_view programName, const std::span<const std::string_view> args) {
+		ReduceOptions options{};
+		try {
+			options = parseArguments(args);
+		}
+		catch (const Arguments::ArgumentError& e) {
+			Detail::printError(std::format("Invalid arguments: {}", e.what()));
+			std::println();
+			printUsage(programName);
+			return 2;
+		}
+
+		if (options.showHelp) {
+			printUsage(programName);
+			return 0;
+		}
+
+		// A missing or unreadable shard would silently skew every statistic, so any failure stops the reduction:
+		std::vector<IO::SweepSummary> summaries{};
+		for (const auto& pattern : options.summaryPatterns) {
+			try {
+				const auto matches = Helpers::Filesystem::expandGlob(pattern);
+				if (matches.empty()) {
+					Detail::printError(std::format("No files match {}", pattern));
+					return 1;
+				}
+				for (const auto& summaryPath : matches) {
+					try {
+						summaries.push_back(IO::SweepSummary::load(summaryPath));
+					}
+					catch (const IO::SweepSummaryError& e) {
+						Detail::printError(std::format("Cannot read summary {}: {}", summaryPath.string(), e.what()));
+						return 1;
+					}
+				}
+			}
+			catch (const Helpers::Filesystem::FilesystemError& e) {
+				Detail::printError(std::format("Invalid summary {}: {}", pattern, e.what()));
+				return 1;
+			}
+		}
+
+		// Every summary must hold all of the top results kept, so by default as many are kept as the fewest any holds:
+		std::size_t numTopResults = summaries.front().maxTopResults();
+		for (const IO::SweepSummary& summary : summaries) {
+			numTopResults = std::min(numTopResults, summary.maxTopResults());
+		}
+		std::optional<IO::SweepSummary> merged{};
+		try {
+			merged.emplace(IO::SweepSummary::merge(summaries, options.numTopResults.value_or(numTopResults)));
+		}
+		catch (const IO::SweepSummaryError& e) {
+			Detail::printError(std::format("Cannot combine summaries: {}", e.what()));
+			return 1;
+		}
+
+		std::println(
+			"Combined {} summar{} of {} inputs ({} failures)",
+			Helpers::Strings::formatIntWithSeparator(summaries.size()),
+			summaries.size() == 1 ? "y" : "ies",
+			Helpers::Strings::formatIntWithSeparator(merged->numInputs()),
+			Helpers::Strings::formatIntWithSeparator(merged->numFailures())
+		);
+		Detail::printBestDistribution(*merged);
+		Detail::printFirstPurchases(*merged);
+		Detail::printTopResults(*merged);
+		std::println();
+
+		if (options.outputPath) {
+			try {
+				merged->save(*options.outputPath);
+				std::println("Saved to {}", options.outputPath->string());
+			}
+			catch (const std::ios_base::failure&) {
+				Detail::printError(std::format("Failed to write summary to {}", options.outputPath->string()));
+				return 1;
+			}
+		}
+		return 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "app/cli/ServeMode.hpp"
+
+#include "app/cli/Arguments.hpp"
+#include "app/io/BinaryCurve.hpp"
+#include "app/service/Server.hpp"
+#include "helpers/Filesystem.hpp"
+#include "helpers/Socket.hpp"
+#include "helpers/printing/StyledPrint.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace ServeMode
+{
+	namespace Detail
+	{
+		// The server being run, for the signal handler to stop.
+		static std::atomic<Service::Server*> activeServer{nullptr};
+
+		extern "C" void handleStopSignal(int) {
+			if (Service::Server* const server = activeServer.load()) {
+				server->stop();
+			}
+		}
+
+		static void printError(const std::string_view message) {
+			Helpers::Printing::styledPrintln(std::cerr, Helpers::Printing::Styles::error, "{}", message);
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	ServeOptions parseArguments(const std::span<const std::string_view> args) {
+		ServeOptions options{};
+		auto& server = options.server;
+
+		for (std::size_t i = 0; i < args.size(); ++i) {
+			const auto [name, inlineValue] = Arguments::splitInlineValue(args[i]);
+
+			// Returns the value for the current option, whether given as "--option=value" or "--option value":
+			const auto getValue = [&, name = name, inlineValue = inlineValue]() -> std::string_view {
+				if (inlineValue) {
+					return *inlineValue;
+				}
+				if (i + 1 >= args.size()) {
+					throw Arguments::ArgumentError(std::format("missing value for {}", name));
+				}
+				return args[++i];
+			};
+
+			if (name == "-h" || name == "--help") {
+				options.showHelp = true;
+			}
+			else if (name == "-q" || name == "--quiet") {
+				server.quiet = true;
+			}
+			else if (name == "-c" || name == "--cache") {
+				server.useBinaryCache = true;
+			}
+			else if (name == "--no-memory-check") {
+				server.checkMemory = false;
+			}
+			else if (name == "-p" || name == "--port") {
+				const int port = Arguments::parsePositiveInt(getValue(), "port");
+				if (port > std::numeric_limits<std::uint16_t>::max()) {
+					throw Arguments::ArgumentError(std::format("port {} is too large", port));
+				}
+				server.port = static_cast<std::uint16_t>(port);
+			}
+			else if (name == "--address") {
+				server.address = getValue();
+			}
+			else if (name == "-r" || name == "--root") {
+				try {
+					server.dataRoot = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw Arguments::ArgumentError(std::format("invalid data directory: {}", e.what()));
+				}
+			}
+			else if (name == "-j" || name == "--threads") {
+				server.numWorkers = static_cast<unsigned int>(
+					Arguments::parsePositiveInt(getValue(), "number of threads")
+				);
+			}
+			else if (name == "--max-curves") {
+				server.maxCurves = static_cast<std::size_t>(
+					Arguments::parsePositiveInt(getValue(), "number of curves")
+				);
+			}
+			else if (name == "--cache-results") {
+				server.maxCachedResults = static_cast<std::size_t>(
+					Arguments::parsePositiveInt(getValue(), "number of cached results")
+				);
+			}
+			else if (name == "--results-dir") {
+				try {
+					server.resultDirectory = Helpers::Filesystem::expandUserPath(getValue());
+				}
+				catch (const Helpers::Filesystem::FilesystemError& e) {
+					throw Arguments::ArgumentError(std::format("invalid results directory: {}", e.what()));
+				}
+			}
+			else if (name == "--max-k") {
+				server.maxResults = Arguments::parsePositiveInt(getValue(), "number of results");
+			}
+			else {
+				throw Arguments::ArgumentError(std::format("unknown option {}", name));
+			}
+		}
+		return options;
+	}
+
+	void printUsage(const std::string_view programName) {
+		std::println("Usage: {} serve [options]", programName);
+		std::println();
+		std::println("Serves the optimiser over HTTP, keeping curves loaded between queries, until interrupted.");
+		std::println();
+		std::println("Requests (answered with JSON):");
+		std::println("  GET /optimise?curve=<path>&k=<n>[&start=<month>][&months=<n>][&log=1][&distinct=1]");
+		std::println("                       the top <n> results for the curve at <path> (relative to the data");
+		std::println("                       directory), over <months> months from <start> (by default all of them)");
+		std::println("  GET /curves          the curves loaded");
+		std::println("  GET /health          whether the server is up");
+		std::println();
+		std::println("Options:");
+		std::println("  -p, --port <n>       port to listen on (defaults to {})", Service::ServerOptions{}.port);
+		std::println("      --address <ip>   IPv4 address to listen on (defaults to {}, this machine only)",
+			Service::ServerOptions{}.address);
+		std::println("  -r, --root <dir>     directory curves are named relative to (defaults to the current one),");
+		std::println("                       no file outside it can be queried");
+		std::println("  -j, --threads <n>    number of queries answered at once (defaults to every hardware thread)");
+		std::println("      --max-curves <n> number of curves kept loaded (defaults to {})",
+			Service::CurveCache::defaultMaxCurves);
+		std::println("      --cache-results <n>");
+		std::println("                       keep the results of the last <n> runs, answering a repeated query (for");
+		std::println("                       as many results or fewer) without running it again; the runs kept are");
+		std::println("                       not counted in the memory each query is fitted to");
+		std::println("      --results-dir <dir>");
+		std::println("                       also save each run's results in <dir>, to be reused by later servers");
+		std::println("      --max-k <n>      most results a query may ask for (defaults to {})",
+			Service::ServerOptions{}.maxResults);
+		std::println("  -c, --cache          convert each CSV curve to a binary .{} file alongside it on first load",
+			IO::binaryCurveExtension);
+		std::println("      --no-memory-check");
+		std::println("                       run each query as requested even if estimated not to fit in memory");
+		std::println("  -q, --quiet          do not log each request");
+		std::println("  -h, --help           show this message");
+	}
+
+	int run(const std::string_view programName, const std::span<const std::string_view> args) {
+		ServeOptions options{};
+		try {
+			options = parseArguments(args);
+		}
+		catch (const Arguments::ArgumentError& e) {
+			Detail::printError(std::format("Invalid arguments: {}", e.what()));
+			std::println();
+			printUsage(programName);
+			return 2;
+		}
+
+		if (options.showHelp) {
+			printUsage(programName);
+			return 0;
+		}
+
+		try {
+			Service::Server server(options.server);
+			Detail::activeServer.store(&server);
+			std::signal(SIGINT, Detail::handleStopSignal);
+			std::signal(SIGTERM, Detail::handleStopSignal);
+			if (!options.server.quiet) {
+				std::println("Serving on http://{}:{}/ (press Ctrl+C to stop)", options.server.address, server.port());
+			}
+			server.run();
+			std::signal(SIGINT, SIG_DFL);
+			std::signal(SIGTERM, SIG_DFL);
+			Detail::activeServer.store(nullptr);
+		}
+		catch (const Helpers::Socket::SocketError& e) {
+			Detail::printError(std::format("Cannot serve: {}", e.what()));
+			return 1;
+		}
+		catch (const std::invalid_argument& e) {
+			Detail::printError(std::format("Cannot serve: {}", e.what()));
+			return 1;
+		}
+		return 0;
+	}
+}
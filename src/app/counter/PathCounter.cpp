@@ -1,98 +1,153 @@
 #include "app/counter/PathCounter.hpp"
 
-#include "helpers/Meta.hpp"
 #include "helpers/Strings.hpp"
 
-#include <cmath>
-#include <limits>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <future>
+#include <iterator>
 #include <print>
-#include <variant>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace PathCounter
 {
 	namespace Detail
 	{
-		struct ExactCount {
-			long long value{};
-		};
-		struct ApproxCount {
-			double value{};
+		/**
+		* A non-negative integer of any size, as little-endian 32-bit limbs (so that every step fits a 64-bit
+		* intermediate on any compiler), supporting just what counting needs: adding and writing out in decimal.
+		*/
+		class BigCount
+		{
+			public:
+				BigCount() = default;
+				explicit BigCount(const std::uint32_t value) {
+					if (value != 0) {
+						limbs_.push_back(value);
+					}
+				}
+
+				/// Sets the count to zero, keeping its storage for reuse.
+				void clear() noexcept { limbs_.clear(); }
+
+				BigCount& operator+=(const BigCount& other) {
+					if (limbs_.size() < other.limbs_.size()) {
+						limbs_.resize(other.limbs_.size(), 0);
+					}
+					std::uint64_t carry = 0;
+					std::size_t i = 0;
+					for (; i < other.limbs_.size(); ++i) {
+						const std::uint64_t sum = std::uint64_t{limbs_[i]} + other.limbs_[i] + carry;
+						limbs_[i] = static_cast<std::uint32_t>(sum);
+						carry = sum >> 32;
+					}
+					for (; carry != 0 && i < limbs_.size(); ++i) {
+						carry = ++limbs_[i] == 0 ? 1 : 0;
+					}
+					if (carry != 0) {
+						limbs_.push_back(1);
+					}
+					return *this;
+				}
+
+				/// Returns the count in decimal, dividing by 10^9 per step to peel off nine digits at a time.
+				[[nodiscard]] std::string toDecimal() const {
+					if (limbs_.empty()) {
+						return "0";
+					}
+					constexpr std::uint32_t chunkBase = 1'000'000'000;
+					std::vector<std::uint32_t> quotient = limbs_;
+					// Chunks of nine digits, least significant first:
+					std::vector<std::uint32_t> chunks{};
+					chunks.reserve(limbs_.size() * 32 / 29 + 1);
+					while (!quotient.empty()) {
+						std::uint64_t remainder = 0;
+						for (std::size_t i = quotient.size(); i-- > 0;) {
+							const std::uint64_t current = (remainder << 32) | quotient[i];
+							quotient[i] = static_cast<std::uint32_t>(current / chunkBase);
+							remainder = current % chunkBase;
+						}
+						chunks.push_back(static_cast<std::uint32_t>(remainder));
+						while (!quotient.empty() && quotient.back() == 0) {
+							quotient.pop_back();
+						}
+					}
+
+					std::string result = std::format("{}", chunks.back());
+					result.reserve(result.size() + (chunks.size() - 1) * 9);
+					for (std::size_t i = chunks.size() - 1; i-- > 0;) {
+						std::format_to(std::back_inserter(result), "{:09}", chunks[i]);
+					}
+					return result;
+				}
+
+			private:
+				std::vector<std::uint32_t> limbs_{};
 		};
-		/// The number of buying strategies may exceed exact representation as a long long,
-		/// if so we store an approximate double instead.
-		using PathCount = std::variant<ExactCount, ApproxCount>;
 
-		/// Uses dynamic programming to calculate the total number of possible buying strategies
-		/// from the provided bond return data, returning printing an approximation if the number of strategies
-		/// exceeds exact representation as a long long.
-		PathCount countPaths(std::vector<int> tenorList, const int numMonths) {
+		/**
+		* Uses dynamic programming to calculate the exact total number of possible buying strategies from the provided
+		* bond return data. The count for each month is the sum of those for the months a decision before it, so only a
+		* window of the last (longest tenor + 1) months' counts is kept, each added into in place. Counts grow by at
+		* least a bit a month, so for long horizons the time is dominated by these additions, O(numTenors * numMonths)
+		* of them at O(numMonths / 32) limbs each, and the memory by the window, O(maxTenor * numMonths / 32) limbs.
+		*/
+		[[nodiscard]] BigCount countPaths(std::vector<int> tenorList, const int numMonths) {
 			// Add the option to wait
 			tenorList.insert(tenorList.begin(), 1);
 
-			std::vector<long long> numPaths( numMonths + 1, 0);
+			const std::size_t window = static_cast<std::size_t>(std::ranges::max(tenorList)) + 1;
+			std::vector<BigCount> numPaths(window);
 			// Seed that there is 1 way to reach month 0
-			numPaths[0] = 1;
-
-			std::vector<double> numPathsApprox;
-
-			bool overflowed = false;
+			numPaths[0] = BigCount{1};
 
 			for (int i = 1; i < numMonths + 1; ++i) {
+				// The slot held month (i - window), which no decision reaches back to from here:
+				BigCount& current = numPaths[static_cast<std::size_t>(i) % window];
+				current.clear();
 				for (const auto t : tenorList) {
 					if (t > i) {
 						break;
 					}
-					if (!overflowed) {
-						// Check for overflow before adding
-						if (std::numeric_limits<long long>::max() - numPaths[i] < numPaths[i - t]) {
-							// Switch to approximate mode
-							overflowed = true;
-
-							// Initialise approximate vector from exact values
-							numPathsApprox.resize(numMonths + 1);
-							for (int j = 0; j < i; ++j) {
-								numPathsApprox[j] = static_cast<double>(numPaths[j]);
-							}
-							numPathsApprox[i] = static_cast<double>(numPaths[i]) + static_cast<double>(numPaths[i - t]);
-						}
-						else {
-							numPaths[i] += numPaths[i - t];
-						}
-					}
-					else {
-						numPathsApprox[i] += numPathsApprox[i - t];
-					}
+					current += numPaths[static_cast<std::size_t>(i - t) % window];
 				}
 			}
-			if (overflowed) {
-				return ApproxCount{numPathsApprox.back()};
+			return std::move(numPaths[static_cast<std::size_t>(numMonths) % window]);
+		}
+
+		/// Returns the decimal digits in scientific notation to 4 significant figures, such as "1.235e+42".
+		[[nodiscard]] std::string formatScientific(const std::string& digits) {
+			// Round the leading five digits to four:
+			int leading = std::stoi(digits.substr(0, 5));
+			int exponent = static_cast<int>(digits.size()) - 1;
+			leading = (leading + 5) / 10;
+			if (leading == 10'000) {
+				leading = 1'000;
+				++exponent;
 			}
-			return ExactCount{numPaths.back()};
+			return std::format("{}.{:03}e+{}", leading / 1'000, leading % 1'000, exponent);
 		}
 	}
 
-	void printPathCount(const std::vector<int>& tenorList, const int numMonths) {
-		const Detail::PathCount count = Detail::countPaths(tenorList, numMonths);
-		std::visit(
-			Helpers::Meta::overloaded{
-				[](const Detail::ApproxCount& approx) {
-					constexpr auto maxExactDoubleInt = static_cast<double>(1ULL << std::numeric_limits<double>::digits);
-					if (const double dCount = approx.value; !std::isfinite(dCount)) {
-						std::println("Over {:.3e}", std::numeric_limits<double>::max());
-					}
-					else if (dCount > maxExactDoubleInt) {
-						std::println("{:.3e}", dCount);
-					}
-					else {
-						std::println("{}", Helpers::Strings::formatIntWithSeparator(static_cast<long long>(dCount)));
-					}
-				},
-				[](const Detail::ExactCount& exact) {
-					std::println("{}", Helpers::Strings::formatIntWithSeparator(exact.value));
-				}
-			},
-			count
-		);
+	std::shared_future<std::string> countPathsAsync(const std::vector<int>& tenorList, const int numMonths) {
+		return std::async(std::launch::async, [tenorList, numMonths] {
+			return Detail::countPaths(tenorList, numMonths).toDecimal();
+		}).share();
+	}
+
+	std::string countPaths(const std::vector<int>& tenorList, const int numMonths) {
+		return Detail::countPaths(tenorList, numMonths).toDecimal();
+	}
+
+	void printPathCount(const std::string& digits) {
+		std::println("{}", Helpers::Strings::formatDigitsWithSeparator(digits));
+		// Beyond a long long, also give the magnitude at a glance:
+		if (digits.size() > 18) {
+			std::println("(about {}, {} digits)", Detail::formatScientific(digits), digits.size());
+		}
 	}
-}
\ No newline at end of file
+}
@@ -1,9 +1,11 @@
 #include "app/domain/BondReturnData.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <filesystem>
 #include <limits>
 #include <mdspan>
+#include <memory>
 #include <stdexcept>
 #include <utility>
 #include <vector>
@@ -17,6 +19,30 @@ namespace Domain
 		gridView_{grid_.data(), tenors_.size(), numMonths_},
 		dataPath_(std::move(s))
 	{
+		validate(grid_.size());
+	}
+
+	BondReturnData::BondReturnData(
+		std::vector<int> t,
+		const int m,
+		std::shared_ptr<const void> storage,
+		const double* const gridData,
+		std::filesystem::path s
+	) :
+		tenors_(std::move(t)),
+		numMonths_(m),
+		externalStorage_(std::move(storage)),
+		externalGrid_(gridData),
+		gridView_{externalGrid_, tenors_.size(), numMonths_},
+		dataPath_(std::move(s))
+	{
+		if (!externalStorage_ || !externalGrid_) {
+			throw std::invalid_argument("BondReturnData: external storage not provided");
+		}
+		validate(tenors_.size() * static_cast<std::size_t>(std::max(numMonths_, 0)));
+	}
+
+	void BondReturnData::validate(const std::size_t gridSize) const {
 		if (tenors_.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
 			throw std::invalid_argument("BondReturnData: too many tenors provided");
 		}
@@ -25,7 +51,7 @@ namespace Domain
 			throw std::invalid_argument("BondReturnData: must have at least 1 month");
 		}
 
-		if (grid_.size() != tenors_.size() * static_cast<std::size_t>(numMonths_)) {
+		if (gridSize != tenors_.size() * static_cast<std::size_t>(numMonths_)) {
 			throw std::invalid_argument("BondReturnData: size mismatch");
 		}
 	}
@@ -36,7 +62,9 @@ namespace Domain
 		tenors_(other.tenors_),
 		numMonths_(other.numMonths_),
 		grid_(other.grid_),
-		gridView_(grid_.data(), other.tenors_.size(), other.numMonths_),
+		externalStorage_(other.externalStorage_),
+		externalGrid_(other.externalGrid_),
+		gridView_(gridData(), other.tenors_.size(), other.numMonths_),
 		dataPath_(other.dataPath_)
 	{}
 
@@ -46,7 +74,9 @@ namespace Domain
 			tenors_ = other.tenors_;
 			numMonths_ = other.numMonths_;
 			grid_ = other.grid_;
-			gridView_ = decltype(gridView_)(grid_.data(), tenors_.size(), numMonths_);
+			externalStorage_ = other.externalStorage_;
+			externalGrid_ = other.externalGrid_;
+			gridView_ = decltype(gridView_)(gridData(), tenors_.size(), numMonths_);
 			dataPath_ = other.dataPath_;
 		}
 		return *this;
@@ -56,7 +86,9 @@ namespace Domain
 		tenors_(std::move(other.tenors_)),
 		numMonths_(other.numMonths_),
 		grid_(std::move(other.grid_)),
-		gridView_(grid_.data(), tenors_.size(), numMonths_),
+		externalStorage_(std::move(other.externalStorage_)),
+		externalGrid_(other.externalGrid_),
+		gridView_(gridData(), tenors_.size(), numMonths_),
 		dataPath_(std::move(other.dataPath_))
 	{}
 
@@ -66,7 +98,9 @@ namespace Domain
 			tenors_ = std::move(other.tenors_);
 			numMonths_ = other.numMonths_;
 			grid_ = std::move(other.grid_);
-			gridView_ = decltype(gridView_)(grid_.data(), tenors_.size(), numMonths_);
+			externalStorage_ = std::move(other.externalStorage_);
+			externalGrid_ = other.externalGrid_;
+			gridView_ = decltype(gridView_)(gridData(), tenors_.size(), numMonths_);
 			dataPath_ = std::move(other.dataPath_);
 		}
 		return *this;
@@ -83,4 +117,31 @@ namespace Domain
 		}
 		return gridView_[row, month];
 	}
-}
\ No newline at end of file
+
+	BondReturnData BondReturnData::monthRange(const int firstMonth, const int count) const {
+		if (firstMonth < 0 || count <= 0 || firstMonth > numMonths_ - count) {
+			throw std::out_of_range("BondReturnData: month range out of range");
+		}
+		const auto months = static_cast<std::size_t>(count);
+		std::vector<double> rangeGrid(tenors_.size() * months);
+		for (std::size_t row = 0; row < tenors_.size(); ++row) {
+			const auto rowMonths = grid().subspan(
+				row * static_cast<std::size_t>(numMonths_) + static_cast<std::size_t>(firstMonth), months
+			);
+			std::ranges::copy(rowMonths, rangeGrid.begin() + static_cast<std::ptrdiff_t>(row * months));
+		}
+		return {tenors_, count, std::move(rangeGrid), dataPath_};
+	}
+
+	BondReturnData BondReturnData::mirrored() const {
+		std::vector<double> mirroredGrid(grid().size(), 0.0);
+		for (int row = 0; row < numTenors(); ++row) {
+			const std::size_t rowStart = static_cast<std::size_t>(row) * static_cast<std::size_t>(numMonths_);
+			for (int month = 0; month + tenors_[row] <= numMonths_; ++month) {
+				mirroredGrid[rowStart + static_cast<std::size_t>(numMonths_ - month - tenors_[row])] =
+					(*this)(row, month);
+			}
+		}
+		return {tenors_, numMonths_, std::move(mirroredGrid), dataPath_};
+	}
+}
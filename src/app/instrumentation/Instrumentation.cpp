@@ -0,0 +1,122 @@
+#include "app/instrumentation/Instrumentation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace Instrumentation
+{
+	namespace Detail
+	{
+		// Guards activeReport, and everything recorded into it, since recording calls may come from any thread.
+		constinit std::mutex mutex{};
+		constinit Report* activeReport = nullptr;
+
+		void addPhaseTime(const Phase phase, const std::chrono::nanoseconds time) noexcept {
+			const std::lock_guard lock(mutex);
+			if (activeReport) {
+				activeReport->phaseTimes[static_cast<std::size_t>(phase)] += time;
+			}
+		}
+
+		void recordCRFsBytes(const std::size_t bytes) noexcept {
+			const std::lock_guard lock(mutex);
+			if (activeReport) {
+				activeReport->peakCRFsBytes = std::max(activeReport->peakCRFsBytes, bytes);
+			}
+		}
+
+		void recordDecisionsBytes(const std::size_t bytes) noexcept {
+			const std::lock_guard lock(mutex);
+			if (activeReport) {
+				activeReport->peakDecisionsBytes = std::max(activeReport->peakDecisionsBytes, bytes);
+			}
+		}
+
+		void countMerge(const std::uint64_t pushes, const std::uint64_t pops) noexcept {
+			const std::lock_guard lock(mutex);
+			if (activeReport) {
+				activeReport->mergePushes += pushes;
+				activeReport->mergePops += pops;
+			}
+		}
+
+		void recordMonthResults(const int month, const int numResults) {
+			const std::lock_guard lock(mutex);
+			if (activeReport) {
+				auto& resultsPerMonth = activeReport->resultsPerMonth;
+				if (static_cast<std::size_t>(month) >= resultsPerMonth.size()) {
+					resultsPerMonth.resize(static_cast<std::size_t>(month) + 1, 0);
+				}
+				resultsPerMonth[static_cast<std::size_t>(month)] = numResults;
+			}
+		}
+	}
+
+	std::string_view phaseName(const Phase phase) noexcept {
+		switch (phase) {
+			case Phase::Load: return "load";
+			case Phase::Sort: return "sort";
+			case Phase::ForwardPass: return "forward_pass";
+			case Phase::Reconstruction: return "reconstruction";
+			case Phase::Export: return "export";
+		}
+		return "unknown";
+	}
+
+	void Report::clear() noexcept {
+		phaseTimes.fill(std::chrono::nanoseconds{0});
+		peakCRFsBytes = 0;
+		peakDecisionsBytes = 0;
+		mergePushes = 0;
+		mergePops = 0;
+		resultsPerMonth.clear();
+	}
+
+	std::string toJSON(const Report& report) {
+		std::string JSON = "{\"phase_seconds\": {";
+		for (std::size_t i = 0; i < numPhases; ++i) {
+			std::format_to(
+				std::back_inserter(JSON),
+				"{}\"{}\": {}",
+				i == 0 ? "" : ", ",
+				phaseName(static_cast<Phase>(i)),
+				std::chrono::duration<double>(report.phaseTimes[i]).count()
+			);
+		}
+		std::format_to(
+			std::back_inserter(JSON),
+			"}}, \"peak_crfs_bytes\": {}, \"peak_decisions_bytes\": {}, \"merge_pushes\": {}, \"merge_pops\": {}"
+			", \"results_per_month\": [",
+			report.peakCRFsBytes,
+			report.peakDecisionsBytes,
+			report.mergePushes,
+			report.mergePops
+		);
+		for (std::size_t month = 0; month < report.resultsPerMonth.size(); ++month) {
+			std::format_to(std::back_inserter(JSON), "{}{}", month == 0 ? "" : ", ", report.resultsPerMonth[month]);
+		}
+		JSON += "]}";
+		return JSON;
+	}
+
+	Recording::Recording(Report& report) {
+		const std::lock_guard lock(Detail::mutex);
+		if (Detail::activeReport) {
+			throw std::logic_error("Only one instrumentation Recording may be active at a time");
+		}
+		Detail::activeReport = &report;
+	}
+
+	Recording::~Recording() {
+		const std::lock_guard lock(Detail::mutex);
+		Detail::activeReport = nullptr;
+	}
+}
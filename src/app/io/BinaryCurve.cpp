@@ -0,0 +1,265 @@
+#include "app/io/BinaryCurve.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "helpers/Filesystem.hpp"
+#include "helpers/MappedFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace IO
+{
+	namespace Detail::BinaryFormat
+	{
+		constexpr std::array<char, 8> magic = {'B', 'S', 'O', 'C', 'U', 'R', 'V', '\0'};
+		// Increment whenever the layout changes, older files are then rejected (and sidecars regenerated).
+		constexpr std::uint32_t version = 1;
+		// Written in native byte order, so reads back differently on a machine with the opposite byte order.
+		constexpr std::uint64_t byteOrderMark = 0x0102030405060708;
+
+		/// The fixed-size header at the start of every binary curve file.
+		struct FileHeader
+		{
+			std::array<char, 8> magic{};
+			std::uint32_t version{};
+			std::uint32_t headerSize{};
+			std::uint64_t byteOrderMark{};
+			std::uint32_t numTenors{};
+			std::uint32_t numMonths{};
+			std::uint64_t sourceSize{};
+			std::int64_t sourceModified{};
+			std::uint64_t sourceHash{};
+			std::uint64_t reserved{};
+		};
+		static_assert(sizeof(FileHeader) == 64, "binary curve header must be exactly 64 bytes");
+
+		/// Returns the size of the tenor list in bytes, padded so that the grid which follows is aligned for doubles.
+		[[nodiscard]] static constexpr std::size_t paddedTenorsSize(const std::size_t numTenors) noexcept {
+			const std::size_t tenorsSize = numTenors * sizeof(std::int32_t);
+			return (tenorsSize + alignof(double) - 1) / alignof(double) * alignof(double);
+		}
+
+		/// Returns whether the total size of a file holding a grid of the given dimensions (at least one tenor) fits in
+		/// a size_t, so that fileSize cannot wrap around.
+		[[nodiscard]] static constexpr bool sizeFits(const std::size_t numTenors, const std::size_t numMonths) noexcept {
+			const std::size_t maxGridSize =
+				(std::numeric_limits<std::size_t>::max() - sizeof(FileHeader) - paddedTenorsSize(numTenors))
+				/ sizeof(double);
+			return numMonths <= maxGridSize / numTenors;
+		}
+
+		/// Returns the total size of a file holding a grid of the given dimensions, which must satisfy sizeFits.
+		[[nodiscard]] static constexpr std::size_t fileSize(
+			const std::size_t numTenors,
+			const std::size_t numMonths
+		) noexcept {
+			return sizeof(FileHeader) + paddedTenorsSize(numTenors) + numTenors * numMonths * sizeof(double);
+		}
+
+		/// Reads and checks the identifying fields of the header, returning nullopt if this is not a binary curve
+		/// file of this version in this machine's byte order, with the reason written to reason if provided.
+		[[nodiscard]] static std::optional<FileHeader> readHeader(
+			const Helpers::Filesystem::MappedFile& file,
+			std::string* const reason = nullptr
+		) {
+			const auto reject = [&](const std::string_view why) -> std::optional<FileHeader> {
+				if (reason) {
+					*reason = why;
+				}
+				return std::nullopt;
+			};
+
+			FileHeader header{};
+			if (file.size() < sizeof(FileHeader)) {
+				return reject("file is too small to be a binary curve");
+			}
+			std::memcpy(&header, file.data(), sizeof(FileHeader));
+
+			if (header.magic != magic) {
+				return reject("file is not a binary curve");
+			}
+			if (header.byteOrderMark != byteOrderMark) {
+				return reject("binary curve was written on a machine with a different byte order");
+			}
+			if (header.version != version || header.headerSize != sizeof(FileHeader)) {
+				return reject(
+					std::format("binary curve version {} is not supported, expected {}", header.version, version)
+				);
+			}
+			return header;
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	namespace Input
+	{
+		Domain::BondReturnData loadBinaryCurve(
+			const std::filesystem::path& binaryPath,
+			std::optional<std::filesystem::path> dataPath
+		) {
+			namespace Format = Detail::BinaryFormat;
+
+			std::shared_ptr<const Helpers::Filesystem::MappedFile> file{};
+			try {
+				file = std::make_shared<const Helpers::Filesystem::MappedFile>(binaryPath);
+			}
+			catch (const Helpers::Filesystem::FileError& e) {
+				throw BinaryCurveError(e.what());
+			}
+
+			std::string reason{};
+			const auto header = Format::readHeader(*file, &reason);
+			if (!header) {
+				throw BinaryCurveError(reason);
+			}
+
+			// Check the dimensions before trusting them to compute offsets:
+			if (header->numTenors == 0) {
+				throw BinaryCurveError("no bond return data");
+			}
+			if (header->numMonths == 0 || header->numMonths > static_cast<std::uint32_t>(std::numeric_limits<int>::max())) {
+				throw BinaryCurveError(std::format("invalid number of months: {}", header->numMonths));
+			}
+			if (header->numTenors > static_cast<std::uint32_t>(std::numeric_limits<int>::max())) {
+				throw BinaryCurveError("too many tenors provided");
+			}
+			// A crafted header could otherwise wrap the expected size around to that of a small file:
+			if (!Format::sizeFits(header->numTenors, header->numMonths)) {
+				throw BinaryCurveError(
+					std::format("{} tenors and {} months are too large", header->numTenors, header->numMonths)
+				);
+			}
+			if (file->size() != Format::fileSize(header->numTenors, header->numMonths)) {
+				throw BinaryCurveError(
+					std::format(
+						"file size {} does not match its {} tenors and {} months, it may be truncated",
+						file->size(),
+						header->numTenors,
+						header->numMonths
+					)
+				);
+			}
+
+			// Read tenors, which must be positive and strictly increasing, as BondReturnData requires:
+			std::vector<int> tenors(header->numTenors);
+			std::memcpy(tenors.data(), file->data() + sizeof(Format::FileHeader), tenors.size() * sizeof(std::int32_t));
+			if (tenors.front() <= 0) {
+				throw BinaryCurveError("tenors must be positive");
+			}
+			if (std::ranges::adjacent_find(tenors, std::ranges::greater_equal{}) != tenors.end()) {
+				throw BinaryCurveError("tenors must be unique and in increasing order");
+			}
+			const int numMonths = static_cast<int>(header->numMonths);
+			if (numMonths < tenors.front()) {
+				throw BinaryCurveError(
+					std::format(
+						"shortest tenor is {} months, but only {} months of data provided", tenors.front(), numMonths
+					)
+				);
+			}
+
+			// The grid offset is a multiple of 8 into a page-aligned mapping, so is suitably aligned to be read in place.
+			const auto* const grid = reinterpret_cast<const double*>(
+				file->data() + sizeof(Format::FileHeader) + Format::paddedTenorsSize(tenors.size())
+			);
+			// Apply the same checks the CSV loader makes on each bond return, since the optimiser relies on them:
+			const std::span<const double> gridValues{grid, tenors.size() * static_cast<std::size_t>(numMonths)};
+			if (
+				const auto invalid = std::ranges::find_if(gridValues, [](const double r) {
+					return std::isnan(r) || std::isinf(1.0 + r);
+				});
+				invalid != gridValues.end()
+			) {
+				const auto index = static_cast<std::size_t>(invalid - gridValues.begin());
+				throw BinaryCurveError(
+					std::format(
+						"tenor {}, month {}: invalid bond return",
+						tenors[index / static_cast<std::size_t>(numMonths)],
+						index % static_cast<std::size_t>(numMonths)
+					)
+				);
+			}
+
+			auto reportedPath = dataPath ? std::move(*dataPath) : binaryPath;
+			return Domain::BondReturnData{std::move(tenors), numMonths, file, grid, std::move(reportedPath)};
+		}
+
+		std::optional<SourceStamp> readSourceStamp(const std::filesystem::path& binaryPath) {
+			std::error_code ec{};
+			if (!std::filesystem::is_regular_file(binaryPath, ec)) {
+				return std::nullopt;
+			}
+			try {
+				const Helpers::Filesystem::MappedFile file{binaryPath};
+				const auto header = Detail::BinaryFormat::readHeader(file);
+				if (!header) {
+					return std::nullopt;
+				}
+				return SourceStamp{
+					.size = header->sourceSize, .modified = header->sourceModified, .hash = header->sourceHash
+				};
+			}
+			catch (const Helpers::Filesystem::FileError&) {
+				return std::nullopt;
+			}
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	namespace Output
+	{
+		void writeBinaryCurve(
+			const Domain::BondReturnData& tenorData,
+			const SourceStamp& sourceStamp,
+			const std::filesystem::path& binaryPath
+		) {
+			namespace Format = Detail::BinaryFormat;
+
+			const Format::FileHeader header{
+				.magic = Format::magic,
+				.version = Format::version,
+				.headerSize = sizeof(Format::FileHeader),
+				.byteOrderMark = Format::byteOrderMark,
+				.numTenors = static_cast<std::uint32_t>(tenorData.numTenors()),
+				.numMonths = static_cast<std::uint32_t>(tenorData.numMonths()),
+				.sourceSize = sourceStamp.size,
+				.sourceModified = sourceStamp.modified,
+				.sourceHash = sourceStamp.hash,
+				.reserved = 0
+			};
+
+			// Lay out the padded tenor list, the padding bytes just being zeros:
+			std::vector<char> tenorBytes(Format::paddedTenorsSize(tenorData.tenors().size()), '\0');
+			for (std::size_t i = 0; i < tenorData.tenors().size(); ++i) {
+				const auto tenor = static_cast<std::int32_t>(tenorData.tenors()[i]);
+				std::memcpy(tenorBytes.data() + i * sizeof(std::int32_t), &tenor, sizeof(std::int32_t));
+			}
+
+			std::ofstream out(binaryPath, std::ios::binary | std::ios::trunc);
+			// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+			out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+
+			const auto grid = tenorData.grid();
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(tenorBytes.data(), static_cast<std::streamsize>(tenorBytes.size()));
+			out.write(reinterpret_cast<const char*>(grid.data()), static_cast<std::streamsize>(grid.size_bytes()));
+			out.flush();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "app/io/BinaryResults.hpp"
+
+#include "app/domain/InvestmentAction.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+#include <vector>
+
+namespace IO::Output
+{
+	namespace Detail::BinaryResultsFormat
+	{
+		constexpr std::array<char, 8> magic = {'B', 'S', 'O', 'R', 'S', 'L', 'T', '\0'};
+		// Increment whenever the layout changes.
+		constexpr std::uint32_t version = 1;
+		// Written in native byte order, so reads back differently on a machine with the opposite byte order.
+		constexpr std::uint64_t byteOrderMark = 0x0102030405060708;
+
+		/// The fixed-size header at the start of every binary results file.
+		struct FileHeader
+		{
+			std::array<char, 8> magic{};
+			std::uint32_t version{};
+			std::uint32_t headerSize{};
+			std::uint64_t byteOrderMark{};
+			std::uint32_t numTenors{};
+			// 1 if the CRFs are natural logs of CRFs (see OptimiserOptions::logSpace), 0 otherwise.
+			std::uint32_t logSpace{};
+			std::uint64_t numResults{};
+			// The number of path bytes, before padding.
+			std::uint64_t numSteps{};
+			std::array<std::uint64_t, 2> reserved{};
+		};
+		static_assert(sizeof(FileHeader) == 64, "binary results header must be exactly 64 bytes");
+
+		/// Returns the number of zero bytes padding a section of the given size to a multiple of 8 bytes.
+		[[nodiscard]] static constexpr std::size_t paddingFor(const std::size_t size) noexcept {
+			return (alignof(double) - size % alignof(double)) % alignof(double);
+		}
+
+		constexpr std::array<char, 8> zeros{};
+	}
+
+	BinaryResultsWriter::BinaryResultsWriter(const std::filesystem::path& filePath, const std::vector<int>& tenors) :
+		numTenors_(static_cast<std::uint32_t>(tenors.size()))
+	{
+		namespace Format = Detail::BinaryResultsFormat;
+
+		// Checked before the file is created, so that nothing is left behind:
+		if (tenors.size() > 255) {
+			throw std::invalid_argument("Binary results can only hold paths of up to 255 tenors");
+		}
+		tenorCodes_.resize(tenors.empty() ? 0 : static_cast<std::size_t>(tenors.back()) + 1, 0);
+		for (std::size_t i = 0; i < tenors.size(); ++i) {
+			tenorCodes_[static_cast<std::size_t>(tenors[i])] = static_cast<std::uint8_t>(i + 1);
+		}
+
+		out_.open(filePath, std::ios::binary | std::ios::trunc);
+		// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+		out_.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+
+		// The header is written last, once the counts are known, so its space is held by zeros until then:
+		const Format::FileHeader placeholder{};
+		out_.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+		for (const int tenor : tenors) {
+			const auto value = static_cast<std::int32_t>(tenor);
+			out_.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+		out_.write(
+			Format::zeros.data(),
+			static_cast<std::streamsize>(Format::paddingFor(tenors.size() * sizeof(std::int32_t)))
+		);
+	}
+
+	void BinaryResultsWriter::write(
+		const DynamicOptimiser::OptimalResults& results,
+		const std::size_t firstRank,
+		const std::size_t numRows
+	) {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Export);
+		if (firstRank != CRFs_.size()) {
+			throw std::invalid_argument("BinaryResultsWriter: results must be written in rank order");
+		}
+		logSpace_ = results.logSpace;
+
+		// Offsets continue from the end of the previous block's steps:
+		const std::uint64_t blockOffset = offsets_.back();
+		steps_.clear();
+		for (std::size_t i = 0; i < numRows; ++i) {
+			for (const Domain::InvestmentAction& action : results.path(i)) {
+				if (action.action() == Domain::InvestmentAction::Action::Buy) {
+					steps_.push_back(tenorCodes_[static_cast<std::size_t>(action.length())]);
+				}
+				else {
+					steps_.insert(steps_.end(), static_cast<std::size_t>(action.length()), 0);
+				}
+			}
+			CRFs_.push_back(results.CRFs[i]);
+			offsets_.push_back(blockOffset + steps_.size());
+		}
+		out_.write(reinterpret_cast<const char*>(steps_.data()), static_cast<std::streamsize>(steps_.size()));
+	}
+
+	void BinaryResultsWriter::finish() {
+		namespace Format = Detail::BinaryResultsFormat;
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Export);
+
+		const std::uint64_t numSteps = offsets_.back();
+		out_.write(Format::zeros.data(), static_cast<std::streamsize>(Format::paddingFor(numSteps)));
+		out_.write(
+			reinterpret_cast<const char*>(CRFs_.data()),
+			static_cast<std::streamsize>(CRFs_.size() * sizeof(double))
+		);
+		out_.write(
+			reinterpret_cast<const char*>(offsets_.data()),
+			static_cast<std::streamsize>(offsets_.size() * sizeof(std::uint64_t))
+		);
+
+		const Format::FileHeader header{
+			.magic = Format::magic,
+			.version = Format::version,
+			.headerSize = sizeof(Format::FileHeader),
+			.byteOrderMark = Format::byteOrderMark,
+			.numTenors = numTenors_,
+			.logSpace = logSpace_ ? 1U : 0U,
+			.numResults = CRFs_.size(),
+			.numSteps = numSteps,
+			.reserved = {}
+		};
+		out_.seekp(0);
+		out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out_.flush();
+	}
+
+	void writeBinaryResults(
+		const DynamicOptimiser::OptimalResults& results,
+		const std::size_t numResultsToExport,
+		const std::vector<int>& tenors,
+		const std::filesystem::path& filePath
+	) {
+		BinaryResultsWriter writer(filePath, tenors);
+		writer.write(results, 0, numResultsToExport);
+		writer.finish();
+	}
+}
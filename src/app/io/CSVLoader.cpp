@@ -1,20 +1,24 @@
 #include "app/io/CSVLoader.hpp"
 
 #include "app/domain/BondReturnData.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
 #include "helpers/Filesystem.hpp"
+#include "helpers/MappedFile.hpp"
+#include "helpers/Parallel.hpp"
 #include "helpers/Strings.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <charconv>
 #include <cmath>
 #include <cstddef>
 #include <filesystem>
 #include <format>
-#include <fstream>
 #include <limits>
 #include <numeric>
+#include <optional>
 #include <ranges>
 #include <stdexcept>
 #include <string>
@@ -29,6 +33,9 @@ namespace IO::Input
 	namespace Detail
 	{
 		constexpr std::string_view tooManyRowsMessage = "CSV too large: too many rows provided";
+		// Parsing is only split across threads in chunks of at least this many bond returns,
+		// below which the cost of starting a thread outweighs the parsing it would save.
+		constexpr std::size_t minCellsPerThread = 1 << 16;
 
 		[[nodiscard]] static constexpr bool isBlankLineCSV(std::string_view sv) noexcept {
 			return std::ranges::all_of(sv, [](const unsigned char c) {
@@ -43,6 +50,35 @@ namespace IO::Input
 			});
 		}
 
+		namespace Rows
+		{
+			/// Splits the file contents into string_views over each line (without the terminating '\n'),
+			/// counting the newlines first so that the list is allocated only once.
+			[[nodiscard]] static std::vector<std::string_view> splitRows(const std::string_view contents) {
+				const auto numNewlines = static_cast<std::size_t>(std::ranges::count(contents, '\n'));
+				// A final line without a terminating '\n' is still a line, as with std::getline.
+				const bool hasUnterminatedLine = !contents.empty() && contents.back() != '\n';
+				const std::size_t numRows = numNewlines + (hasUnterminatedLine ? 1 : 0);
+				if (numRows > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+					throw CSVError(std::string{tooManyRowsMessage});
+				}
+
+				std::vector<std::string_view> rows{};
+				rows.reserve(numRows);
+
+				std::size_t rowStart = 0;
+				while (rowStart < contents.size()) {
+					std::size_t rowEnd = contents.find('\n', rowStart);
+					if (rowEnd == std::string_view::npos) {
+						rowEnd = contents.size();
+					}
+					rows.push_back(contents.substr(rowStart, rowEnd - rowStart));
+					rowStart = rowEnd + 1;
+				}
+				return rows;
+			}
+		}
+
 		namespace Filepath
 		{
 			/// Checks if an extension matches that of common spreadsheet formats,
@@ -53,63 +89,24 @@ namespace IO::Input
 				});
 				return std::ranges::contains(spreadsheetExtensions, ext);
 			}
-
-			/// Returns the fully-expanded CSV path, checking its validity and extension
-			[[nodiscard]] static std::filesystem::path validatedPath(const std::string_view CSVPathSv) {
-				// Expand and check path:
-				std::filesystem::path CSVPath{};
-				try {
-					CSVPath = Helpers::Filesystem::expandUserPath(CSVPathSv);
-					Helpers::Filesystem::assertDirectoryValid(Helpers::Filesystem::getDirectory(CSVPath));
-					Helpers::Filesystem::assertFileValid(CSVPath);
-				}
-				catch (const Helpers::Filesystem::FilesystemError& e) {
-					throw CSVError(e.what());
-				}
-
-				// Check extension:
-				const std::string fileExtension = Helpers::Strings::svToLowercase(Helpers::Filesystem::getExtension(CSVPath));
-				if (fileExtension.empty()) {
-					throw CSVError("file has no extension, must be .csv or .txt");
-				}
-				if (isSpreadsheetExtension(fileExtension)) {
-					throw CSVError(
-						std::format("file extension .{} is a spreadsheet format, save as CSV instead", fileExtension)
-					);
-				}
-				if (fileExtension != "csv" && fileExtension != "txt") {
-					throw CSVError(std::format("file extension must be .csv or .txt, received .{}", fileExtension));
-				}
-
-				return CSVPath;
-			}
 		}
 
 		namespace Header
 		{
 			struct HeaderData
 			{
-				std::string headerContents{};
-				int headerRowNum{};
+				std::string_view headerContents{};
+				// Index into the list of rows, so row numbers (as reported to the user) are this + 1.
+				std::size_t headerRowIndex{};
 			};
 
-			/// Gets the contents and line number of the first non-empty row,
-			/// throwing a CSVError if none found or if too many rows provided:
-			[[nodiscard]] static HeaderData getHeaderData(std::ifstream& CSVStream) {
-				std::string currentRow{};
-				int currentRowNum = 0;
-
-				while (std::getline(CSVStream, currentRow)) {
-					if (currentRowNum == std::numeric_limits<int>::max()) {
-						throw CSVError(std::string{tooManyRowsMessage});
-					}
-					++currentRowNum;
-
-					if (const std::string_view currentRowView{currentRow}; isBlankLineCSV(currentRowView)) {
+			/// Gets the contents and index of the first non-empty row, throwing a CSVError if none found:
+			[[nodiscard]] static HeaderData getHeaderData(const std::vector<std::string_view>& rows) {
+				for (std::size_t i = 0; i < rows.size(); ++i) {
+					if (isBlankLineCSV(rows[i])) {
 						continue;
 					}
-
-					return {.headerContents = std::move(currentRow), .headerRowNum = currentRowNum};
+					return {.headerContents = rows[i], .headerRowIndex = i};
 				}
 
 				throw CSVError("all lines blank");
@@ -219,111 +216,170 @@ namespace IO::Input
 
 		namespace Data
 		{
-			struct UnsortedData
+			/// A non-blank row of bond return data, along with its row number for error reporting.
+			struct DataRow
+			{
+				std::string_view contents{};
+				int rowNum{};
+			};
+
+			struct TenorScan
 			{
-				// Unsorted list of tenors (i.e. the data from the first column).
-				std::vector<int> tenorsUnsorted{};
-				// Row-major vectorisation of the bond data grid in CSV.
-				std::vector<double> gridUnsorted{};
+				// The data rows, in file order, up to (but excluding) the first row with an invalid tenor.
+				std::vector<DataRow> rows{};
+				// The tenor of each data row, unsorted.
+				std::vector<int> tenors{};
+				// The error for the first row with an invalid or duplicate tenor, if any.
+				std::optional<std::string> tenorError{};
 			};
 
-			/// Loads data from the CSV stream into an UnsortedData struct.
-			[[nodiscard]] static UnsortedData loadData(std::ifstream& CSVStream, int currentRowNum, int numMonths) {
-				std::vector<int> tenorsUnsorted{};
-				std::vector<double> gridUnsorted{};
+			/// Finds the data rows following the header and parses the tenor at the start of each.
+			/// Rather than throwing at the first invalid tenor, we record the error and stop, since an earlier row may
+			/// still have an invalid bond return, which must be reported first to match the order of the file.
+			[[nodiscard]] static TenorScan scanTenors(
+				const std::vector<std::string_view>& rows,
+				const std::size_t headerRowIndex
+			) {
+				TenorScan scan{};
 
 				// Used to detect duplicate tenors, testing unordered set membership is faster than checking vector membership.
 				std::unordered_set<int> tenorsSeen{};
 
-				std::string currentRow{};
-				while (std::getline(CSVStream, currentRow)) {
-					if (currentRowNum == std::numeric_limits<int>::max()) {
-						throw CSVError(std::string{tooManyRowsMessage});
-					}
-					++currentRowNum;
-
+				for (std::size_t i = headerRowIndex + 1; i < rows.size(); ++i) {
+					const std::string_view currentRowView = rows[i];
 					// Skip blank lines:
-					auto currentRowView = std::string_view{currentRow};
 					if (isBlankLineCSV(currentRowView)) {
 						continue;
 					}
-
-					auto currentRowNumString = std::to_string(currentRowNum);
-
-					auto rowCells = getCells(currentRowView);
+					// Row count is checked against int's limit when splitting, so this is safe.
+					const int currentRowNum = static_cast<int>(i) + 1;
 
 					// Parse tenor:
 					int currentTenor{};
 					try {
-						currentTenor = Parsing::parseTenor(*rowCells.begin());
+						currentTenor = Parsing::parseTenor(currentRowView.substr(0, currentRowView.find(',')));
 					}
 					catch (const Parsing::ParseError &e) {
-						throw CSVError(std::format("row {}: {}", currentRowNumString, e.what()));
+						scan.tenorError = std::format("row {}: {}", currentRowNum, e.what());
+						break;
 					}
 					if (!tenorsSeen.emplace(currentTenor).second) {
-						throw CSVError(
-							std::format("row {}: duplicate tenor {}", currentRowNumString, currentTenor)
-						);
+						scan.tenorError = std::format("row {}: duplicate tenor {}", currentRowNum, currentTenor);
+						break;
 					}
-					tenorsUnsorted.push_back(currentTenor);
+					scan.rows.push_back({.contents = currentRowView, .rowNum = currentRowNum});
+					scan.tenors.push_back(currentTenor);
+				}
+				return scan;
+			}
 
-					// Add another row's worth of space to the grid vector:
-					const std::size_t base = gridUnsorted.size();
-					gridUnsorted.resize(base + static_cast<std::size_t>(numMonths));
+			/// Parses the bond returns of a data row (the cells following its tenor) into dest, which must have space
+			/// for numMonths values, throwing a CSVError if any are invalid or missing.
+			static void parseReturns(const DataRow& row, const int numMonths, double* const dest) {
+				int currentMonth = 0;
 
-					// Traverse the row, read and validate the bond return for the current tenor and month,
-					// add it to the bond return data grid if valid, throw a CSVError if not:
-					int currentMonth = 0;
-					for (auto cell : rowCells | std::views::drop(1)) {
+				// Traverse the row, read and validate the bond return for the current tenor and month,
+				// add it to the bond return data grid if valid, throw a CSVError if not:
+				if (const std::size_t firstComma = row.contents.find(','); firstComma != std::string_view::npos) {
+					const std::string_view returnsView = row.contents.substr(firstComma + 1);
+					std::size_t cellStart = 0;
+					while (true) {
+						const std::size_t cellEnd = returnsView.find(',', cellStart);
+						const std::string_view cell = returnsView.substr(
+							cellStart,
+							cellEnd == std::string_view::npos ? std::string_view::npos : cellEnd - cellStart
+						);
+						if (currentMonth == numMonths) {
+							throw CSVError(
+								std::format("row {}: more bond returns than the {} months in header", row.rowNum, numMonths)
+							);
+						}
 						try {
-							gridUnsorted[base + static_cast<std::size_t>(currentMonth)] = Parsing::parseBondReturn(cell);
+							dest[currentMonth] = Parsing::parseBondReturn(cell);
 						}
 						catch (const Parsing::ParseError &e) {
-							throw CSVError(
-								std::format("row {}, month {}: {}", currentRowNumString, currentMonth, e.what())
-							);
+							throw CSVError(std::format("row {}, month {}: {}", row.rowNum, currentMonth, e.what()));
 						}
 						++currentMonth;
-					}
 
-					// Check that there are no missing months of bond return data for this tenor:
-					if (currentMonth != numMonths) {
-						if (currentMonth == numMonths - 1) {
-							throw CSVError(
-								std::format("row {}: missing month {}", currentRowNumString, numMonths - 1)
-							);
+						if (cellEnd == std::string_view::npos) {
+							break;
 						}
-						throw CSVError(
-							std::format(
-								"row {}: missing months {} to {}",
-								currentRowNumString,
-								currentMonth,
-								numMonths - 1
-							)
-						);
+						cellStart = cellEnd + 1;
 					}
 				}
-				if (tenorsUnsorted.empty()) {
-					throw CSVError("no bond return data");
+
+				// Check that there are no missing months of bond return data for this tenor:
+				if (currentMonth != numMonths) {
+					if (currentMonth == numMonths - 1) {
+						throw CSVError(std::format("row {}: missing month {}", row.rowNum, numMonths - 1));
+					}
+					throw CSVError(
+						std::format("row {}: missing months {} to {}", row.rowNum, currentMonth, numMonths - 1)
+					);
 				}
-				return {.tenorsUnsorted = std::move(tenorsUnsorted), .gridUnsorted = std::move(gridUnsorted)};
+			}
+
+			/**
+			* Parses the bond returns of every data row, splitting the rows across threads with each filling its own
+			* slice of the grid: the ith row is written to row destinationRows[i] of grid, or if destinationRows is null,
+			* the rows are only validated, with each thread parsing into its own scratch row.
+			*
+			* Workers stop once a row before the one they are about to parse has failed, and the error from the
+			* earliest failing chunk is rethrown, so the error reported is always that of the first invalid row in
+			* file order, exactly as when parsing serially.
+			*/
+			static void parseAllReturns(
+				const std::vector<DataRow>& rows,
+				const int numMonths,
+				const std::vector<std::size_t>* const destinationRows,
+				double* const grid
+			) {
+				const auto rowLength = static_cast<std::size_t>(numMonths);
+				// Index of the earliest row known to have failed (rows.size() if none have).
+				std::atomic<std::size_t> firstFailedRow{rows.size()};
+
+				Helpers::Parallel::forEachChunk(
+					rows.size(),
+					std::max<std::size_t>(minCellsPerThread / rowLength, 1),
+					[&](const std::size_t begin, const std::size_t end) {
+						std::vector<double> scratchRow(destinationRows ? 0 : rowLength);
+
+						for (std::size_t i = begin; i < end; ++i) {
+							// An earlier row has already failed, so nothing after it will be reported:
+							if (firstFailedRow.load(std::memory_order_relaxed) < i) {
+								return;
+							}
+							double* const dest = destinationRows
+								? grid + (*destinationRows)[i] * rowLength
+								: scratchRow.data();
+							try {
+								parseReturns(rows[i], numMonths, dest);
+							}
+							catch (const CSVError&) {
+								std::size_t expected = firstFailedRow.load(std::memory_order_relaxed);
+								while (i < expected && !firstFailedRow.compare_exchange_weak(expected, i)) {}
+								throw;
+							}
+						}
+					}
+				);
 			}
 		}
 
 		namespace Sorting
 		{
-			struct SortedData
+			struct SortedPositions
 			{
 				std::vector<int> tenorsSorted{};
-				std::vector<double> gridSorted{};
+				// destinationRows[i] is the row of the sorted grid that the ith data row (in file order) belongs in.
+				std::vector<std::size_t> destinationRows{};
 			};
 
-			/// Returns sorted copies of the tenor list and return grid in case the CSV data is disordered
-			[[nodiscard]] static SortedData sortData(
-				const std::vector<int>& tenorsUnsorted,
-				const std::vector<double>& gridUnsorted,
-				const int numMonths
-			) {
+			/// Works out where each row belongs once sorted by tenor, so that bond returns can be parsed straight
+			/// into their sorted position rather than being sorted after loading.
+			[[nodiscard]] static SortedPositions sortedPositions(const std::vector<int>& tenorsUnsorted) {
+				const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Sort);
 				// sortedIndices stores the indices of the tenors in ascending order,
 				// for example, if tenorsUnsorted were { 3, 9, 6 }, then sortedIndices would be { 0, 2, 1 }.
 				std::vector<std::size_t> sortedIndices(tenorsUnsorted.size());
@@ -332,65 +388,103 @@ namespace IO::Input
 				// We then sort these indices according to the values of tenorsUnsorted of the corresponding index.
 				std::ranges::sort(sortedIndices, {}, [&](const std::size_t i) { return tenorsUnsorted[i]; });
 
-				// If we have fewer months of data than the shortest tenor, no solution is possible.
-				if (const int shortestTenor = tenorsUnsorted[sortedIndices.front()]; numMonths < shortestTenor) {
-					throw CSVError(
-						std::format(
-							"shortest tenor is {} months, but only {} months of data provided",
-							shortestTenor,
-							numMonths
-						)
-					);
-				}
-
-				std::vector<int> tenorsSorted(tenorsUnsorted.size());
-				std::vector<double> gridSorted(gridUnsorted.size());
-
-				// Construct the sorted tenor list and grid:
+				SortedPositions positions{
+					.tenorsSorted = std::vector<int>(tenorsUnsorted.size()),
+					.destinationRows = std::vector<std::size_t>(tenorsUnsorted.size())
+				};
 				for (std::size_t r = 0; r < sortedIndices.size(); ++r) {
-					// The index in tenorsUnsorted of the rth tenor (in ascending order).
-					const std::size_t sourceIndex = sortedIndices[r];
-					// Store the rth tenor (in ascending order):
-					tenorsSorted[r] = tenorsUnsorted[sourceIndex];
-
-					// Copy numMonths of bond return data from gridUnsorted starting at the position corresponding to
-					// the values for tenorsSorted[r] into the position corresponding to the rth "row" of the
-					// vectorised gridSorted:
-					std::copy_n(&gridUnsorted[sourceIndex * numMonths], numMonths, &gridSorted[r * numMonths]);
+					// The rth tenor (in ascending order) comes from data row sortedIndices[r], which belongs in row r:
+					positions.tenorsSorted[r] = tenorsUnsorted[sortedIndices[r]];
+					positions.destinationRows[sortedIndices[r]] = r;
 				}
-
-				return {.tenorsSorted = std::move(tenorsSorted), .gridSorted = std::move(gridSorted)};
+				return positions;
 			}
 		}
 	}
 
+	std::filesystem::path validatedCSVPath(const std::string_view CSVPathSv) {
+		// Expand and check path:
+		std::filesystem::path CSVPath{};
+		try {
+			CSVPath = Helpers::Filesystem::expandUserPath(CSVPathSv);
+			Helpers::Filesystem::assertDirectoryValid(Helpers::Filesystem::getDirectory(CSVPath));
+			Helpers::Filesystem::assertFileValid(CSVPath);
+		}
+		catch (const Helpers::Filesystem::FilesystemError& e) {
+			throw CSVError(e.what());
+		}
+
+		// Check extension:
+		const std::string fileExtension = Helpers::Strings::svToLowercase(Helpers::Filesystem::getExtension(CSVPath));
+		if (fileExtension.empty()) {
+			throw CSVError("file has no extension, must be .csv or .txt");
+		}
+		if (Detail::Filepath::isSpreadsheetExtension(fileExtension)) {
+			throw CSVError(
+				std::format("file extension .{} is a spreadsheet format, save as CSV instead", fileExtension)
+			);
+		}
+		if (fileExtension != "csv" && fileExtension != "txt") {
+			throw CSVError(std::format("file extension must be .csv or .txt, received .{}", fileExtension));
+		}
+
+		return CSVPath;
+	}
+
 	Domain::BondReturnData loadBondReturnCSV(const std::string_view CSVPathSv) {
-		// Open file:
-		auto CSVPath = Detail::Filepath::validatedPath(CSVPathSv);
-		std::ifstream CSVStream{CSVPath};
-		if (!CSVStream.is_open()) {
-			throw CSVError(std::format("cannot open\n{}", CSVPath.string()));
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Load);
+		// Map file:
+		auto CSVPath = validatedCSVPath(CSVPathSv);
+		std::optional<Helpers::Filesystem::MappedFile> CSVFile{};
+		try {
+			CSVFile.emplace(CSVPath);
+		}
+		catch (const Helpers::Filesystem::FileError& e) {
+			throw CSVError(e.what());
 		}
-		if (CSVStream.peek() == std::ifstream::traits_type::eof()) {
+		return parseBondReturnCSV(CSVFile->contents(), std::move(CSVPath));
+	}
+
+	Domain::BondReturnData parseBondReturnCSV(const std::string_view contents, std::filesystem::path CSVPath) {
+		if (contents.empty()) {
 			throw CSVError(std::format("{}\nis empty", CSVPath.string()));
 		}
+		const auto rows = Detail::Rows::splitRows(contents);
 
 		// Read header:
-		auto headerData = Detail::Header::getHeaderData(CSVStream);
-		auto headerView = std::string_view{headerData.headerContents};
-		int numMonths = Detail::Header::numMonthsInHeader(headerView);
-
-		// Load data:
-		auto unsortedData = Detail::Data::loadData(CSVStream, headerData.headerRowNum, numMonths);
-		if (!CSVStream.eof()) {
-			throw CSVError(std::format("error reading\n{}", CSVPath.string()));
+		const auto headerData = Detail::Header::getHeaderData(rows);
+		const int numMonths = Detail::Header::numMonthsInHeader(headerData.headerContents);
+
+		// Find data rows and their tenors:
+		const auto tenorScan = Detail::Data::scanTenors(rows, headerData.headerRowIndex);
+		if (tenorScan.tenorError) {
+			// Any invalid bond returns before the row with the invalid tenor must be reported first,
+			// so validate those rows (discarding the values) before reporting the tenor error.
+			Detail::Data::parseAllReturns(tenorScan.rows, numMonths, nullptr, nullptr);
+			throw CSVError(*tenorScan.tenorError);
+		}
+		if (tenorScan.rows.empty()) {
+			throw CSVError("no bond return data");
 		}
 
-		// Sort data:
-		auto sortedData = Detail::Sorting::sortData(unsortedData.tenorsUnsorted, unsortedData.gridUnsorted, numMonths);
+		// Load data, writing each row directly into its sorted position (in parallel for large files):
+		auto sortedPositions = Detail::Sorting::sortedPositions(tenorScan.tenors);
+		std::vector<double> gridSorted(tenorScan.rows.size() * static_cast<std::size_t>(numMonths));
+		Detail::Data::parseAllReturns(tenorScan.rows, numMonths, &sortedPositions.destinationRows, gridSorted.data());
+
+		// If we have fewer months of data than the shortest tenor, no solution is possible.
+		if (const int shortestTenor = sortedPositions.tenorsSorted.front(); numMonths < shortestTenor) {
+			throw CSVError(
+				std::format(
+					"shortest tenor is {} months, but only {} months of data provided",
+					shortestTenor,
+					numMonths
+				)
+			);
+		}
 
 		return Domain::BondReturnData{
-			std::move(sortedData.tenorsSorted), numMonths, std::move(sortedData.gridSorted), std::move(CSVPath)
+			std::move(sortedPositions.tenorsSorted), numMonths, std::move(gridSorted), std::move(CSVPath)
 		};
 	}
 }
\ No newline at end of file
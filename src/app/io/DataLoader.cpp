@@ -0,0 +1,131 @@
+#include "app/io/DataLoader.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/io/BinaryCurve.hpp"
+#include "app/io/CSVLoader.hpp"
+#include "helpers/Filesystem.hpp"
+#include "helpers/Hash.hpp"
+#include "helpers/MappedFile.hpp"
+#include "helpers/Strings.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <ios>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace IO::Input
+{
+	namespace Detail
+	{
+		/// Returns the stamp of a CSV whose contents have already been read,
+		/// or nullopt if its modification time cannot be determined.
+		[[nodiscard]] static std::optional<SourceStamp> stampCSV(
+			const std::filesystem::path& CSVPath,
+			const std::string_view contents
+		) {
+			std::error_code ec{};
+			const auto modified = std::filesystem::last_write_time(CSVPath, ec);
+			if (ec) {
+				return std::nullopt;
+			}
+			return SourceStamp{
+				.size = contents.size(),
+				.modified = static_cast<std::int64_t>(modified.time_since_epoch().count()),
+				.hash = Helpers::Hash::hashBytes(contents.data(), contents.size())
+			};
+		}
+
+		/// Writes the sidecar via a temporary file renamed into place, so that a concurrent or interrupted write
+		/// never leaves a partial sidecar behind. The cache is only an optimisation, so failures are ignored.
+		static void tryWriteSidecar(
+			const Domain::BondReturnData& tenorData,
+			const SourceStamp& stamp,
+			const std::filesystem::path& sidecarPath
+		) {
+			auto tempPath = sidecarPath;
+			tempPath += ".tmp";
+			std::error_code ec{};
+			try {
+				Output::writeBinaryCurve(tenorData, stamp, tempPath);
+			}
+			catch (const std::ios_base::failure&) {
+				std::filesystem::remove(tempPath, ec);
+				return;
+			}
+			std::filesystem::rename(tempPath, sidecarPath, ec);
+			if (ec) {
+				std::filesystem::remove(tempPath, ec);
+			}
+		}
+
+		/// Loads a CSV, using its sidecar if that is up to date, and writing a fresh sidecar if not.
+		[[nodiscard]] static Domain::BondReturnData loadCSVWithCache(const std::string_view CSVPathSv) {
+			auto CSVPath = validatedCSVPath(CSVPathSv);
+			std::optional<Helpers::Filesystem::MappedFile> CSVFile{};
+			try {
+				CSVFile.emplace(CSVPath);
+			}
+			catch (const Helpers::Filesystem::FileError& e) {
+				throw CSVError(e.what());
+			}
+
+			const auto sidecarPath = binarySidecarPath(CSVPath);
+			const auto stamp = stampCSV(CSVPath, CSVFile->contents());
+			if (stamp && readSourceStamp(sidecarPath) == stamp) {
+				try {
+					return loadBinaryCurve(sidecarPath, CSVPath);
+				}
+				catch (const BinaryCurveError&) {
+					// A damaged sidecar is simply regenerated from the CSV below.
+				}
+			}
+
+			auto tenorData = parseBondReturnCSV(CSVFile->contents(), std::move(CSVPath));
+			if (stamp) {
+				tryWriteSidecar(tenorData, *stamp, sidecarPath);
+			}
+			return tenorData;
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	std::filesystem::path binarySidecarPath(const std::filesystem::path& CSVPath) {
+		auto sidecarPath = CSVPath;
+		sidecarPath += '.';
+		sidecarPath += binaryCurveExtension;
+		return sidecarPath;
+	}
+
+	Domain::BondReturnData loadBondReturnData(const std::string_view pathSv, const LoadOptions& options) {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Load);
+		std::filesystem::path dataPath{};
+		try {
+			dataPath = Helpers::Filesystem::expandUserPath(pathSv);
+		}
+		catch (const Helpers::Filesystem::FilesystemError& e) {
+			throw LoadError(e.what());
+		}
+
+		if (Helpers::Strings::svToLowercase(Helpers::Filesystem::getExtension(dataPath)) == binaryCurveExtension) {
+			try {
+				Helpers::Filesystem::assertDirectoryValid(Helpers::Filesystem::getDirectory(dataPath));
+				Helpers::Filesystem::assertFileValid(dataPath);
+			}
+			catch (const Helpers::Filesystem::FilesystemError& e) {
+				throw BinaryCurveError(e.what());
+			}
+			return loadBinaryCurve(dataPath);
+		}
+
+		if (options.useBinaryCache) {
+			return Detail::loadCSVWithCache(pathSv);
+		}
+		return loadBondReturnCSV(pathSv);
+	}
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "app/io/ExportOptions.hpp"
 
 #include "app/domain/BondReturnData.hpp"
+#include "app/io/BinaryResults.hpp"
 #include "helpers/Filesystem.hpp"
 #include "helpers/Strings.hpp"
 #include "helpers/printing/StyledPrint.hpp"
@@ -115,6 +116,20 @@ namespace IO::Output
 					{.caseSensitive = false}
 				);
 			}
+
+			/// Asks the user whether to save as CSV (c) or binary results (b).
+			[[nodiscard]] static auto promptForFormat() {
+				return Transformers::Mapping::mappingTransformer<ResultsFormat>(
+					std::format(
+						"Enter \"c\" to save results as CSV;\n"
+						"OR enter \"b\" to save results in binary (.{}) for analysis tools;\n"
+						"OR press ENTER to see options again:",
+						binaryResultsExtension
+					),
+					{{"c", ResultsFormat::CSV}, {"b", ResultsFormat::Binary}},
+					{.caseSensitive = false, .quitWord = ""}
+				);
+			}
 		}
 
 		namespace Filename
@@ -124,18 +139,22 @@ namespace IO::Output
 				using std::runtime_error::runtime_error;
 			};
 
-			[[nodiscard]] static std::filesystem::path generateOutputFilename(const std::filesystem::path& dir) {
+			[[nodiscard]] static std::filesystem::path generateOutputFilename(
+				const std::filesystem::path& dir,
+				const std::string_view extension
+			) {
 				if (std::error_code ec; !std::filesystem::is_directory(dir, ec) || ec) {
 					throw FilenameGenerationError(std::format("Unable to access directory {}", dir.string()));
 				}
 				// Filename set in header.
-				std::filesystem::path baseCandidate = dir / std::format("{}.csv", RESULTS_FILENAME);
+				std::filesystem::path baseCandidate = dir / std::format("{}.{}", RESULTS_FILENAME, extension);
 				if (std::error_code ec; !std::filesystem::exists(baseCandidate, ec)) {
 					return baseCandidate;
 				}
 				// Limit set in header.
 				for (int i = 2; i <= RESULT_FILES_LIMIT; ++i) {
-					std::filesystem::path numCandidate = dir / std::format("{}_{}.csv", RESULTS_FILENAME,i);
+					std::filesystem::path numCandidate =
+						dir / std::format("{}_{}.{}", RESULTS_FILENAME, i, extension);
 					if (std::error_code ec; !std::filesystem::exists(numCandidate, ec)) {
 						return numCandidate;
 					}
@@ -147,6 +166,7 @@ namespace IO::Output
 
 	ExportDecision getExportDecision(const Domain::BondReturnData& tenorData) {
 		std::filesystem::path filePath{};
+		ResultsFormat format = ResultsFormat::CSV;
 
 		std::filesystem::path outputDirectory{};
 
@@ -218,8 +238,17 @@ namespace IO::Output
 				case Detail::ExportLocation::Terminal:
 					return Decision::Print{};
 			}
+
+			const auto formatPromptResult = Detail::LocationPrompt::promptForFormat();
+			if (formatPromptResult.isEscape()) {
+				continue;
+			}
+			format = formatPromptResult.getValue();
+
 			try {
-				filePath = Detail::Filename::generateOutputFilename(outputDirectory);
+				filePath = Detail::Filename::generateOutputFilename(
+					outputDirectory, format == ResultsFormat::Binary ? binaryResultsExtension : "csv"
+				);
 			}
 			catch (const Detail::Filename::FilenameGenerationError& e) {
 				Helpers::Printing::styledPrintln(Helpers::Printing::Styles::error, "{}", e.what());
@@ -230,6 +259,6 @@ namespace IO::Output
 			break;
 		}
 		std::println();
-		return Decision::Save{std::move(filePath)};
+		return Decision::Save{.filePath = std::move(filePath), .format = format};
 	}
 }
\ No newline at end of file
@@ -1,15 +1,27 @@
 #include "app/io/ResultsOutput.hpp"
 
 #include "app/domain/InvestmentAction.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/io/BinaryResults.hpp"
 #include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/ResultDAG.hpp"
+#include "helpers/Parallel.hpp"
 #include "helpers/Strings.hpp"
 #include "helpers/printing/StyledPrint.hpp"
 #include "transformers/Generic.hpp"
 #include "transformers/Mapping.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <cstddef>
 #include <format>
 #include <fstream>
+#include <ios>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <print>
 #include <string>
 #include <vector>
 
@@ -17,50 +29,205 @@ namespace IO::Output
 {
 	namespace Detail
 	{
-		[[nodiscard]] static std::string formatCSVRow(
+		// Enough for any action formatted as in InvestmentAction's formatter: a letter, then an int, then a comma.
+		constexpr std::size_t maxActionChars = 1 + std::numeric_limits<int>::digits10 + 1 + 1;
+		// Enough for the rank, the HPR (up to 309 digits before its 2 decimal places, or scientific notation beyond a
+		// double), and the line break, separators and quotes around the path.
+		constexpr std::size_t maxRowOverheadChars = 512;
+
+		/**
+		* Appends the ith result as a CSV row to the buffer for the given rank, preceded by a line break unless it is
+		* the first row (the first rank of the first horizon, if the row is for one),
+		* exactly as std::format would with "{},{},\"{}\"" (rank, HPR, path), or "{},{},{},\"{}\"" if a horizon
+		* (above 0) is given to start the row. Formatting each field with
+		* std::to_chars straight into space reserved for the longest possible row avoids both a temporary string
+		* per row and std::format's parsing, which otherwise dominate the time of large exports.
+		*/
+		static void appendCSVRow(
+			std::string& buffer,
 			const DynamicOptimiser::OptimalResults& results,
-			const std::size_t i
+			const std::size_t i,
+			const std::size_t rank,
+			const int horizon = 0
 		) {
-			return std::format(
-				"{},{:.2f}%,\"{}\"",
-				i + 1,
-				100 * results.CRFs[i] - 100,
-				Helpers::Strings::joinFormatted(results.decisions[i], ",")
+			const auto path = results.path(i);
+			const std::size_t oldSize = buffer.size();
+			buffer.resize_and_overwrite(
+				oldSize + maxRowOverheadChars + path.size() * maxActionChars,
+				[&](char* const data, const std::size_t capacity) {
+					char* out = data + oldSize;
+					char* const end = data + capacity;
+					if (rank > 0 || horizon > 1) {
+						*out++ = '\n';
+					}
+					if (horizon > 0) {
+						out = std::to_chars(out, end, horizon).ptr;
+						*out++ = ',';
+					}
+					out = std::to_chars(out, end, rank + 1).ptr;
+					*out++ = ',';
+
+					if (const double CRF = results.CRF(i); std::isfinite(CRF)) {
+						out = std::to_chars(out, end, 100 * CRF - 100, std::chars_format::fixed, 2).ptr;
+						*out++ = '%';
+					}
+					else {
+						const std::string HPR = formatHoldingPeriodReturn(results, i);
+						out = std::ranges::copy(HPR, out).out;
+					}
+
+					*out++ = ',';
+					*out++ = '"';
+					for (bool first = true; const Domain::InvestmentAction& action : path) {
+						if (!first) {
+							*out++ = ',';
+						}
+						first = false;
+						*out++ = action.action() == Domain::InvestmentAction::Action::Buy ? 'b' : 'w';
+						out = std::to_chars(out, end, action.length()).ptr;
+					}
+					*out++ = '"';
+					return static_cast<std::size_t>(out - data);
+				}
 			);
 		}
 	}
 
+	std::string formatHoldingPeriodReturn(const DynamicOptimiser::OptimalResults& results, const std::size_t i) {
+		if (const double CRF = results.CRF(i); std::isfinite(CRF)) {
+			return std::format("{:.2f}%", 100 * CRF - 100);
+		}
+		// The CRF is beyond a double, so the -100 is negligible, and the percentage is 10^(log10(CRF) + 2):
+		const double log10Percent = results.CRFs[i] / std::numbers::ln10 + 2;
+		const double exponent = std::floor(log10Percent);
+		return std::format("{:.3f}e+{:.0f}%", std::pow(10.0, log10Percent - exponent), exponent);
+	}
+
 	void printResults(const DynamicOptimiser::OptimalResults& results, const std::size_t numResultsToPrint) {
 		std::println();
 		std::println("Results:");
 		std::println();
 		for (std::size_t i = 0; i < numResultsToPrint; ++i) {
 			std::println(
-				"{}. {:.2f}%: {}",
+				"{}. {}: {}",
 				i + 1,
-				100 * results.CRFs[i] - 100,
-				Helpers::Strings::joinFormatted(results.decisions[i],",")
+				formatHoldingPeriodReturn(results, i),
+				Helpers::Strings::joinFormatted(results.path(i),",")
 			);
 		}
 	}
 
-	ExportOutcome exportCSV(
+	CSVWriter::CSVWriter(const std::filesystem::path& filePath) : out_(filePath, std::ios::trunc) {
+		// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+		out_.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+	}
+
+	CSVWriter::~CSVWriter() = default;
+
+	void CSVWriter::write(
+		const DynamicOptimiser::OptimalResults& results,
+		const std::size_t firstRank,
+		const std::size_t numRows
+	) {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Export);
+		const std::size_t numBlocks = (numRows + rowsPerBlock - 1) / rowsPerBlock;
+		// Only start threads once a write has blocks enough to be worth sharing, keeping them for later writes:
+		if (!pool_ && numBlocks >= minBlocksForThreads && Helpers::Parallel::availableThreads() > 1) {
+			pool_ = std::make_unique<Helpers::Parallel::WorkerPool>(Helpers::Parallel::availableThreads());
+		}
+		const std::size_t numThreads = pool_ ? pool_->numThreads() : 1;
+		if (buffers_.size() < numThreads) {
+			buffers_.resize(numThreads);
+		}
+
+		// Each round formats one block per thread, so the buffers (and their capacity) are reused every round:
+		for (std::size_t roundBegin = 0; roundBegin < numBlocks; roundBegin += numThreads) {
+			const std::size_t numTasks = std::min(numThreads, numBlocks - roundBegin);
+			const auto formatBlock = [&](const std::size_t task) {
+				const std::size_t begin = (roundBegin + task) * rowsPerBlock;
+				const std::size_t end = std::min(begin + rowsPerBlock, numRows);
+				std::string& buffer = buffers_[task];
+				buffer.clear();
+				for (std::size_t i = begin; i < end; ++i) {
+					Detail::appendCSVRow(buffer, results, i, firstRank + i);
+				}
+			};
+			if (pool_) {
+				pool_->forEachTask(numTasks, formatBlock);
+			}
+			else {
+				formatBlock(0);
+			}
+			for (std::size_t task = 0; task < numTasks; ++task) {
+				out_.write(buffers_[task].data(), static_cast<std::streamsize>(buffers_[task].size()));
+			}
+		}
+	}
+
+	void CSVWriter::finish() {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Export);
+		out_.flush();
+	}
+
+	void writeCSV(
 		const DynamicOptimiser::OptimalResults& results,
 		const std::size_t numResultsToExport,
 		const std::filesystem::path& filePath
 	) {
-		try {
-			std::ofstream out(filePath, std::ios::trunc);
-			// Convert stream state failures into exceptions so partial/failed writes are handled by the catch path:
-			out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+		CSVWriter writer(filePath);
+		writer.write(results, 0, numResultsToExport);
+		writer.finish();
+	}
 
-			for (std::size_t i = 0; i < numResultsToExport; ++i) {
-				if (i > 0) {
-					out << '\n';
-				}
-				out << Detail::formatCSVRow(results, i);
+	void writeCSV(const DynamicOptimiser::ResultDAG& results, const std::filesystem::path& filePath) {
+		// Only a block of paths is unfolded at a time, so the paths are never all held at once:
+		constexpr std::size_t ranksPerBlock = 1 << 16;
+		CSVWriter writer(filePath);
+		DynamicOptimiser::OptimalResults block{};
+		for (std::size_t firstRank = 0; firstRank < results.size(); firstRank += ranksPerBlock) {
+			const std::size_t numRows = std::min(ranksPerBlock, results.size() - firstRank);
+			results.unfold(firstRank, numRows, block);
+			writer.write(block, firstRank, numRows);
+		}
+		writer.finish();
+	}
+
+	void writeHorizonsCSV(
+		const std::vector<DynamicOptimiser::OptimalResults>& resultsByHorizon,
+		const std::filesystem::path& filePath
+	) {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Export);
+		std::ofstream out(filePath, std::ios::trunc);
+		out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+		// One horizon's rows are formatted at a time, reusing the buffer:
+		std::string buffer{};
+		for (std::size_t h = 0; h < resultsByHorizon.size(); ++h) {
+			const auto& results = resultsByHorizon[h];
+			buffer.clear();
+			for (std::size_t i = 0; i < results.size(); ++i) {
+				Detail::appendCSVRow(buffer, results, i, i, static_cast<int>(h + 1));
+			}
+			out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		}
+		out.flush();
+	}
+
+	ExportOutcome exportResults(
+		const DynamicOptimiser::OptimalResults& results,
+		const std::size_t numResultsToExport,
+		const std::vector<int>& tenors,
+		const Decision::Save& decision
+	) {
+		const auto& filePath = decision.filePath;
+		try {
+			switch (decision.format) {
+				case ResultsFormat::CSV:
+					writeCSV(results, numResultsToExport, filePath);
+					break;
+				case ResultsFormat::Binary:
+					writeBinaryResults(results, numResultsToExport, tenors, filePath);
+					break;
 			}
-			out.flush();
 
 			std::println("Export complete, saved to:");
 			std::println("{}", filePath.string());
@@ -0,0 +1,440 @@
+#include "app/io/SweepSummary.hpp"
+
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "helpers/Filesystem.hpp"
+#include "helpers/MappedFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace IO
+{
+	namespace Detail::SummaryFormat
+	{
+		constexpr std::array<char, 8> magic = {'B', 'S', 'O', 'S', 'W', 'E', 'E', 'P'};
+		// Increment whenever the layout changes, older files are then rejected.
+		constexpr std::uint32_t version = 1;
+		// Written in native byte order, so reads back differently on a machine with the opposite byte order.
+		constexpr std::uint64_t byteOrderMark = 0x0102030405060708;
+		constexpr std::uint32_t logSpaceFlag = 1;
+
+		/// The fixed-size header at the start of every sweep summary file.
+		struct FileHeader
+		{
+			std::array<char, 8> magic{};
+			std::uint32_t version{};
+			std::uint32_t headerSize{};
+			std::uint64_t byteOrderMark{};
+			std::uint32_t flags{};
+			std::uint32_t maxTopResults{};
+			std::uint64_t numInputs{};
+			std::uint64_t numFailures{};
+			std::uint32_t numTopResults{};
+			std::uint32_t numFirstPurchases{};
+			std::uint64_t numSteps{};
+		};
+		static_assert(sizeof(FileHeader) == 64, "sweep summary header must be exactly 64 bytes");
+
+		/// Returns the size of a part in bytes, padded to a multiple of 8.
+		[[nodiscard]] static constexpr std::size_t paddedSize(const std::size_t numBytes) noexcept {
+			return (numBytes + 7) / 8 * 8;
+		}
+
+		/// Reads the parts of a file in order, checking that each lies within the file.
+		class PartReader
+		{
+			public:
+				explicit PartReader(const Helpers::Filesystem::MappedFile& file) noexcept : file_(file) {}
+
+				/// Copies the next part, of count values of type T, into values.
+				template <typename T>
+				void read(std::vector<T>& values, const std::size_t count) {
+					const std::size_t numBytes = count * sizeof(T);
+					if (count > (file_.size() - pos_) / sizeof(T) || paddedSize(numBytes) > file_.size() - pos_) {
+						throw SweepSummaryError("sweep summary is truncated");
+					}
+					values.resize(count);
+					std::memcpy(values.data(), file_.data() + pos_, numBytes);
+					pos_ += paddedSize(numBytes);
+				}
+
+				[[nodiscard]] bool atEnd() const noexcept { return pos_ == file_.size(); }
+
+			private:
+				const Helpers::Filesystem::MappedFile& file_;
+				std::size_t pos_ = sizeof(FileHeader);
+		};
+
+		/// Writes count values as the next part, padding it with zeros.
+		template <typename T>
+		static void writePart(std::ofstream& out, const T* const values, const std::size_t count) {
+			const std::size_t numBytes = count * sizeof(T);
+			out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(numBytes));
+			constexpr std::array<char, 8> padding{};
+			out.write(padding.data(), static_cast<std::streamsize>(paddedSize(numBytes) - numBytes));
+		}
+	}
+
+	namespace Detail
+	{
+		/// A top result as it is ordered: by CRF, then by the position of its input in the sweep, then by its rank.
+		struct Candidate
+		{
+			double CRF{};
+			std::uint64_t position{};
+			std::uint32_t rank{};
+		};
+
+		[[nodiscard]] static bool ranksAbove(const Candidate& a, const Candidate& b) noexcept {
+			if (a.CRF != b.CRF) {
+				return a.CRF > b.CRF;
+			}
+			if (a.position != b.position) {
+				return a.position < b.position;
+			}
+			return a.rank < b.rank;
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	SweepSummary::SweepSummary(const std::size_t maxTopResults, const bool logSpace) noexcept :
+		maxTopResults_(maxTopResults),
+		logSpace_(logSpace)
+	{
+		top_.logSpace = logSpace;
+	}
+
+	void SweepSummary::add(
+		const std::string_view inputName,
+		const std::size_t position,
+		const DynamicOptimiser::OptimalResults& results
+	) {
+		if (results.size() > 0 && results.logSpace != logSpace_) {
+			throw std::invalid_argument("SweepSummary: results must be in log space exactly when the summary is");
+		}
+		const auto input = static_cast<std::uint32_t>(inputNames_.size());
+		inputNames_.emplace_back(inputName);
+		positions_.push_back(position);
+		bestCRFs_.push_back(results.size() > 0 ? results.CRFs[0] : std::numeric_limits<double>::quiet_NaN());
+		if (results.size() > 0) {
+			const auto path = results.path(0);
+			const auto firstPurchase = std::ranges::find(
+				path, Domain::InvestmentAction::Action::Buy, &Domain::InvestmentAction::action
+			);
+			++firstPurchaseCounts_[firstPurchase == path.end() ? 0 : firstPurchase->length()];
+		}
+
+		// Both lists are sorted, so the new top results are found by merging them until enough are taken:
+		DynamicOptimiser::OptimalResults previousTop = std::move(top_);
+		std::vector<std::uint32_t> previousInputs = std::move(topInputs_);
+		std::vector<std::uint32_t> previousRanks = std::move(topRanks_);
+		top_ = {};
+		top_.logSpace = logSpace_;
+		topInputs_.clear();
+		topRanks_.clear();
+
+		const std::size_t numNew = std::min(results.size(), maxTopResults_);
+		std::size_t i = 0;
+		std::size_t j = 0;
+		while (topInputs_.size() < maxTopResults_ && (i < previousTop.size() || j < numNew)) {
+			const bool takePrevious = j == numNew || (
+				i < previousTop.size()
+				&& Detail::ranksAbove(
+					{previousTop.CRFs[i], positions_[previousInputs[i]], previousRanks[i]},
+					{results.CRFs[j], position, static_cast<std::uint32_t>(j)}
+				)
+			);
+			if (takePrevious) {
+				appendTop(previousTop, i, previousInputs[i], previousRanks[i]);
+				++i;
+			}
+			else {
+				appendTop(results, j, input, static_cast<std::uint32_t>(j));
+				++j;
+			}
+		}
+	}
+
+	void SweepSummary::appendTop(
+		const DynamicOptimiser::OptimalResults& results,
+		const std::size_t i,
+		const std::uint32_t input,
+		const std::uint32_t rank
+	) {
+		if (top_.pathOffsets.empty()) {
+			top_.pathOffsets.push_back(0);
+		}
+		const auto path = results.path(i);
+		top_.actions.insert(top_.actions.end(), path.begin(), path.end());
+		top_.pathOffsets.push_back(top_.actions.size());
+		top_.CRFs.push_back(results.CRFs[i]);
+		topInputs_.push_back(input);
+		topRanks_.push_back(rank);
+	}
+
+	SweepSummary SweepSummary::merge(const std::span<const SweepSummary> summaries, const std::size_t maxTopResults) {
+		const bool logSpace = !summaries.empty() && summaries.front().logSpace_;
+		const auto differs = [&](const SweepSummary& summary) { return summary.logSpace_ != logSpace; };
+		if (std::ranges::any_of(summaries, differs)) {
+			throw SweepSummaryError("summaries of runs in log space cannot be combined with those of runs not");
+		}
+		// A summary holds only its own best maxTopResults, so any result it dropped could belong among more:
+		for (const SweepSummary& summary : summaries) {
+			if (maxTopResults > summary.maxTopResults_) {
+				throw SweepSummaryError(std::format(
+					"cannot keep {} top results, since a summary keeps only {}", maxTopResults, summary.maxTopResults_
+				));
+			}
+		}
+
+		// Each summary's inputs follow those of the summaries before it:
+		SweepSummary merged(maxTopResults, logSpace);
+		std::vector<std::uint32_t> firstInputs{};
+		for (const SweepSummary& summary : summaries) {
+			firstInputs.push_back(static_cast<std::uint32_t>(merged.inputNames_.size()));
+			merged.numFailures_ += summary.numFailures_;
+			merged.inputNames_.insert(merged.inputNames_.end(), summary.inputNames_.begin(), summary.inputNames_.end());
+			merged.positions_.insert(merged.positions_.end(), summary.positions_.begin(), summary.positions_.end());
+			merged.bestCRFs_.insert(merged.bestCRFs_.end(), summary.bestCRFs_.begin(), summary.bestCRFs_.end());
+			for (const auto& [tenor, count] : summary.firstPurchaseCounts_) {
+				merged.firstPurchaseCounts_[tenor] += count;
+			}
+		}
+		// An input in more than one summary (a summary given twice, or overlapping shards) would be counted twice:
+		std::vector<std::size_t> byPosition(merged.positions_.size());
+		std::iota(byPosition.begin(), byPosition.end(), std::size_t{0});
+		std::ranges::sort(byPosition, {}, [&](const std::size_t input) { return merged.positions_[input]; });
+		const auto samePosition = [&](const std::size_t a, const std::size_t b) {
+			return merged.positions_[a] == merged.positions_[b];
+		};
+		if (const auto repeat = std::ranges::adjacent_find(byPosition, samePosition); repeat != byPosition.end()) {
+			throw SweepSummaryError(std::format(
+				"{} is in more than one summary, so they overlap", merged.inputNames_[*repeat]
+			));
+		}
+
+		// Each summary's top results are sorted, so a heap of each one's best not yet taken yields them all in order:
+		using Head = std::pair<std::size_t, std::size_t>;
+		const auto candidateOf = [&](const Head& head) -> Detail::Candidate {
+			const auto& [s, i] = head;
+			const SweepSummary& summary = summaries[s];
+			return {summary.top_.CRFs[i], summary.positions_[summary.topInputs_[i]], summary.topRanks_[i]};
+		};
+		const auto ranksBelow = [&](const Head& a, const Head& b) {
+			return Detail::ranksAbove(candidateOf(b), candidateOf(a));
+		};
+		std::priority_queue<Head, std::vector<Head>, decltype(ranksBelow)> heads(ranksBelow);
+		for (std::size_t s = 0; s < summaries.size(); ++s) {
+			if (summaries[s].top_.size() > 0) {
+				heads.emplace(s, 0);
+			}
+		}
+		while (!heads.empty() && merged.topInputs_.size() < maxTopResults) {
+			const auto [s, i] = heads.top();
+			heads.pop();
+			const SweepSummary& summary = summaries[s];
+			merged.appendTop(summary.top_, i, firstInputs[s] + summary.topInputs_[i], summary.topRanks_[i]);
+			if (i + 1 < summary.top_.size()) {
+				heads.emplace(s, i + 1);
+			}
+		}
+		return merged;
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	void SweepSummary::save(const std::filesystem::path& summaryPath) const {
+		namespace Format = Detail::SummaryFormat;
+
+		std::vector<std::uint32_t> nameLengths{};
+		std::string names{};
+		for (const std::string& name : inputNames_) {
+			nameLengths.push_back(static_cast<std::uint32_t>(name.size()));
+			names += name;
+		}
+		std::vector<std::int32_t> firstPurchaseTenors{};
+		std::vector<std::uint64_t> firstPurchaseCounts{};
+		for (const auto& [tenor, count] : firstPurchaseCounts_) {
+			firstPurchaseTenors.push_back(static_cast<std::int32_t>(tenor));
+			firstPurchaseCounts.push_back(count);
+		}
+		std::vector<std::uint64_t> offsets{0};
+		std::vector<std::int32_t> steps{};
+		for (std::size_t i = 0; i < top_.size(); ++i) {
+			for (const Domain::InvestmentAction& action : top_.path(i)) {
+				const bool buy = action.action() == Domain::InvestmentAction::Action::Buy;
+				steps.push_back(static_cast<std::int32_t>(buy ? action.length() : -action.length()));
+			}
+			offsets.push_back(steps.size());
+		}
+
+		const Format::FileHeader header{
+			.magic = Format::magic,
+			.version = Format::version,
+			.headerSize = sizeof(Format::FileHeader),
+			.byteOrderMark = Format::byteOrderMark,
+			.flags = logSpace_ ? Format::logSpaceFlag : 0,
+			.maxTopResults = static_cast<std::uint32_t>(
+				std::min<std::size_t>(maxTopResults_, std::numeric_limits<std::uint32_t>::max())
+			),
+			.numInputs = inputNames_.size(),
+			.numFailures = numFailures_,
+			.numTopResults = static_cast<std::uint32_t>(top_.size()),
+			.numFirstPurchases = static_cast<std::uint32_t>(firstPurchaseTenors.size()),
+			.numSteps = steps.size()
+		};
+
+		std::ofstream out(summaryPath, std::ios::binary | std::ios::trunc);
+		// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+		out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		Format::writePart(out, positions_.data(), positions_.size());
+		Format::writePart(out, bestCRFs_.data(), bestCRFs_.size());
+		Format::writePart(out, nameLengths.data(), nameLengths.size());
+		Format::writePart(out, names.data(), names.size());
+		Format::writePart(out, firstPurchaseTenors.data(), firstPurchaseTenors.size());
+		Format::writePart(out, firstPurchaseCounts.data(), firstPurchaseCounts.size());
+		Format::writePart(out, top_.CRFs.data(), top_.CRFs.size());
+		Format::writePart(out, topInputs_.data(), topInputs_.size());
+		Format::writePart(out, topRanks_.data(), topRanks_.size());
+		Format::writePart(out, offsets.data(), offsets.size());
+		Format::writePart(out, steps.data(), steps.size());
+		out.flush();
+	}
+
+	SweepSummary SweepSummary::load(const std::filesystem::path& summaryPath) {
+		namespace Format = Detail::SummaryFormat;
+
+		std::optional<Helpers::Filesystem::MappedFile> file{};
+		try {
+			file.emplace(summaryPath);
+		}
+		catch (const Helpers::Filesystem::FileError& e) {
+			throw SweepSummaryError(e.what());
+		}
+
+		Format::FileHeader header{};
+		if (file->size() < sizeof(Format::FileHeader)) {
+			throw SweepSummaryError("file is too small to be a sweep summary");
+		}
+		std::memcpy(&header, file->data(), sizeof(Format::FileHeader));
+		if (header.magic != Format::magic) {
+			throw SweepSummaryError("file is not a sweep summary");
+		}
+		if (header.byteOrderMark != Format::byteOrderMark) {
+			throw SweepSummaryError("sweep summary was written on a machine with a different byte order");
+		}
+		if (header.version != Format::version || header.headerSize != sizeof(Format::FileHeader)) {
+			throw SweepSummaryError(
+				std::format("sweep summary version {} is not supported, expected {}", header.version, Format::version)
+			);
+		}
+		if (header.numTopResults > header.maxTopResults) {
+			throw SweepSummaryError("sweep summary holds more top results than it keeps");
+		}
+		// Every count sizes a part, so none can be larger than the file holds:
+		if (header.numInputs > file->size() || header.numSteps > file->size()) {
+			throw SweepSummaryError("sweep summary is truncated");
+		}
+
+		SweepSummary summary(header.maxTopResults, (header.flags & Format::logSpaceFlag) != 0);
+		summary.numFailures_ = static_cast<std::size_t>(header.numFailures);
+		const auto numInputs = static_cast<std::size_t>(header.numInputs);
+
+		Format::PartReader reader(*file);
+		reader.read(summary.positions_, numInputs);
+		reader.read(summary.bestCRFs_, numInputs);
+		std::vector<std::uint32_t> nameLengths{};
+		reader.read(nameLengths, numInputs);
+		std::size_t namesSize = 0;
+		for (const std::uint32_t length : nameLengths) {
+			namesSize += length;
+		}
+		std::vector<char> names{};
+		reader.read(names, namesSize);
+		summary.inputNames_.reserve(numInputs);
+		for (std::size_t i = 0, offset = 0; i < numInputs; offset += nameLengths[i++]) {
+			summary.inputNames_.emplace_back(names.data() + offset, nameLengths[i]);
+		}
+
+		std::vector<std::int32_t> firstPurchaseTenors{};
+		std::vector<std::uint64_t> firstPurchaseCounts{};
+		reader.read(firstPurchaseTenors, header.numFirstPurchases);
+		reader.read(firstPurchaseCounts, header.numFirstPurchases);
+		if (std::ranges::adjacent_find(firstPurchaseTenors, std::ranges::greater_equal{}) != firstPurchaseTenors.end()
+			|| (!firstPurchaseTenors.empty() && firstPurchaseTenors.front() < 0)) {
+			throw SweepSummaryError("first purchases must be of unique, non-negative tenors in increasing order");
+		}
+		for (std::size_t i = 0; i < firstPurchaseTenors.size(); ++i) {
+			summary.firstPurchaseCounts_.emplace_hint(
+				summary.firstPurchaseCounts_.end(), firstPurchaseTenors[i], firstPurchaseCounts[i]
+			);
+		}
+
+		auto& top = summary.top_;
+		std::vector<std::uint64_t> offsets{};
+		std::vector<std::int32_t> steps{};
+		reader.read(top.CRFs, header.numTopResults);
+		reader.read(summary.topInputs_, header.numTopResults);
+		reader.read(summary.topRanks_, header.numTopResults);
+		reader.read(offsets, static_cast<std::size_t>(header.numTopResults) + 1);
+		reader.read(steps, static_cast<std::size_t>(header.numSteps));
+		if (!reader.atEnd()) {
+			throw SweepSummaryError("sweep summary has unexpected trailing data");
+		}
+		if (std::ranges::any_of(top.CRFs, [](const double CRF) { return std::isnan(CRF); })) {
+			throw SweepSummaryError("invalid CRF");
+		}
+		if (std::ranges::any_of(summary.topInputs_, [&](const std::uint32_t input) { return input >= numInputs; })) {
+			throw SweepSummaryError("top result from an input not in the summary");
+		}
+		if (offsets.front() != 0 || offsets.back() != steps.size()
+			|| std::ranges::adjacent_find(offsets, std::ranges::greater{}) != offsets.end()) {
+			throw SweepSummaryError("invalid path offsets");
+		}
+
+		// Unfolds each path's steps into actions, checking each as InvestmentAction's constructor does:
+		if (header.numTopResults > 0) {
+			top.pathOffsets.push_back(0);
+		}
+		for (std::size_t i = 0; i < header.numTopResults; ++i) {
+			for (std::size_t step = offsets[i]; step < offsets[i + 1]; ++step) {
+				// The lowest int32 has no negation, but is far beyond any path anyway, so is made an invalid length:
+				const int length = steps[step] == std::numeric_limits<std::int32_t>::min() ? 0 : std::abs(steps[step]);
+				try {
+					const auto action = steps[step] > 0
+						? Domain::InvestmentAction::Action::Buy
+						: Domain::InvestmentAction::Action::Wait;
+					top.actions.emplace_back(action, length);
+				}
+				catch (const std::invalid_argument& e) {
+					throw SweepSummaryError(std::format("top result {}: {}", i + 1, e.what()));
+				}
+			}
+			top.pathOffsets.push_back(top.actions.size());
+		}
+		return summary;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "app/optimiser/DecisionStore.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	namespace Detail
+	{
+		// Auto only packs once the Wide layout would reach this size, below which the memory saved is not worth
+		// the slower access.
+		constexpr std::size_t packedThresholdBytes = std::size_t{256} << 20;
+	}
+
+	DecisionLayout resolveDecisionLayout(
+		const DecisionLayout requested,
+		const int numTenors,
+		const int numMonths,
+		const int numResultsRequested
+	) noexcept {
+		if (requested != DecisionLayout::Auto) {
+			return requested;
+		}
+		const std::size_t wideBytes = (static_cast<std::size_t>(numMonths) + 1)
+			* static_cast<std::size_t>(numResultsRequested) * sizeof(Decision);
+		// A packed decision needs at most this many bits, so only pack if that is a real saving over 64:
+		const auto packedBits = static_cast<std::size_t>(
+			std::bit_width(static_cast<unsigned int>(numTenors))
+			+ std::bit_width(static_cast<unsigned int>(std::max(numResultsRequested - 1, 0)))
+		);
+		if (wideBytes >= Detail::packedThresholdBytes && packedBits <= 48) {
+			return DecisionLayout::Packed;
+		}
+		return DecisionLayout::Wide;
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	WideDecisionStore::WideDecisionStore(
+		const int,
+		const int numMonths,
+		const int numResultsRequested,
+		std::pmr::memory_resource* const resource
+	) :
+		rowCapacity_(static_cast<std::size_t>(numResultsRequested)),
+		decisions_((static_cast<std::size_t>(numMonths) + 1) * rowCapacity_, resource),
+		counts_(static_cast<std::size_t>(numMonths) + 1, 0, resource)
+	{}
+
+	void WideDecisionStore::extendRows(const int numMonths) {
+		if (const std::size_t numRows = static_cast<std::size_t>(numMonths) + 1; numRows > counts_.size()) {
+			// Resizing grows the capacity geometrically, so extending a month at a time is amortised O(1) per row.
+			decisions_.resize(numRows * rowCapacity_);
+			counts_.resize(numRows, 0);
+		}
+	}
+
+	void WideDecisionStore::reset(const int, const int numMonths, const int numResultsRequested) {
+		rowCapacity_ = static_cast<std::size_t>(numResultsRequested);
+		const std::size_t numRows = static_cast<std::size_t>(numMonths) + 1;
+		// Only rows' counts need clearing, since decisions beyond a row's count are never read:
+		decisions_.resize(numRows * rowCapacity_);
+		counts_.assign(numRows, 0);
+		currentRow_ = nullptr;
+		currentMonth_ = 0;
+		currentCount_ = 0;
+	}
+
+	std::size_t WideDecisionStore::bytes() const noexcept {
+		return decisions_.capacity() * sizeof(Decision) + counts_.capacity() * sizeof(int);
+	}
+
+	std::size_t WideDecisionStore::maxBytes(const int, const int numMonths, const int numResultsRequested) noexcept {
+		const std::size_t numRows = static_cast<std::size_t>(numMonths) + 1;
+		return numRows * (static_cast<std::size_t>(numResultsRequested) * sizeof(Decision) + sizeof(int));
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	PackedDecisionStore::PackedDecisionStore(
+		const int numTenors,
+		const int numMonths,
+		const int numResultsRequested,
+		std::pmr::memory_resource* const resource
+	) :
+		resource_(resource),
+		// Codes run from 0 (wait) to numTenors.
+		tenorBits_(static_cast<unsigned int>(std::bit_width(static_cast<unsigned int>(numTenors)))),
+		scratch_(static_cast<std::size_t>(numResultsRequested), resource)
+	{
+		extendRows(numMonths);
+	}
+
+	void PackedDecisionStore::extendRows(const int numMonths) {
+		const std::size_t numRows = static_cast<std::size_t>(numMonths) + 1;
+		// Rows are moved in rather than resized into, since only moving keeps the resource their words were made with
+		// (and pushing grows the capacity geometrically, as resizing would):
+		while (rows_.size() < numRows) {
+			rows_.push_back({.words = std::pmr::vector<std::uint64_t>(resource_)});
+		}
+	}
+
+	void PackedDecisionStore::reset(const int numTenors, const int numMonths, const int numResultsRequested) {
+		tenorBits_ = static_cast<unsigned int>(std::bit_width(static_cast<unsigned int>(numTenors)));
+		extendRows(numMonths);
+		for (PackedRow& row : rows_) {
+			row.count = 0;
+			row.rankBits = 0;
+		}
+		scratch_.resize(static_cast<std::size_t>(numResultsRequested));
+		currentMonth_ = 0;
+		scratchCount_ = 0;
+	}
+
+	std::size_t PackedDecisionStore::bytes() const noexcept {
+		std::size_t total = rows_.capacity() * sizeof(PackedRow) + scratch_.capacity() * sizeof(Decision);
+		for (const PackedRow& row : rows_) {
+			total += row.words.capacity() * sizeof(std::uint64_t);
+		}
+		return total;
+	}
+
+	std::size_t PackedDecisionStore::maxBytes(
+		const int numTenors,
+		const int numMonths,
+		const int numResultsRequested
+	) noexcept {
+		const auto entryBits = static_cast<std::size_t>(
+			std::bit_width(static_cast<unsigned int>(numTenors))
+			+ std::bit_width(static_cast<unsigned int>(std::max(numResultsRequested - 1, 0)))
+		);
+		// As in commitRow(), plus the word of padding:
+		const std::size_t rowWords = (static_cast<std::size_t>(numResultsRequested) * entryBits + 63) / 64 + 1;
+		const std::size_t numRows = static_cast<std::size_t>(numMonths) + 1;
+		return numRows * (sizeof(PackedRow) + rowWords * sizeof(std::uint64_t))
+			+ static_cast<std::size_t>(numResultsRequested) * sizeof(Decision);
+	}
+
+	void PackedDecisionStore::commitRow() {
+		PackedRow& row = rows_[currentMonth_];
+		const auto scratchRow = std::span(scratch_).first(static_cast<std::size_t>(scratchCount_));
+
+		const int maxPrevRank = scratchRow.empty() ? 0 : std::ranges::max(scratchRow, {}, &Decision::prevRank).prevRank;
+		row.rankBits = static_cast<unsigned int>(std::bit_width(static_cast<unsigned int>(maxPrevRank)));
+		row.count = scratchCount_;
+
+		const unsigned int entryBits = tenorBits_ + row.rankBits;
+		// Plus one word of padding, see get().
+		const std::size_t numWords = (static_cast<std::size_t>(scratchCount_) * entryBits + 63) / 64 + 1;
+		// Assigning keeps the row's allocation, which a reused store's row will usually already have large enough.
+		row.words.assign(numWords, 0);
+
+		std::size_t bitPos = 0;
+		for (const auto& [tenorCode, prevRank] : scratchRow) {
+			const std::uint64_t bits =
+				static_cast<std::uint64_t>(tenorCode) | (static_cast<std::uint64_t>(prevRank) << tenorBits_);
+			const std::size_t wordPos = bitPos / 64;
+			const unsigned int shift = bitPos % 64;
+			row.words[wordPos] |= bits << shift;
+			if (shift + entryBits > 64) {
+				row.words[wordPos + 1] |= bits >> (64 - shift);
+			}
+			bitPos += entryBits;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "app/optimiser/DeviceKernel.hpp"
+
+#include <cuda_runtime.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace DynamicOptimiser::Detail::Device
+{
+	namespace Kernel
+	{
+		constexpr unsigned int threadsPerBlock = 128;
+
+		/// Throws std::runtime_error if a CUDA call failed.
+		static void check(const cudaError_t error) {
+			if (error != cudaSuccess) {
+				throw std::runtime_error(std::string("CUDA: ") + cudaGetErrorString(error));
+			}
+		}
+
+		/// An array in device memory, freed when destroyed.
+		template <typename T>
+		class DeviceArray
+		{
+			public:
+				explicit DeviceArray(const std::size_t size) : size_(size) {
+					check(cudaMalloc(&data_, size * sizeof(T)));
+				}
+
+				~DeviceArray() {
+					cudaFree(data_);
+				}
+
+				DeviceArray(const DeviceArray&) = delete;
+				DeviceArray& operator=(const DeviceArray&) = delete;
+
+				[[nodiscard]] T* data() const noexcept { return data_; }
+
+				void copyFrom(const T* const host) {
+					check(cudaMemcpy(data_, host, size_ * sizeof(T), cudaMemcpyHostToDevice));
+				}
+
+				/// Copies back to the host, waiting for the kernels before (and so reporting their errors).
+				void copyTo(T* const host) const {
+					check(cudaMemcpy(host, data_, size_ * sizeof(T), cudaMemcpyDeviceToHost));
+				}
+
+			private:
+				T* data_ = nullptr;
+				std::size_t size_;
+		};
+
+		/// Combines a CRF with a factor, as the CRF policy does (see "include/app/optimiser/KWayMerge.hpp").
+		template <bool LogSpace>
+		__device__ double combine(const double prevCRF, const double factor) {
+			return LogSpace ? prevCRF + factor : prevCRF * factor;
+		}
+
+		/// Whether a product of CRFs has overflowed, as ProductCRFs::apply checks (log space never does).
+		template <bool LogSpace>
+		__device__ bool overflows(const double CRF) {
+			return !LogSpace && (CRF == HUGE_VAL || CRF == -HUGE_VAL);
+		}
+
+		/**
+		* Runs the scenario of each thread over every month, holding its window of recent months' CRFs, enough for the
+		* longest tenor, in window as [(month % windowMonths * numResults + rank) * numScenarios + scenario]. Each
+		* month's sources are waiting then each tenor short enough, as for the CPU, and a source's index is its tenor
+		* code. The heads and ranks are only ever indexed by unrolled loops, so stay in registers.
+		*/
+		template <bool LogSpace>
+		__global__ void runScenarios(const Chunk chunk, double* const window, const int windowMonths) {
+			const std::size_t scenario = static_cast<std::size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+			if (scenario >= chunk.numScenarios) {
+				return;
+			}
+			const std::size_t numScenarios = chunk.numScenarios;
+			const int numResults = chunk.numResults;
+			// -inf marks a rank not reached, as on the CPU.
+			constexpr double unreached = -HUGE_VAL;
+			const double initialCRF = LogSpace ? 0.0 : 1.0;
+
+			// Month 0 is only reached by the empty path:
+			window[scenario] = initialCRF;
+			for (int rank = 1; rank < numResults; ++rank) {
+				window[static_cast<std::size_t>(rank) * numScenarios + scenario] = unreached;
+			}
+
+			double heads[maxSources];
+			int ranks[maxSources];
+			// Each source's row of the window, and the factor it applies to every CRF there:
+			std::size_t prevRows[maxSources];
+			double factors[maxSources];
+
+			for (int month = 1; month <= chunk.numMonths; ++month) {
+				const std::size_t row = static_cast<std::size_t>(month % windowMonths * numResults);
+				int numSources = 1;
+				while (numSources <= chunk.numTenors && chunk.tenors[numSources - 1] <= month) {
+					++numSources;
+				}
+
+				bool overflowed = false;
+				#pragma unroll
+				for (int source = 0; source < maxSources; ++source) {
+					heads[source] = unreached;
+					ranks[source] = 0;
+					prevRows[source] = 0;
+					factors[source] = initialCRF;
+					if (source < numSources) {
+						// Waiting applies the factor of a 0% return, the identity.
+						const int prevMonth = source == 0 ? month - 1 : month - chunk.tenors[source - 1];
+						prevRows[source] = static_cast<std::size_t>(prevMonth % windowMonths * numResults);
+						if (source > 0) {
+							factors[source] = chunk.factors[
+								(static_cast<std::size_t>(month) * chunk.numTenors + source - 1) * numScenarios
+								+ scenario
+							];
+						}
+						// Every month is reached by waiting, so a predecessor's best is never -inf:
+						const double prevBestCRF = window[prevRows[source] * numScenarios + scenario];
+						heads[source] = combine<LogSpace>(prevBestCRF, factors[source]);
+						overflowed = overflowed || overflows<LogSpace>(heads[source]);
+					}
+				}
+				if (overflowed) {
+					chunk.overflowed[scenario] = 1;
+					return;
+				}
+
+				// The FixedEngine's merge: each result is the first greatest head, then its source's next candidate
+				// takes its place.
+				int numFound = 0;
+				while (numFound < numResults) {
+					double winnerCRF = heads[0];
+					int winner = 0;
+					int winnerRank = ranks[0];
+					#pragma unroll
+					for (int source = 1; source < maxSources; ++source) {
+						if (heads[source] > winnerCRF) {
+							winnerCRF = heads[source];
+							winner = source;
+							winnerRank = ranks[source];
+						}
+					}
+					if (winnerCRF == unreached) {
+						break;
+					}
+					window[(row + numFound) * numScenarios + scenario] = winnerCRF;
+					chunk.decisions[
+						(static_cast<std::size_t>(month) * numResults + numFound) * numScenarios + scenario
+					] = {winner, winnerRank};
+					++numFound;
+
+					const int nextRank = winnerRank + 1;
+					#pragma unroll
+					for (int source = 0; source < maxSources; ++source) {
+						if (source == winner) {
+							ranks[source] = nextRank;
+							heads[source] = unreached;
+							if (nextRank < numResults) {
+								const double prevCRF = window[(prevRows[source] + nextRank) * numScenarios + scenario];
+								if (prevCRF != unreached) {
+									heads[source] = combine<LogSpace>(prevCRF, factors[source]);
+									overflowed = overflows<LogSpace>(heads[source]);
+								}
+							}
+						}
+					}
+					if (overflowed) {
+						chunk.overflowed[scenario] = 1;
+						return;
+					}
+				}
+				// Ranks not reached are -inf, since the window's rows are reused:
+				for (int rank = numFound; rank < numResults; ++rank) {
+					window[(row + rank) * numScenarios + scenario] = unreached;
+				}
+			}
+
+			const std::size_t finalRow = static_cast<std::size_t>(chunk.numMonths % windowMonths * numResults);
+			for (int rank = 0; rank < numResults; ++rank) {
+				chunk.finalCRFs[static_cast<std::size_t>(rank) * numScenarios + scenario] =
+					window[(finalRow + rank) * numScenarios + scenario];
+			}
+			chunk.overflowed[scenario] = 0;
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	bool available() noexcept {
+		// Without a driver, looking for devices fails rather than finding none, but either way there is none to use:
+		static const bool found = [] {
+			int numDevices = 0;
+			return cudaGetDeviceCount(&numDevices) == cudaSuccess && numDevices > 0;
+		}();
+		return found;
+	}
+
+	void run(const Chunk& chunk) {
+		const std::size_t numScenarios = chunk.numScenarios;
+		const auto numResults = static_cast<std::size_t>(chunk.numResults);
+		const auto numTenors = static_cast<std::size_t>(chunk.numTenors);
+		const auto numRows = static_cast<std::size_t>(chunk.numMonths) + 1;
+		// A month reads back at most the longest tenor (or to month 0), so the window holds that many months before:
+		const int windowMonths = std::min(chunk.tenors[chunk.numTenors - 1], chunk.numMonths) + 1;
+
+		Kernel::DeviceArray<int> tenors(numTenors);
+		Kernel::DeviceArray<double> factors(numRows * numTenors * numScenarios);
+		Kernel::DeviceArray<double> window(static_cast<std::size_t>(windowMonths) * numResults * numScenarios);
+		Kernel::DeviceArray<double> finalCRFs(numResults * numScenarios);
+		Kernel::DeviceArray<Decision> decisions(numRows * numResults * numScenarios);
+		Kernel::DeviceArray<std::uint8_t> overflowed(numScenarios);
+		tenors.copyFrom(chunk.tenors);
+		factors.copyFrom(chunk.factors);
+
+		Chunk deviceChunk = chunk;
+		deviceChunk.tenors = tenors.data();
+		deviceChunk.factors = factors.data();
+		deviceChunk.finalCRFs = finalCRFs.data();
+		deviceChunk.decisions = decisions.data();
+		deviceChunk.overflowed = overflowed.data();
+
+		const auto numBlocks = static_cast<unsigned int>(
+			(numScenarios + Kernel::threadsPerBlock - 1) / Kernel::threadsPerBlock
+		);
+		if (chunk.logSpace) {
+			Kernel::runScenarios<true><<<numBlocks, Kernel::threadsPerBlock>>>(
+				deviceChunk, window.data(), windowMonths
+			);
+		}
+		else {
+			Kernel::runScenarios<false><<<numBlocks, Kernel::threadsPerBlock>>>(
+				deviceChunk, window.data(), windowMonths
+			);
+		}
+		Kernel::check(cudaGetLastError());
+
+		finalCRFs.copyTo(chunk.finalCRFs);
+		decisions.copyTo(chunk.decisions);
+		overflowed.copyTo(chunk.overflowed);
+	}
+}
\ No newline at end of file
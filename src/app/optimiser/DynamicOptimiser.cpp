@@ -2,16 +2,34 @@
 
 #include "app/domain/BondReturnData.hpp"
 #include "app/domain/InvestmentAction.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/DeviceKernel.hpp"
+#include "app/optimiser/ForwardPass.hpp"
+#include "app/optimiser/KWayMerge.hpp"
+#include "app/optimiser/PathReconstruction.hpp"
+#include "app/optimiser/ResultDAG.hpp"
+#include "helpers/Parallel.hpp"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <format>
+#include <functional>
+#include <future>
 #include <limits>
 #include <mdspan>
-#include <queue>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -19,127 +37,579 @@ namespace DynamicOptimiser
 {
     namespace Detail
     {
-        using DecisionsList = std::vector<std::vector<Domain::InvestmentAction>>;
-        // Type for the decisions mdspan:
-        using DecisionsSpan =
-            std::mdspan<int, std::extents<std::size_t, std::dynamic_extent, std::dynamic_extent, 2>>;
+        /// The buffers a Workspace holds between runs.
+        struct WorkspaceBuffers
+        {
+            explicit WorkspaceBuffers(std::pmr::memory_resource* const memoryResource) :
+                resource(memoryResource),
+                CRFs(memoryResource),
+                wideDecisions(0, 0, 0, memoryResource),
+                packedDecisions(0, 0, 0, memoryResource)
+            {}
+
+            std::pmr::memory_resource* resource;
+            std::pmr::vector<double> CRFs;
+            WideDecisionStore wideDecisions;
+            PackedDecisionStore packedDecisions;
+            std::vector<PathReconstruction::PathCollector::Stage> pathStages{};
+        };
+
+        WorkspaceBuffers& buffersOf(Workspace& workspace) noexcept {
+            return *workspace.buffers_;
+        }
+
+        /// Calls run(mergeEngine, decisions) with the merge engine selected, and whichever decision layout suits the
+        /// number of rows to be held at once and the number of results run. The store is the workspace's, reset for
+        /// the run, so that a store large enough from an earlier run is reused rather than reallocated.
+        template <typename Run>
+        static void withEngineAndStore(
+            const OptimiserOptions& options,
+            const int numTenors,
+            const int numRows,
+            const int numResultsRun,
+            WorkspaceBuffers& buffers,
+            Run&& run
+        ) {
+            const auto withStore = [&](auto& mergeEngine) {
+                if (
+                    resolveDecisionLayout(options.decisionLayout, numTenors, numRows, numResultsRun)
+                    == DecisionLayout::Packed
+                ) {
+                    buffers.packedDecisions.reset(numTenors, numRows, numResultsRun);
+                    run(mergeEngine, buffers.packedDecisions);
+                }
+                else {
+                    buffers.wideDecisions.reset(numTenors, numRows, numResultsRun);
+                    run(mergeEngine, buffers.wideDecisions);
+                }
+            };
+            ForwardPass::withMergeEngine(options.mergeEngine, options.logSpace, numTenors, numResultsRun, withStore);
+        }
 
-        namespace Overflow
+        namespace ForwardPass
         {
-            static void throwCRFOverflow(const double value, const int month) {
-                if (!std::signbit(value)) {
-                    throw std::overflow_error(
-                        std::format(
-                            "return exceeding finite limit ({:.3e}) possible by month {}",
-                            std::numeric_limits<double>::max(),
-                            month
-                        )
-                    );
+            void assertLogSpaceValid(
+                const Domain::BondReturnData& tenorData,
+                const int firstMonth,
+                const int lastMonth
+            ) {
+                const auto& tenorList = tenorData.tenors();
+                for (int i = 0; i < tenorData.numTenors(); ++i) {
+                    // Bonds of this tenor bought in these months end within [firstMonth, lastMonth]:
+                    const int firstBuyMonth = std::max(firstMonth - tenorList[i], 0);
+                    for (int month = firstBuyMonth; month + tenorList[i] <= lastMonth; ++month) {
+                        if (1.0 + tenorData(i, month) <= 0.0) {
+                            throw std::domain_error(
+                                std::format(
+                                    "log-space returns need every bond return above -100%, "
+                                    "but the {}-month bond at month {} returns {:.2f}%",
+                                    tenorList[i],
+                                    month,
+                                    100 * tenorData(i, month)
+                                )
+                            );
+                        }
+                    }
                 }
-                throw std::overflow_error(
-                    std::format(
-                        "return below finite limit ({:.3e}) possible by month {}",
-                        std::numeric_limits<double>::lowest(),
-                        month
-                    )
-                );
+            }
+
+            DistinctPurchases::DistinctPurchases(
+                const std::vector<int>& tenorList,
+                const std::size_t window,
+                const int numResultsRequested
+            ) :
+                tenorList_(tenorList),
+                window_(static_cast<int>(window)),
+                // Month 0's only result buys nothing, so has the signature of an empty path, 0.
+                signaturesBuffer_(window * static_cast<std::size_t>(numResultsRequested), 0),
+                signatures_(signaturesBuffer_.data(), window, static_cast<std::size_t>(numResultsRequested))
+            {}
+
+            void DistinctPurchases::SignatureSet::clear() noexcept {
+                size_ = 0;
+                // Slots from every earlier generation are then empty, unless the generation wraps around:
+                if (++generation_ == 0) {
+                    std::ranges::fill(slots_, Slot{});
+                    generation_ = 1;
+                }
+            }
+
+            bool DistinctPurchases::SignatureSet::insert(const std::uint64_t signature) {
+                // Kept at most half full, so probes stay short:
+                if (2 * (size_ + 1) > slots_.size()) {
+                    std::vector<Slot> live{};
+                    live.reserve(size_);
+                    for (const Slot& slot : slots_) {
+                        if (slot.generation == generation_) {
+                            live.push_back(slot);
+                        }
+                    }
+                    slots_.assign(std::bit_ceil(std::max<std::size_t>(16, 4 * (size_ + 1))), Slot{});
+                    size_ = 0;
+                    for (const Slot& slot : live) {
+                        insert(slot.signature);
+                    }
+                }
+
+                // Signatures are well mixed in their high bits, which pick the slot:
+                const std::size_t mask = slots_.size() - 1;
+                std::size_t i = static_cast<std::size_t>((signature * 0xC2B2AE3D27D4EB4FULL) >> 32) & mask;
+                while (slots_[i].generation == generation_) {
+                    if (slots_[i].signature == signature) {
+                        return false;
+                    }
+                    i = (i + 1) & mask;
+                }
+                slots_[i] = {signature, generation_};
+                ++size_;
+                return true;
             }
         }
 
-        namespace PriorityQueue
+
+        namespace Checkpointing
         {
-            /// Stores the necessary data for each priority queue element in the k-way merge.
-            struct Candidate
-            {
-                double CRF{}; // candidate cumulative return factor at current month
-                int tenor{}; // 0 = wait, > 0 = buy tenor
-                int prevRank{}; // rank in predecessor row
+            /**
+            * Runs the optimiser keeping decisions for only one segment of months at a time, rather than every month.
+            *
+            * The first pass runs every month discarding decisions, but saves a snapshot of the CRFs window at the start
+            * of each segment. Paths are then reconstructed segment by segment from the last: the segment's snapshot is
+            * restored and its months re-run to recover their decisions, and every result's walker steps back through
+            * them to the segment's start. Resuming from a checkpoint needs the whole window of earlier months, so a
+            * snapshot costs window rows, and segments of sqrt(numMonths * window) months balance the snapshots against
+            * the segment's decisions. This takes about twice as long as keeping every month's decisions.
+            */
+            template <typename MergeEngine, typename DecisionStore>
+            static void runAndReconstruct(
+                const Domain::BondReturnData& tenorData,
+                const int numResultsRequested,
+                const CRFsSpan& CRFs,
+                const int segmentLength,
+                MergeEngine& mergeEngine,
+                DecisionStore& segmentDecisions,
+                OptimalResults& results,
+                std::vector<PathReconstruction::PathCollector::Stage>& pathStages
+            ) {
+                const int numMonths = tenorData.numMonths();
+                const std::size_t numResultsU = static_cast<std::size_t>(numResultsRequested);
+                const std::size_t windowSize = CRFs.extent(0) * numResultsU;
+                // Segment j covers months (j * segmentLength, (j + 1) * segmentLength], clamped to numMonths.
+                const int numSegments = (numMonths + segmentLength - 1) / segmentLength;
+                const std::span windowContents(CRFs.data_handle(), windowSize);
 
-                // These are not strictly necessary, but are present to avoid unnecessary recomputation and branching:
-                int prevMonth{}; // month of predecessor
-                double factor{}; // return factor of predecessor
-            };
+                // First pass, saving the window at the start of each segment:
+                std::vector<double> snapshots(static_cast<std::size_t>(numSegments) * windowSize);
+                Instrumentation::recordCRFsBytes((snapshots.size() + windowSize) * sizeof(double));
+                ForwardPass::DiscardedDecisions discarded{};
+                ForwardPass::seedBaseCase<typename MergeEngine::Policy>(CRFs);
+                for (int segment = 0; segment < numSegments; ++segment) {
+                    const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+                    const int segmentStart = segment * segmentLength;
+                    std::ranges::copy(
+                        windowContents, snapshots.begin() + static_cast<std::ptrdiff_t>(segment * windowSize)
+                    );
+                    ForwardPass::runMonths(
+                        tenorData,
+                        numResultsRequested,
+                        CRFs,
+                        segmentStart + 1,
+                        std::min(segmentStart + segmentLength, numMonths),
+                        mergeEngine,
+                        discarded,
+                        0
+                    );
+                }
 
-            constexpr auto compareCandidates = [](const Candidate& a, const Candidate& b) {
-                return a.CRF < b.CRF;
-            };
+                // The final row must be read before the window is overwritten by re-running segments:
+                const std::size_t finalRow = static_cast<std::size_t>(numMonths) % CRFs.extent(0);
+                results.CRFs.clear();
+                for (std::size_t i = 0; i < numResultsU; ++i) {
+                    if (CRFs[finalRow, i] == -std::numeric_limits<double>::infinity()) {
+                        break;
+                    }
+                    results.CRFs.push_back(CRFs[finalRow, i]);
+                }
+                const int numResultsFound = static_cast<int>(results.CRFs.size());
+
+                std::vector<PathReconstruction::PathWalker> walkers{};
+                walkers.reserve(numResultsFound);
+                for (int rank = 0; rank < numResultsFound; ++rank) {
+                    walkers.emplace_back(numMonths, rank);
+                }
+                PathReconstruction::PathCollector collector(numResultsFound, pathStages);
 
-            using CandidateQueue =
-                std::priority_queue<Candidate, std::vector<Candidate>, decltype(compareCandidates)>;
+                // Second pass, re-running each segment from its snapshot and walking back through it:
+                const auto& tenorList = tenorData.tenors();
+                for (int segment = numSegments - 1; segment >= 0; --segment) {
+                    const int segmentStart = segment * segmentLength;
+                    const auto snapshot = std::span(snapshots).subspan(segment * windowSize, windowSize);
+                    std::ranges::copy(snapshot, windowContents.begin());
+                    {
+                        const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+                        ForwardPass::runMonths(
+                            tenorData,
+                            numResultsRequested,
+                            CRFs,
+                            segmentStart + 1,
+                            std::min(segmentStart + segmentLength, numMonths),
+                            mergeEngine,
+                            segmentDecisions,
+                            segmentStart + 1
+                        );
+                    }
+                    if constexpr (Instrumentation::enabled) {
+                        Instrumentation::recordDecisionsBytes(segmentDecisions.bytes());
+                    }
+                    const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+                    collector.walkStage([&](const int rank, std::vector<Domain::InvestmentAction>& buffer) {
+                        walkers[rank].walkBackTo(segmentStart, segmentDecisions, segmentStart + 1, tenorList, buffer);
+                        if (segment == 0) {
+                            walkers[rank].finish(buffer);
+                        }
+                    });
+                }
+                const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+                collector.assemble(results);
+            }
         }
 
-        namespace PathReconstruction
+        namespace Scenarios
         {
-            /// Reconstructs the paths of optimal investment decisions made by getOptimalSequences.
-            [[nodiscard]] static DecisionsList reconstructPaths(
-                const DecisionsSpan& decisions,
-                const int numMonths,
-                const int numResultsFound
+            // Scenarios finding only their best result are run together in blocks of this many, few enough that a
+            // block's window of CRFs stays in cache, but enough for the loops across the block to vectorise well.
+            constexpr std::size_t lanesPerBlock = 64;
+
+            /// Rethrows the exception being handled, prefixed with the scenario it came from if it is an
+            /// overflow_error or domain_error (which report a problem with the scenario's returns).
+            [[noreturn]] static void rethrowForScenario(const std::size_t scenario) {
+                try {
+                    throw;
+                }
+                catch (const std::overflow_error& e) {
+                    throw std::overflow_error(std::format("scenario {}: {}", scenario, e.what()));
+                }
+                catch (const std::domain_error& e) {
+                    throw std::domain_error(std::format("scenario {}: {}", scenario, e.what()));
+                }
+            }
+
+            /**
+            * Recovers the decisions of one scenario in a block from its best CRF at every month, for walking its path.
+            * The decision at a month is the first source (waiting, then by increasing tenor) whose candidate equals
+            * the month's CRF, since only a strictly greater candidate replaces the best, and recomputing a candidate
+            * repeats the same arithmetic exactly. With only the best result kept, the previous rank is always 0.
+            */
+            template <typename CRFPolicy>
+            struct LaneDecisions
+            {
+                const Domain::BondReturnData& scenario;
+                const double* history{}; // best CRFs, indexed as [month * numLanes + lane]
+                std::size_t numLanes{};
+                std::size_t lane{};
+
+                [[nodiscard]] double CRFAt(const int month) const noexcept {
+                    return history[static_cast<std::size_t>(month) * numLanes + lane];
+                }
+
+                [[nodiscard]] Decision get(const int month, int) const noexcept {
+                    const double CRF = CRFAt(month);
+                    // 0 is wait sentinel.
+                    if (CRFPolicy::combine(CRFAt(month - 1), CRFPolicy::factor(0.0)) == CRF) {
+                        return {0, 0};
+                    }
+                    const auto& tenorList = scenario.tenors();
+                    for (int i = 0; i < scenario.numTenors() && tenorList[i] <= month; ++i) {
+                        const int prevMonth = month - tenorList[i];
+                        if (CRFPolicy::combine(CRFAt(prevMonth), CRFPolicy::factor(scenario(i, prevMonth))) == CRF) {
+                            return {i + 1, 0};
+                        }
+                    }
+                    // Unreachable, since the month's CRF came from one of its sources.
+                    return {0, 0};
+                }
+            };
+
+            /**
+            * Finds the best result for each scenario in a block (every scenario being a "lane") into blockResults.
+            * Every month's CRFs are stored lane-minor, so that each source is combined with the whole block in one
+            * contiguous, branchless loop taking the maximum, which the compiler vectorises. No decisions are recorded
+            * in the loop, leaving it free to vectorise, but every month's CRFs are kept instead of a window, from
+            * which LaneDecisions recovers the decisions along each path.
+            */
+            template <typename CRFPolicy>
+            static void runBestOfBlock(
+                const std::span<const Domain::BondReturnData> block,
+                const std::size_t firstScenario,
+                const std::span<OptimalResults> blockResults
             ) {
-                DecisionsList pathsList{};
-                pathsList.reserve(numResultsFound);
+                const auto& tenorList = block.front().tenors();
+                const int numTenors = block.front().numTenors();
+                const int numMonths = block.front().numMonths();
+                const std::size_t numLanes = block.size();
 
-                for (int currentRank = 0; currentRank < numResultsFound; ++currentRank) {
-                    // If this rank wasn't produced, stop:
-                    if (decisions[numMonths, currentRank, 0] == -1) {
-                        break;
+                const std::size_t historySize = (static_cast<std::size_t>(numMonths) + 1) * numLanes;
+                std::vector<double> history(historySize, CRFPolicy::initialCRF);
+                // The lowest candidate for each lane this month, since only the highest is kept in the history, but
+                // either may overflow.
+                std::vector<double> lowestCRFs(numLanes);
+                std::vector<double> factors(numLanes);
+                const auto rowCRFs = [&](const int month) {
+                    return history.data() + static_cast<std::size_t>(month) * numLanes;
+                };
+                const double waitFactor = CRFPolicy::factor(0.0);
+
+                for (int currentMonth = 1; currentMonth <= numMonths; ++currentMonth) {
+                    double* const currentCRFs = rowCRFs(currentMonth);
+
+                    // Waiting never changes the CRF, so cannot overflow:
+                    const double* const waitCRFs = rowCRFs(currentMonth - 1);
+                    for (std::size_t lane = 0; lane < numLanes; ++lane) {
+                        currentCRFs[lane] = CRFPolicy::combine(waitCRFs[lane], waitFactor);
+                        lowestCRFs[lane] = currentCRFs[lane];
                     }
 
-                    std::vector<Domain::InvestmentAction> currentPath{};
-                    int currentMonth = numMonths;
-                    int prevRank = currentRank;
-                    // Rather than add multiple 1-month waits, we keep track of contiguous waits and add this period
-                    // as a single InvestmentAction.
-                    int waitStreak = 0;
-
-                    while (currentMonth > 0) {
-                        const int tenorToReachMonth = decisions[currentMonth, prevRank, 0];
-                        prevRank = decisions[currentMonth, prevRank, 1];
-                        // 0 is wait sentinel.
-                        if (tenorToReachMonth == 0) {
-                            // Wait 1 month:
-                            ++waitStreak;
-                            --currentMonth;
+                    // Tenors are sorted, so none after the first too long to end at this month can either:
+                    for (int i = 0; i < numTenors && tenorList[i] <= currentMonth; ++i) {
+                        const int prevMonth = currentMonth - tenorList[i];
+                        // Gathering the factors across scenarios is the only strided access:
+                        for (std::size_t lane = 0; lane < numLanes; ++lane) {
+                            factors[lane] = CRFPolicy::factor(block[lane](i, prevMonth));
                         }
-                        else {
-                            // Period of waiting has ended, so must add this to decision list:
-                            if (waitStreak > 0) {
-                                currentPath.emplace_back(
-                                    Domain::InvestmentAction::Action::Wait,
-                                    currentMonth,
-                                    waitStreak
-                                );
-                                waitStreak = 0;
+                        const double* const prevCRFs = rowCRFs(prevMonth);
+                        for (std::size_t lane = 0; lane < numLanes; ++lane) {
+                            const double candidate = CRFPolicy::combine(prevCRFs[lane], factors[lane]);
+                            currentCRFs[lane] = candidate > currentCRFs[lane] ? candidate : currentCRFs[lane];
+                            if constexpr (CRFPolicy::canOverflow) {
+                                lowestCRFs[lane] = candidate < lowestCRFs[lane] ? candidate : lowestCRFs[lane];
                             }
-                            // Buy tenor starting from current month:
-                            currentMonth -= tenorToReachMonth;
-                            currentPath.emplace_back(
-                                Domain::InvestmentAction::Action::Buy,
-                                currentMonth,
-                                tenorToReachMonth
-                            );
                         }
                     }
-                    // If we the path finished with waiting, we need to add this to the decision list too:
-                    if (waitStreak > 0) {
-                        currentPath.emplace_back(
-                            Domain::InvestmentAction::Action::Wait,
-                            0,
-                            waitStreak
-                        );
+
+                    if constexpr (CRFPolicy::canOverflow) {
+                        for (std::size_t lane = 0; lane < numLanes; ++lane) {
+                            if (std::isinf(currentCRFs[lane]) || std::isinf(lowestCRFs[lane])) {
+                                try {
+                                    Merge::throwCRFOverflow(
+                                        std::isinf(currentCRFs[lane]) ? currentCRFs[lane] : lowestCRFs[lane],
+                                        currentMonth
+                                    );
+                                }
+                                catch (...) {
+                                    rethrowForScenario(firstScenario + lane);
+                                }
+                            }
+                        }
                     }
-                    // Path was constructed in reverse to avoid using .insert() and constantly shuffling memory.
-                    std::ranges::reverse(currentPath);
-                    pathsList.push_back(std::move(currentPath));
                 }
-                return pathsList;
+
+                for (std::size_t lane = 0; lane < numLanes; ++lane) {
+                    OptimalResults& results = blockResults[lane];
+                    results.actions.clear();
+                    const LaneDecisions<CRFPolicy> decisions{block[lane], history.data(), numLanes, lane};
+                    PathReconstruction::PathWalker walker(numMonths, 0);
+                    walker.walkBackTo(0, decisions, 0, tenorList, results.actions);
+                    walker.finish(results.actions);
+                    std::ranges::reverse(results.actions);
+                    results.pathOffsets.assign({0, results.actions.size()});
+                    results.CRFs.assign(1, decisions.CRFAt(numMonths));
+                }
+            }
+
+            #if BSO_CUDA
+                /// Reads one scenario's decisions from a chunk run on the device, interleaved across its scenarios.
+                struct DeviceDecisions
+                {
+                    const Device::Decision* decisions{};
+                    std::size_t numScenarios{};
+                    std::size_t numResults{};
+                    std::size_t scenario{};
+
+                    [[nodiscard]] Decision get(const int month, const int rank) const noexcept {
+                        const Device::Decision decision = decisions[
+                            (static_cast<std::size_t>(month) * numResults + static_cast<std::size_t>(rank))
+                            * numScenarios + scenario
+                        ];
+                        return {decision.tenorCode, decision.prevRank};
+                    }
+                };
+
+                /**
+                * Runs a chunk of scenarios on the CUDA device (see "include/app/optimiser/DeviceKernel.hpp"), giving
+                * exactly the results of the batch getOptimalSequences. The bonds' factors are found here, as the CPU
+                * finds them, and ordered by the month they mature, and the paths are walked here once the chunk's
+                * decisions are copied back. Returns nothing, for the chunk to be run on the CPU instead, if there is
+                * no device, or the chunk needs more results or tenors than the kernel holds, or distinct purchases.
+                * Likewise if any scenario has a return invalid in log space, or its CRFs overflow, so that the CPU
+                * reports which. Throws std::runtime_error if CUDA fails.
+                */
+                static std::optional<std::vector<OptimalResults>> runOnDevice(
+                    const std::vector<int>& tenors,
+                    const ScenarioReturns chunk,
+                    const int numResultsRequested,
+                    const OptimiserOptions& options
+                ) {
+                    const std::size_t numScenarios = chunk.extent(0);
+                    const std::size_t numTenors = tenors.size();
+                    const std::size_t numMonths = chunk.extent(2);
+                    if (
+                        !Device::available()
+                        || numResultsRequested < 1 || numResultsRequested > Device::maxResults
+                        || numTenors == 0 || numTenors + 1 > static_cast<std::size_t>(Device::maxSources)
+                        || chunk.extent(1) != numTenors || !std::ranges::is_sorted(tenors) || tenors.front() <= 0
+                        || numMonths == 0 || numMonths > static_cast<std::size_t>(std::numeric_limits<int>::max())
+                        || options.distinctPurchases
+                    ) {
+                        return std::nullopt;
+                    }
+
+                    const std::size_t gridSize = numTenors * numMonths;
+                    std::vector<double> factors((numMonths + 1) * numTenors * numScenarios);
+                    for (std::size_t s = 0; s < numScenarios; ++s) {
+                        const double* const grid = chunk.data_handle() + s * gridSize;
+                        for (std::size_t i = 0; i < numTenors; ++i) {
+                            const auto tenor = static_cast<std::size_t>(tenors[i]);
+                            for (std::size_t month = tenor; month <= numMonths; ++month) {
+                                const double bondReturn = grid[i * numMonths + month - tenor];
+                                if (options.logSpace && 1.0 + bondReturn <= 0.0) {
+                                    return std::nullopt;
+                                }
+                                factors[(month * numTenors + i) * numScenarios + s] = options.logSpace
+                                    ? Merge::LogCRFs::factor(bondReturn)
+                                    : Merge::ProductCRFs::factor(bondReturn);
+                            }
+                        }
+                    }
+
+                    const auto numResults = static_cast<std::size_t>(numResultsRequested);
+                    std::vector<double> finalCRFs(numResults * numScenarios);
+                    std::vector<Device::Decision> decisions((numMonths + 1) * numResults * numScenarios);
+                    std::vector<std::uint8_t> overflowed(numScenarios);
+                    Device::run({
+                        .numScenarios = numScenarios,
+                        .numMonths = static_cast<int>(numMonths),
+                        .tenors = tenors.data(),
+                        .numTenors = static_cast<int>(numTenors),
+                        .numResults = numResultsRequested,
+                        .logSpace = options.logSpace,
+                        .factors = factors.data(),
+                        .finalCRFs = finalCRFs.data(),
+                        .decisions = decisions.data(),
+                        .overflowed = overflowed.data()
+                    });
+                    if (std::ranges::contains(overflowed, std::uint8_t{1})) {
+                        return std::nullopt;
+                    }
+
+                    std::vector<OptimalResults> results(numScenarios);
+                    const auto walkScenarios = [&](const std::size_t begin, const std::size_t end) {
+                        for (std::size_t s = begin; s < end; ++s) {
+                            OptimalResults& scenarioResults = results[s];
+                            scenarioResults.logSpace = options.logSpace;
+                            for (std::size_t rank = 0; rank < numResults; ++rank) {
+                                const double CRF = finalCRFs[rank * numScenarios + s];
+                                if (CRF == -std::numeric_limits<double>::infinity()) {
+                                    break;
+                                }
+                                scenarioResults.CRFs.push_back(CRF);
+                            }
+                            PathReconstruction::reconstructPaths(
+                                DeviceDecisions{decisions.data(), numScenarios, numResults, s},
+                                tenors,
+                                static_cast<int>(numMonths),
+                                static_cast<int>(scenarioResults.size()),
+                                scenarioResults
+                            );
+                        }
+                    };
+                    Helpers::Parallel::forEachChunk(numScenarios, 1, walkScenarios);
+                    return results;
+                }
+            #endif
+
+            /// Runs a chunk of streamed scenarios on the CUDA device if the build has one and the chunk can run there
+            /// (see runOnDevice), and otherwise as the batch getOptimalSequences.
+            static std::vector<OptimalResults> runChunk(
+                const std::vector<int>& tenors,
+                const ScenarioReturns chunk,
+                const int numResultsRequested,
+                const OptimiserOptions& options
+            ) {
+                #if BSO_CUDA
+                    if (auto results = runOnDevice(tenors, chunk, numResultsRequested, options)) {
+                        return std::move(*results);
+                    }
+                #endif
+                return getOptimalSequences(tenors, chunk, numResultsRequested, options);
             }
         }
     }
 
     //----------------------------------------------------------------------------------------------------------------------
 
-    OptimalResults getOptimalSequences(const Domain::BondReturnData& tenorData, const int numResultsRequested) {
+    std::span<const Domain::InvestmentAction> OptimalResults::path(const std::size_t i) const noexcept {
+        return std::span(actions).subspan(pathOffsets[i], pathOffsets[i + 1] - pathOffsets[i]);
+    }
+
+    void OptimalResults::clear() noexcept {
+        CRFs.clear();
+        actions.clear();
+        pathOffsets.clear();
+        logSpace = false;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+
+    Workspace::Workspace(std::pmr::memory_resource* const resource) :
+        buffers_(std::make_unique<Detail::WorkspaceBuffers>(resource))
+    {}
+
+    Workspace::~Workspace() = default;
+    Workspace::Workspace(Workspace&&) noexcept = default;
+    Workspace& Workspace::operator=(Workspace&&) noexcept = default;
+
+    std::size_t Workspace::bytes() const noexcept {
+        if (!buffers_) {
+            return 0;
+        }
+        const Detail::WorkspaceBuffers& buffers = *buffers_;
+        std::size_t total = buffers.CRFs.capacity() * sizeof(double)
+            + buffers.wideDecisions.bytes()
+            + buffers.packedDecisions.bytes();
+        for (const auto& stage : buffers.pathStages) {
+            for (const auto& chunk : stage.chunkActions) {
+                total += chunk.capacity() * sizeof(Domain::InvestmentAction);
+            }
+            total += stage.counts.capacity() * sizeof(std::size_t);
+        }
+        return total;
+    }
+
+    void Workspace::release() {
+        buffers_ = std::make_unique<Detail::WorkspaceBuffers>(buffers_->resource);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+
+    OptimalResults getOptimalSequences(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        const OptimiserOptions& options
+    ) {
+        OptimalResults results{};
+        getOptimalSequences(tenorData, numResultsRequested, results, options);
+        return results;
+    }
+
+    /// Runs getOptimalSequences into results, or if sink is set, streams the results to it instead, using results
+    /// for each block (see streamOptimalSequences).
+    static void findOptimalSequences(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        OptimalResults& results,
+        Workspace& workspace,
+        const OptimiserOptions& options,
+        const ResultBlockSink* const sink
+    ) {
         const int numTenors = tenorData.numTenors();
         const int numMonths = tenorData.numMonths();
 
@@ -152,138 +622,565 @@ namespace DynamicOptimiser
 
         // numMonths and numTenors should always be > 0 with current input validation.
         if (numResultsRequested == 0 || numMonths == 0 || numTenors == 0) {
-            return {{}, {}};
+            results.clear();
+            return;
         }
 
-        // Stores the results once computed:
-        std::vector<double> finalCRFs{};
-        Detail::DecisionsList finalPaths{};
-
-        int numResultsFound{};
+        if (options.distinctPurchases && options.lowMemory) {
+            throw std::invalid_argument("Distinct purchases cannot be combined with low memory mode");
+        }
+        if (options.logSpace) {
+            Detail::ForwardPass::assertLogSpaceValid(tenorData, 1, numMonths);
+        }
+        results.logSpace = options.logSpace;
 
         // This works since tenors are sorted at construction.
         const int maxTenor = tenorList.back();
         // When calculating CRFs, we only need to look back as far as the length of the longest tenor
         // (+ 1 since we also need to store the current month), and so we can use a window to save memory.
-        // We can't do this with decisionsBuffer, since we need to reconstruct the full path later.
+        // We can't do this with the decisions, since we need to reconstruct the full path later
+        // (unless recomputing them from checkpoints with options.lowMemory).
         const std::size_t window = static_cast<std::size_t>(std::min(maxTenor, numMonths)) + 1;
-        // Since we are using a rolling window, we need to know the index of the true last month,
-        // we can't just use the last month in CRFsBuffer since it may have wrapped.
-        std::size_t finalRowPos{};
 
-        // Stores the requested number of maximal CRFs for each month, to be accessed as CRFs[month, rank].
+        Detail::WorkspaceBuffers& buffers = Detail::buffersOf(workspace);
+
+        const auto withEngineAndStore = [&](const int numRows, const int numResultsRun, auto&& run) {
+            Detail::withEngineAndStore(options, numTenors, numRows, numResultsRun, buffers, run);
+        };
+
+        // Stores the requested number of maximal CRFs for each month, to be accessed as CRFs[month % window, rank].
         // We use an mdspan over a flat, contiguous vector for speed.
-        std::vector CRFsBuffer(window * numResultsRequested, -std::numeric_limits<double>::infinity());
-        const std::mdspan CRFs(CRFsBuffer.data(), window, numResultsRequested);
+        auto& CRFsBuffer = buffers.CRFs;
+        CRFsBuffer.assign(window * numResultsRequested, -std::numeric_limits<double>::infinity());
+        const Detail::CRFsSpan CRFs(CRFsBuffer.data(), window, numResultsRequested);
+        Instrumentation::recordCRFsBytes(CRFsBuffer.size() * sizeof(double));
 
-        // We scope decisionsBuffer to ensure is destroyed via RAII as soon as possible, since it can be large.
-        {
-            // Stores the tenor chosen and the previous rank in the path so we can reconstruct the chain of purchases,
-            // the tenor is accessed as decisions[month, rank, 0], and the previous rank as decisions[month, rank, 1].
-            // 0 is a sentinel representing wait, since we don't need to purchase at any given month.
-            // We use an mdspan over a flat, contiguous vector for speed.
-            std::vector decisionsBuffer(
-                (static_cast<std::size_t>(numMonths) + 1) * static_cast<std::size_t>(numResultsRequested) * 2,
-                -1
+        if (options.lowMemory) {
+            const int segmentLength = std::clamp(
+                static_cast<int>(std::sqrt(static_cast<double>(numMonths) * static_cast<double>(window))), 1, numMonths
             );
-            const Detail::DecisionsSpan decisions(
-                decisionsBuffer.data(),
-                static_cast<std::size_t>(numMonths) + 1,
-                numResultsRequested,
-                2
-            );
-
-            // Base case:
-            CRFs[0, 0] = 1.0; // return at month 0 is 1
-            decisions[0, 0, 0] = 0; // seeded that we "waited" to reach month 0
+            withEngineAndStore(segmentLength, numResultsRequested, [&](auto& mergeEngine, auto& segmentDecisions) {
+                Detail::Checkpointing::runAndReconstruct(
+                    tenorData,
+                    numResultsRequested,
+                    CRFs,
+                    segmentLength,
+                    mergeEngine,
+                    segmentDecisions,
+                    results,
+                    buffers.pathStages
+                );
+            });
+            // Checkpointing walks every path a segment at a time, so they are only complete once all are:
+            if (sink && results.size() > 0) {
+                (*sink)(0, results);
+            }
+            return;
+        }
 
-            // Stores the index in the windowed CRFs span which corresponds to a given month.
-            // We do this rather than using % since testing suggested a modest performance gain.
-            std::vector<std::size_t> rowIndex(static_cast<std::size_t>(numMonths) + 1);
-            std::size_t windowCounter = 1;
+        // Runs every month keeping its decisions, holding only the results filter keeps, and reconstructs them.
+        const auto runAndReconstruct = [&](auto& filter) {
+            withEngineAndStore(numMonths, numResultsRequested, [&](auto& mergeEngine, auto& decisions) {
+                // Stores the tenor chosen and the previous rank in the path so we can reconstruct the chain of
+                // purchases.
+                Detail::ForwardPass::seedBaseCase<typename std::remove_cvref_t<decltype(mergeEngine)>::Policy>(CRFs);
+                decisions.beginRow(0);
+                decisions.push(0, 0); // seeded that we "waited" to reach month 0
+                decisions.commitRow();
+                {
+                    const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+                    Detail::ForwardPass::IgnoreRows ignoreRows{};
+                    Detail::ForwardPass::runMonths(
+                        tenorData,
+                        numResultsRequested,
+                        CRFs,
+                        1,
+                        numMonths,
+                        mergeEngine,
+                        decisions,
+                        0,
+                        ignoreRows,
+                        filter
+                    );
+                }
+                if constexpr (Instrumentation::enabled) {
+                    Instrumentation::recordDecisionsBytes(decisions.bytes());
+                }
 
-            for (int currentMonth = 1; currentMonth <= numMonths; ++currentMonth) {
-                rowIndex[currentMonth] = windowCounter;
-                if (++windowCounter == window) {
-                    windowCounter = 0;
+                const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+                const int numResultsFound = decisions.count(numMonths);
+                const std::size_t finalRowPos = static_cast<std::size_t>(numMonths) % window;
+                if (sink) {
+                    Detail::PathReconstruction::streamPaths(
+                        decisions,
+                        tenorList,
+                        numMonths,
+                        numResultsFound,
+                        [&](const int rank) -> double { return CRFs[finalRowPos, rank]; },
+                        results,
+                        *sink,
+                        buffers.pathStages
+                    );
+                    return;
                 }
+                Detail::PathReconstruction::reconstructPaths(
+                    decisions, tenorList, numMonths, numResultsFound, results, buffers.pathStages
+                );
 
-                // Reset the current months values, since they will be stale after the window first wraps:
-                for (int i = 0; i < numResultsRequested; ++i) {
-                    CRFs[rowIndex[currentMonth], i] = -std::numeric_limits<double>::infinity();
+                // Return last row of CRFs as a vector:
+                results.CRFs.clear();
+                results.CRFs.reserve(numResultsFound);
+                for (int i = 0; i < numResultsFound; ++i) {
+                    results.CRFs.push_back(CRFs[finalRowPos, i]);
                 }
+            });
+        };
+
+        // With a single result there is nothing to be a duplicate of.
+        if (options.distinctPurchases && numResultsRequested > 1) {
+            Detail::ForwardPass::DistinctPurchases distinctPurchases(tenorList, window, numResultsRequested);
+            runAndReconstruct(distinctPurchases);
+            return;
+        }
+        Detail::ForwardPass::AllResults allResults{};
+        runAndReconstruct(allResults);
+    }
+
+    void getOptimalSequences(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        OptimalResults& results,
+        const OptimiserOptions& options
+    ) {
+        Workspace workspace{};
+        findOptimalSequences(tenorData, numResultsRequested, results, workspace, options, nullptr);
+    }
+
+    void getOptimalSequences(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        OptimalResults& results,
+        Workspace& workspace,
+        const OptimiserOptions& options
+    ) {
+        findOptimalSequences(tenorData, numResultsRequested, results, workspace, options, nullptr);
+    }
+
+    std::size_t streamOptimalSequences(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        const ResultBlockSink& sink,
+        const OptimiserOptions& options
+    ) {
+        Workspace workspace{};
+        return streamOptimalSequences(tenorData, numResultsRequested, sink, workspace, options);
+    }
+
+    std::size_t streamOptimalSequences(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        const ResultBlockSink& sink,
+        Workspace& workspace,
+        const OptimiserOptions& options
+    ) {
+        std::size_t numResultsFound = 0;
+        const ResultBlockSink countingSink = [&](const std::size_t firstRank, const OptimalResults& block) {
+            sink(firstRank, block);
+            numResultsFound = firstRank + block.size();
+        };
+        OptimalResults block{};
+        findOptimalSequences(tenorData, numResultsRequested, block, workspace, options, &countingSink);
+        return numResultsFound;
+    }
+
+    std::vector<OptimalResults> getOptimalSequencesForAllHorizons(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        const OptimiserOptions& options
+    ) {
+        std::vector<OptimalResults> results{};
+        Workspace workspace{};
+        getOptimalSequencesForAllHorizons(tenorData, numResultsRequested, results, workspace, options);
+        return results;
+    }
+
+    void getOptimalSequencesForAllHorizons(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        std::vector<OptimalResults>& results,
+        Workspace& workspace,
+        const OptimiserOptions& options
+    ) {
+        const int numTenors = tenorData.numTenors();
+        const int numMonths = tenorData.numMonths();
+        const auto& tenorList = tenorData.tenors();
+
+        if (numResultsRequested < 0) {
+            throw std::invalid_argument("Cannot request a negative number of results");
+        }
+        if (options.lowMemory) {
+            throw std::invalid_argument(
+                "Results for every horizon need every month's decisions, so cannot be combined with low memory mode"
+            );
+        }
+
+        results.resize(static_cast<std::size_t>(numMonths));
+        for (OptimalResults& horizonResults : results) {
+            horizonResults.clear();
+            horizonResults.logSpace = options.logSpace;
+        }
+        if (numResultsRequested == 0 || numMonths == 0 || numTenors == 0) {
+            return;
+        }
+        if (options.logSpace) {
+            Detail::ForwardPass::assertLogSpaceValid(tenorData, 1, numMonths);
+        }
 
-                // Build a heap of list heads: waiting + each tenor that can end at the current month
-                Detail::PriorityQueue::CandidateQueue candidatePQ(Detail::PriorityQueue::compareCandidates);
+        // As for a single horizon, only a window of recent months' CRFs is needed to run the next month.
+        const std::size_t window = static_cast<std::size_t>(std::min(tenorList.back(), numMonths)) + 1;
+        Detail::WorkspaceBuffers& buffers = Detail::buffersOf(workspace);
+        auto& CRFsBuffer = buffers.CRFs;
+        CRFsBuffer.assign(window * numResultsRequested, -std::numeric_limits<double>::infinity());
+        const Detail::CRFsSpan CRFs(CRFsBuffer.data(), window, numResultsRequested);
+        Instrumentation::recordCRFsBytes(CRFsBuffer.size() * sizeof(double));
 
-                // Add the waiting head:
-                int prevMonth = currentMonth - 1;
-                candidatePQ.emplace(CRFs[rowIndex[prevMonth], 0], 0, 0, prevMonth, 1.0);
+        // The window overwrites each month's row a few months later, so each is copied out as its horizon's CRFs:
+        const auto keepRow = [&](const int month, const std::span<const double> row) {
+            results[static_cast<std::size_t>(month - 1)].CRFs.assign(row.begin(), row.end());
+        };
 
-                // Add the tenors heads:
-                for (int i = 0; i < numTenors; ++i) {
-                    const int currentTenor = tenorList[i];
-                    if (currentMonth < currentTenor) {
-                        continue;
+        const auto runAndReconstruct = [&](auto& filter) {
+            Detail::withEngineAndStore(
+                options, numTenors, numMonths, numResultsRequested, buffers, [&](auto& mergeEngine, auto& decisions) {
+                    Detail::ForwardPass::seedBaseCase<typename std::remove_cvref_t<decltype(mergeEngine)>::Policy>(
+                        CRFs
+                    );
+                    decisions.beginRow(0);
+                    decisions.push(0, 0); // seeded that we "waited" to reach month 0
+                    decisions.commitRow();
+                    {
+                        const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+                        Detail::ForwardPass::runMonths(
+                            tenorData,
+                            numResultsRequested,
+                            CRFs,
+                            1,
+                            numMonths,
+                            mergeEngine,
+                            decisions,
+                            0,
+                            keepRow,
+                            filter
+                        );
+                    }
+                    if constexpr (Instrumentation::enabled) {
+                        Instrumentation::recordDecisionsBytes(decisions.bytes());
                     }
-                    prevMonth = currentMonth - currentTenor;
-                    const double factor = 1.0 + tenorData(i, prevMonth);
-                    // Note: prevCRF will never be -inf here, since we allow waiting there will always be
-                    // at least one way to reach each month.
-                    const double prevCRF = CRFs[rowIndex[prevMonth], 0];
-                    const double nextCRF = prevCRF * factor;
-
-                    if (std::isinf(nextCRF)) {
-                        Detail::Overflow::throwCRFOverflow(nextCRF, currentMonth);
+
+                    // Every decision is kept, so a path can be walked back from any month as from the last:
+                    const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+                    for (int month = 1; month <= numMonths; ++month) {
+                        OptimalResults& horizonResults = results[static_cast<std::size_t>(month - 1)];
+                        Detail::PathReconstruction::reconstructPaths(
+                            decisions,
+                            tenorList,
+                            month,
+                            static_cast<int>(horizonResults.size()),
+                            horizonResults,
+                            buffers.pathStages
+                        );
                     }
-                    candidatePQ.emplace(nextCRF, currentTenor, 0, prevMonth, factor);
                 }
+            );
+        };
 
-                // Extract the number of maximal results requested for this month:
-                int numResults = 0;
-                while (numResults < numResultsRequested && !candidatePQ.empty()) {
-                    Detail::PriorityQueue::Candidate topCandidate = candidatePQ.top();
-                    candidatePQ.pop();
-
-                    CRFs[rowIndex[currentMonth], numResults] = topCandidate.CRF;
-                    decisions[currentMonth, numResults, 0] = topCandidate.tenor;
-                    decisions[currentMonth, numResults, 1] = topCandidate.prevRank;
-                    ++numResults;
-
-                    // Advance the list the current maximal head came from:
-                    if (const int nextRank = topCandidate.prevRank + 1; nextRank < numResultsRequested) {
-                        const double prevCRF = CRFs[rowIndex[topCandidate.prevMonth], nextRank];
-                        // Stop advancing if we reach the sentinel, no more results are available from that month.
-                        if (prevCRF != -std::numeric_limits<double>::infinity()) {
-                            const double nextCRF = prevCRF * topCandidate.factor;
-                            if (std::isinf(nextCRF)) {
-                                Detail::Overflow::throwCRFOverflow(nextCRF, currentMonth);
-                            }
-                            candidatePQ.emplace(
-                                nextCRF, topCandidate.tenor, nextRank, topCandidate.prevMonth, topCandidate.factor
-                            );
-                        }
+        // With a single result there is nothing to be a duplicate of.
+        if (options.distinctPurchases && numResultsRequested > 1) {
+            Detail::ForwardPass::DistinctPurchases distinctPurchases(tenorList, window, numResultsRequested);
+            runAndReconstruct(distinctPurchases);
+            return;
+        }
+        Detail::ForwardPass::AllResults allResults{};
+        runAndReconstruct(allResults);
+    }
+
+    std::vector<OptimalResults> getOptimalSequencesForAllStarts(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        const OptimiserOptions& options
+    ) {
+        std::vector<OptimalResults> results{};
+        Workspace workspace{};
+        getOptimalSequencesForAllStarts(tenorData, numResultsRequested, results, workspace, options);
+        return results;
+    }
+
+    void getOptimalSequencesForAllStarts(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        std::vector<OptimalResults>& results,
+        Workspace& workspace,
+        const OptimiserOptions& options
+    ) {
+        const int numMonths = tenorData.numMonths();
+        // Checked before mirroring, so that any bond reported is at its month in tenorData:
+        if (options.logSpace) {
+            Detail::ForwardPass::assertLogSpaceValid(tenorData, 1, numMonths);
+        }
+        getOptimalSequencesForAllHorizons(tenorData.mirrored(), numResultsRequested, results, workspace, options);
+
+        // The mirror's horizon of h months starts at month numMonths - h, so reversing the horizons orders them by
+        // start, and each path is mirrored back by reversing its actions:
+        std::ranges::reverse(results);
+        for (OptimalResults& startResults : results) {
+            for (std::size_t i = 0; i < startResults.size(); ++i) {
+                std::ranges::reverse(std::span(startResults.actions).subspan(
+                    startResults.pathOffsets[i], startResults.pathOffsets[i + 1] - startResults.pathOffsets[i]
+                ));
+            }
+        }
+    }
+
+    ResultDAG getOptimalSequencesAsDAG(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        const OptimiserOptions& options
+    ) {
+        Workspace workspace{};
+        return getOptimalSequencesAsDAG(tenorData, numResultsRequested, workspace, options);
+    }
+
+    ResultDAG getOptimalSequencesAsDAG(
+        const Domain::BondReturnData& tenorData,
+        const int numResultsRequested,
+        Workspace& workspace,
+        const OptimiserOptions& options
+    ) {
+        const int numTenors = tenorData.numTenors();
+        const int numMonths = tenorData.numMonths();
+        const auto& tenorList = tenorData.tenors();
+
+        if (numResultsRequested < 0) {
+            throw std::invalid_argument("Cannot request a negative number of results");
+        }
+        if (options.lowMemory) {
+            throw std::invalid_argument(
+                "A result DAG needs every month's decisions, so cannot be combined with low memory mode"
+            );
+        }
+        if (numResultsRequested == 0 || numMonths == 0 || numTenors == 0) {
+            return {tenorList, numMonths, {}, {}, {}, options.logSpace};
+        }
+        if (options.logSpace) {
+            Detail::ForwardPass::assertLogSpaceValid(tenorData, 1, numMonths);
+        }
+
+        const std::size_t window = static_cast<std::size_t>(std::min(tenorList.back(), numMonths)) + 1;
+        Detail::WorkspaceBuffers& buffers = Detail::buffersOf(workspace);
+        auto& CRFsBuffer = buffers.CRFs;
+        CRFsBuffer.assign(window * numResultsRequested, -std::numeric_limits<double>::infinity());
+        const Detail::CRFsSpan CRFs(CRFsBuffer.data(), window, numResultsRequested);
+        Instrumentation::recordCRFsBytes(CRFsBuffer.size() * sizeof(double));
+
+        ResultDAG dag{};
+        const auto runAndBuild = [&](auto& filter) {
+            Detail::withEngineAndStore(
+                options, numTenors, numMonths, numResultsRequested, buffers, [&](auto& mergeEngine, auto& decisions) {
+                    Detail::ForwardPass::seedBaseCase<typename std::remove_cvref_t<decltype(mergeEngine)>::Policy>(
+                        CRFs
+                    );
+                    decisions.beginRow(0);
+                    decisions.push(0, 0); // seeded that we "waited" to reach month 0
+                    decisions.commitRow();
+                    {
+                        const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+                        Detail::ForwardPass::IgnoreRows ignoreRows{};
+                        Detail::ForwardPass::runMonths(
+                            tenorData,
+                            numResultsRequested,
+                            CRFs,
+                            1,
+                            numMonths,
+                            mergeEngine,
+                            decisions,
+                            0,
+                            ignoreRows,
+                            filter
+                        );
+                    }
+                    if constexpr (Instrumentation::enabled) {
+                        Instrumentation::recordDecisionsBytes(decisions.bytes());
                     }
+
+                    const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+                    const int numResultsFound = decisions.count(numMonths);
+                    const std::size_t finalRowPos = static_cast<std::size_t>(numMonths) % window;
+                    std::vector<double> finalCRFs(static_cast<std::size_t>(numResultsFound));
+                    for (int i = 0; i < numResultsFound; ++i) {
+                        finalCRFs[static_cast<std::size_t>(i)] = CRFs[finalRowPos, i];
+                    }
+                    dag = Detail::PathReconstruction::buildResultDAG(
+                        decisions, tenorList, numMonths, numResultsFound, std::move(finalCRFs), options.logSpace
+                    );
+                }
+            );
+        };
+
+        // With a single result there is nothing to be a duplicate of.
+        if (options.distinctPurchases && numResultsRequested > 1) {
+            Detail::ForwardPass::DistinctPurchases distinctPurchases(tenorList, window, numResultsRequested);
+            runAndBuild(distinctPurchases);
+            return dag;
+        }
+        Detail::ForwardPass::AllResults allResults{};
+        runAndBuild(allResults);
+        return dag;
+    }
+
+    std::vector<OptimalResults> getOptimalSequences(
+        const std::vector<int>& tenors,
+        const ScenarioReturns scenarioReturns,
+        const int numResultsRequested,
+        const OptimiserOptions& options
+    ) {
+        if (numResultsRequested < 0) {
+            throw std::invalid_argument("Cannot request a negative number of results");
+        }
+        if (scenarioReturns.extent(1) != tenors.size()) {
+            throw std::invalid_argument("Scenario returns must have one row per tenor");
+        }
+        if (!std::ranges::is_sorted(tenors)) {
+            throw std::invalid_argument("Scenario tenors must be sorted in increasing order");
+        }
+        if (scenarioReturns.extent(2) > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+            throw std::invalid_argument("Scenario returns have too many months");
+        }
+
+        const std::size_t numScenarios = scenarioReturns.extent(0);
+        const int numMonths = static_cast<int>(scenarioReturns.extent(2));
+        std::vector<OptimalResults> results(numScenarios);
+
+        // As for a single run: nothing to find, so every scenario's results are empty.
+        if (numResultsRequested == 0 || numMonths == 0 || tenors.empty()) {
+            return results;
+        }
+
+        // Each scenario is viewed in place as BondReturnData. The caller keeps the batch alive for the whole call,
+        // so the storage handle needs no owner, and aliases the (non-null) grid only to mark the grid as external.
+        // ScenarioReturns is row-major, so each scenario's grid is contiguous.
+        const std::size_t gridSize = tenors.size() * static_cast<std::size_t>(numMonths);
+        std::vector<Domain::BondReturnData> scenarios{};
+        scenarios.reserve(numScenarios);
+        for (std::size_t s = 0; s < numScenarios; ++s) {
+            const double* const grid = scenarioReturns.data_handle() + s * gridSize;
+            scenarios.emplace_back(
+                tenors, numMonths, std::shared_ptr<const void>(std::shared_ptr<const void>{}, grid), grid, ""
+            );
+            if (options.logSpace) {
+                try {
+                    Detail::ForwardPass::assertLogSpaceValid(scenarios.back(), 1, numMonths);
+                }
+                catch (...) {
+                    Detail::Scenarios::rethrowForScenario(s);
                 }
-                // Any unfilled tail remains at -inf CRF and {-1, -1} decision.
             }
-            for (int i = 0; i < numResultsRequested; ++i) {
-                if (CRFs[finalRowPos, i] == -std::numeric_limits<double>::infinity()) break;
-                ++numResultsFound;
+        }
+
+        if (numResultsRequested == 1) {
+            constexpr std::size_t lanesPerBlock = Detail::Scenarios::lanesPerBlock;
+            const std::size_t numBlocks = (numScenarios + lanesPerBlock - 1) / lanesPerBlock;
+            Helpers::Parallel::forEachChunk(numBlocks, 1, [&](const std::size_t beginBlock, const std::size_t endBlock) {
+                for (std::size_t blockIndex = beginBlock; blockIndex < endBlock; ++blockIndex) {
+                    const std::size_t first = blockIndex * lanesPerBlock;
+                    const std::size_t count = std::min(lanesPerBlock, numScenarios - first);
+                    const auto block = std::span<const Domain::BondReturnData>(scenarios).subspan(first, count);
+                    const auto blockResults = std::span(results).subspan(first, count);
+                    if (options.logSpace) {
+                        Detail::Scenarios::runBestOfBlock<Merge::LogCRFs>(block, first, blockResults);
+                    }
+                    else {
+                        Detail::Scenarios::runBestOfBlock<Merge::ProductCRFs>(block, first, blockResults);
+                    }
+                }
+            });
+            for (OptimalResults& scenarioResults : results) {
+                scenarioResults.logSpace = options.logSpace;
             }
-            finalPaths = Detail::PathReconstruction::reconstructPaths(decisions, numMonths, numResultsFound);
-            finalRowPos = rowIndex[numMonths];
+            return results;
         }
 
-        // Return last row of CRFs as a vector (note that numResultsFound will hold the value for the final month):
-        finalCRFs.reserve(numResultsFound);
-        for (int i = 0; i < numResultsFound; ++i) {
-            finalCRFs.push_back(CRFs[finalRowPos, i]);
+        // With more results, each scenario's merges take their own data-dependent course, so cannot share loops,
+        // and scenarios are instead run independently across threads (any parallel work within each runs serially),
+        // each thread's scenarios sharing a workspace.
+        Helpers::Parallel::forEachChunk(numScenarios, 1, [&](const std::size_t begin, const std::size_t end) {
+            Workspace workspace{};
+            for (std::size_t s = begin; s < end; ++s) {
+                try {
+                    getOptimalSequences(scenarios[s], numResultsRequested, results[s], workspace, options);
+                }
+                catch (...) {
+                    Detail::Scenarios::rethrowForScenario(s);
+                }
+            }
+        });
+        return results;
+    }
+
+    std::size_t streamScenarios(
+        const std::vector<int>& tenors,
+        const int numMonths,
+        const int numResultsRequested,
+        const std::size_t scenariosPerChunk,
+        const ScenarioSource& source,
+        const ScenarioResultsSink& sink,
+        const OptimiserOptions& options
+    ) {
+        if (scenariosPerChunk == 0) {
+            throw std::invalid_argument("Scenarios must be streamed at least one at a time");
+        }
+        if (numMonths < 0) {
+            throw std::invalid_argument("Scenarios cannot have a negative number of months");
         }
 
-        return OptimalResults{
-            .CRFs = std::move(finalCRFs),
-            .decisions = std::move(finalPaths)
+        const std::size_t numTenors = tenors.size();
+        const auto months = static_cast<std::size_t>(numMonths);
+        // One chunk is filled while the other runs, each taking the other's place once both are done:
+        std::array<std::vector<double>, 2> chunks{};
+        for (auto& chunk : chunks) {
+            chunk.resize(scenariosPerChunk * numTenors * months);
+        }
+        const auto fill = [&](std::vector<double>& chunk, const std::size_t firstScenario) {
+            const std::size_t numFilled =
+                source(firstScenario, ScenarioChunk(chunk.data(), scenariosPerChunk, numTenors, months));
+            if (numFilled > scenariosPerChunk) {
+                throw std::invalid_argument(std::format(
+                    "Scenario source filled {} scenarios into a chunk of {}", numFilled, scenariosPerChunk
+                ));
+            }
+            return numFilled;
         };
+
+        std::size_t firstScenario = 0;
+        // Every chunk, the first too, is filled on another thread, so the source never runs on the calling thread:
+        std::size_t numFilled = std::async(std::launch::async, fill, std::ref(chunks[0]), std::size_t{0}).get();
+        for (std::size_t chunkIndex = 0; numFilled > 0; ++chunkIndex) {
+            // A chunk the source could not fill was the last, so there is no next to fill:
+            std::future<std::size_t> next{};
+            if (numFilled == scenariosPerChunk) {
+                next = std::async(
+                    std::launch::async, fill, std::ref(chunks[(chunkIndex + 1) % 2]), firstScenario + numFilled
+                );
+            }
+            const auto results = Detail::Scenarios::runChunk(
+                tenors,
+                ScenarioReturns(chunks[chunkIndex % 2].data(), numFilled, numTenors, months),
+                numResultsRequested,
+                options
+            );
+            sink(firstScenario, results);
+            firstScenario += numFilled;
+            numFilled = next.valid() ? next.get() : 0;
+        }
+        return firstScenario;
     }
 }
\ No newline at end of file
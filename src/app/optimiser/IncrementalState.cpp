@@ -0,0 +1,266 @@
+#include "app/optimiser/IncrementalState.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/ForwardPass.hpp"
+#include "app/optimiser/PathReconstruction.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	namespace Detail::Incremental
+	{
+		/// Views the grid as BondReturnData without copying it, for as long as the grid is unchanged in size.
+		[[nodiscard]] static Domain::BondReturnData viewOf(
+			const std::vector<int>& tenors,
+			const int numMonths,
+			const std::vector<double>& grid
+		) {
+			// The storage handle needs no owner, and aliases the grid only to mark it as external.
+			const double* const gridData = grid.data();
+			const std::shared_ptr<const void> storage(std::shared_ptr<const void>{}, gridData);
+			return {tenors, numMonths, storage, gridData, ""};
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	IncrementalState::IncrementalState(
+		const Domain::BondReturnData& tenorData,
+		const int numResultsRequested,
+		const OptimiserOptions& options
+	) :
+		tenors_(tenorData.tenors()),
+		numMonths_(tenorData.numMonths()),
+		numResultsRequested_(numResultsRequested),
+		logSpace_(options.logSpace),
+		mergeEngine_(options.mergeEngine),
+		grid_(tenorData.grid().begin(), tenorData.grid().end()),
+		dataPath_(tenorData.dataPath())
+	{
+		if (numResultsRequested <= 0) {
+			throw std::invalid_argument("IncrementalState: at least 1 result must be requested");
+		}
+		if (tenors_.empty()) {
+			throw std::invalid_argument("IncrementalState: no tenors provided");
+		}
+		if (options.lowMemory) {
+			throw std::invalid_argument("IncrementalState: keeps every month's decisions, so cannot use lowMemory");
+		}
+		if (options.distinctPurchases) {
+			throw std::invalid_argument("IncrementalState: cannot use distinctPurchases");
+		}
+		if (logSpace_) {
+			Detail::ForwardPass::assertLogSpaceValid(tenorData, 1, numMonths_);
+		}
+
+		const int numTenors = tenorData.numTenors();
+		const std::size_t numRows = static_cast<std::size_t>(numMonths_) + 1;
+		CRFs_.assign(
+			numRows * static_cast<std::size_t>(numResultsRequested_), -std::numeric_limits<double>::infinity()
+		);
+		// Every month is its own row of the "window", so month % window is the month itself:
+		const Detail::CRFsSpan CRFs(CRFs_.data(), numRows, numResultsRequested_);
+		Instrumentation::recordCRFsBytes(CRFs_.size() * sizeof(double));
+		if (logSpace_) {
+			Detail::ForwardPass::seedBaseCase<Merge::LogCRFs>(CRFs);
+		}
+		else {
+			Detail::ForwardPass::seedBaseCase<Merge::ProductCRFs>(CRFs);
+		}
+
+		if (
+			resolveDecisionLayout(options.decisionLayout, numTenors, numMonths_, numResultsRequested_)
+			== DecisionLayout::Packed
+		) {
+			decisions_.emplace<PackedDecisionStore>(numTenors, numMonths_, numResultsRequested_);
+		}
+		else {
+			decisions_.emplace<WideDecisionStore>(numTenors, numMonths_, numResultsRequested_);
+		}
+
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+		std::visit([&](auto& decisions) {
+			decisions.beginRow(0);
+			decisions.push(0, 0); // seeded that we "waited" to reach month 0
+			decisions.commitRow();
+			Detail::ForwardPass::withMergeEngine(
+				mergeEngine_, logSpace_, numTenors, numResultsRequested_, [&](auto& mergeEngine) {
+					Detail::ForwardPass::runMonths(
+						tenorData, numResultsRequested_, CRFs, 1, numMonths_, mergeEngine, decisions, 0
+					);
+				}
+			);
+			if constexpr (Instrumentation::enabled) {
+				Instrumentation::recordDecisionsBytes(decisions.bytes());
+			}
+		}, decisions_);
+	}
+
+	int IncrementalState::applyEdits(const std::span<const ReturnEdit> edits) {
+		// Every edit is checked before any is applied:
+		std::vector<std::size_t> cells{};
+		cells.reserve(edits.size());
+		for (const ReturnEdit& edit : edits) {
+			const auto tenor = std::ranges::find(tenors_, edit.tenor);
+			if (tenor == tenors_.end()) {
+				throw std::invalid_argument(std::format("IncrementalState: no {}-month tenor is held", edit.tenor));
+			}
+			if (edit.month < 0 || edit.month >= numMonths_) {
+				throw std::invalid_argument(
+					std::format("IncrementalState: month {} is beyond the {} months held", edit.month, numMonths_)
+				);
+			}
+			if (!std::isfinite(edit.bondReturn)) {
+				throw std::invalid_argument("IncrementalState: bond returns must be finite");
+			}
+			if (logSpace_ && 1.0 + edit.bondReturn <= 0.0) {
+				throw std::domain_error(
+					std::format(
+						"log-space returns need every bond return above -100%, "
+						"but the {}-month bond at month {} returns {:.2f}%",
+						edit.tenor,
+						edit.month,
+						100 * edit.bondReturn
+					)
+				);
+			}
+			const auto row = static_cast<std::size_t>(tenor - tenors_.begin());
+			cells.push_back(row * static_cast<std::size_t>(numMonths_) + static_cast<std::size_t>(edit.month));
+		}
+
+		// A bond only enters the merge of the month it matures, and one maturing beyond the data never does:
+		std::vector<char> editedMaturities(static_cast<std::size_t>(numMonths_) + 1, 0);
+		std::vector<double> previousReturns(edits.size());
+		int firstMonth = numMonths_ + 1;
+		for (std::size_t i = 0; i < edits.size(); ++i) {
+			previousReturns[i] = grid_[cells[i]];
+			grid_[cells[i]] = edits[i].bondReturn;
+			const int maturity = edits[i].month + edits[i].tenor;
+			if (maturity <= numMonths_ && previousReturns[i] != edits[i].bondReturn) {
+				editedMaturities[maturity] = 1;
+				firstMonth = std::min(firstMonth, maturity);
+			}
+		}
+		if (firstMonth > numMonths_) {
+			return 0;
+		}
+
+		try {
+			return rerunFrom(firstMonth, editedMaturities);
+		}
+		catch (...) {
+			// Re-running the same months over the previous returns rebuilds every row exactly as it was, since the
+			// months re-run before the failure are again those reached:
+			for (std::size_t i = edits.size(); i-- > 0;) {
+				grid_[cells[i]] = previousReturns[i];
+			}
+			rerunFrom(firstMonth, editedMaturities);
+			throw;
+		}
+	}
+
+	int IncrementalState::rerunFrom(const int firstMonth, const std::vector<char>& editedMaturities) {
+		const Domain::BondReturnData tenorData = Detail::Incremental::viewOf(tenors_, numMonths_, grid_);
+		const int numTenors = static_cast<int>(tenors_.size());
+		const int maxTenor = tenors_.back();
+		const auto numResultsU = static_cast<std::size_t>(numResultsRequested_);
+		const Detail::CRFsSpan CRFs(CRFs_.data(), static_cast<std::size_t>(numMonths_) + 1, numResultsRequested_);
+		int lastEditedMaturity = numMonths_;
+		while (editedMaturities[lastEditedMaturity] == 0) {
+			--lastEditedMaturity;
+		}
+
+		// Whether each month's row differs from before the edits, of which only a window is ever read back:
+		std::vector<char> changed(static_cast<std::size_t>(numMonths_) + 1, 0);
+		int lastChangedMonth = firstMonth - 1 - maxTenor;
+		// The row being re-run as it was, to compare against:
+		std::vector<double> previousCRFs(numResultsU);
+		std::vector<Decision> previousDecisions(numResultsU);
+		int numRerun = 0;
+
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+		std::visit([&](auto& decisions) {
+			Detail::ForwardPass::withMergeEngine(
+				mergeEngine_, logSpace_, numTenors, numResultsRequested_, [&](auto& mergeEngine) {
+					for (int month = firstMonth; month <= numMonths_; ++month) {
+						// A month reads the month before (waiting) and the month each tenor was bought in:
+						bool reached = editedMaturities[month] != 0 || changed[month - 1] != 0;
+						for (int i = 0; !reached && i < numTenors && tenors_[i] <= month; ++i) {
+							reached = changed[month - tenors_[i]] != 0;
+						}
+						if (!reached) {
+							// Past the last edit, a whole window unchanged leaves nothing for later months to read:
+							if (month > lastEditedMaturity && month - lastChangedMonth > maxTenor) {
+								return;
+							}
+							continue;
+						}
+
+						const auto row =
+							std::span(CRFs_).subspan(static_cast<std::size_t>(month) * numResultsU, numResultsU);
+						std::ranges::copy(row, previousCRFs.begin());
+						const int previousCount = decisions.count(month);
+						for (int rank = 0; rank < previousCount; ++rank) {
+							previousDecisions[rank] = decisions.get(month, rank);
+						}
+
+						Detail::ForwardPass::runMonths(
+							tenorData, numResultsRequested_, CRFs, month, month, mergeEngine, decisions, 0
+						);
+						++numRerun;
+
+						bool same = decisions.count(month) == previousCount && std::ranges::equal(row, previousCRFs);
+						for (int rank = 0; same && rank < previousCount; ++rank) {
+							const Decision decision = decisions.get(month, rank);
+							same = decision.tenorCode == previousDecisions[rank].tenorCode
+								&& decision.prevRank == previousDecisions[rank].prevRank;
+						}
+						if (!same) {
+							changed[month] = 1;
+							lastChangedMonth = month;
+						}
+					}
+				}
+			);
+		}, decisions_);
+		return numRerun;
+	}
+
+	void IncrementalState::results(OptimalResults& results) const {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+		std::visit([&](const auto& decisions) {
+			const int numResultsFound = decisions.count(numMonths_);
+			Detail::PathReconstruction::reconstructPaths(decisions, tenors_, numMonths_, numResultsFound, results);
+
+			const auto finalRow = std::span(CRFs_).subspan(
+				static_cast<std::size_t>(numMonths_) * static_cast<std::size_t>(numResultsRequested_)
+			);
+			results.CRFs.assign(finalRow.begin(), finalRow.begin() + numResultsFound);
+		}, decisions_);
+		results.logSpace = logSpace_;
+	}
+
+	OptimalResults IncrementalState::results() const {
+		OptimalResults optimalResults{};
+		results(optimalResults);
+		return optimalResults;
+	}
+
+	Domain::BondReturnData IncrementalState::tenorData() const {
+		return {tenors_, numMonths_, grid_, dataPath_};
+	}
+}
\ No newline at end of file
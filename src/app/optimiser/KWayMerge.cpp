@@ -0,0 +1,28 @@
+#include "app/optimiser/KWayMerge.hpp"
+
+#include <cmath>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+namespace DynamicOptimiser::Merge
+{
+	void throwCRFOverflow(const double value, const int month) {
+		if (!std::signbit(value)) {
+			throw std::overflow_error(
+				std::format(
+					"return exceeding finite limit ({:.3e}) possible by month {}",
+					std::numeric_limits<double>::max(),
+					month
+				)
+			);
+		}
+		throw std::overflow_error(
+			std::format(
+				"return below finite limit ({:.3e}) possible by month {}",
+				std::numeric_limits<double>::lowest(),
+				month
+			)
+		);
+	}
+}
\ No newline at end of file
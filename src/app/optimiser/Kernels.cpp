@@ -0,0 +1,79 @@
+#include "app/optimiser/Kernels.hpp"
+
+#include "helpers/Platform.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace DynamicOptimiser::Kernels
+{
+	BSO_TARGET_CLONES void fillUnreached(double* const CRFs, const std::size_t count) noexcept {
+		for (std::size_t i = 0; i < count; ++i) {
+			CRFs[i] = -std::numeric_limits<double>::infinity();
+		}
+	}
+
+	BSO_TARGET_CLONES std::size_t combineHeads(
+		const double* const prevCRFs,
+		const double* const factors,
+		double* const heads,
+		const std::size_t count,
+		const bool logSpace
+	) noexcept {
+		if (logSpace) {
+			for (std::size_t s = 0; s < count; ++s) {
+				heads[s] = prevCRFs[s] + factors[s];
+			}
+			return count;
+		}
+
+		// Products are formed, then checked, in separate branchless passes, so that both vectorise, and the
+		// overflowing head is only searched for if there is one. A head's magnitude only reaches infinity by
+		// overflowing, since every predecessor's best CRF is finite.
+		for (std::size_t s = 0; s < count; ++s) {
+			heads[s] = prevCRFs[s] * factors[s];
+		}
+		int anyOverflowed = 0;
+		for (std::size_t s = 0; s < count; ++s) {
+			anyOverflowed |= std::abs(heads[s]) == std::numeric_limits<double>::infinity();
+		}
+		if (!anyOverflowed) {
+			return count;
+		}
+		std::size_t first = 0;
+		while (std::abs(heads[first]) != std::numeric_limits<double>::infinity()) {
+			++first;
+		}
+		return first;
+	}
+
+	BSO_TARGET_CLONES std::size_t firstMaxIndex(const double* const values, const std::size_t count) noexcept {
+		// The greatest value is found as many running maxima side by side, which vectorises where a single running
+		// maximum would not (reordering its comparisons being unsafe for floating point), and only then is its first
+		// position searched for. Fewer lanes are unrolled by the compiler into scalar code instead.
+		constexpr std::size_t numLanes = 32;
+		std::array<double, numLanes> maxima{};
+		maxima.fill(-std::numeric_limits<double>::infinity());
+		std::size_t s = 0;
+		for (; s + numLanes <= count; s += numLanes) {
+			for (std::size_t lane = 0; lane < numLanes; ++lane) {
+				maxima[lane] = values[s + lane] > maxima[lane] ? values[s + lane] : maxima[lane];
+			}
+		}
+		double greatest = -std::numeric_limits<double>::infinity();
+		for (const double maximum : maxima) {
+			greatest = maximum > greatest ? maximum : greatest;
+		}
+		for (; s < count; ++s) {
+			greatest = values[s] > greatest ? values[s] : greatest;
+		}
+
+		std::size_t first = 0;
+		while (values[first] != greatest) {
+			++first;
+		}
+		return first;
+	}
+}
\ No newline at end of file
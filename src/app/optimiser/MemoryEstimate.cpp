@@ -0,0 +1,174 @@
+#include "app/optimiser/MemoryEstimate.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/PathReconstruction.hpp"
+#include "helpers/Memory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace DynamicOptimiser
+{
+	namespace Detail
+	{
+		// The share of the memory available that runs are admitted to use by default.
+		constexpr double memoryBudgetShare = 0.8;
+	}
+
+	MemoryEstimate estimateMemory(
+		const Domain::BondReturnData& tenorData,
+		const int numResultsRequested,
+		const OptimiserOptions& options,
+		const bool pathsStreamed
+	) noexcept {
+		const int numTenors = tenorData.numTenors();
+		const int numMonths = tenorData.numMonths();
+		if (numResultsRequested <= 0 || numMonths <= 0 || numTenors <= 0) {
+			return {};
+		}
+		const auto& tenorList = tenorData.tenors();
+		const auto k = static_cast<std::size_t>(numResultsRequested);
+		const auto months = static_cast<std::size_t>(numMonths);
+
+		// As in getOptimalSequences:
+		const std::size_t window = static_cast<std::size_t>(std::min(tenorList.back(), numMonths)) + 1;
+		MemoryEstimate estimate{};
+		estimate.CRFsBytes = window * k * sizeof(double);
+
+		int numRows = numMonths;
+		std::size_t numSegments = 1;
+		if (options.lowMemory) {
+			numRows = std::clamp(
+				static_cast<int>(std::sqrt(static_cast<double>(numMonths) * static_cast<double>(window))), 1, numMonths
+			);
+			numSegments = (months + static_cast<std::size_t>(numRows) - 1) / static_cast<std::size_t>(numRows);
+			estimate.CRFsBytes += numSegments * window * k * sizeof(double);
+		}
+		if (options.distinctPurchases && numResultsRequested > 1) {
+			estimate.CRFsBytes += window * k * sizeof(std::uint64_t);
+		}
+
+		const DecisionLayout layout =
+			resolveDecisionLayout(options.decisionLayout, numTenors, numRows, numResultsRequested);
+		estimate.decisionsBytes = layout == DecisionLayout::Packed
+			? PackedDecisionStore::maxBytes(numTenors, numRows, numResultsRequested)
+			: WideDecisionStore::maxBytes(numTenors, numRows, numResultsRequested);
+
+		// Waits are merged into one action, so a path alternates at most between buying the shortest tenor and waiting,
+		// and never has more actions than months:
+		const auto shortestTenor = static_cast<std::size_t>(std::max(tenorList.front(), 1));
+		const std::size_t maxPathActions = std::min(months, 2 * (months / shortestTenor) + 1);
+		// Checkpointing walks every path together, so only streams them once all are complete:
+		const std::size_t ranksHeld = pathsStreamed && !options.lowMemory
+			? std::min(k, static_cast<std::size_t>(Detail::PathReconstruction::ranksPerStreamedBlock))
+			: k;
+		// The paths are walked into buffers of their own and then joined into the results, so are held twice at the
+		// end, along with each stage's (segment's) count of actions per rank:
+		estimate.resultsBytes = ranksHeld * (
+			2 * maxPathActions * sizeof(Domain::InvestmentAction)
+			+ numSegments * sizeof(std::size_t)
+			+ sizeof(double)
+			+ sizeof(std::size_t)
+		);
+		if (options.lowMemory) {
+			estimate.resultsBytes += k * sizeof(Detail::PathReconstruction::PathWalker);
+		}
+		return estimate;
+	}
+
+	Admission admitRun(
+		const Domain::BondReturnData& tenorData,
+		const int numResultsRequested,
+		const OptimiserOptions& options,
+		const std::size_t budgetBytes,
+		const bool pathsStreamed
+	) noexcept {
+		Admission admission{
+			.options = options,
+			.numResultsRequested = numResultsRequested,
+			.requestedEstimate = estimateMemory(tenorData, numResultsRequested, options, pathsStreamed),
+			.budgetBytes = budgetBytes
+		};
+		admission.estimate = admission.requestedEstimate;
+		admission.fits = admission.estimate.total() <= budgetBytes;
+		if (admission.fits) {
+			return admission;
+		}
+
+		// Takes a fallback only if it saves memory, since checkpointing's snapshots of the CRFs window can cost more
+		// than the decisions it saves for short horizons, returning whether the run then fits:
+		const auto tryFallback = [&](const OptimiserOptions& fallbackOptions, bool& taken) {
+			const MemoryEstimate estimate = estimateMemory(
+				tenorData, numResultsRequested, fallbackOptions, pathsStreamed
+			);
+			if (estimate.total() < admission.estimate.total()) {
+				admission.options = fallbackOptions;
+				admission.estimate = estimate;
+				admission.fits = estimate.total() <= budgetBytes;
+				taken = true;
+			}
+			return admission.fits;
+		};
+
+		// Only counted as a fallback if Auto would not have packed anyway:
+		if (
+			options.decisionLayout == DecisionLayout::Auto
+			&& resolveDecisionLayout(
+				options.decisionLayout, tenorData.numTenors(), tenorData.numMonths(), numResultsRequested
+			) != DecisionLayout::Packed
+		) {
+			OptimiserOptions packedOptions = admission.options;
+			packedOptions.decisionLayout = DecisionLayout::Packed;
+			if (tryFallback(packedOptions, admission.packedDecisions)) {
+				return admission;
+			}
+		}
+
+		if (!options.lowMemory && !options.distinctPurchases) {
+			OptimiserOptions lowMemoryOptions = admission.options;
+			lowMemoryOptions.lowMemory = true;
+			if (tryFallback(lowMemoryOptions, admission.lowMemory)) {
+				return admission;
+			}
+		}
+
+		// The estimate only grows with the number of results, so search for the most that fit:
+		int lowest = 0;
+		int highest = numResultsRequested - 1;
+		while (lowest < highest) {
+			const int middle = lowest + (highest - lowest + 1) / 2;
+			if (estimateMemory(tenorData, middle, admission.options, pathsStreamed).total() <= budgetBytes) {
+				lowest = middle;
+			}
+			else {
+				highest = middle - 1;
+			}
+		}
+		if (lowest == 0) {
+			// Not even one result fits, so leave the run as it was asked for and let the caller decide:
+			admission.options = options;
+			admission.packedDecisions = false;
+			admission.lowMemory = false;
+			admission.estimate = admission.requestedEstimate;
+			return admission;
+		}
+		admission.numResultsRequested = lowest;
+		admission.cappedResults = true;
+		admission.estimate = estimateMemory(tenorData, lowest, admission.options, pathsStreamed);
+		admission.fits = true;
+		return admission;
+	}
+
+	std::optional<std::size_t> defaultMemoryBudget() noexcept {
+		const auto available = Helpers::Memory::availableBytes();
+		if (!available) {
+			return std::nullopt;
+		}
+		return static_cast<std::size_t>(static_cast<double>(*available) * Detail::memoryBudgetShare);
+	}
+}
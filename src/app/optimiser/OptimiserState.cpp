@@ -0,0 +1,472 @@
+#include "app/optimiser/OptimiserState.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/instrumentation/Instrumentation.hpp"
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/ForwardPass.hpp"
+#include "app/optimiser/PathReconstruction.hpp"
+#include "helpers/Filesystem.hpp"
+#include "helpers/MappedFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	namespace Detail::StateFormat
+	{
+		/*
+		* A state file holds, after a 64-byte header, each part of the state in native byte order, every part padded
+		* with zeros to a multiple of 8 bytes:
+		*  - the tenors in increasing order as 32-bit integers;
+		*  - the CRFs window, as (maxTenor + 1) x numResultsRequested doubles;
+		*  - the recent bond returns, as numTenors rows of doubles;
+		*  - the number of decisions in each month's row, as (numMonths + 1) 32-bit integers;
+		*  - every row's decisions end to end, as pairs of 32-bit integers.
+		*/
+
+		constexpr std::array<char, 8> magic = {'B', 'S', 'O', 'S', 'T', 'A', 'T', 'E'};
+		// Increment whenever the layout changes, older files are then rejected.
+		constexpr std::uint32_t version = 1;
+		// Written in native byte order, so reads back differently on a machine with the opposite byte order.
+		constexpr std::uint64_t byteOrderMark = 0x0102030405060708;
+		constexpr std::uint32_t logSpaceFlag = 1;
+
+		/// The fixed-size header at the start of every state file.
+		struct FileHeader
+		{
+			std::array<char, 8> magic{};
+			std::uint32_t version{};
+			std::uint32_t headerSize{};
+			std::uint64_t byteOrderMark{};
+			std::uint32_t numTenors{};
+			std::uint32_t numMonths{};
+			std::uint32_t numResultsRequested{};
+			std::uint32_t flags{};
+			std::uint32_t mergeEngine{};
+			std::uint32_t decisionLayout{};
+			std::uint64_t numDecisions{};
+			std::uint64_t reserved{};
+		};
+		static_assert(sizeof(FileHeader) == 64, "optimiser state header must be exactly 64 bytes");
+		static_assert(sizeof(Decision) == 2 * sizeof(std::int32_t), "decisions must be stored as pairs of int32s");
+
+		/// Returns the size of a part in bytes, padded to a multiple of 8.
+		[[nodiscard]] static constexpr std::size_t paddedSize(const std::size_t numBytes) noexcept {
+			return (numBytes + 7) / 8 * 8;
+		}
+
+		/// Reads the parts of a file in order, checking that each lies within the file.
+		class PartReader
+		{
+			public:
+				explicit PartReader(const Helpers::Filesystem::MappedFile& file) noexcept : file_(file) {}
+
+				/// Copies the next part, of count values of type T, into values.
+				template <typename T>
+				void read(std::vector<T>& values, const std::size_t count) {
+					const std::size_t numBytes = count * sizeof(T);
+					if (count > (file_.size() - pos_) / sizeof(T) || paddedSize(numBytes) > file_.size() - pos_) {
+						throw OptimiserStateError("state file is truncated");
+					}
+					values.resize(count);
+					std::memcpy(values.data(), file_.data() + pos_, numBytes);
+					pos_ += paddedSize(numBytes);
+				}
+
+				[[nodiscard]] bool atEnd() const noexcept { return pos_ == file_.size(); }
+
+			private:
+				const Helpers::Filesystem::MappedFile& file_;
+				std::size_t pos_ = sizeof(FileHeader);
+		};
+
+		/// Writes count values as the next part, padding it with zeros.
+		template <typename T>
+		static void writePart(std::ofstream& out, const T* const values, const std::size_t count) {
+			const std::size_t numBytes = count * sizeof(T);
+			out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(numBytes));
+			constexpr std::array<char, 8> padding{};
+			out.write(padding.data(), static_cast<std::streamsize>(paddedSize(numBytes) - numBytes));
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	OptimiserState::OptimiserState(
+		const Domain::BondReturnData& tenorData,
+		const int numResultsRequested,
+		const OptimiserOptions& options
+	) :
+		tenors_(tenorData.tenors()),
+		numResultsRequested_(numResultsRequested),
+		logSpace_(options.logSpace),
+		mergeEngine_(options.mergeEngine)
+	{
+		if (numResultsRequested <= 0) {
+			throw std::invalid_argument("OptimiserState: at least 1 result must be requested");
+		}
+		if (tenors_.empty()) {
+			throw std::invalid_argument("OptimiserState: no tenors provided");
+		}
+		if (options.lowMemory) {
+			throw std::invalid_argument("OptimiserState: keeps every month's decisions, so cannot use lowMemory");
+		}
+		if (options.distinctPurchases) {
+			throw std::invalid_argument("OptimiserState: cannot use distinctPurchases");
+		}
+
+		const int numTenors = tenorData.numTenors();
+		CRFs_.assign(window() * static_cast<std::size_t>(numResultsRequested_), 0.0);
+		const Detail::CRFsSpan CRFs(CRFs_.data(), window(), numResultsRequested_);
+		if (logSpace_) {
+			Detail::ForwardPass::seedBaseCase<Merge::LogCRFs>(CRFs);
+		}
+		else {
+			Detail::ForwardPass::seedBaseCase<Merge::ProductCRFs>(CRFs);
+		}
+
+		const int numMonths = tenorData.numMonths();
+		if (
+			resolveDecisionLayout(options.decisionLayout, numTenors, numMonths, numResultsRequested_)
+			== DecisionLayout::Packed
+		) {
+			decisions_.emplace<PackedDecisionStore>(numTenors, numMonths, numResultsRequested_);
+		}
+		else {
+			decisions_.emplace<WideDecisionStore>(numTenors, numMonths, numResultsRequested_);
+		}
+		std::visit([](auto& decisions) {
+			decisions.beginRow(0);
+			decisions.push(0, 0); // seeded that we "waited" to reach month 0
+			decisions.commitRow();
+		}, decisions_);
+
+		extend(tenorData);
+	}
+
+	int OptimiserState::firstRecentMonth() const noexcept {
+		// Month m buys a bond of tenor t in month m - t, which for months still to run is at least this:
+		return std::max(numMonths_ + 1 - tenors_.back(), 0);
+	}
+
+	void OptimiserState::keepRecentReturns(const Domain::BondReturnData& tenorData) {
+		const int firstMonth = firstRecentMonth();
+		const auto numRecent = static_cast<std::size_t>(numMonths_ - firstMonth);
+		recentReturns_.resize(tenors_.size() * numRecent);
+		for (std::size_t i = 0; i < tenors_.size(); ++i) {
+			for (std::size_t j = 0; j < numRecent; ++j) {
+				recentReturns_[i * numRecent + j] = tenorData(static_cast<int>(i), firstMonth + static_cast<int>(j));
+			}
+		}
+	}
+
+	bool OptimiserState::canExtendWith(const Domain::BondReturnData& tenorData) const {
+		if (tenorData.tenors() != tenors_ || tenorData.numMonths() < numMonths_) {
+			return false;
+		}
+		const int firstMonth = firstRecentMonth();
+		const auto numRecent = static_cast<std::size_t>(numMonths_ - firstMonth);
+		for (std::size_t i = 0; i < tenors_.size(); ++i) {
+			for (std::size_t j = 0; j < numRecent; ++j) {
+				const double bondReturn = tenorData(static_cast<int>(i), firstMonth + static_cast<int>(j));
+				if (bondReturn != recentReturns_[i * numRecent + j]) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void OptimiserState::extend(const Domain::BondReturnData& tenorData) {
+		if (!canExtendWith(tenorData)) {
+			throw std::invalid_argument(
+				"OptimiserState: bond return data does not continue the months already run, "
+				"having different tenors, fewer months, or changed returns"
+			);
+		}
+		const int lastMonth = tenorData.numMonths();
+		if (lastMonth == numMonths_) {
+			return;
+		}
+		if (logSpace_) {
+			Detail::ForwardPass::assertLogSpaceValid(tenorData, numMonths_ + 1, lastMonth);
+		}
+
+		const Detail::CRFsSpan CRFs(CRFs_.data(), window(), numResultsRequested_);
+		Instrumentation::recordCRFsBytes(CRFs_.size() * sizeof(double));
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::ForwardPass);
+		std::visit([&](auto& decisions) {
+			decisions.extendRows(lastMonth);
+			const auto runMonths = [&](auto& mergeEngine) {
+				// Months are run one at a time, so that if one fails (such as on overflow), the state is left after
+				// the last month that succeeded: running a month writes only its own row of the window, which holds a
+				// month older than any later months need, and its row of decisions is only counted once complete.
+				try {
+					while (numMonths_ < lastMonth) {
+						const int month = numMonths_ + 1;
+						Detail::ForwardPass::runMonths(
+							tenorData, numResultsRequested_, CRFs, month, month, mergeEngine, decisions, 0
+						);
+						numMonths_ = month;
+					}
+				}
+				catch (...) {
+					keepRecentReturns(tenorData);
+					throw;
+				}
+			};
+			Detail::ForwardPass::withMergeEngine(
+				mergeEngine_, logSpace_, tenorData.numTenors(), numResultsRequested_, runMonths
+			);
+			if constexpr (Instrumentation::enabled) {
+				Instrumentation::recordDecisionsBytes(decisions.bytes());
+			}
+		}, decisions_);
+		keepRecentReturns(tenorData);
+	}
+
+	void OptimiserState::results(OptimalResults& results) const {
+		this->results(results, numResultsRequested_);
+	}
+
+	void OptimiserState::results(OptimalResults& results, const int maxResults) const {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+		std::visit([&](const auto& decisions) {
+			// Each row holds its top results in order, so the top few are a prefix of them:
+			const int numResultsFound = std::min(decisions.count(numMonths_), std::max(maxResults, 0));
+			Detail::PathReconstruction::reconstructPaths(decisions, tenors_, numMonths_, numResultsFound, results);
+
+			const auto finalRow =
+				std::span(CRFs_).subspan(static_cast<std::size_t>(numMonths_) % window() * numResultsRequested_);
+			results.CRFs.assign(finalRow.begin(), finalRow.begin() + numResultsFound);
+		}, decisions_);
+		results.logSpace = logSpace_;
+	}
+
+	OptimalResults OptimiserState::results() const {
+		OptimalResults optimalResults{};
+		results(optimalResults);
+		return optimalResults;
+	}
+
+	ResultDAG OptimiserState::resultDAG(const int maxResults) const {
+		const Instrumentation::PhaseTimer timer(Instrumentation::Phase::Reconstruction);
+		return std::visit([&](const auto& decisions) {
+			const int numResultsFound = std::min(decisions.count(numMonths_), std::max(maxResults, 0));
+			const auto finalRow =
+				std::span(CRFs_).subspan(static_cast<std::size_t>(numMonths_) % window() * numResultsRequested_);
+			return Detail::PathReconstruction::buildResultDAG(
+				decisions,
+				tenors_,
+				numMonths_,
+				numResultsFound,
+				std::vector<double>(finalRow.begin(), finalRow.begin() + numResultsFound),
+				logSpace_
+			);
+		}, decisions_);
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	void OptimiserState::save(const std::filesystem::path& statePath) const {
+		namespace Format = Detail::StateFormat;
+
+		std::vector<std::int32_t> counts(static_cast<std::size_t>(numMonths_) + 1);
+		std::visit([&](const auto& decisions) {
+			for (int month = 0; month <= numMonths_; ++month) {
+				counts[month] = decisions.count(month);
+			}
+		}, decisions_);
+		std::uint64_t numDecisions = 0;
+		for (const std::int32_t count : counts) {
+			numDecisions += static_cast<std::uint64_t>(count);
+		}
+
+		const Format::FileHeader header{
+			.magic = Format::magic,
+			.version = Format::version,
+			.headerSize = sizeof(Format::FileHeader),
+			.byteOrderMark = Format::byteOrderMark,
+			.numTenors = static_cast<std::uint32_t>(tenors_.size()),
+			.numMonths = static_cast<std::uint32_t>(numMonths_),
+			.numResultsRequested = static_cast<std::uint32_t>(numResultsRequested_),
+			.flags = logSpace_ ? Format::logSpaceFlag : 0,
+			.mergeEngine = static_cast<std::uint32_t>(mergeEngine_),
+			.decisionLayout = static_cast<std::uint32_t>(
+				std::holds_alternative<PackedDecisionStore>(decisions_) ? DecisionLayout::Packed : DecisionLayout::Wide
+			),
+			.numDecisions = numDecisions,
+			.reserved = 0
+		};
+
+		std::ofstream out(statePath, std::ios::binary | std::ios::trunc);
+		// Convert stream state failures into exceptions so partial/failed writes are handled by the caller:
+		out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+
+		const std::vector<std::int32_t> tenors(tenors_.begin(), tenors_.end());
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		Format::writePart(out, tenors.data(), tenors.size());
+		Format::writePart(out, CRFs_.data(), CRFs_.size());
+		Format::writePart(out, recentReturns_.data(), recentReturns_.size());
+		Format::writePart(out, counts.data(), counts.size());
+
+		// Decisions are unpacked a row at a time, whichever layout holds them:
+		std::vector<Decision> row(static_cast<std::size_t>(numResultsRequested_));
+		std::visit([&](const auto& decisions) {
+			for (int month = 0; month <= numMonths_; ++month) {
+				for (int rank = 0; rank < counts[month]; ++rank) {
+					row[rank] = decisions.get(month, rank);
+				}
+				out.write(
+					reinterpret_cast<const char*>(row.data()),
+					static_cast<std::streamsize>(static_cast<std::size_t>(counts[month]) * sizeof(Decision))
+				);
+			}
+		}, decisions_);
+		out.flush();
+	}
+
+	OptimiserState OptimiserState::load(const std::filesystem::path& statePath) {
+		namespace Format = Detail::StateFormat;
+
+		std::optional<Helpers::Filesystem::MappedFile> file{};
+		try {
+			file.emplace(statePath);
+		}
+		catch (const Helpers::Filesystem::FileError& e) {
+			throw OptimiserStateError(e.what());
+		}
+
+		Format::FileHeader header{};
+		if (file->size() < sizeof(Format::FileHeader)) {
+			throw OptimiserStateError("file is too small to be an optimiser state");
+		}
+		std::memcpy(&header, file->data(), sizeof(Format::FileHeader));
+		if (header.magic != Format::magic) {
+			throw OptimiserStateError("file is not an optimiser state");
+		}
+		if (header.byteOrderMark != Format::byteOrderMark) {
+			throw OptimiserStateError("optimiser state was written on a machine with a different byte order");
+		}
+		if (header.version != Format::version || header.headerSize != sizeof(Format::FileHeader)) {
+			throw OptimiserStateError(
+				std::format("optimiser state version {} is not supported, expected {}", header.version, Format::version)
+			);
+		}
+
+		// Check every field before trusting it to size anything:
+		constexpr auto maxInt = static_cast<std::uint32_t>(std::numeric_limits<int>::max());
+		if (header.numTenors == 0 || header.numTenors > maxInt) {
+			throw OptimiserStateError(std::format("invalid number of tenors: {}", header.numTenors));
+		}
+		if (header.numMonths == 0 || header.numMonths > maxInt) {
+			throw OptimiserStateError(std::format("invalid number of months: {}", header.numMonths));
+		}
+		if (header.numResultsRequested == 0 || header.numResultsRequested > maxInt) {
+			throw OptimiserStateError(std::format("invalid number of results: {}", header.numResultsRequested));
+		}
+		if (header.mergeEngine > static_cast<std::uint32_t>(MergeEngine::Auto)) {
+			throw OptimiserStateError(std::format("invalid merge engine: {}", header.mergeEngine));
+		}
+		const auto layout = static_cast<DecisionLayout>(header.decisionLayout);
+		if (layout != DecisionLayout::Wide && layout != DecisionLayout::Packed) {
+			throw OptimiserStateError(std::format("invalid decision layout: {}", header.decisionLayout));
+		}
+
+		OptimiserState state{};
+		state.numMonths_ = static_cast<int>(header.numMonths);
+		state.numResultsRequested_ = static_cast<int>(header.numResultsRequested);
+		state.logSpace_ = (header.flags & Format::logSpaceFlag) != 0;
+		state.mergeEngine_ = static_cast<MergeEngine>(header.mergeEngine);
+
+		Format::PartReader reader(*file);
+		std::vector<std::int32_t> tenors{};
+		reader.read(tenors, header.numTenors);
+		if (tenors.front() <= 0) {
+			throw OptimiserStateError("tenors must be positive");
+		}
+		if (std::ranges::adjacent_find(tenors, std::ranges::greater_equal{}) != tenors.end()) {
+			throw OptimiserStateError("tenors must be unique and in increasing order");
+		}
+		state.tenors_.assign(tenors.begin(), tenors.end());
+
+		const auto numResultsU = static_cast<std::size_t>(state.numResultsRequested_);
+		if (state.window() > std::numeric_limits<std::size_t>::max() / sizeof(double) / numResultsU) {
+			throw OptimiserStateError("state file is truncated");
+		}
+		reader.read(state.CRFs_, state.window() * numResultsU);
+		if (std::ranges::any_of(state.CRFs_, [](const double CRF) { return std::isnan(CRF); })) {
+			throw OptimiserStateError("invalid CRF");
+		}
+		reader.read(
+			state.recentReturns_,
+			state.tenors_.size() * static_cast<std::size_t>(state.numMonths_ - state.firstRecentMonth())
+		);
+
+		std::vector<std::int32_t> counts{};
+		reader.read(counts, static_cast<std::size_t>(state.numMonths_) + 1);
+		std::uint64_t numDecisions = 0;
+		for (const std::int32_t count : counts) {
+			if (count < 0 || count > state.numResultsRequested_) {
+				throw OptimiserStateError(std::format("invalid number of decisions in a month: {}", count));
+			}
+			numDecisions += static_cast<std::uint64_t>(count);
+		}
+		if (numDecisions != header.numDecisions) {
+			throw OptimiserStateError("number of decisions does not match the header");
+		}
+		std::vector<Decision> decisions{};
+		reader.read(decisions, static_cast<std::size_t>(numDecisions));
+		if (!reader.atEnd()) {
+			throw OptimiserStateError("state file has unexpected trailing data");
+		}
+
+		// Rebuild the store row by row, checking every decision leads to a month and rank that exist, so that
+		// reconstructing paths from a damaged file cannot read out of bounds:
+		const int numTenors = static_cast<int>(state.tenors_.size());
+		const auto fillStore = [&](auto& store) {
+			std::size_t next = 0;
+			for (int month = 0; month <= state.numMonths_; ++month) {
+				store.beginRow(month);
+				for (int rank = 0; rank < counts[month]; ++rank) {
+					const auto [tenorCode, prevRank] = decisions[next++];
+					if (month > 0) {
+						if (tenorCode < 0 || tenorCode > numTenors) {
+							throw OptimiserStateError(std::format("month {}: invalid tenor code {}", month, tenorCode));
+						}
+						const int prevMonth = month - (tenorCode == 0 ? 1 : state.tenors_[tenorCode - 1]);
+						if (prevMonth < 0 || prevRank < 0 || prevRank >= counts[prevMonth]) {
+							throw OptimiserStateError(std::format("month {}: invalid decision", month));
+						}
+					}
+					store.push(tenorCode, prevRank);
+				}
+				store.commitRow();
+			}
+		};
+		const int numMonths = state.numMonths_;
+		const int numResultsRequested = state.numResultsRequested_;
+		if (layout == DecisionLayout::Packed) {
+			fillStore(state.decisions_.emplace<PackedDecisionStore>(numTenors, numMonths, numResultsRequested));
+		}
+		else {
+			fillStore(state.decisions_.emplace<WideDecisionStore>(numTenors, numMonths, numResultsRequested));
+		}
+		return state;
+	}
+}
\ No newline at end of file
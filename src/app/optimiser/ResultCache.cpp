@@ -0,0 +1,153 @@
+#include "app/optimiser/ResultCache.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/OptimiserState.hpp"
+#include "helpers/Hash.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <utility>
+
+namespace DynamicOptimiser
+{
+	namespace Detail
+	{
+		/// Writes the state via a temporary file renamed into place, so that a reader never sees a partly written
+		/// file. Saving is only an optimisation, so failures are ignored.
+		static void trySaveState(const OptimiserState& state, const std::filesystem::path& statePath) {
+			auto tempPath = statePath;
+			tempPath += ".tmp";
+			std::error_code ec{};
+			try {
+				state.save(tempPath);
+			}
+			catch (const std::ios_base::failure&) {
+				std::filesystem::remove(tempPath, ec);
+				return;
+			}
+			std::filesystem::rename(tempPath, statePath, ec);
+			if (ec) {
+				std::filesystem::remove(tempPath, ec);
+			}
+		}
+	}
+
+	ResultCache::ResultCache(const std::size_t maxEntries, std::optional<std::filesystem::path> directory) :
+		maxEntries_(std::max<std::size_t>(maxEntries, 1)),
+		directory_(std::move(directory))
+	{}
+
+	std::uint64_t ResultCache::keyOf(const Domain::BondReturnData& tenorData) noexcept {
+		const auto& tenors = tenorData.tenors();
+		const int numMonths = tenorData.numMonths();
+		const auto grid = tenorData.grid();
+		// The shape is hashed as well as the grid, since the same returns split into rows of another length differ:
+		std::uint64_t hash = Helpers::Hash::hashBytes(tenors.data(), tenors.size() * sizeof(int));
+		hash = Helpers::Hash::hashBytes(&numMonths, sizeof(numMonths), hash);
+		return Helpers::Hash::hashBytes(grid.data(), grid.size_bytes(), hash);
+	}
+
+	bool ResultCache::get(
+		const Domain::BondReturnData& tenorData,
+		const int numResultsRequested,
+		OptimalResults& results,
+		const OptimiserOptions& options
+	) {
+		if (options.lowMemory || options.distinctPurchases) {
+			getOptimalSequences(tenorData, numResultsRequested, results, options);
+			const std::lock_guard lock(mutex_);
+			++runs_;
+			return false;
+		}
+
+		// Matches a state against the data as well as the key, to guard against collisions and stale files:
+		const auto answers = [&](const OptimiserState& state) {
+			return state.numResultsRequested() >= numResultsRequested
+				&& state.numMonths() == tenorData.numMonths()
+				&& state.canExtendWith(tenorData);
+		};
+
+		const Key key{keyOf(tenorData), options.logSpace};
+		std::shared_ptr<const OptimiserState> held{};
+		{
+			const std::lock_guard lock(mutex_);
+			if (const auto it = entries_.find(key); it != entries_.end() && answers(*it->second.state)) {
+				it->second.lastUsed = ++clock_;
+				++hits_;
+				held = it->second.state;
+			}
+		}
+		if (held) {
+			// States are never changed once held, so reconstructing from one needs no lock:
+			held->results(results, numResultsRequested);
+			return true;
+		}
+
+		if (directory_) {
+			std::shared_ptr<const OptimiserState> state{};
+			try {
+				state = std::make_shared<const OptimiserState>(OptimiserState::load(statePath(key)));
+			}
+			catch (const OptimiserStateError&) {
+				// Missing, unreadable or malformed, so run as if it were never saved.
+			}
+			if (state && state->logSpace() == options.logSpace && answers(*state)) {
+				state->results(results, numResultsRequested);
+				const std::lock_guard lock(mutex_);
+				++diskHits_;
+				insert(key, std::move(state));
+				return true;
+			}
+		}
+
+		auto state = std::make_shared<const OptimiserState>(tenorData, numResultsRequested, options);
+		state->results(results);
+
+		if (directory_) {
+			Detail::trySaveState(*state, statePath(key));
+		}
+
+		const std::lock_guard lock(mutex_);
+		++runs_;
+		insert(key, std::move(state));
+		return false;
+	}
+
+	ResultCache::Stats ResultCache::stats() const {
+		const std::lock_guard lock(mutex_);
+		return {.entries = entries_.size(), .hits = hits_, .diskHits = diskHits_, .runs = runs_};
+	}
+
+	std::filesystem::path ResultCache::statePath(const Key& key) const {
+		return *directory_ / std::format("{:016x}{}.{}", key.first, key.second ? "-log" : "", optimiserStateExtension);
+	}
+
+	void ResultCache::insert(const Key& key, std::shared_ptr<const OptimiserState> state) {
+		const auto [it, inserted] = entries_.try_emplace(key);
+		const OptimiserState* const previous = it->second.state.get();
+		if (
+			inserted
+			|| previous->numResultsRequested() <= state->numResultsRequested()
+			|| previous->numMonths() != state->numMonths()
+			|| previous->tenors() != state->tenors()
+		) {
+			it->second.state = std::move(state);
+		}
+		it->second.lastUsed = ++clock_;
+		if (entries_.size() > maxEntries_) {
+			entries_.erase(std::ranges::min_element(entries_, {}, [](const auto& entry) {
+				return entry.second.lastUsed;
+			}));
+		}
+	}
+}
\ No newline at end of file
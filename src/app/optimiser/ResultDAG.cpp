@@ -0,0 +1,110 @@
+#include "app/optimiser/ResultDAG.hpp"
+
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	ResultDAG::ReverseIterator::ReverseIterator(const ResultDAG& dag, const std::uint32_t node) noexcept :
+		dag_(&dag),
+		node_(node),
+		startMonth_(dag.numMonths_),
+		done_(false)
+	{
+		advance();
+	}
+
+	void ResultDAG::ReverseIterator::advance() noexcept {
+		// The current action starts in the month of node_, so the one before it ends there:
+		if (startMonth_ == 0) {
+			done_ = true;
+			return;
+		}
+		const auto& nodes = dag_->nodes_;
+		if (nodes[node_].tenorCode == 0) {
+			// Rather than a 1-month wait per month, contiguous waits are merged into a single action:
+			int waitStreak = 0;
+			while (startMonth_ > 0 && nodes[node_].tenorCode == 0) {
+				node_ = nodes[node_].parent;
+				--startMonth_;
+				++waitStreak;
+			}
+			action_ = Domain::InvestmentAction::Action::Wait;
+			length_ = waitStreak;
+			return;
+		}
+		const int tenor = dag_->tenors_[static_cast<std::size_t>(nodes[node_].tenorCode - 1)];
+		node_ = nodes[node_].parent;
+		startMonth_ -= tenor;
+		action_ = Domain::InvestmentAction::Action::Buy;
+		length_ = tenor;
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	ResultDAG::ResultDAG(
+		std::vector<int> tenors,
+		const int numMonths,
+		std::vector<Node> nodes,
+		std::vector<std::uint32_t> roots,
+		std::vector<double> CRFs,
+		const bool logSpace
+	) noexcept :
+		tenors_(std::move(tenors)),
+		numMonths_(numMonths),
+		nodes_(std::move(nodes)),
+		roots_(std::move(roots)),
+		CRFs_(std::move(CRFs)),
+		logSpace_(logSpace)
+	{}
+
+	double ResultDAG::CRF(const std::size_t i) const noexcept {
+		return logSpace_ ? std::exp(CRFs_[i]) : CRFs_[i];
+	}
+
+	std::size_t ResultDAG::bytes() const noexcept {
+		return nodes_.capacity() * sizeof(Node)
+			+ roots_.capacity() * sizeof(std::uint32_t)
+			+ CRFs_.capacity() * sizeof(double)
+			+ tenors_.capacity() * sizeof(int);
+	}
+
+	void ResultDAG::unfoldPath(const std::size_t i, std::vector<Domain::InvestmentAction>& path) const {
+		path.clear();
+		std::ranges::copy(reversePath(i), std::back_inserter(path));
+		std::ranges::reverse(path);
+	}
+
+	void ResultDAG::unfold(const std::size_t firstRank, const std::size_t numResults, OptimalResults& block) const {
+		block.actions.clear();
+		block.pathOffsets.resize(numResults + 1);
+		block.pathOffsets[0] = 0;
+		for (std::size_t i = 0; i < numResults; ++i) {
+			const auto pathStart = static_cast<std::ptrdiff_t>(block.actions.size());
+			std::ranges::copy(reversePath(firstRank + i), std::back_inserter(block.actions));
+			std::reverse(block.actions.begin() + pathStart, block.actions.end());
+			block.pathOffsets[i + 1] = block.actions.size();
+		}
+		const auto CRFs = std::span(CRFs_).subspan(firstRank, numResults);
+		block.CRFs.assign(CRFs.begin(), CRFs.end());
+		block.logSpace = logSpace_;
+	}
+
+	OptimalResults ResultDAG::unfold() const {
+		OptimalResults results{};
+		unfold(0, size(), results);
+		if (results.size() == 0) {
+			results.pathOffsets.clear();
+		}
+		return results;
+	}
+}
\ No newline at end of file
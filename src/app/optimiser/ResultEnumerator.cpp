@@ -0,0 +1,350 @@
+#include "app/optimiser/ResultEnumerator.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/optimiser/DecisionStore.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/ForwardPass.hpp"
+#include "app/optimiser/KWayMerge.hpp"
+#include "app/optimiser/PathReconstruction.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace DynamicOptimiser
+{
+	namespace Detail::Enumeration
+	{
+		// The relative slack given to the bound on a path's final CRF. The bound is found in a different order from
+		// the CRFs it bounds, so is rounded differently, and the slack ensures that no path which only just meets the
+		// threshold is pruned. Rounding over even a million months stays well below this.
+		constexpr double boundSlack = 1e-9;
+
+		/// Returns log(exp(bestLogCRF) - margin), or -inf if the margin is at least the best CRF, without leaving log
+		/// space (in which exp(bestLogCRF) may not fit in a double).
+		[[nodiscard]] static double logBelow(const double bestLogCRF, const double margin) noexcept {
+			if (margin == 0.0) {
+				return bestLogCRF;
+			}
+			const double ratio = margin * std::exp(-bestLogCRF);
+			return ratio >= 1.0 ? -std::numeric_limits<double>::infinity() : bestLogCRF + std::log1p(-ratio);
+		}
+
+		/// Orders candidates as the loser tree merge does, so that a max-heap pops the greatest CRF first,
+		/// and of equal CRFs, the lowest tenor code (waiting, then shorter tenors).
+		template <typename C>
+		[[nodiscard]] static bool popsAfter(const C& a, const C& b) noexcept {
+			return a.CRF < b.CRF || (a.CRF == b.CRF && a.tenorCode > b.tenorCode);
+		}
+
+		/// Reads the ranked paths of every month as a decision store, for walking the paths taken.
+		template <typename Months>
+		struct RankedDecisions
+		{
+			const Months& months;
+
+			[[nodiscard]] Decision get(const int month, const int rank) const noexcept {
+				const auto& path = months[month].paths[rank];
+				return {path.tenorCode, path.prevRank};
+			}
+		};
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	ResultEnumerator::ResultEnumerator(Domain::BondReturnData tenorData, const OptimiserOptions& options) :
+		tenorData_(std::move(tenorData)),
+		logSpace_(options.logSpace)
+	{
+		prepare();
+	}
+
+	ResultEnumerator::ResultEnumerator(
+		Domain::BondReturnData tenorData,
+		const CRFThreshold& threshold,
+		const OptimiserOptions& options
+	) :
+		tenorData_(std::move(tenorData)),
+		logSpace_(options.logSpace)
+	{
+		assertCanPrune(threshold);
+		prepare();
+		setThreshold(threshold);
+	}
+
+	void ResultEnumerator::prepare() {
+		if (logSpace_) {
+			Detail::ForwardPass::assertLogSpaceValid(tenorData_, 1, tenorData_.numMonths());
+		}
+		months_.resize(static_cast<std::size_t>(tenorData_.numMonths()) + 1);
+		findBestPaths();
+		// As with getOptimalSequences, there is nothing to find without any months or tenors:
+		if (tenorData_.numMonths() == 0 || tenorData_.numTenors() == 0) {
+			clearResults();
+		}
+	}
+
+	int ResultEnumerator::predecessor(const int month, const int tenorCode) const noexcept {
+		return month - (tenorCode == 0 ? 1 : tenorData_.tenors()[tenorCode - 1]);
+	}
+
+	ResultEnumerator::Candidate ResultEnumerator::candidate(
+		const int month,
+		const int tenorCode,
+		const int prevRank
+	) const {
+		const int prevMonth = predecessor(month, tenorCode);
+		const double bondReturn = tenorCode == 0 ? 0.0 : tenorData_(tenorCode - 1, prevMonth);
+		const double prevCRF = months_[prevMonth].paths[prevRank].CRF;
+		const double CRF = logSpace_
+			? Merge::LogCRFs::apply(prevCRF, Merge::LogCRFs::factor(bondReturn), month)
+			: Merge::ProductCRFs::apply(prevCRF, Merge::ProductCRFs::factor(bondReturn), month);
+		return {CRF, tenorCode, prevRank};
+	}
+
+	void ResultEnumerator::findBestPaths() {
+		months_[0].paths.push_back({logSpace_ ? Merge::LogCRFs::initialCRF : Merge::ProductCRFs::initialCRF, 0, 0});
+		// Only one path reaches month 0, having "waited" there.
+		months_[0].exhausted = true;
+
+		const auto& tenorList = tenorData_.tenors();
+		for (int month = 1; month <= tenorData_.numMonths(); ++month) {
+			Candidate best = candidate(month, 0, 0);
+			// Tenors are tried in order, and only a strictly greater CRF replaces the best, as in the merge:
+			for (int i = 0; i < tenorData_.numTenors() && tenorList[i] <= month; ++i) {
+				if (const Candidate next = candidate(month, i + 1, 0); next.CRF > best.CRF) {
+					best = next;
+				}
+			}
+			months_[month].paths.push_back({best.CRF, best.tenorCode, best.prevRank});
+		}
+	}
+
+	void ResultEnumerator::assertCanPrune(const CRFThreshold& threshold) const {
+		if (std::isnan(threshold.value)) {
+			throw std::invalid_argument("CRF threshold must be a number");
+		}
+		if (threshold.kind == CRFThreshold::Kind::BelowBest && threshold.value < 0.0) {
+			throw std::invalid_argument("CRF threshold margin below the best cannot be negative");
+		}
+
+		const int numMonths = tenorData_.numMonths();
+		const auto& tenorList = tenorData_.tenors();
+		// A path's final CRF is bounded by its CRF so far times the best factor to come, which only holds if no factor
+		// is negative (reversing the ranking). Log space already requires every factor to be positive.
+		if (!logSpace_) {
+			for (int i = 0; i < tenorData_.numTenors(); ++i) {
+				for (int month = 0; month + tenorList[i] <= numMonths; ++month) {
+					if (1.0 + tenorData_(i, month) < 0.0) {
+						throw std::domain_error(
+							std::format(
+								"pruning by a CRF threshold needs every bond return to be at least -100%, "
+								"but the {}-month bond at month {} returns {:.2f}%",
+								tenorList[i],
+								month,
+								100 * tenorData_(i, month)
+							)
+						);
+					}
+				}
+			}
+		}
+	}
+
+	void ResultEnumerator::setThreshold(const CRFThreshold& threshold) {
+		if (months_.back().paths.empty()) {
+			return;
+		}
+
+		const int numMonths = tenorData_.numMonths();
+		const auto& tenorList = tenorData_.tenors();
+
+		const auto factor = [&](const double bondReturn) {
+			return logSpace_ ? Merge::LogCRFs::factor(bondReturn) : Merge::ProductCRFs::factor(bondReturn);
+		};
+		const auto combine = [&](const double a, const double b) {
+			return logSpace_ ? Merge::LogCRFs::combine(a, b) : Merge::ProductCRFs::combine(a, b);
+		};
+		const double identity = logSpace_ ? Merge::LogCRFs::initialCRF : Merge::ProductCRFs::initialCRF;
+
+		// The best way to complete a path from a month either waits, or buys a tenor ending by the final month, and
+		// then completes it in the best way from there. Large factors may overflow to infinity here, which only
+		// loosens the bound, the forward pass still reporting any CRF that does overflow.
+		bestSuffixFactors_.assign(static_cast<std::size_t>(numMonths) + 1, identity);
+		for (int month = numMonths - 1; month >= 0; --month) {
+			double best = combine(bestSuffixFactors_[month + 1], factor(0.0));
+			for (int i = 0; i < tenorData_.numTenors() && month + tenorList[i] <= numMonths; ++i) {
+				best = std::max(best, combine(factor(tenorData_(i, month)), bestSuffixFactors_[month + tenorList[i]]));
+			}
+			bestSuffixFactors_[month] = best;
+		}
+
+		const double bestCRF = months_.back().paths.front().CRF;
+		if (threshold.kind == CRFThreshold::Kind::AtLeast) {
+			threshold_ = !logSpace_
+				? threshold.value
+				: threshold.value > 0.0 ? std::log(threshold.value) : -std::numeric_limits<double>::infinity();
+		}
+		else {
+			threshold_ = logSpace_
+				? Detail::Enumeration::logBelow(bestCRF, threshold.value)
+				: bestCRF - threshold.value;
+		}
+		if (!canMeetThreshold(bestCRF, numMonths)) {
+			clearResults();
+		}
+	}
+
+	bool ResultEnumerator::canMeetThreshold(const double CRF, const int month) const noexcept {
+		if (bestSuffixFactors_.empty()) {
+			return true;
+		}
+		// The final month's CRFs are the results themselves, so are compared exactly:
+		if (month == tenorData_.numMonths()) {
+			return CRF >= threshold_;
+		}
+		const double suffix = bestSuffixFactors_[month];
+		if (logSpace_) {
+			return CRF + suffix + Detail::Enumeration::boundSlack * (std::abs(CRF) + std::abs(suffix) + 1.0)
+				>= threshold_;
+		}
+		// A CRF of 0 remains 0 however large the factors to come (which may be infinite):
+		return (CRF == 0.0 ? 0.0 : CRF * suffix * (1.0 + Detail::Enumeration::boundSlack)) >= threshold_;
+	}
+
+	void ResultEnumerator::clearResults() noexcept {
+		// No month follows the final month, so its paths are never needed to find another month's.
+		months_.back().paths.clear();
+		months_.back().exhausted = true;
+	}
+
+	void ResultEnumerator::findNextPath(const int month) {
+		const auto& tenorList = tenorData_.tenors();
+		pending_.push_back(month);
+
+		while (!pending_.empty()) {
+			const int current = pending_.back();
+			MonthPaths& currentPaths = months_[current];
+
+			// The next rank through the edge the latest rank came from, which is the only candidate not yet known:
+			const RankedPath& latest = currentPaths.paths.back();
+			const int prevMonth = predecessor(current, latest.tenorCode);
+			const int nextPrevRank = latest.prevRank + 1;
+			MonthPaths& prevPaths = months_[prevMonth];
+			if (nextPrevRank >= static_cast<int>(prevPaths.paths.size()) && !prevPaths.exhausted) {
+				// The predecessor's next rank must be found first, and is always exactly this one, since its
+				// previous rank has already been used here.
+				pending_.push_back(prevMonth);
+				continue;
+			}
+
+			if (!currentPaths.candidatesInitialised) {
+				// Every other edge's best path, the best path's own edge being replaced below:
+				for (int tenorCode = 0; tenorCode <= tenorData_.numTenors(); ++tenorCode) {
+					if (tenorCode > 0 && tenorList[tenorCode - 1] > current) {
+						break;
+					}
+					if (tenorCode == latest.tenorCode) {
+						continue;
+					}
+					if (const Candidate c = candidate(current, tenorCode, 0); canMeetThreshold(c.CRF, current)) {
+						currentPaths.candidates.push_back(c);
+					}
+				}
+				std::ranges::make_heap(currentPaths.candidates, Detail::Enumeration::popsAfter<Candidate>);
+				currentPaths.candidatesInitialised = true;
+			}
+			if (nextPrevRank < static_cast<int>(prevPaths.paths.size())) {
+				// Later ranks through this edge only have lower CRFs, so once one cannot meet the threshold, the edge
+				// is finished with.
+				if (
+					const Candidate c = candidate(current, latest.tenorCode, nextPrevRank);
+					canMeetThreshold(c.CRF, current)
+				) {
+					currentPaths.candidates.push_back(c);
+					std::ranges::push_heap(currentPaths.candidates, Detail::Enumeration::popsAfter<Candidate>);
+				}
+			}
+
+			if (currentPaths.candidates.empty()) {
+				currentPaths.exhausted = true;
+			}
+			else {
+				std::ranges::pop_heap(currentPaths.candidates, Detail::Enumeration::popsAfter<Candidate>);
+				const Candidate best = currentPaths.candidates.back();
+				currentPaths.candidates.pop_back();
+				currentPaths.paths.push_back({best.CRF, best.tenorCode, best.prevRank});
+			}
+			pending_.pop_back();
+		}
+	}
+
+	bool ResultEnumerator::exhausted() const noexcept {
+		const MonthPaths& finalPaths = months_.back();
+		return finalPaths.exhausted && numTaken_ == static_cast<int>(finalPaths.paths.size());
+	}
+
+	int ResultEnumerator::next(const int count, OptimalResults& results) {
+		if (count < 0) {
+			throw std::invalid_argument("Cannot request a negative number of results");
+		}
+
+		const int numMonths = tenorData_.numMonths();
+		MonthPaths& finalPaths = months_.back();
+		const int firstRank = numTaken_;
+		const std::int64_t endRank = static_cast<std::int64_t>(firstRank) + count;
+		while (static_cast<std::int64_t>(finalPaths.paths.size()) < endRank && !finalPaths.exhausted) {
+			findNextPath(numMonths);
+		}
+		const int numFound = std::min(count, static_cast<int>(finalPaths.paths.size()) - firstRank);
+
+		const Detail::Enumeration::RankedDecisions<std::vector<MonthPaths>> decisions{months_};
+		Detail::PathReconstruction::PathCollector collector(numFound);
+		collector.walkStage([&](const int rank, std::vector<Domain::InvestmentAction>& buffer) {
+			Detail::PathReconstruction::PathWalker walker(numMonths, firstRank + rank);
+			walker.walkBackTo(0, decisions, 0, tenorData_.tenors(), buffer);
+			walker.finish(buffer);
+		});
+		collector.assemble(results);
+
+		results.CRFs.clear();
+		for (int rank = firstRank; rank < firstRank + numFound; ++rank) {
+			results.CRFs.push_back(finalPaths.paths[rank].CRF);
+		}
+		results.logSpace = logSpace_;
+		numTaken_ += numFound;
+		return numFound;
+	}
+
+	OptimalResults ResultEnumerator::next(const int count) {
+		OptimalResults results{};
+		next(count, results);
+		return results;
+	}
+
+	OptimalResults getOptimalSequencesWithin(
+		const Domain::BondReturnData& tenorData,
+		const CRFThreshold& threshold,
+		const OptimiserOptions& options
+	) {
+		OptimalResults results{};
+		getOptimalSequencesWithin(tenorData, threshold, results, options);
+		return results;
+	}
+
+	void getOptimalSequencesWithin(
+		const Domain::BondReturnData& tenorData,
+		const CRFThreshold& threshold,
+		OptimalResults& results,
+		const OptimiserOptions& options
+	) {
+		ResultEnumerator enumerator(tenorData, threshold, options);
+		enumerator.next(std::numeric_limits<int>::max(), results);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "app/service/CurveCache.hpp"
+
+#include "app/domain/BondReturnData.hpp"
+#include "app/io/DataLoader.hpp"
+#include "app/io/LoadError.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+namespace Service
+{
+	CurveCache::CurveCache(const std::size_t maxCurves, const IO::Input::LoadOptions loadOptions) :
+		maxCurves_(std::max<std::size_t>(maxCurves, 1)),
+		loadOptions_(loadOptions)
+	{}
+
+	std::shared_ptr<const Domain::BondReturnData> CurveCache::get(const std::filesystem::path& curvePath) {
+		// Stamped before loading, so that a write during the load is seen as a change on the next lookup:
+		std::error_code ec{};
+		const auto modified = std::filesystem::last_write_time(curvePath, ec);
+		const auto size = ec ? 0 : std::filesystem::file_size(curvePath, ec);
+		if (ec) {
+			throw IO::Input::LoadError(std::format("cannot open\n{}", curvePath.string()));
+		}
+
+		{
+			const std::lock_guard lock(mutex_);
+			if (const auto it = entries_.find(curvePath); it != entries_.end()) {
+				if (it->second.modified == modified && it->second.size == size) {
+					it->second.lastUsed = ++clock_;
+					++hits_;
+					return it->second.data;
+				}
+			}
+		}
+
+		auto data = std::make_shared<const Domain::BondReturnData>(
+			IO::Input::loadBondReturnData(curvePath.string(), loadOptions_)
+		);
+
+		const std::lock_guard lock(mutex_);
+		++loads_;
+		entries_.insert_or_assign(curvePath, Entry{
+			.data = data,
+			.modified = modified,
+			.size = size,
+			.lastUsed = ++clock_
+		});
+		if (entries_.size() > maxCurves_) {
+			entries_.erase(std::ranges::min_element(entries_, {}, [](const auto& entry) {
+				return entry.second.lastUsed;
+			}));
+		}
+		return data;
+	}
+
+	CurveCache::Stats CurveCache::stats() const {
+		const std::lock_guard lock(mutex_);
+		Stats stats{.hits = hits_, .loads = loads_};
+		stats.curves.reserve(entries_.size());
+		for (const auto& [path, entry] : entries_) {
+			stats.curves.push_back({
+				.path = path,
+				.tenors = entry.data->tenors(),
+				.numMonths = entry.data->numMonths()
+			});
+		}
+		return stats;
+	}
+}
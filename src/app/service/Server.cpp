@@ -0,0 +1,582 @@
+#include "app/service/Server.hpp"
+
+#include "app/cli/Arguments.hpp"
+#include "app/cli/OutputMessages.hpp"
+#include "app/domain/BondReturnData.hpp"
+#include "app/domain/InvestmentAction.hpp"
+#include "app/io/LoadError.hpp"
+#include "app/io/ResultsOutput.hpp"
+#include "app/optimiser/DynamicOptimiser.hpp"
+#include "app/optimiser/MemoryEstimate.hpp"
+#include "app/optimiser/ResultCache.hpp"
+#include "helpers/Parallel.hpp"
+#include "helpers/Socket.hpp"
+#include "helpers/Strings.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Service
+{
+	namespace Detail
+	{
+		// Requests are only ever a line of parameters, so anything larger is refused rather than read.
+		constexpr std::size_t maxHeaderBytes = 16 * 1024;
+		constexpr std::size_t maxBodyBytes = 16 * 1024;
+		// Connections accepted but not yet taken by a worker, per worker, beyond which they are turned away.
+		constexpr std::size_t pendingPerWorker = 16;
+		// How long accept waits between checks for stop, and how long a client may stall mid-request.
+		constexpr std::chrono::milliseconds acceptTimeout{250};
+		constexpr std::chrono::milliseconds receiveTimeout{10'000};
+
+		/// Thrown while answering a request to reply with an error instead.
+		struct RequestError final : std::runtime_error
+		{
+			RequestError(const int s, const std::string& message) : std::runtime_error(message), status(s) {}
+
+			int status;
+		};
+
+		[[nodiscard]] static std::string_view reasonPhrase(const int status) noexcept {
+			switch (status) {
+				case 200: return "OK";
+				case 400: return "Bad Request";
+				case 404: return "Not Found";
+				case 405: return "Method Not Allowed";
+				case 413: return "Content Too Large";
+				case 422: return "Unprocessable Content";
+				case 431: return "Request Header Fields Too Large";
+				case 503: return "Service Unavailable";
+				default: return "Internal Server Error";
+			}
+		}
+
+		[[nodiscard]] static std::string errorBody(const std::string_view message) {
+			return std::format("{{\"error\": {}}}\n", Helpers::Strings::quoteJSON(message));
+		}
+
+		[[nodiscard]] static std::string formatResponse(const Response& response) {
+			return std::format(
+				"HTTP/1.1 {} {}\r\nContent-Type: application/json\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+				response.status,
+				reasonPhrase(response.status),
+				response.body.size(),
+				response.body
+			);
+		}
+
+		/// Decodes "%XX" escapes, and '+' as a space, throwing a RequestError if an escape is malformed.
+		[[nodiscard]] static std::string percentDecode(const std::string_view sv) {
+			std::string decoded{};
+			decoded.reserve(sv.size());
+			for (std::size_t i = 0; i < sv.size(); ++i) {
+				if (sv[i] == '+') {
+					decoded += ' ';
+				}
+				else if (sv[i] == '%') {
+					unsigned int byte = 0;
+					if (
+						i + 2 >= sv.size()
+						|| std::from_chars(sv.data() + i + 1, sv.data() + i + 3, byte, 16).ptr != sv.data() + i + 3
+					) {
+						throw RequestError(400, "malformed percent-encoding");
+					}
+					decoded += static_cast<char>(byte);
+					i += 2;
+				}
+				else {
+					decoded += sv[i];
+				}
+			}
+			return decoded;
+		}
+
+		/// Parses "name=value&..." into its parameters, a later value for a name replacing an earlier one.
+		static void parseParameters(const std::string_view sv, std::map<std::string, std::string>& parameters) {
+			for (std::size_t begin = 0; begin < sv.size();) {
+				const std::size_t end = std::min(sv.find('&', begin), sv.size());
+				const std::string_view pair = sv.substr(begin, end - begin);
+				if (!pair.empty()) {
+					const std::size_t equalsPos = pair.find('=');
+					const std::string_view name = pair.substr(0, equalsPos);
+					const std::string_view value = equalsPos == std::string_view::npos
+						? std::string_view{}
+						: pair.substr(equalsPos + 1);
+					parameters.insert_or_assign(percentDecode(name), percentDecode(value));
+				}
+				begin = end + 1;
+			}
+		}
+
+		/// Parses a parameter which is a positive integer, or 0 if allowZero is set.
+		[[nodiscard]] static int parseCount(
+			const std::string_view sv,
+			const std::string_view name,
+			const bool allowZero
+		) {
+			if (allowZero && sv == "0") {
+				return 0;
+			}
+			try {
+				return Arguments::parsePositiveInt(sv, name);
+			}
+			catch (const Arguments::ArgumentError& e) {
+				throw RequestError(400, e.what());
+			}
+		}
+
+		[[nodiscard]] static bool parseFlag(const std::string_view sv, const std::string_view name) {
+			if (sv.empty() || sv == "1" || Helpers::Strings::svCaseInsensitiveCompare(sv, "true")) {
+				return true;
+			}
+			if (sv == "0" || Helpers::Strings::svCaseInsensitiveCompare(sv, "false")) {
+				return false;
+			}
+			throw RequestError(400, std::format("{} must be 1, 0, true or false, received {}", name, sv));
+		}
+
+		/// Resolves a curve named by a query against the data root, which must be canonical, refusing any path (or
+		/// symlink) leading outside it.
+		[[nodiscard]] static std::filesystem::path resolveCurvePath(
+			const std::filesystem::path& dataRoot,
+			const std::string_view curve
+		) {
+			const std::filesystem::path relativePath(curve);
+			if (curve.empty() || relativePath.has_root_path()) {
+				throw RequestError(400, "curve must be a path relative to the data directory");
+			}
+			std::error_code ec{};
+			const auto curvePath = std::filesystem::weakly_canonical(dataRoot / relativePath, ec);
+			if (ec || std::ranges::mismatch(dataRoot, curvePath).in1 != dataRoot.end()) {
+				throw RequestError(400, "curve must be within the data directory");
+			}
+			if (!std::filesystem::is_regular_file(curvePath, ec)) {
+				throw RequestError(404, std::format("no curve {}", curve));
+			}
+			return curvePath;
+		}
+
+		/// Writes the results, with their HPRs, CRFs (null if beyond a double) and paths, as a JSON array.
+		static void appendResultsJSON(std::string& JSON, const DynamicOptimiser::OptimalResults& results) {
+			auto out = std::back_inserter(JSON);
+			JSON += '[';
+			for (std::size_t i = 0; i < results.size(); ++i) {
+				const double CRF = results.CRF(i);
+				std::format_to(
+					out,
+					"{}\n  {{\"hpr\": \"{}\", \"crf\": {}, \"path\": \"{}\"}}",
+					i == 0 ? "" : ",",
+					IO::Output::formatHoldingPeriodReturn(results, i),
+					std::isfinite(CRF) ? std::format("{}", CRF) : "null",
+					Helpers::Strings::joinFormatted(results.path(i), ",")
+				);
+			}
+			JSON += "\n]";
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	Server::Server(ServerOptions options) :
+		options_(std::move(options)),
+		numWorkers_(options_.numWorkers > 0 ? options_.numWorkers : Helpers::Parallel::hardwareThreads()),
+		dataRoot_([&] {
+			std::error_code ec{};
+			auto root = std::filesystem::canonical(options_.dataRoot, ec);
+			if (ec || !std::filesystem::is_directory(root, ec)) {
+				throw std::invalid_argument(std::format("{} is not a directory", options_.dataRoot.string()));
+			}
+			return root;
+		}()),
+		cache_(options_.maxCurves, {.useBinaryCache = options_.useBinaryCache}),
+		listener_(options_.address, options_.port)
+	{
+		if (options_.resultDirectory) {
+			std::error_code ec{};
+			std::filesystem::create_directories(*options_.resultDirectory, ec);
+			if (ec || !std::filesystem::is_directory(*options_.resultDirectory, ec)) {
+				throw std::invalid_argument(
+					std::format("cannot use {} as a results directory", options_.resultDirectory->string())
+				);
+			}
+		}
+		if (options_.maxCachedResults > 0 || options_.resultDirectory) {
+			resultCache_ = std::make_unique<DynamicOptimiser::ResultCache>(
+				options_.maxCachedResults, options_.resultDirectory
+			);
+		}
+	}
+
+	Server::~Server() = default;
+
+	void Server::run() {
+		std::mutex mutex{};
+		std::condition_variable connectionPending{};
+		std::deque<Helpers::Socket::Connection> pending{};
+		bool closing = false;
+
+		{
+			std::vector<std::jthread> workers{};
+			workers.reserve(numWorkers_);
+			for (unsigned int i = 0; i < numWorkers_; ++i) {
+				workers.emplace_back([&] {
+					// Each query runs on its worker alone, since the other workers already occupy the other threads:
+					std::optional<Helpers::Parallel::SerialScope> serial{};
+					if (numWorkers_ > 1) {
+						serial.emplace();
+					}
+					DynamicOptimiser::Workspace workspace{};
+					DynamicOptimiser::OptimalResults results{};
+					while (true) {
+						std::unique_lock lock(mutex);
+						connectionPending.wait(lock, [&] { return !pending.empty() || closing; });
+						if (pending.empty()) {
+							return;
+						}
+						auto connection = std::move(pending.front());
+						pending.pop_front();
+						lock.unlock();
+						serve(connection, workspace, results);
+					}
+				});
+			}
+
+			while (!stopping_.load(std::memory_order_relaxed)) {
+				auto connection = listener_.accept(Detail::acceptTimeout);
+				if (!connection) {
+					continue;
+				}
+				std::unique_lock lock(mutex);
+				if (pending.size() >= Detail::pendingPerWorker * numWorkers_) {
+					lock.unlock();
+					try {
+						connection->sendAll(Detail::formatResponse({
+							.status = 503,
+							.body = Detail::errorBody("too many requests waiting, try again shortly")
+						}));
+					}
+					catch (const Helpers::Socket::SocketError&) {
+						// The client has gone, so there is no one to tell.
+					}
+					continue;
+				}
+				pending.push_back(std::move(*connection));
+				lock.unlock();
+				connectionPending.notify_one();
+			}
+
+			{
+				const std::lock_guard lock(mutex);
+				closing = true;
+			}
+			connectionPending.notify_all();
+			// The jthreads join on leaving scope, once the connections already accepted have been answered.
+		}
+	}
+
+	void Server::serve(
+		Helpers::Socket::Connection& connection,
+		DynamicOptimiser::Workspace& workspace,
+		DynamicOptimiser::OptimalResults& results
+	) {
+		connection.setReceiveTimeout(Detail::receiveTimeout);
+		const auto startTime = std::chrono::steady_clock::now();
+
+		std::string request{};
+		std::array<char, 4096> buffer{};
+		const auto receiveMore = [&] {
+			const std::size_t received = connection.receive(buffer);
+			request.append(buffer.data(), received);
+			return received > 0;
+		};
+
+		std::string_view method{};
+		std::string_view target{};
+		Response response{};
+		try {
+			std::size_t headerEnd = 0;
+			while ((headerEnd = request.find("\r\n\r\n")) == std::string::npos) {
+				if (request.size() > Detail::maxHeaderBytes) {
+					throw Detail::RequestError(431, "request headers too large");
+				}
+				if (!receiveMore()) {
+					// The client gave up, or stalled, before finishing its request.
+					return;
+				}
+			}
+
+			// The request line is "<method> <target> HTTP/<version>":
+			const std::string_view head = std::string_view(request).substr(0, headerEnd);
+			const std::string_view requestLine = head.substr(0, head.find("\r\n"));
+			const std::size_t methodEnd = requestLine.find(' ');
+			const std::size_t targetEnd = requestLine.rfind(' ');
+			if (methodEnd == std::string_view::npos || targetEnd == methodEnd) {
+				throw Detail::RequestError(400, "malformed request line");
+			}
+
+			std::size_t contentLength = 0;
+			for (std::size_t lineBegin = requestLine.size() + 2; lineBegin < head.size();) {
+				const std::size_t lineEnd = std::min(head.find("\r\n", lineBegin), head.size());
+				const std::string_view line = head.substr(lineBegin, lineEnd - lineBegin);
+				constexpr std::string_view contentLengthName = "content-length:";
+				const std::string_view name = line.substr(0, std::min(line.size(), contentLengthName.size()));
+				if (Helpers::Strings::svCaseInsensitiveCompare(name, contentLengthName)) {
+					std::string_view value = line.substr(contentLengthName.size());
+					Helpers::Strings::svTrimWhitespaceInPlace(value);
+					const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), contentLength);
+					if (ec != std::errc{} || ptr != value.data() + value.size()) {
+						throw Detail::RequestError(400, "malformed Content-Length");
+					}
+				}
+				lineBegin = lineEnd + 2;
+			}
+			if (contentLength > Detail::maxBodyBytes) {
+				throw Detail::RequestError(413, "request body too large");
+			}
+			const std::size_t bodyBegin = headerEnd + 4;
+			while (request.size() - bodyBegin < contentLength) {
+				if (!receiveMore()) {
+					return;
+				}
+			}
+
+			// Taken only now the request is complete, since receiving may have moved it:
+			const std::string_view requestView(request);
+			method = requestView.substr(0, methodEnd);
+			target = requestView.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+			response = handle(method, target, requestView.substr(bodyBegin, contentLength), workspace, results);
+		}
+		catch (const Detail::RequestError& e) {
+			response = {.status = e.status, .body = Detail::errorBody(e.what())};
+		}
+
+		try {
+			connection.sendAll(Detail::formatResponse(response));
+		}
+		catch (const Helpers::Socket::SocketError&) {
+			// The client has gone, so there is no one to tell.
+		}
+
+		if (!options_.quiet) {
+			const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - startTime;
+			std::println("{} {} -> {} in {:.3f} ms", method, target, response.status, time.count());
+		}
+	}
+
+	Response Server::handle(
+		const std::string_view method,
+		const std::string_view target,
+		const std::string_view body,
+		DynamicOptimiser::Workspace& workspace,
+		DynamicOptimiser::OptimalResults& results
+	) {
+		try {
+			const std::size_t queryPos = target.find('?');
+			const std::string_view path = target.substr(0, queryPos);
+			const std::string_view query = queryPos == std::string_view::npos
+				? std::string_view{}
+				: target.substr(queryPos + 1);
+
+			if (path == "/health" || path == "/curves") {
+				if (method != "GET") {
+					throw Detail::RequestError(405, std::format("{} only accepts GET", path));
+				}
+				if (path == "/health") {
+					return {.body = std::format("{{\"status\": \"ok\", \"workers\": {}}}\n", numWorkers_)};
+				}
+				const auto stats = cache_.stats();
+				std::string JSON = "{\"curves\": [";
+				for (std::size_t i = 0; i < stats.curves.size(); ++i) {
+					const auto& curve = stats.curves[i];
+					std::format_to(
+						std::back_inserter(JSON),
+						"{}\n  {{\"path\": {}, \"tenors\": [{}], \"months\": {}}}",
+						i == 0 ? "" : ",",
+						Helpers::Strings::quoteJSON(curve.path.string()),
+						Helpers::Strings::joinFormatted(curve.tenors, ", "),
+						curve.numMonths
+					);
+				}
+				std::format_to(std::back_inserter(JSON), "\n], \"hits\": {}, \"loads\": {}", stats.hits, stats.loads);
+				if (resultCache_) {
+					const auto resultStats = resultCache_->stats();
+					std::format_to(
+						std::back_inserter(JSON),
+						", \"results\": {{\"entries\": {}, \"hits\": {}, \"disk_hits\": {}, \"runs\": {}}}",
+						resultStats.entries,
+						resultStats.hits,
+						resultStats.diskHits,
+						resultStats.runs
+					);
+				}
+				JSON += "}\n";
+				return {.body = std::move(JSON)};
+			}
+
+			if (path != "/optimise") {
+				throw Detail::RequestError(404, std::format("no such endpoint {}", path));
+			}
+			if (method != "GET" && method != "POST") {
+				throw Detail::RequestError(405, "/optimise only accepts GET or POST");
+			}
+
+			std::map<std::string, std::string> parameters{};
+			Detail::parseParameters(query, parameters);
+			if (method == "POST") {
+				Detail::parseParameters(body, parameters);
+			}
+			for (const auto& name : parameters | std::views::keys) {
+				if (name != "curve" && name != "k" && name != "start" && name != "months" && name != "log"
+					&& name != "distinct") {
+					throw Detail::RequestError(400, std::format("unknown parameter {}", name));
+				}
+			}
+			const auto parameter = [&](const std::string& name) -> std::optional<std::string_view> {
+				if (const auto it = parameters.find(name); it != parameters.end()) {
+					return it->second;
+				}
+				return std::nullopt;
+			};
+
+			const auto curve = parameter("curve");
+			const auto numResultsParameter = parameter("k");
+			if (!curve || !numResultsParameter) {
+				throw Detail::RequestError(400, "curve and k must be given");
+			}
+			const int numResultsRequested = Detail::parseCount(*numResultsParameter, "k", false);
+			if (numResultsRequested > options_.maxResults) {
+				throw Detail::RequestError(400, std::format("k may be at most {}", options_.maxResults));
+			}
+
+			const auto curveData = cache_.get(Detail::resolveCurvePath(dataRoot_, *curve));
+			const int firstMonth = parameter("start")
+				? Detail::parseCount(*parameter("start"), "start", true)
+				: 0;
+			if (firstMonth >= curveData->numMonths()) {
+				throw Detail::RequestError(
+					400, std::format("start must be less than the curve's {} months", curveData->numMonths())
+				);
+			}
+			const int numMonths = parameter("months")
+				? Detail::parseCount(*parameter("months"), "months", false)
+				: curveData->numMonths() - firstMonth;
+			if (numMonths > curveData->numMonths() - firstMonth) {
+				throw Detail::RequestError(400, std::format(
+					"the curve has only {} months from month {}", curveData->numMonths() - firstMonth, firstMonth
+				));
+			}
+
+			// Only a horizon other than the curve's own needs its months copied out:
+			std::optional<Domain::BondReturnData> monthRange{};
+			if (firstMonth != 0 || numMonths != curveData->numMonths()) {
+				monthRange.emplace(curveData->monthRange(firstMonth, numMonths));
+			}
+			const Domain::BondReturnData& tenorData = monthRange ? *monthRange : *curveData;
+
+			DynamicOptimiser::OptimiserOptions optimiserOptions{
+				.logSpace = parameter("log") && Detail::parseFlag(*parameter("log"), "log"),
+				.distinctPurchases = parameter("distinct") && Detail::parseFlag(*parameter("distinct"), "distinct")
+			};
+			int numResultsRun = numResultsRequested;
+			std::string note{};
+			// The workers may all be running at once, so each is fitted to its share of the memory available:
+			const auto memoryBudget = options_.checkMemory ? DynamicOptimiser::defaultMemoryBudget() : std::nullopt;
+			if (memoryBudget) {
+				const auto admission = DynamicOptimiser::admitRun(
+					tenorData, numResultsRequested, optimiserOptions, *memoryBudget / numWorkers_
+				);
+				if (!admission.fits) {
+					throw Detail::RequestError(503, OutputMessages::admissionNote(admission, numResultsRequested));
+				}
+				if (admission.adjusted()) {
+					note = OutputMessages::admissionNote(admission, numResultsRequested);
+				}
+				optimiserOptions = admission.options;
+				numResultsRun = admission.numResultsRequested;
+			}
+
+			bool cached = false;
+			const auto runQuery = [&] {
+				if (resultCache_) {
+					cached = resultCache_->get(tenorData, numResultsRun, results, optimiserOptions);
+				}
+				else {
+					DynamicOptimiser::getOptimalSequences(
+						tenorData, numResultsRun, results, workspace, optimiserOptions
+					);
+				}
+			};
+			const auto startTime = std::chrono::steady_clock::now();
+			try {
+				runQuery();
+			}
+			catch (const std::overflow_error&) {
+				// Products of returns have overflowed, but sums of their logs cannot, so fall back to log space:
+				optimiserOptions.logSpace = true;
+				runQuery();
+				note = "CRFs overflowed, so results were ranked by log returns";
+			}
+			const std::chrono::duration<double, std::milli> computationTime =
+				std::chrono::steady_clock::now() - startTime;
+
+			std::string JSON = std::format(
+				"{{\"curve\": {}, \"start\": {}, \"months\": {}, \"k\": {}, \"found\": {}, \"log_space\": {}"
+				", \"milliseconds\": {:.3f}",
+				Helpers::Strings::quoteJSON(*curve),
+				firstMonth,
+				numMonths,
+				numResultsRequested,
+				results.size(),
+				results.logSpace,
+				computationTime.count()
+			);
+			if (cached) {
+				JSON += ", \"cached\": true";
+			}
+			if (!note.empty()) {
+				std::format_to(std::back_inserter(JSON), ", \"note\": {}", Helpers::Strings::quoteJSON(note));
+			}
+			JSON += ", \"results\": ";
+			Detail::appendResultsJSON(JSON, results);
+			JSON += "}\n";
+			return {.body = std::move(JSON)};
+		}
+		catch (const Detail::RequestError& e) {
+			return {.status = e.status, .body = Detail::errorBody(e.what())};
+		}
+		catch (const IO::Input::LoadError& e) {
+			return {.status = 422, .body = Detail::errorBody(std::format("failed to load curve: {}", e.what()))};
+		}
+		catch (const std::domain_error& e) {
+			return {.status = 422, .body = Detail::errorBody(e.what())};
+		}
+		catch (const std::invalid_argument& e) {
+			return {.status = 400, .body = Detail::errorBody(e.what())};
+		}
+		catch (const std::exception& e) {
+			return {.status = 500, .body = Detail::errorBody(e.what())};
+		}
+	}
+}
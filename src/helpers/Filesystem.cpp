@@ -1,13 +1,17 @@
 #include "helpers/Filesystem.hpp"
 
 #include "helpers/Platform.hpp"
+#include "helpers/Strings.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <filesystem>
 #include <format>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <vector>
 
 namespace Helpers::Filesystem
 {
@@ -91,4 +95,34 @@ namespace Helpers::Filesystem
 		}
 		return expanded.lexically_normal();
 	}
+
+	std::vector<std::filesystem::path> expandGlob(const std::string_view patternSv) {
+		const std::filesystem::path pattern = expandUserPath(patternSv);
+		const std::string filenamePattern = pattern.filename().string();
+
+		if (filenamePattern.find_first_of("*?") == std::string::npos) {
+			return {pattern};
+		}
+
+		const std::filesystem::path dir = getDirectory(pattern);
+		assertDirectoryValid(dir);
+
+		std::vector<std::filesystem::path> matches{};
+		std::error_code ec;
+		for (std::filesystem::directory_iterator it{dir, ec}, end{}; !ec && it != end; it.increment(ec)) {
+			if (std::error_code ecFile; !it->is_regular_file(ecFile) || ecFile) {
+				continue;
+			}
+			if (Strings::svWildcardMatch(filenamePattern, it->path().filename().string())) {
+				matches.push_back(it->path().lexically_normal());
+			}
+		}
+		if (ec) {
+			throw DirectoryError(std::format("cannot read \n{}\n{}", dir.string(), ec.message()));
+		}
+
+		// Directory iteration order is unspecified, so sort for reproducible runs:
+		std::ranges::sort(matches);
+		return matches;
+	}
 }
\ No newline at end of file
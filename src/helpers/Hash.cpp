@@ -0,0 +1,53 @@
+#include "helpers/Hash.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Helpers::Hash
+{
+	namespace Detail
+	{
+		// Odd constants with well-mixed bits (from the golden ratio and MurmurHash3 respectively).
+		constexpr std::uint64_t multiplier1 = 0x9E3779B97F4A7C15ULL;
+		constexpr std::uint64_t multiplier2 = 0xC2B2AE3D27D4EB4FULL;
+
+		[[nodiscard]] static constexpr std::uint64_t mixWord(std::uint64_t hash, std::uint64_t word) noexcept {
+			word *= multiplier1;
+			word ^= word >> 32;
+			hash = (hash ^ word) * multiplier2;
+			return std::rotl(hash, 31);
+		}
+
+		/// The SplitMix64 finaliser, so that every input bit affects every output bit.
+		[[nodiscard]] static constexpr std::uint64_t finalise(std::uint64_t hash) noexcept {
+			hash ^= hash >> 30;
+			hash *= 0xBF58476D1CE4E5B9ULL;
+			hash ^= hash >> 27;
+			hash *= 0x94D049BB133111EBULL;
+			hash ^= hash >> 31;
+			return hash;
+		}
+	}
+
+	std::uint64_t hashBytes(const void* data, const std::size_t size, const std::uint64_t seed) noexcept {
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		// Include the size so that inputs differing only by trailing zero bytes hash differently.
+		std::uint64_t hash = seed ^ (static_cast<std::uint64_t>(size) * Detail::multiplier1);
+
+		std::size_t i = 0;
+		for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+			// memcpy avoids unaligned reads, and compiles to a single load.
+			std::uint64_t word{};
+			std::memcpy(&word, bytes + i, sizeof(word));
+			hash = Detail::mixWord(hash, word);
+		}
+		if (i < size) {
+			std::uint64_t tail{};
+			std::memcpy(&tail, bytes + i, size - i);
+			hash = Detail::mixWord(hash, tail);
+		}
+		return Detail::finalise(hash);
+	}
+}
\ No newline at end of file
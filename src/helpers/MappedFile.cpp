@@ -0,0 +1,123 @@
+#include "helpers/MappedFile.hpp"
+
+#include "helpers/Filesystem.hpp"
+#include "helpers/Platform.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <system_error>
+#include <utility>
+
+#if BSO_IS_WINDOWS
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace Helpers::Filesystem
+{
+	MappedFile::MappedFile(const std::filesystem::path& filePath) {
+		#if BSO_IS_WINDOWS
+			const HANDLE file = CreateFileW(
+				filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+			);
+			if (file == INVALID_HANDLE_VALUE) {
+				throw FileError(std::format("cannot open\n{}", filePath.string()));
+			}
+			LARGE_INTEGER fileSize{};
+			if (!GetFileSizeEx(file, &fileSize)) {
+				CloseHandle(file);
+				throw FileError(std::format("cannot read size of\n{}", filePath.string()));
+			}
+			size_ = static_cast<std::size_t>(fileSize.QuadPart);
+			// Zero-length files cannot be mapped, but are simply empty:
+			if (size_ == 0) {
+				CloseHandle(file);
+				return;
+			}
+			mappingHandle_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			// The mapping keeps the file open, so the handle is no longer needed either way.
+			CloseHandle(file);
+			if (!mappingHandle_) {
+				throw FileError(std::format("cannot map\n{}", filePath.string()));
+			}
+			data_ = static_cast<const char*>(MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0));
+			if (!data_) {
+				CloseHandle(mappingHandle_);
+				throw FileError(std::format("cannot map\n{}", filePath.string()));
+			}
+		#else
+			const int fd = ::open(filePath.c_str(), O_RDONLY);
+			if (fd == -1) {
+				throw FileError(
+					std::format("cannot open\n{}\n{}", filePath.string(), std::generic_category().message(errno))
+				);
+			}
+			struct stat fileStat{};
+			if (::fstat(fd, &fileStat) == -1) {
+				::close(fd);
+				throw FileError(std::format("cannot read size of\n{}", filePath.string()));
+			}
+			size_ = static_cast<std::size_t>(fileStat.st_size);
+			// Zero-length files cannot be mapped, but are simply empty:
+			if (size_ == 0) {
+				::close(fd);
+				return;
+			}
+			void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			// The mapping keeps its own reference to the file, so the descriptor is no longer needed either way.
+			::close(fd);
+			if (mapping == MAP_FAILED) {
+				throw FileError(
+					std::format("cannot map\n{}\n{}", filePath.string(), std::generic_category().message(errno))
+				);
+			}
+			// Files are parsed front to back, so let the kernel read ahead aggressively (this is only a hint):
+			::madvise(mapping, size_, MADV_SEQUENTIAL);
+			data_ = static_cast<const char*>(mapping);
+		#endif
+	}
+
+	MappedFile::~MappedFile() {
+		unmap();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept :
+		data_(std::exchange(other.data_, nullptr)),
+		size_(std::exchange(other.size_, 0)),
+		mappingHandle_(std::exchange(other.mappingHandle_, nullptr))
+	{}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+			mappingHandle_ = std::exchange(other.mappingHandle_, nullptr);
+		}
+		return *this;
+	}
+
+	void MappedFile::unmap() noexcept {
+		#if BSO_IS_WINDOWS
+			if (data_) {
+				UnmapViewOfFile(data_);
+			}
+			if (mappingHandle_) {
+				CloseHandle(mappingHandle_);
+			}
+		#else
+			if (data_) {
+				::munmap(const_cast<char*>(data_), size_);
+			}
+		#endif
+		data_ = nullptr;
+		size_ = 0;
+		mappingHandle_ = nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "helpers/Memory.hpp"
+
+#include "helpers/Platform.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#if BSO_IS_WINDOWS
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+namespace Helpers::Memory
+{
+	std::optional<std::size_t> availableBytes() noexcept {
+		#if BSO_IS_WINDOWS
+			MEMORYSTATUSEX status{};
+			status.dwLength = sizeof(status);
+			if (!GlobalMemoryStatusEx(&status)) {
+				return std::nullopt;
+			}
+			return static_cast<std::size_t>(status.ullAvailPhys);
+		#else
+			#if defined(__linux__)
+				// Free pages alone undercount, since the page cache is given back on demand, so prefer the kernel's
+				// own estimate where there is one:
+				if (std::FILE* const meminfo = std::fopen("/proc/meminfo", "r")) {
+					std::array<char, 256> line{};
+					std::optional<std::size_t> available{};
+					while (std::fgets(line.data(), static_cast<int>(line.size()), meminfo)) {
+						unsigned long long kibibytes = 0;
+						if (std::sscanf(line.data(), "MemAvailable: %llu kB", &kibibytes) == 1) {
+							available = static_cast<std::size_t>(kibibytes) * 1024;
+							break;
+						}
+					}
+					std::fclose(meminfo);
+					if (available) {
+						return available;
+					}
+				}
+			#endif
+			#if defined(_SC_AVPHYS_PAGES) && defined(_SC_PAGESIZE)
+				const long pages = sysconf(_SC_AVPHYS_PAGES);
+				const long pageSize = sysconf(_SC_PAGESIZE);
+				if (pages > 0 && pageSize > 0) {
+					return static_cast<std::size_t>(pages) * static_cast<std::size_t>(pageSize);
+				}
+			#endif
+			return std::nullopt;
+		#endif
+	}
+
+	std::string formatBytes(const std::size_t bytes) {
+		constexpr std::array<std::string_view, 5> units = {"B", "KiB", "MiB", "GiB", "TiB"};
+		auto value = static_cast<double>(bytes);
+		std::size_t unit = 0;
+		while (value >= 1024.0 && unit + 1 < units.size()) {
+			value /= 1024.0;
+			++unit;
+		}
+		return unit == 0 ? std::format("{} B", bytes) : std::format("{:.1f} {}", value, units[unit]);
+	}
+}
@@ -0,0 +1,111 @@
+#include "helpers/Parallel.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace Helpers::Parallel
+{
+	namespace Detail
+	{
+		// 0 means no limit has been set.
+		constinit std::atomic<unsigned int> maxThreadsSetting{0};
+	}
+
+	unsigned int hardwareThreads() noexcept {
+		// hardware_concurrency is allowed to return 0 if the number of threads cannot be determined.
+		const unsigned int numThreads = std::thread::hardware_concurrency();
+		return numThreads > 0 ? numThreads : 1;
+	}
+
+	unsigned int maxThreads() noexcept {
+		if (const unsigned int setting = Detail::maxThreadsSetting.load(std::memory_order_relaxed); setting > 0) {
+			return setting;
+		}
+		return hardwareThreads();
+	}
+
+	void setMaxThreads(const unsigned int numThreads) noexcept {
+		Detail::maxThreadsSetting.store(numThreads, std::memory_order_relaxed);
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	WorkerPool::WorkerPool(const unsigned int numThreads) {
+		const unsigned int numWorkers = numThreads > 1 ? numThreads - 1 : 0;
+		workers_.reserve(numWorkers);
+		for (unsigned int i = 0; i < numWorkers; ++i) {
+			workers_.emplace_back([this] { workerLoop(); });
+		}
+	}
+
+	WorkerPool::~WorkerPool() {
+		{
+			const std::scoped_lock lock(mutex_);
+			stopping_ = true;
+		}
+		roundStarted_.notify_all();
+		// The jthreads join on destruction.
+	}
+
+	void WorkerPool::run(const std::size_t numTasks, const TaskFn call, void* const context) {
+		{
+			const std::scoped_lock lock(mutex_);
+			call_ = call;
+			context_ = context;
+			numTasks_ = numTasks;
+			nextTask_.store(0, std::memory_order_relaxed);
+			busyWorkers_ = static_cast<unsigned int>(workers_.size());
+			++generation_;
+		}
+		roundStarted_.notify_all();
+
+		claimTasks(call, context, numTasks);
+
+		// Every task has been claimed, but the workers may still be running theirs:
+		std::unique_lock lock(mutex_);
+		roundFinished_.wait(lock, [this] { return busyWorkers_ == 0; });
+	}
+
+	void WorkerPool::claimTasks(const TaskFn call, void* const context, const std::size_t numTasks) noexcept {
+		for (
+			std::size_t task = nextTask_.fetch_add(1, std::memory_order_relaxed);
+			task < numTasks;
+			task = nextTask_.fetch_add(1, std::memory_order_relaxed)
+		) {
+			call(context, task);
+		}
+	}
+
+	void WorkerPool::workerLoop() {
+		std::uint64_t seenGeneration = 0;
+		while (true) {
+			TaskFn call = nullptr;
+			void* context = nullptr;
+			std::size_t numTasks = 0;
+			{
+				std::unique_lock lock(mutex_);
+				roundStarted_.wait(lock, [&] { return stopping_ || generation_ != seenGeneration; });
+				if (stopping_) {
+					return;
+				}
+				seenGeneration = generation_;
+				call = call_;
+				context = context_;
+				numTasks = numTasks_;
+			}
+
+			claimTasks(call, context, numTasks);
+
+			{
+				const std::scoped_lock lock(mutex_);
+				if (--busyWorkers_ > 0) {
+					continue;
+				}
+			}
+			roundFinished_.notify_one();
+		}
+	}
+}
\ No newline at end of file
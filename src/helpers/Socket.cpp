@@ -0,0 +1,219 @@
+#include "helpers/Socket.hpp"
+
+#include "helpers/Platform.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if BSO_IS_WINDOWS
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+#else
+	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <sys/time.h>
+	#include <unistd.h>
+#endif
+
+namespace Helpers::Socket
+{
+	namespace Detail
+	{
+		constexpr std::intptr_t invalidHandle = -1;
+
+		#if BSO_IS_WINDOWS
+			using NativeSocket = SOCKET;
+
+			/// Starts Winsock the first time a socket is needed, throwing a SocketError if it cannot be.
+			static void ensureStarted() {
+				static const int startupError = [] {
+					WSADATA data{};
+					return WSAStartup(MAKEWORD(2, 2), &data);
+				}();
+				if (startupError != 0) {
+					throw SocketError(std::format("cannot start Winsock (error {})", startupError));
+				}
+			}
+
+			[[nodiscard]] static std::string lastError() {
+				return std::system_category().message(WSAGetLastError());
+			}
+
+			static void closeNative(const NativeSocket socket) noexcept {
+				closesocket(socket);
+			}
+		#else
+			using NativeSocket = int;
+
+			static void ensureStarted() noexcept {}
+
+			[[nodiscard]] static std::string lastError() {
+				return std::generic_category().message(errno);
+			}
+
+			static void closeNative(const NativeSocket socket) noexcept {
+				::close(socket);
+			}
+		#endif
+
+		[[nodiscard]] static NativeSocket native(const std::intptr_t handle) noexcept {
+			return static_cast<NativeSocket>(handle);
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	Connection::~Connection() {
+		close();
+	}
+
+	Connection::Connection(Connection&& other) noexcept :
+		handle_(std::exchange(other.handle_, Detail::invalidHandle))
+	{}
+
+	Connection& Connection::operator=(Connection&& other) noexcept {
+		if (this != &other) {
+			close();
+			handle_ = std::exchange(other.handle_, Detail::invalidHandle);
+		}
+		return *this;
+	}
+
+	void Connection::close() noexcept {
+		if (handle_ != Detail::invalidHandle) {
+			Detail::closeNative(Detail::native(handle_));
+			handle_ = Detail::invalidHandle;
+		}
+	}
+
+	void Connection::setReceiveTimeout(const std::chrono::milliseconds timeout) noexcept {
+		#if BSO_IS_WINDOWS
+			const auto milliseconds = static_cast<DWORD>(timeout.count());
+			setsockopt(
+				Detail::native(handle_),
+				SOL_SOCKET,
+				SO_RCVTIMEO,
+				reinterpret_cast<const char*>(&milliseconds),
+				sizeof(milliseconds)
+			);
+		#else
+			const timeval time{
+				.tv_sec = static_cast<decltype(timeval::tv_sec)>(timeout.count() / 1000),
+				.tv_usec = static_cast<decltype(timeval::tv_usec)>(timeout.count() % 1000 * 1000)
+			};
+			setsockopt(Detail::native(handle_), SOL_SOCKET, SO_RCVTIMEO, &time, sizeof(time));
+		#endif
+	}
+
+	std::size_t Connection::receive(const std::span<char> buffer) noexcept {
+		#if BSO_IS_WINDOWS
+			const int received = recv(Detail::native(handle_), buffer.data(), static_cast<int>(buffer.size()), 0);
+		#else
+			ssize_t received = 0;
+			do {
+				received = recv(Detail::native(handle_), buffer.data(), buffer.size(), 0);
+			} while (received < 0 && errno == EINTR);
+		#endif
+		return received > 0 ? static_cast<std::size_t>(received) : 0;
+	}
+
+	void Connection::sendAll(std::string_view data) {
+		// A peer closing early must fail the send rather than raise SIGPIPE, which would end the process:
+		#if defined(MSG_NOSIGNAL)
+			constexpr int flags = MSG_NOSIGNAL;
+		#else
+			constexpr int flags = 0;
+		#endif
+		while (!data.empty()) {
+			#if BSO_IS_WINDOWS
+				const int sent = send(Detail::native(handle_), data.data(), static_cast<int>(data.size()), flags);
+			#else
+				const ssize_t sent = send(Detail::native(handle_), data.data(), data.size(), flags);
+				if (sent < 0 && errno == EINTR) {
+					continue;
+				}
+			#endif
+			if (sent <= 0) {
+				throw SocketError(std::format("cannot send: {}", Detail::lastError()));
+			}
+			data.remove_prefix(static_cast<std::size_t>(sent));
+		}
+	}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+	Listener::Listener(const std::string_view address, const std::uint16_t port) {
+		Detail::ensureStarted();
+
+		sockaddr_in socketAddress{};
+		socketAddress.sin_family = AF_INET;
+		socketAddress.sin_port = htons(port);
+		const std::string addressString(address);
+		if (inet_pton(AF_INET, addressString.c_str(), &socketAddress.sin_addr) != 1) {
+			throw SocketError(std::format("invalid IPv4 address {}", address));
+		}
+
+		const auto socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		handle_ = static_cast<std::intptr_t>(socket);
+		if (handle_ == Detail::invalidHandle) {
+			throw SocketError(std::format("cannot open socket: {}", Detail::lastError()));
+		}
+
+		// Lets a restarted server take its port back straight away, rather than once the old connections time out:
+		const int reuse = 1;
+		setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+		if (
+			bind(socket, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0
+			|| listen(socket, SOMAXCONN) != 0
+		) {
+			const std::string error = Detail::lastError();
+			Detail::closeNative(socket);
+			throw SocketError(std::format("cannot listen on {}:{}: {}", address, port, error));
+		}
+
+		sockaddr_in boundAddress{};
+		#if BSO_IS_WINDOWS
+			int boundSize = sizeof(boundAddress);
+		#else
+			socklen_t boundSize = sizeof(boundAddress);
+		#endif
+		getsockname(socket, reinterpret_cast<sockaddr*>(&boundAddress), &boundSize);
+		port_ = ntohs(boundAddress.sin_port);
+	}
+
+	Listener::~Listener() {
+		Detail::closeNative(Detail::native(handle_));
+	}
+
+	std::optional<Connection> Listener::accept(const std::chrono::milliseconds timeout) noexcept {
+		#if BSO_IS_WINDOWS
+			WSAPOLLFD pollSocket{.fd = Detail::native(handle_), .events = POLLRDNORM, .revents = 0};
+			if (WSAPoll(&pollSocket, 1, static_cast<INT>(timeout.count())) <= 0) {
+				return std::nullopt;
+			}
+		#else
+			pollfd pollSocket{.fd = Detail::native(handle_), .events = POLLIN, .revents = 0};
+			if (poll(&pollSocket, 1, static_cast<int>(timeout.count())) <= 0) {
+				return std::nullopt;
+			}
+		#endif
+		const auto socket = ::accept(Detail::native(handle_), nullptr, nullptr);
+		const auto handle = static_cast<std::intptr_t>(socket);
+		if (handle == Detail::invalidHandle) {
+			return std::nullopt;
+		}
+		return Connection(handle);
+	}
+}
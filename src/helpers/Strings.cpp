@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <cctype>
 #include <charconv>
+#include <cstddef>
+#include <format>
+#include <iterator>
 #include <ranges>
 #include <string>
 #include <string_view>
@@ -53,4 +56,79 @@ namespace Helpers::Strings
 		}
 		return value > 0;
 	}
+
+	std::string formatDigitsWithSeparator(
+		const std::string_view digits,
+		const std::string_view separator,
+		const int blockSize
+	) {
+		const auto block = static_cast<std::size_t>(blockSize);
+		std::string result{};
+		result.reserve(digits.size() + digits.size() / block * separator.size());
+		// The first block takes any remainder, so that every later block is full:
+		const std::size_t firstBlock = (digits.size() - 1) % block + 1;
+		for (std::size_t i = 0; i < digits.size(); ++i) {
+			if (i >= firstBlock && (i - firstBlock) % block == 0) {
+				result.append(separator);
+			}
+			result.push_back(digits[i]);
+		}
+		return result;
+	}
+
+	std::string quoteJSON(const std::string_view sv) {
+		std::string result = "\"";
+		result.reserve(sv.size() + 2);
+		for (const char c : sv) {
+			switch (c) {
+				case '"': result += "\\\""; break;
+				case '\\': result += "\\\\"; break;
+				case '\n': result += "\\n"; break;
+				case '\r': result += "\\r"; break;
+				case '\t': result += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						std::format_to(std::back_inserter(result), "\\u{:04x}", static_cast<unsigned char>(c));
+					}
+					else {
+						result.push_back(c);
+					}
+			}
+		}
+		result.push_back('"');
+		return result;
+	}
+
+	bool svWildcardMatch(const std::string_view pattern, const std::string_view sv) noexcept {
+		std::size_t p = 0;
+		std::size_t s = 0;
+		// Position of the last '*' seen, and the position in sv it is currently assumed to match up to,
+		// so that we can backtrack greedily rather than recursively.
+		std::size_t starPos = std::string_view::npos;
+		std::size_t starMatch = 0;
+
+		while (s < sv.size()) {
+			if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == sv[s])) {
+				++p;
+				++s;
+			}
+			else if (p < pattern.size() && pattern[p] == '*') {
+				starPos = p++;
+				starMatch = s;
+			}
+			else if (starPos != std::string_view::npos) {
+				// Let the last '*' absorb one more character and retry:
+				p = starPos + 1;
+				s = ++starMatch;
+			}
+			else {
+				return false;
+			}
+		}
+		// Any remaining pattern must consist solely of '*':
+		while (p < pattern.size() && pattern[p] == '*') {
+			++p;
+		}
+		return p == pattern.size();
+	}
 }
\ No newline at end of file